@@ -3599,7 +3599,7 @@ process_program_headers (FILE * file)
 	  else
 	    {
 	      char fmt [32];
-	      int ret = snprintf (fmt, sizeof (fmt), "%%%ds", PATH_MAX);
+	      int ret = snprintf (fmt, sizeof (fmt), "%%%ds", PATH_MAX - 1);
 
 	      if (ret >= (int) sizeof (fmt) || ret < 0)
 		error (_("Internal error: failed to create format string to display program interpreter\n"));
@@ -11686,7 +11686,7 @@ char* find_ELF_program_interpreter(char * file_name) {
         }
       else {
         char fmt [32];
-        int ret = snprintf (fmt, sizeof (fmt), "%%%ds", PATH_MAX);
+        int ret = snprintf (fmt, sizeof (fmt), "%%%ds", PATH_MAX - 1);
 
         if (ret >= (int) sizeof (fmt) || ret < 0) {
           error (_("Internal error: failed to create format string to display program interpreter\n"));
@@ -11815,6 +11815,156 @@ int find_ELF_class(char * file_name) {
 }
 
 
+// look for the DT_NEEDED, DT_RPATH, and DT_RUNPATH entries in the
+// dynamic section of this ELF binary, so that the caller can resolve
+// its shared library dependencies without running the dynamic linker.
+//
+// on success, *needed is set to a malloc'ed NULL-terminated array of
+// malloc'ed library names (e.g., "libc.so.6"), and *rpath and *runpath
+// are set to malloc'ed strings (or NULL if not present).  Returns the
+// ELF class (32 or 64) on success, -1 on error (unreadable or non-ELF
+// file).  a static binary succeeds with an empty *needed array.
+int find_ELF_dynamic_deps(char * file_name, char*** needed,
+                          char** rpath, char** runpath) {
+  int ret = -1;
+  unsigned int i;
+  unsigned int num_needed = 0;
+  char* dyn_strings = NULL;
+  unsigned long dyn_strings_length = 0;
+  Elf_Internal_Dyn * entry;
+
+  *needed = NULL;
+  *rpath = NULL;
+  *runpath = NULL;
+
+  FILE* file = fopen(file_name, "rb");
+  if (!file) {
+    return -1;
+  }
+
+  // check the magic bytes first, since get_file_header() complains
+  // loudly about non-ELF files (e.g., shell scripts)
+  unsigned char magic[4];
+  if (fread (magic, sizeof (magic), 1, file) != 1
+      || magic[0] != ELFMAG0 || magic[1] != ELFMAG1
+      || magic[2] != ELFMAG2 || magic[3] != ELFMAG3) {
+    goto done;
+  }
+  rewind (file);
+
+  if (! get_file_header (file)) {
+    goto done;
+  }
+
+  *needed = (char**)calloc(1, sizeof(char*));
+
+  // no program headers or no PT_DYNAMIC segment means that there's
+  // nothing to load (static binary), which isn't an error
+  ret = is_32bit_elf ? 32 : 64;
+
+  if (elf_header.e_phnum == 0 || ! get_program_headers (file)) {
+    goto done;
+  }
+
+  dynamic_addr = 0;
+  dynamic_size = 0;
+  for (i = 0; i < elf_header.e_phnum; i++) {
+    if (program_headers[i].p_type == PT_DYNAMIC) {
+      dynamic_addr = program_headers[i].p_offset;
+      dynamic_size = program_headers[i].p_filesz;
+      break;
+    }
+  }
+
+  if (dynamic_size == 0) {
+    goto done;
+  }
+
+  if (is_32bit_elf
+      ? ! get_32bit_dynamic_section (file)
+      : ! get_64bit_dynamic_section (file)) {
+    goto done;
+  }
+
+  // find the dynamic string table; its size is in DT_STRSZ, so unlike
+  // process_dynamic_section(), we don't need to read in the entire file
+  bfd_vma strtab_vma = 0;
+  for (entry = dynamic_section; entry < dynamic_section + dynamic_nent; ++entry) {
+    if (entry->d_tag == DT_STRTAB) {
+      strtab_vma = entry->d_un.d_val;
+    }
+    else if (entry->d_tag == DT_STRSZ) {
+      dyn_strings_length = entry->d_un.d_val;
+    }
+    else if (entry->d_tag == DT_NEEDED) {
+      num_needed++;
+    }
+  }
+
+  if (strtab_vma == 0 || dyn_strings_length == 0) {
+    goto done;
+  }
+
+  dyn_strings = (char *) get_data (NULL, file,
+                                   offset_from_vma (file, strtab_vma, dyn_strings_length),
+                                   1, dyn_strings_length, _("dynamic string table"));
+  if (!dyn_strings) {
+    goto done;
+  }
+
+  free(*needed);
+  *needed = (char**)calloc(num_needed + 1, sizeof(char*));
+  num_needed = 0;
+
+  for (entry = dynamic_section; entry < dynamic_section + dynamic_nent; ++entry) {
+    if (entry->d_un.d_val >= dyn_strings_length) {
+      continue;
+    }
+    char* name = dyn_strings + entry->d_un.d_val;
+    switch (entry->d_tag) {
+      case DT_NEEDED:
+        (*needed)[num_needed++] = strdup(name);
+        break;
+      case DT_RPATH:
+        if (!*rpath) *rpath = strdup(name);
+        break;
+      case DT_RUNPATH:
+        if (!*runpath) *runpath = strdup(name);
+        break;
+    }
+  }
+
+done:
+
+  fclose(file);
+
+  if (dyn_strings) {
+    free (dyn_strings);
+  }
+
+  if (dynamic_section)
+    {
+      free (dynamic_section);
+      dynamic_section = NULL;
+      dynamic_nent = 0;
+    }
+
+  if (program_headers)
+    {
+      free (program_headers);
+      program_headers = NULL;
+    }
+
+  if (section_headers)
+    {
+      free (section_headers);
+      section_headers = NULL;
+    }
+
+  return ret;
+}
+
+
 // comment-out main so that we can make this into a library
 /*
 int
@@ -29,6 +29,7 @@
 #include <sys/utsname.h> // P2001: struct utsname, uname()
 #include <linux/unistd.h>// GLIBC: shared mem: __NR_shmat()
 #include <sys/shm.h>     // P2001: shared mem: IPC_CREAT, IPC_EXCL, IPC_RMID, shmctl(), shmget(), shmat(), shmdt()
+#include <sched.h>       // GLIBC: CLONE_FS, CLONE_FILES
 #include <dirent.h>      // P2001: stuct dirent, DIR, readdir(), opendir(), closedir()
 #include <pthread.h>     // P2001: pthread_mutex_t, pthread_mutex_init(), pthread_mutex_lock/unlock()
 #include <stdbool.h>     // C99: bool, true, false
@@ -51,6 +52,18 @@
 #include "syslimits.h"   // max_open_files()
 #include "strutils.h"    // str_rstrip(), str_startswith(), str_endswith()
 #include "shellutils.h"  // malloc_quoted_arg_str()
+#include "libdeps.h"     // start_lib_prefetch(), queue_lib_prefetch(), finish_lib_prefetch()
+#include "ldcache.h"     // write_ld_so_cache()
+#include "strmap.h"      // StrMap, strmap_new(), strmap_put(), strmap_contains()
+#include "manifest.h"    // ManifestEntry, manifest_load(), manifest_save()
+#include "perftimers.h"  // start_perf_timer(), stop_perf_timer(), count_perf_event()
+#include "sysprofile.h"  // Sysprofile_mode, sysprofile_count_child_write()
+#include "trie.h"        // Trie, TrieNew(), TrieInsert(), TrieContains(), TrieLongestPrefix()
+#include "pathrules.h"   // PathRules, pathrules_match()
+#include "ctlsock.h"     // ctlsock_enabled(), ctlsock_add_pending_copies()
+#include "redircache.h"  // RedirCache, redircache_new(), redircache_get(), redircache_put()
+#include "envblock.h"    // EnvBlock, envblock_parse(), envblock_read(), envblock_var(), envblock_layout()
+#include "startsnap.h"   // StartSnap, startsnap_open(), startsnap_section(), startsnap_save()
 // #include "memoize.h"     // AKY adds for checkpoint/restore functionality
 // extern int CRIU_dump(const pid_t pid, const char *imgdir);
 /*******************************************************************************
@@ -71,16 +84,18 @@ char Cde_app_dir[MAXPATHLEN]; // abs path to cde app dir (contains cde-root)
 
 char Cde_restore_mode = 0;
 
+int CDE_lib_prefetch_workers = 4; // threads copying ELF lib closures during audit (-J option, 0 to turn OFF)
+
 /*******************************************************************************
  * PRIVATE CONSTANTS / VARIABLES
  ******************************************************************************/
 
 // private constants
-const size_t shared_page_size = MAXPATHLEN * 4; // shared mem page size
+const size_t shared_page_size = MAXPATHLEN * 8; // shared mem page size
+const size_t shared_env_offset = MAXPATHLEN * 4; // upper half of the page holds an injected envp
 
 // private variables
 static char cde_cderoot_dir[MAXPATHLEN]; // abs path to cde-root dir (root of captured app)
-static pthread_mutex_t mut_findelf = PTHREAD_MUTEX_INITIALIZER; // quanpt: make find_ELF_program_interpreter threadsafe
 static bool local_network_settings = true; // use local hostnames/etc during audit/exec
 
 
@@ -120,50 +135,136 @@ static bool get_script_command (const char* const script_file_path, char** scrip
   return is_textual_script;
 }
 
-/*******************************************************************************
- * PUBLIC FUNCTIONS
- ******************************************************************************/
-
-// allocate heap memory for a tcb's cde fields
-void alloc_tcb_cde_fields (struct tcb* tcp) {
-  tcp->localshm = NULL;
-  tcp->childshm = NULL;
-  tcp->setting_up_shm = 0;
+// the tracing thread changes and frees cwds while the control socket thread
+// reads them (see CDE_copy_current_dir())
+static pthread_mutex_t tcb_fs_mut = PTHREAD_MUTEX_INITIALIZER;
 
-  if (Cde_exec_mode || 1) { // TODO: quanpt: make it into cde option
-    key_t key;
-    // randomly probe for a valid shm key
-    do {
-      errno = 0;
-      key = rand();
-      tcp->shmid = shmget(key, shared_page_size, IPC_CREAT|IPC_EXCL|0600);
-    } while (tcp->shmid == -1 && errno == EEXIST);
+// new cwd block holding path
+static struct shared_cwd* new_shared_cwd (const char* path) {
+  struct shared_cwd* cwd = (struct shared_cwd*) malloc(sizeof(struct shared_cwd) + MAXPATHLEN); // big boy!
+  cwd->refcount = 1;
+  strcpy(cwd->path, path);
+  return cwd;
+}
 
-    tcp->localshm = (char*)shmat(tcp->shmid, NULL, 0);
+static void put_shared_cwd (struct shared_cwd* cwd) {
+  if (--cwd->refcount == 0) {
+    free(cwd);
+  }
+}
 
-    if ((long)tcp->localshm == -1) {
-      perror("shmat");
-      exit(1);
+// new fd->path table: a copy of from, or empty (if from is NULL)
+static struct shared_fd_paths* new_shared_fd_paths (const struct shared_fd_paths* from) {
+  const long maxof = max_open_files();
+  struct shared_fd_paths* fd_paths =
+    (struct shared_fd_paths*) calloc(1, sizeof(struct shared_fd_paths) + maxof * sizeof(char*));
+  fd_paths->refcount = 1;
+  if (from) {
+    for (long i = 0; i < maxof; i++) {
+      if (from->path[i]) {
+        fd_paths->path[i] = strdup(from->path[i]);
+      }
     }
+  }
+  return fd_paths;
+}
 
-    if (shmctl(tcp->shmid, IPC_RMID, NULL) == -1) {
-      perror("shmctl(IPC_RMID)");
-      exit(1);
+static void put_shared_fd_paths (struct shared_fd_paths* fd_paths) {
+  if (--fd_paths->refcount == 0) {
+    for (long i = 0; i < max_open_files(); i++) {
+      free(fd_paths->path[i]);
     }
+    free(fd_paths);
+  }
+}
+
+// new cwd of a proc: from's (copied on write), or empty (if from is NULL)
+static struct tcb_fs* new_tcb_fs (const struct tcb_fs* from) {
+  struct tcb_fs* fs = (struct tcb_fs*) malloc(sizeof(struct tcb_fs));
+  fs->refcount = 1;
+  if (from) {
+    fs->cwd = from->cwd;
+    fs->cwd->refcount++;
+    fs->current_repo_ind = from->current_repo_ind;
+  }
+  else {
+    fs->cwd = new_shared_cwd("");
+    fs->current_repo_ind = -1;
+  }
+  fs->current_dir = fs->cwd->path;
+  return fs;
+}
 
-    assert(tcp->localshm);
+// drop a proc's reference to its cwd, freeing it with the last reference
+static void put_tcb_fs (struct tcb_fs* fs) {
+  pthread_mutex_lock(&tcb_fs_mut);
+  if (fs && (--fs->refcount == 0)) {
+    put_shared_cwd(fs->cwd);
+    free(fs);
   }
+  pthread_mutex_unlock(&tcb_fs_mut);
+}
 
-  // digimokan: abs paths used to open this proc's currently open files
-  const long maxof = max_open_files();
-  tcp->opened_file_paths = (char**) malloc(maxof * sizeof(char*));
-  for (int i = 0; i < maxof; i++) {
-    tcp->opened_file_paths[i] = NULL;
+// set the cwd of fs (and the procs sharing it) to path, first copying its
+// cwd block if it is shared with procs forked from or by it
+static void set_current_dir (struct tcb_fs* fs, const char* path) {
+  pthread_mutex_lock(&tcb_fs_mut);
+  if (fs->cwd->refcount > 1) {
+    struct shared_cwd* cwd = new_shared_cwd("");
+    put_shared_cwd(fs->cwd);
+    fs->cwd = cwd;
+    fs->current_dir = cwd->path;
+  }
+  snprintf(fs->current_dir, MAXPATHLEN, "%s", path);
+  pthread_mutex_unlock(&tcb_fs_mut);
+}
+
+// new open files of a proc: from's paths (copied on write, with no bytes
+// counted yet), or none (if from is NULL)
+static struct tcb_files* new_tcb_files (const struct tcb_files* from) {
+  struct tcb_files* files = (struct tcb_files*) malloc(sizeof(struct tcb_files));
+  files->refcount = 1;
+  if (from) {
+    files->fd_paths = from->fd_paths;
+    files->fd_paths->refcount++;
+  }
+  else {
+    files->fd_paths = new_shared_fd_paths(NULL);
   }
+  files->opened_file_paths = files->fd_paths->path;
+  files->opened_file_bytes = NULL; // allocated on first read/write, if -B
+  return files;
+}
+
+// drop a proc's reference to its open files, freeing them with the last reference
+static void put_tcb_files (struct tcb_files* files) {
+  if (files && (--files->refcount == 0)) {
+    put_shared_fd_paths(files->fd_paths);
+    free(files->opened_file_bytes);
+    free(files);
+  }
+}
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+// allocate heap memory for a tcb's cde fields
+void alloc_tcb_cde_fields (struct tcb* tcp) {
+  // digimokan: the shared memory segment is created by begin_setup_shmat(),
+  // the first time this proc needs one (most threads never do)
+  tcp->shmid = -1;
+  tcp->localshm = NULL;
+  tcp->childshm = NULL;
+  tcp->setting_up_shm = 0;
+
+  // digimokan: cwd and open files are copied or shared by CDE_init_tcb_dir_fields()
+  tcp->fs = NULL;
+  tcp->files = NULL;
 
-  tcp->current_dir = NULL;
   tcp->p_ignores = NULL;
-  tcp->current_repo_ind = -1;
+  tcp->untraced = 0;
+  tcp->env_repo_ind = -1;
 }
 
 // free heap-allocated cde fields in a tcb
@@ -172,23 +273,41 @@ void free_tcb_cde_fields (struct tcb* tcp) {
     shmdt(tcp->localshm);
   }
   // need to null out elts in case table entries are recycled
+  tcp->shmid = -1;
   tcp->localshm = NULL;
   tcp->childshm = NULL;
   tcp->setting_up_shm = 0;
   tcp->p_ignores = NULL;
+  tcp->untraced = 0;
+
+  struct tcb_fs* fs = tcp->fs;
+  pthread_mutex_lock(&tcb_fs_mut);
+  tcp->fs = NULL;
+  pthread_mutex_unlock(&tcb_fs_mut);
+  put_tcb_fs(fs);
+  put_tcb_files(tcp->files);
+  tcp->files = NULL;
+  tcp->env_repo_ind = -1;
+}
 
-  // digimokan: abs paths used to open this proc's currently open files
-  for (int i = 0; i < max_open_files(); i++) {
-    if (tcp->opened_file_paths[i] != NULL) {
-      free(tcp->opened_file_paths[i]);
-    }
-  }
+// copy the cwd of tcp into buf (of size bytes), or "" if it has none yet
+// (safe to call from other threads than the tracing one)
+void CDE_copy_current_dir (struct tcb* tcp, char* buf, size_t size) {
+  pthread_mutex_lock(&tcb_fs_mut);
+  snprintf(buf, size, "%s", tcp->fs ? tcp->fs->current_dir : "");
+  pthread_mutex_unlock(&tcb_fs_mut);
+}
 
-  if (tcp->current_dir) {
-    free(tcp->current_dir);
-    tcp->current_dir = NULL;
+// make tcp's open files the only user of their fd->path table (by copying
+// the one shared with procs forked from or by it), before changing it
+void CDE_own_opened_file_paths (struct tcb* tcp) {
+  struct tcb_files* files = tcp->files;
+  if (files->fd_paths->refcount > 1) {
+    struct shared_fd_paths* fd_paths = new_shared_fd_paths(files->fd_paths);
+    put_shared_fd_paths(files->fd_paths);
+    files->fd_paths = fd_paths;
+    files->opened_file_paths = fd_paths->path;
   }
-  tcp->current_repo_ind = -1;
 }
 
 // use local network hostnames/etc during audit/exec
@@ -221,47 +340,6 @@ char CDE_exec_streaming_mode = 0; // -s option
 #define IS_32BIT_EMU (current_personality == 1)
 #endif
 
-// Super-simple trie implementation for doing fast string matching:
-// adapted from my earlier IncPy project
-
-typedef struct _trie {
-  struct _trie* children[128]; // we support ASCII characters from 0 to 127
-  int elt_is_present; // 1 if there is an element present here
-} Trie;
-
-
-static Trie* TrieNew(void) {
-  // VERY important to blank out the contents with a calloc()
-  return (Trie*)calloc(1, sizeof(Trie));
-}
-
-static void TrieInsert(Trie* t, char* ascii_string) {
-  while (*ascii_string != '\0') {
-    unsigned char idx = (unsigned char)*ascii_string;
-    assert(idx < 128); // we don't support extended ASCII characters
-    if (!t->children[idx]) {
-      t->children[idx] = TrieNew();
-    }
-    t = t->children[idx];
-    ascii_string++;
-  }
-
-  t->elt_is_present = 1;
-}
-
-static int TrieContains(Trie* t, char* ascii_string) {
-  while (*ascii_string != '\0') {
-    unsigned char idx = (unsigned char)*ascii_string;
-    t = t->children[idx];
-    if (!t) {
-      return 0; // early termination, no match!
-    }
-    ascii_string++;
-  }
-
-  return t->elt_is_present;
-}
-
 // 1 if we should use the dynamic linker from within the package
 //   (much more portable, but might be less robust since the dynamic linker
 //   must be invoked explicitly, which leads to some weird-ass bugs)
@@ -273,16 +351,28 @@ char CDE_use_linker_from_package = 1; // ON by default, -l option to turn OFF
 
 // only 1 if we are running cde-exec from OUTSIDE of a cde-root/ directory
 char cde_exec_from_outside_cderoot = 0;
+
+// cde-exec: redirections of recently used (cwd, path)s
+#define REDIRECT_CACHE_SIZE 4096
+static RedirCache* redirect_cache = NULL;
 FILE* CDE_copied_files_logfile = NULL;
 
 static char cde_options_initialized = 0; // set to 1 after CDE_init_options() done
 
+// cde-exec: startup snapshot of the package (cde.startup.<root>), opened if
+// current, else built during startup and saved by CDE_finish_startup_snapshot()
+static StartSnap* startup_snap = NULL;
+static StartSnapWriter* startup_snap_writer = NULL;
+static uint64_t startup_snap_key = 0;
+
 static void begin_setup_shmat(struct tcb* tcp);
 static void* find_free_addr(int pid, int exec, unsigned long size);
 
 char* strcpy_from_child(struct tcb* tcp, long addr);
 char* strcpy_from_child_or_null(struct tcb* tcp, long addr);
+static char* getenv_from_child(struct tcb* tcp, long child_envp, const char* name);
 static int ignore_path(char* filename, struct tcb* tcp);
+static bool is_referenced_path(char* filename_abspath);
 
 static char* redirect_filename_into_cderoot(char* filename, char* child_current_pwd, struct tcb* tcp);
 void memcpy_to_child(int pid, char* dst_child, char* src, int size);
@@ -296,24 +386,20 @@ char cde_starting_pwd[MAXPATHLEN];
 
 // these arrays are initialized in CDE_init_options()
 // yeah, statically-sized arrays are dumb but easy to implement :)
-static char* ignore_exact_paths[100];
-static char* ignore_prefix_paths[100];
-static char* ignore_substr_paths[100];
-static int ignore_exact_paths_ind;
-static int ignore_prefix_paths_ind;
-static int ignore_substr_paths_ind;
+static PathRules ignore_rules;
 
 static char* multi_repo_paths[100]; // quanpt
 static int multi_repo_paths_ind;
 static int multi_repo_paths_curr;
+static char* multi_repo_names[100];        // as given in cde.options (names their environment files)
+static size_t multi_repo_paths_len[100];
+static bool multi_repo_paths_nested[100];  // true if another repo is within this one
+static Trie* multi_repo_trie = NULL;       // multi_repo_paths -> their index
+static EnvBlock* multi_repo_envs[100];     // environments of the repos, parsed on first use
+static bool multi_repo_envs_loaded[100];
 
 // these override their ignore path counterparts
-static char* redirect_exact_paths[100];
-static char* redirect_prefix_paths[100];
-static char* redirect_substr_paths[100];
-static int redirect_exact_paths_ind;
-static int redirect_prefix_paths_ind;
-static int redirect_substr_paths_ind;
+static PathRules redirect_rules;
 
 static char* ignore_envvars[100]; // each element should be an environment variable to ignore
 static char* ignore_envvars_values[100];
@@ -322,6 +408,26 @@ static int ignore_envvars_ind;
 static struct PI process_ignores[50];
 static int process_ignores_ind;
 
+// capture policy, also initialized in CDE_init_options()
+#define CAPTURE_METADATA 1  // kinds of capture_file(), in increasing order
+#define CAPTURE_FULL     2
+static char capture_metadata_placeholders = 0; // 'capture_policy=metadata_placeholders'
+static long long reference_files_larger_than = -1; // 'reference_files_larger_than=<size>' (-1 means never)
+static StrMap* placeholder_paths = NULL; // abspaths whose file in cde-root/ is only a placeholder
+static StrMap* referenced_paths = NULL;  // abspaths used from the real system (val non-NULL if added during this audit)
+static StrMap* capture_manifest = NULL;  // abspath -> ManifestEntry* of regular files fully copied into cde-root/
+static char capture_deferred = 0;        // 'capture_timing=deferred'
+static StrMap* deferred_captures = NULL; // abspath -> CAPTURE_* kind, captured by CDE_finish_deferred_captures()
+static StrMap* captured_before_write = NULL; // abspath -> CAPTURE_* kind, captured right away (in deferred mode) before the app wrote it
+static pthread_mutex_t capture_policy_mut = PTHREAD_MUTEX_INITIALIZER; // libdeps workers copy files too
+
+// files of the package written on a thread of their own, during the audit
+// (see CDE_create_package_files())
+static char** package_files_argv = NULL;
+static int package_files_optind = 0;
+static pthread_t package_files_thread;
+static bool package_files_thread_started = false;
+
 // the path to where the root directory is mounted on the remote machine
 // (only relevant for "cde-exec -s")
 char* cde_remote_root_dir = NULL;
@@ -342,11 +448,18 @@ extern void path_pop(struct path* p);
 static void CDE_init_options(void);
 static void CDE_create_convenience_scripts(char** argv, int optind);
 static void CDE_create_toplevel_symlink_dirs(void);
-static void CDE_create_path_symlink_dirs(void);
+static void CDE_create_path_symlink_dirs(const char* path_envvar);
+static void CDE_load_placeholder_paths(void);
+static void CDE_load_capture_manifest(void);
 void CDE_load_environment_vars(char*);
 
 // multiple repo support
 int get_repo_path_id(char* path);
+static int get_tcb_repo_path_id(char* path, struct tcb* tcp);
+static void inject_repo_environment(struct tcb* tcp, int id);
+static void load_cached_files_trie(void);
+static bool detach_ignored_process(struct tcb* tcp);
+static void CDE_open_startup_snapshot(void);
 int is_cde_binary(const char *str);
 int detach(struct tcb *tcp, int sig);
 int is_in_another_repo(char* path, struct tcb* tcp);
@@ -398,7 +511,7 @@ static char* extract_sandboxed_pwd(char* real_pwd, struct tcb* tcp) {
   // if we're not ignoring it
   if (!real_pwd_is_within_cde_cderoot_dir) {
     // if we're in this mode, then we're okay!!!  don't return an error!
-    if (cde_exec_from_outside_cderoot || get_repo_path_id(real_pwd) >= 0) {
+    if (cde_exec_from_outside_cderoot || get_tcb_repo_path_id(real_pwd, tcp) >= 0) {
       return real_pwd;
     }
     else {
@@ -472,6 +585,9 @@ char* create_abspath_within_cderoot(char* path) {
 
         // we REALLY rely on cached_files_trie for performance to avoid
         // unnecessary filesystem accesses
+        if (!cached_files_trie) {
+          load_cached_files_trie();
+        }
         if (TrieContains(cached_files_trie, path)) {
           // cache hit!  fall-through
         }
@@ -517,7 +633,7 @@ char* create_abspath_within_cderoot(char* path) {
 
 // does simple string comparisons on ABSOLUTE PATHS.
 // (tcp argument is optional and used for tcp->p_ignores)
-static int ignore_path(char* filename, struct tcb* tcp) {
+static int do_ignore_path(char* filename, struct tcb* tcp) {
   assert(cde_options_initialized);
 
   // sometimes you will get a BOGUS empty filename ... in that case,
@@ -552,39 +668,17 @@ static int ignore_path(char* filename, struct tcb* tcp) {
 
 
   // redirect paths override ignore paths
-  for (i = 0; i < redirect_exact_paths_ind; i++) {
-    if (strcmp(filename, redirect_exact_paths[i]) == 0) {
-      return 0;
-    }
-  }
-  for (i = 0; i < redirect_prefix_paths_ind; i++) {
-    char* p = redirect_prefix_paths[i];
-    if (strncmp(filename, p, strlen(p)) == 0) {
-      return 0;
-    }
-  }
-  for (i = 0; i < redirect_substr_paths_ind; i++) {
-    if (strstr(filename, redirect_substr_paths[i])) {
-      return 0;
-    }
+  if (pathrules_match(&redirect_rules, filename)) {
+    return 0;
   }
 
-
-  for (i = 0; i < ignore_exact_paths_ind; i++) {
-    if (strcmp(filename, ignore_exact_paths[i]) == 0) {
-      return 1;
-    }
-  }
-  for (i = 0; i < ignore_prefix_paths_ind; i++) {
-    char* p = ignore_prefix_paths[i];
-    if (strncmp(filename, p, strlen(p)) == 0) {
-      return 1;
-    }
+  // referenced files are used from the real system, just like ignored ones
+  if (is_referenced_path(filename)) {
+    return 1;
   }
-  for (i = 0; i < ignore_substr_paths_ind; i++) {
-    if (strstr(filename, ignore_substr_paths[i])) {
-      return 1;
-    }
+
+  if (pathrules_match(&ignore_rules, filename)) {
+    return 1;
   }
 
   if (cde_exec_from_outside_cderoot) {
@@ -613,12 +707,252 @@ static int ignore_path(char* filename, struct tcb* tcp) {
   }
 }
 
+// ignore_path(), optionally tracking time of matching paths against rules
+static int ignore_path(char* filename, struct tcb* tcp) {
+  start_perf_timer(PATH_RULE_MATCHING);
+  int ret = do_ignore_path(filename, tcp);
+  stop_perf_timer(PATH_RULE_MATCHING);
+  return ret;
+}
+
 
-// copies a file into its respective location within cde-root/,
-// creating all necessary intermediate sub-directories and symlinks
+static bool is_referenced_path(char* filename_abspath) {
+  pthread_mutex_lock(&capture_policy_mut);
+  bool is_referenced = strmap_contains(referenced_paths, filename_abspath);
+  pthread_mutex_unlock(&capture_policy_mut);
+  return is_referenced;
+}
+
+// apply the capture policy right before filename_abspath gets fully copied:
+// drop any placeholder of it, and return false if it is too big to copy
+// (in which case it is referenced from the real system from now on)
+static bool prepare_full_copy(char* filename_abspath) {
+  bool is_referenced = false;
+  struct stat st;
+
+  pthread_mutex_lock(&capture_policy_mut);
+
+  // okapi won't overwrite a placeholder, since it has the original's mtime
+  if (strmap_contains(placeholder_paths, filename_abspath)) {
+    char* dst_path = format("%s%s", CDE_ROOT_DIR, filename_abspath);
+    unlink(dst_path);
+    free(dst_path);
+    strmap_remove(placeholder_paths, filename_abspath);
+    free(strmap_remove(capture_manifest, filename_abspath));
+  }
+
+  if (reference_files_larger_than >= 0 &&
+      stat(filename_abspath, &st) == 0 && S_ISREG(st.st_mode) &&
+      st.st_size > reference_files_larger_than) {
+    strmap_put(referenced_paths, filename_abspath, (void*)1);
+    is_referenced = true;
+  }
+
+  pthread_mutex_unlock(&capture_policy_mut);
+
+  if (is_referenced) {
+    vbp(1, "REFERENCED '%s' (%lld bytes)\n", filename_abspath, (long long)st.st_size);
+  }
+  return !is_referenced;
+}
+
+// mirror filename_abspath into cde-root/, unless capture_manifest shows that
+// cde-root/ already has its current version (from this or an earlier audit)
 //
-// if filename is a symlink, then copy both it AND its target into cde-root
-static void copy_file_into_cde_root(char* filename, char* child_current_pwd) {
+// this costs a single lstat() for unchanged files, rather than the lstat(),
+// stat(), and link() (or copy) of create_mirror_file()
+static void mirror_file_using_manifest(char* filename_abspath) {
+  struct stat src_stat;
+  if (lstat(filename_abspath, &src_stat) != 0 || !S_ISREG(src_stat.st_mode)) {
+    create_mirror_file_in_cde_package(filename_abspath, (char*)"", CDE_ROOT_DIR);
+    return;
+  }
+
+  pthread_mutex_lock(&capture_policy_mut);
+  ManifestEntry* entry = (ManifestEntry*)strmap_get(capture_manifest, filename_abspath);
+  bool is_unchanged = (entry && manifest_entry_matches(entry, &src_stat));
+  bool check_hash = (entry && !is_unchanged && entry->has_hash && entry->size == src_stat.st_size);
+  uint64_t old_hash = entry ? entry->hash : 0;
+  if (is_unchanged) {
+    entry->touched = true;
+  }
+  pthread_mutex_unlock(&capture_policy_mut);
+
+  if (is_unchanged) {
+    count_perf_event(CAPTURE_CACHE_HITS, 1);
+    return;
+  }
+
+  // a file replaced by an identical one (e.g., a re-installed package) has
+  // a new inode and mtime, but needn't be copied again
+  uint64_t new_hash = 0;
+  bool has_new_hash = false;
+  if (check_hash && hash_file_contents(filename_abspath, &new_hash) == 0) {
+    has_new_hash = true;
+  }
+
+  if (!has_new_hash || new_hash != old_hash) {
+    // okapi won't replace an existing file that is newer than the original
+    if (entry) {
+      char* dst_path = format("%s%s", CDE_ROOT_DIR, filename_abspath);
+      unlink(dst_path);
+      free(dst_path);
+    }
+    create_mirror_file_in_cde_package(filename_abspath, (char*)"", CDE_ROOT_DIR);
+    count_perf_event(CAPTURE_CACHE_MISSES, 1);
+    vbp(2, "CAPTURED '%s'\n", filename_abspath);
+  }
+  else {
+    count_perf_event(CAPTURE_CACHE_HITS, 1);
+  }
+
+  pthread_mutex_lock(&capture_policy_mut);
+  entry = (ManifestEntry*)strmap_get(capture_manifest, filename_abspath);
+  if (!entry) {
+    entry = (ManifestEntry*)malloc(sizeof(ManifestEntry));
+    strmap_put(capture_manifest, filename_abspath, entry);
+  }
+  manifest_entry_set_stat(entry, &src_stat);
+  entry->hash = new_hash;
+  entry->has_hash = has_new_hash;
+  entry->touched = true;
+  pthread_mutex_unlock(&capture_policy_mut);
+}
+
+// mirror filename_abspath into cde-root/ (the tail of copy_file_into_cde_root())
+static void capture_file_abspath(char* filename_abspath) {
+  if (!Prov_no_app_capture && !prepare_full_copy(filename_abspath)) {
+    return;
+  }
+
+  if (CDE_copied_files_logfile) {
+    fprintf(CDE_copied_files_logfile, "%s\n", filename_abspath);
+  }
+
+  if (Prov_no_app_capture) {
+    create_mirror_file_in_cde_package(filename_abspath, (char*)"", CDE_ROOT_DIR);
+  }
+  else {
+    mirror_file_using_manifest(filename_abspath);
+  }
+}
+
+// with 'capture_policy=metadata_placeholders', syscalls that only need the
+// metadata of a regular file (see is_metadata_only_fileop()) get a sparse
+// placeholder in cde-root/ with the original's size, mode, and times,
+// rather than a full copy.  capture_file_abspath() replaces the
+// placeholder with a full copy if the file is later opened or executed.
+static void capture_file_metadata_abspath(char* filename_abspath) {
+  if (!capture_metadata_placeholders || Prov_no_app_capture) {
+    capture_file_abspath(filename_abspath);
+    return;
+  }
+
+  // symlinks and dirs are cheap to mirror, so let okapi handle them
+  struct stat src_stat;
+  if (lstat(filename_abspath, &src_stat) != 0 || !S_ISREG(src_stat.st_mode)) {
+    capture_file_abspath(filename_abspath);
+    return;
+  }
+
+  char* dst_path = format("%s%s", CDE_ROOT_DIR, filename_abspath);
+
+  pthread_mutex_lock(&capture_policy_mut);
+
+  bool is_placeholder = strmap_contains(placeholder_paths, filename_abspath);
+  struct stat dst_stat;
+  if (!is_placeholder && lstat(dst_path, &dst_stat) == 0) {
+    // already fully copied, so let okapi refresh it if needed
+    pthread_mutex_unlock(&capture_policy_mut);
+    capture_file_abspath(filename_abspath);
+    free(dst_path);
+    return;
+  }
+
+  // re-create (rather than update) a placeholder, in case its mode changed
+  if (is_placeholder) {
+    unlink(dst_path);
+  }
+  else {
+    make_mirror_dirs_in_cde_package(filename_abspath, 1);
+  }
+
+  int fd = open(dst_path, O_WRONLY | O_CREAT | O_EXCL, src_stat.st_mode & 07777);
+  if (fd >= 0) {
+    struct timespec times[2] = { src_stat.st_atim, src_stat.st_mtim };
+    if (ftruncate(fd, src_stat.st_size) == 0 && futimens(fd, times) == 0) {
+      strmap_put(placeholder_paths, filename_abspath, NULL);
+      vbp(1, "PLACEHOLDER '%s' (%lld bytes)\n", filename_abspath, (long long)src_stat.st_size);
+    }
+    else {
+      unlink(dst_path);
+      strmap_remove(placeholder_paths, filename_abspath);
+    }
+    close(fd);
+  }
+  else {
+    strmap_remove(placeholder_paths, filename_abspath);
+  }
+
+  pthread_mutex_unlock(&capture_policy_mut);
+
+  free(dst_path);
+}
+
+// with 'capture_timing=deferred', record that filename_abspath must be
+// captured when the audit finishes (a full capture overrides a metadata
+// one), and return true.  else return false, to capture it right away.
+static bool defer_capture(char* filename_abspath, intptr_t kind) {
+  if (!capture_deferred || Prov_no_app_capture) {
+    return false;
+  }
+
+  pthread_mutex_lock(&capture_policy_mut);
+  // keep the copy made before the app wrote the file (unless it was only
+  // metadata, and the contents are needed now)
+  if ((intptr_t)strmap_get(captured_before_write, filename_abspath) >= kind) {
+    pthread_mutex_unlock(&capture_policy_mut);
+    return true;
+  }
+  bool is_new = !strmap_contains(deferred_captures, filename_abspath);
+  if ((intptr_t)strmap_get(deferred_captures, filename_abspath) < kind) {
+    strmap_put(deferred_captures, filename_abspath, (void*)kind);
+  }
+  pthread_mutex_unlock(&capture_policy_mut);
+
+  // live stats (-k) show how much the deferred captures will copy
+  struct stat st;
+  if (is_new && ctlsock_enabled() && stat(filename_abspath, &st) == 0 && S_ISREG(st.st_mode)) {
+    ctlsock_add_pending_copies(1, st.st_size);
+  }
+  return true;
+}
+
+// okapi hard-links a captured file to its original when it can, so replace
+// such a capture of filename_abspath with a copy, for it to keep the
+// contents the file had before the app writes it
+static void unshare_captured_file(char* filename_abspath) {
+  char* dst_path = format("%s%s", CDE_ROOT_DIR, filename_abspath);
+  struct stat src_stat, dst_stat;
+  if (stat(filename_abspath, &src_stat) == 0 && stat(dst_path, &dst_stat) == 0 &&
+      src_stat.st_dev == dst_stat.st_dev && src_stat.st_ino == dst_stat.st_ino) {
+    char* tmp_path = format("%s.ptu-copy", dst_path);
+    okapi_copy_file(filename_abspath, tmp_path, 0);
+    struct timespec times[2] = { src_stat.st_atim, src_stat.st_mtim };
+    if (utimensat(AT_FDCWD, tmp_path, times, 0) != 0 || rename(tmp_path, dst_path) != 0) {
+      unlink(tmp_path);
+    }
+    free(tmp_path);
+  }
+  free(dst_path);
+}
+
+// capture filename (relative to child_current_pwd) into cde-root/, as
+// either a full copy (CAPTURE_FULL) or only its metadata (CAPTURE_METADATA)
+//
+// if may_defer is false, then capture it right away even in deferred mode
+// (e.g., before the file gets written to)
+static void capture_file(char* filename, char* child_current_pwd, intptr_t kind, bool may_defer) {
   assert(filename);
   assert(!Cde_exec_mode);
 
@@ -638,11 +972,101 @@ static void copy_file_into_cde_root(char* filename, char* child_current_pwd) {
     return;
   }
 
-  if (CDE_copied_files_logfile) {
-    fprintf(CDE_copied_files_logfile, "%s\n", filename_abspath);
+  if (may_defer && defer_capture(filename_abspath, kind)) {
+    free(filename_abspath);
+    return;
+  }
+
+  // in deferred mode, a capture before a write replaces any pending one (which
+  // would copy the written contents), and later ones for the file are no-ops
+  bool is_before_write = false;
+  if (!may_defer && capture_deferred && !Prov_no_app_capture) {
+    struct stat st;
+    pthread_mutex_lock(&capture_policy_mut);
+    intptr_t pending_kind = (intptr_t)strmap_remove(deferred_captures, filename_abspath);
+    if (pending_kind > kind) {
+      kind = pending_kind;
+    }
+    if ((intptr_t)strmap_get(captured_before_write, filename_abspath) >= kind) {
+      pthread_mutex_unlock(&capture_policy_mut);
+      free(filename_abspath);
+      return;
+    }
+    // (a file the app creates is its output, so it's captured as usual)
+    if (lstat(filename_abspath, &st) == 0) {
+      strmap_put(captured_before_write, filename_abspath, (void*)kind);
+      is_before_write = true;
+    }
+    pthread_mutex_unlock(&capture_policy_mut);
+  }
+
+  if (kind == CAPTURE_METADATA) {
+    capture_file_metadata_abspath(filename_abspath);
+  }
+  else {
+    capture_file_abspath(filename_abspath);
+    if (is_before_write) {
+      unshare_captured_file(filename_abspath);
+    }
   }
 
-  create_mirror_file_in_cde_package(filename_abspath, (char*)"", CDE_ROOT_DIR);
+  free(filename_abspath);
+}
+
+// copies a file into its respective location within cde-root/,
+// creating all necessary intermediate sub-directories and symlinks
+//
+// if filename is a symlink, then copy both it AND its target into cde-root
+static void copy_file_into_cde_root(char* filename, char* child_current_pwd) {
+  capture_file(filename, child_current_pwd, CAPTURE_FULL, true);
+}
+
+// return true if syscall_name (as passed to CDE_begin_*_fileop()) never
+// reads the contents of its file
+static bool is_metadata_only_fileop(const char* syscall_name) {
+  static const char* const metadata_only_syscalls[] = {
+    "sys_access", "sys_faccessat",
+    "sys_stat", "sys_stat64", "sys_oldstat", "sys_newfstatat",
+    "sys_lstat", "sys_lstat64", "sys_oldlstat",
+    "sys_statfs", "sys_statfs64",
+    "sys_chmod", "sys_fchmodat", "sys_chown", "sys_fchownat",
+    "sys_truncate", "sys_truncate64",
+    "sys_utime", "sys_utimes", "sys_futimesat",
+    NULL
+  };
+
+  for (int i = 0; metadata_only_syscalls[i]; i++) {
+    if (strcmp(syscall_name, metadata_only_syscalls[i]) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// return true if syscall_name (as passed to CDE_begin_*_fileop()) may change
+// the contents of its file, so that its original contents must be captured
+// before the syscall runs (flags_arg_index is the arg of the open() flags)
+static bool is_write_fileop(struct tcb* tcp, const char* syscall_name, int flags_arg_index) {
+  if (strcmp(syscall_name, "sys_open") == 0 || strcmp(syscall_name, "sys_openat") == 0) {
+    long flags = tcp->u_arg[flags_arg_index];
+    return ((flags & O_ACCMODE) != O_RDONLY) || (flags & O_TRUNC);
+  }
+  return strcmp(syscall_name, "sys_creat") == 0 ||
+         strcmp(syscall_name, "sys_truncate") == 0 ||
+         strcmp(syscall_name, "sys_truncate64") == 0;
+}
+
+// the package mirrors the final state of the app's files, so a file that
+// the app deletes (or renames) is deleted from cde-root/ and needs no capture
+static void forget_captured_file(char* filename, char* child_current_pwd) {
+  char* filename_abspath = canonicalize_path(filename, child_current_pwd);
+
+  pthread_mutex_lock(&capture_policy_mut);
+  strmap_remove(deferred_captures, filename_abspath);
+  strmap_remove(captured_before_write, filename_abspath);
+  strmap_remove(placeholder_paths, filename_abspath);
+  free(strmap_remove(capture_manifest, filename_abspath));
+  pthread_mutex_unlock(&capture_policy_mut);
 
   free(filename_abspath);
 }
@@ -666,7 +1090,7 @@ static void modify_syscall_single_arg(struct tcb* tcp, int arg_num, char* filena
 
   //printf("from '%s' ", filename);
   char* redirected_filename =
-    redirect_filename_into_cderoot(filename, tcp->current_dir, tcp);
+    redirect_filename_into_cderoot(filename, tcp->fs->current_dir, tcp);
   if (!redirected_filename) {
     return;
   }
@@ -737,12 +1161,12 @@ static void modify_syscall_two_args(struct tcb* tcp) {
 
   char* filename1 = strcpy_from_child(tcp, tcp->u_arg[0]);
   char* redirected_filename1 =
-    redirect_filename_into_cderoot(filename1, tcp->current_dir, tcp);
+    redirect_filename_into_cderoot(filename1, tcp->fs->current_dir, tcp);
   free(filename1);
 
   char* filename2 = strcpy_from_child(tcp, tcp->u_arg[1]);
   char* redirected_filename2 =
-    redirect_filename_into_cderoot(filename2, tcp->current_dir, tcp);
+    redirect_filename_into_cderoot(filename2, tcp->fs->current_dir, tcp);
   free(filename2);
 
   // gotta do both, yuck
@@ -833,12 +1257,12 @@ static void modify_syscall_second_and_fourth_args(struct tcb* tcp) {
 
   char* filename1 = strcpy_from_child(tcp, tcp->u_arg[1]);
   char* redirected_filename1 =
-    redirect_filename_into_cderoot(filename1, tcp->current_dir, tcp);
+    redirect_filename_into_cderoot(filename1, tcp->fs->current_dir, tcp);
   free(filename1);
 
   char* filename2 = strcpy_from_child(tcp, tcp->u_arg[3]);
   char* redirected_filename2 =
-    redirect_filename_into_cderoot(filename2, tcp->current_dir, tcp);
+    redirect_filename_into_cderoot(filename2, tcp->fs->current_dir, tcp);
   free(filename2);
 
   // gotta do both, yuck
@@ -923,12 +1347,12 @@ static void modify_syscall_first_and_third_args(struct tcb* tcp) {
 
   char* filename1 = strcpy_from_child(tcp, tcp->u_arg[0]);
   char* redirected_filename1 =
-    redirect_filename_into_cderoot(filename1, tcp->current_dir, tcp);
+    redirect_filename_into_cderoot(filename1, tcp->fs->current_dir, tcp);
   free(filename1);
 
   char* filename2 = strcpy_from_child(tcp, tcp->u_arg[2]);
   char* redirected_filename2 =
-    redirect_filename_into_cderoot(filename2, tcp->current_dir, tcp);
+    redirect_filename_into_cderoot(filename2, tcp->fs->current_dir, tcp);
   free(filename2);
 
   // gotta do both, yuck
@@ -1007,7 +1431,7 @@ static void modify_syscall_first_and_third_args(struct tcb* tcp) {
 // WARNING: behavior differs based on Cde_exec_mode!
 //
 // (tcp argument is optional and used to pass into ignore_path)
-static char* redirect_filename_into_cderoot(char* filename, char* child_current_pwd, struct tcb* tcp) {
+static char* do_redirect_filename_into_cderoot(char* filename, char* child_current_pwd, struct tcb* tcp) {
   /* sometimes this is called with a null arg ... investigate further
      before making this hack permanent, though
   if (!filename) {
@@ -1040,7 +1464,7 @@ static char* redirect_filename_into_cderoot(char* filename, char* child_current_
   assert(filename_abspath);
 
   // quanpt - don't redirect to this root if filename point to some root
-  if (get_repo_path_id(filename_abspath)>=0) {
+  if (get_tcb_repo_path_id(filename_abspath, tcp)>=0) {
     //free(filename_abspath);
     //return NULL;
     return filename_abspath;
@@ -1071,6 +1495,44 @@ static char* redirect_filename_into_cderoot(char* filename, char* child_current_
 }
 
 
+// redirect_filename_into_cderoot(), from redirect_cache in cde-exec mode:
+// there the redirection only depends on filename and child_current_pwd
+// (unless tcp has its own ignores), or on which files cde-root has if
+// cde-exec runs from outside of it (see forget_redirects())
+static char* redirect_filename_into_cderoot(char* filename, char* child_current_pwd, struct tcb* tcp) {
+  const bool cacheable = Cde_exec_mode && !(tcp && tcp->p_ignores);
+  if (cacheable) {
+    if (!redirect_cache) {
+      redirect_cache = redircache_new(REDIRECT_CACHE_SIZE);
+    }
+    const char* cached;
+    if (redircache_get(redirect_cache, child_current_pwd, filename, &cached)) {
+      count_perf_event(REDIRECT_CACHE_HITS, 1);
+      if (Cde_verbose_mode && cached) {
+        vbprintf("redirect '%s' => '%s' (cached)\n", filename, cached);
+      }
+      return cached ? strdup(cached) : NULL;
+    }
+    count_perf_event(REDIRECT_CACHE_MISSES, 1);
+  }
+
+  char* ret = do_redirect_filename_into_cderoot(filename, child_current_pwd, tcp);
+  if (cacheable) {
+    redircache_put(redirect_cache, child_current_pwd, filename, ret);
+  }
+  return ret;
+}
+
+// forget cached redirections after tcp's syscall succeeded in removing or
+// renaming files, if cde-exec runs from outside of cde-root/ (where a path
+// is only redirected while cde-root/ has it)
+static void forget_redirects(struct tcb* tcp) {
+  if (Cde_exec_mode && cde_exec_from_outside_cderoot && redirect_cache && tcp->u_rval == 0) {
+    redircache_clear(redirect_cache);
+  }
+}
+
+
 /* standard functionality for syscalls that take a filename as first argument
 
   cde (package creation) mode:
@@ -1126,7 +1588,9 @@ void CDE_begin_standard_fileop(struct tcb* tcp, const char* syscall_name) {
     // non-existent files.
     // (Note that filename can sometimes be a JUNKY STRING due to weird race
     //  conditions when strace is tracing complex multi-process applications)
-      copy_file_into_cde_root(filename, tcp->current_dir);
+      capture_file(filename, tcp->fs->current_dir,
+                   is_metadata_only_fileop(syscall_name) ? CAPTURE_METADATA : CAPTURE_FULL,
+                   !is_write_fileop(tcp, syscall_name, 1));
     }
   }
 
@@ -1159,7 +1623,7 @@ void CDE_begin_at_fileop(struct tcb* tcp, const char* syscall_name) {
     vbprintf("[%d] BEGIN %s '%s' (dirfd=%u)\n", tcp->pid, syscall_name, filename, (unsigned int)tcp->u_arg[0]);
   }
 
-  if (!IS_ABSPATH(filename) && tcp->u_arg[0] != AT_FDCWD) {
+  if (!IS_ABSPATH(filename) && (int)tcp->u_arg[0] != AT_FDCWD) {
     fprintf(stderr,
             "CDE WARNING (unsupported operation): %s '%s' is a relative path and dirfd != AT_FDCWD\n",
             syscall_name, filename);
@@ -1176,7 +1640,9 @@ void CDE_begin_at_fileop(struct tcb* tcp, const char* syscall_name) {
     // non-existent files.
     // (Note that filename can sometimes be a JUNKY STRING due to weird race
     //  conditions when strace is tracing complex multi-process applications)
-    copy_file_into_cde_root(filename, tcp->current_dir);
+    capture_file(filename, tcp->fs->current_dir,
+                 is_metadata_only_fileop(syscall_name) ? CAPTURE_METADATA : CAPTURE_FULL,
+                 !is_write_fileop(tcp, syscall_name, 2));
   }
 
 done:
@@ -1240,7 +1706,7 @@ static void CDE_end_readlink_internal(struct tcb* tcp, int input_buffer_arg_inde
       // (note that we don't handle /proc/<pid>/cwd yet)
       else if (strcmp(filename, "/proc/self/cwd") == 0) {
         // copied from CDE_end_getcwd
-        char* sandboxed_pwd = extract_sandboxed_pwd(tcp->current_dir, tcp);
+        char* sandboxed_pwd = extract_sandboxed_pwd(tcp->fs->current_dir, tcp);
         memcpy_to_child(tcp->pid, (char*)tcp->u_arg[output_buffer_arg_index],
                         sandboxed_pwd, strlen(sandboxed_pwd) + 1);
 
@@ -1360,6 +1826,7 @@ void CDE_begin_execve(struct tcb* tcp) {
   char* ld_linux_filename = NULL;
   char* ld_linux_fullpath = NULL;
   char* opened_filename_abspath = NULL;
+  int exec_repo_ind = -1; // repo whose environment to pass to the program, if not this proc's
 
   exe_filename = strcpy_from_child(tcp, tcp->u_arg[0]);
 
@@ -1390,14 +1857,14 @@ void CDE_begin_execve(struct tcb* tcp) {
     //  since exe_filename is the script's name and NOT "/bin/bash".
     //  We will need to handle this case LATER in the function.)
     opened_filename_abspath =
-      canonicalize_path(exe_filename, extract_sandboxed_pwd(tcp->current_dir, tcp));
+      canonicalize_path(exe_filename, extract_sandboxed_pwd(tcp->fs->current_dir, tcp));
 
     // try to exec another cde - unwrap it from this cde-exec
     if (is_cde_binary(exe_filename)) {
-//      printf("detach %s\n", tcp->current_dir); // quanpt debug
+//      printf("detach %s\n", tcp->fs->current_dir); // quanpt debug
 //      // move the pwd to the path in some other repo, should be done in chdir? TOCONFIRM
-//      strcpy(tcp->current_dir, extract_sandboxed_pwd(tcp->current_dir, tcp));
-//      printf("detach2 %s\n", tcp->current_dir); // quanpt debug
+//      strcpy(tcp->fs->current_dir, extract_sandboxed_pwd(tcp->fs->current_dir, tcp));
+//      printf("detach2 %s\n", tcp->fs->current_dir); // quanpt debug
 //      tcp->isCDEprocess = 1;
       //printf("audit - cde_begin_execve: IGNORED '%s'\n", exe_filename);
       if (tcp->flags & TCB_ATTACHED) {
@@ -1419,21 +1886,25 @@ void CDE_begin_execve(struct tcb* tcp) {
       if (strcmp(opened_filename_abspath, process_ignores[i].process_name) == 0) {
         //printf("IGNORED '%s'\n", opened_filename_abspath);
         tcp->p_ignores = &process_ignores[i];
+        if (detach_ignored_process(tcp)) {
+          is_runable_count += 64;
+        }
         goto done; // TOTALLY PUNT!!!
       }
     }
 
-    redirected_path = redirect_filename_into_cderoot(exe_filename, tcp->current_dir, tcp);
+    redirected_path = redirect_filename_into_cderoot(exe_filename, tcp->fs->current_dir, tcp);
 
     // quanpt - setup env if binary is in a different package from its parent
-    int id=get_repo_path_id(opened_filename_abspath);
-    if (id >= 0 && id != tcp->current_repo_ind) {
-      CDE_load_environment_vars(multi_repo_paths[i]);
+    // (injected into the execve once the shared page is set up, below)
+    int id = get_tcb_repo_path_id(opened_filename_abspath, tcp);
+    if (id >= 0 && id != tcp->env_repo_ind) {
+      exec_repo_ind = id;
     }
   } else {
 
     // just check the file itself (REMEMBER TO GET ITS ABSOLUTE PATH!)
-    exe_filename_abspath = canonicalize_path(exe_filename, tcp->current_dir);
+    exe_filename_abspath = canonicalize_path(exe_filename, tcp->fs->current_dir);
 
     if (is_cde_binary(exe_filename_abspath)) {
       //printf("audit - cde_begin_execve: IGNORED '%s'\n", exe_filename_abspath);
@@ -1462,7 +1933,7 @@ void CDE_begin_execve(struct tcb* tcp) {
   }
   else {
     //// just check the file itself (REMEMBER TO GET ITS ABSOLUTE PATH!)
-    //exe_filename_abspath = canonicalize_path(exe_filename, tcp->current_dir);
+    //exe_filename_abspath = canonicalize_path(exe_filename, tcp->fs->current_dir);
 
     // TODO: we don't check whether it's a real executable file :/
     if (stat(exe_filename_abspath, &filename_stat) != 0) {
@@ -1504,7 +1975,10 @@ void CDE_begin_execve(struct tcb* tcp) {
     // mallocs a new string if successful
     // (this string is most likely "/lib/ld-linux.so.2")
     pthread_mutex_lock(&mut_findelf);
+    start_perf_timer(ELF_PARSING);
     ld_linux_filename = find_ELF_program_interpreter(path_to_executable);
+    stop_perf_timer(ELF_PARSING);
+    count_perf_event(ELF_FILES_PARSED, 1);
     pthread_mutex_unlock(&mut_findelf);
     if (!ld_linux_filename) {
       // if the program interpreter isn't found, then it's a static
@@ -1512,9 +1986,12 @@ void CDE_begin_execve(struct tcb* tcp) {
       if (Cde_exec_mode) {
         // redirect the executable's path to within $CDE_ROOT_DIR:
         modify_syscall_single_arg(tcp, 1, exe_filename);
+        if (tcp->childshm && exec_repo_ind >= 0) {
+          inject_repo_environment(tcp, exec_repo_ind);
+        }
       }
       else {
-        copy_file_into_cde_root(exe_filename, tcp->current_dir);
+        copy_file_into_cde_root(exe_filename, tcp->fs->current_dir);
       }
 
       // remember to EXIT EARLY!
@@ -1554,7 +2031,7 @@ void CDE_begin_execve(struct tcb* tcp) {
       // this path should look like the name in the #! line, just
       // canonicalized to be an absolute path
       char* script_command_abspath =
-        canonicalize_path(p, extract_sandboxed_pwd(tcp->current_dir, tcp));
+        canonicalize_path(p, extract_sandboxed_pwd(tcp->fs->current_dir, tcp));
 
       if (ignore_path(script_command_abspath, tcp)) {
         free(script_command_abspath);
@@ -1569,6 +2046,9 @@ void CDE_begin_execve(struct tcb* tcp) {
         if (strcmp(script_command_abspath, process_ignores[i].process_name) == 0) {
           //printf("IGNORED (script) '%s'\n", script_command_abspath);
           tcp->p_ignores = &process_ignores[i];
+          if (detach_ignored_process(tcp)) {
+            is_runable_count += 64;
+          }
           free(script_command_abspath);
           free(tmp);
           goto done; // TOTALLY PUNT!!!
@@ -1577,7 +2057,7 @@ void CDE_begin_execve(struct tcb* tcp) {
 
       free(script_command_abspath);
 
-      script_command_filename = redirect_filename_into_cderoot(p, tcp->current_dir, tcp);
+      script_command_filename = redirect_filename_into_cderoot(p, tcp->fs->current_dir, tcp);
     }
 
     if (!script_command_filename) {
@@ -1585,7 +2065,10 @@ void CDE_begin_execve(struct tcb* tcp) {
     }
 
     pthread_mutex_lock(&mut_findelf);
+    start_perf_timer(ELF_PARSING);
     ld_linux_filename = find_ELF_program_interpreter(script_command_filename);
+    stop_perf_timer(ELF_PARSING);
+    count_perf_event(ELF_FILES_PARSED, 1);
     pthread_mutex_unlock(&mut_findelf);
 
     free(script_command_filename);
@@ -1618,6 +2101,10 @@ void CDE_begin_execve(struct tcb* tcp) {
     goto done; // MUST punt early here!!!
   }
 
+  if (exec_repo_ind >= 0) {
+    inject_repo_environment(tcp, exec_repo_ind);
+  }
+
   if (Cde_exec_mode) {
 
     ld_linux_fullpath = create_abspath_within_cderoot(ld_linux_filename);
@@ -1703,7 +2190,7 @@ void CDE_begin_execve(struct tcb* tcp) {
           // redirected INSIDE of cde-root ...
           if (!CDE_use_linker_from_package) {
             char* program_full_path_in_cderoot =
-              redirect_filename_into_cderoot(tcp->perceived_program_fullpath, tcp->current_dir, tcp);
+              redirect_filename_into_cderoot(tcp->perceived_program_fullpath, tcp->fs->current_dir, tcp);
 
             strcpy(cur_loc, program_full_path_in_cderoot);
             script_command_token_starts[script_command_num_tokens] = cur_loc;
@@ -1912,7 +2399,7 @@ void CDE_begin_execve(struct tcb* tcp) {
         // create a path WITHIN cde-root, so that we can call realpath on it.
         // (otherwise this path might not exist natively on the target machine!)
         char* program_full_path_in_cderoot =
-          redirect_filename_into_cderoot(tcp->perceived_program_fullpath, tcp->current_dir, tcp);
+          redirect_filename_into_cderoot(tcp->perceived_program_fullpath, tcp->fs->current_dir, tcp);
 
         if (program_full_path_in_cderoot) {
           // realpath follows ALL symbolic links and returns the path to the TRUE binary file :)
@@ -2039,7 +2526,7 @@ void CDE_begin_execve(struct tcb* tcp) {
     if (tcp->perceived_program_fullpath) {
       char* redirected_path =
         redirect_filename_into_cderoot(tcp->perceived_program_fullpath,
-                                       tcp->current_dir, tcp);
+                                       tcp->fs->current_dir, tcp);
       // redirected_path could be NULL (e.g., if it's in cde.ignore),
       // in which case just do nothing
       if (redirected_path) {
@@ -2058,11 +2545,22 @@ void CDE_begin_execve(struct tcb* tcp) {
 
   } else {
 
-    copy_file_into_cde_root(exe_filename, tcp->current_dir);
+    copy_file_into_cde_root(exe_filename, tcp->fs->current_dir);
 
     if (ld_linux_filename) {
       // copy ld-linux.so.2 (or whatever the program interpreter is) into cde-root
-      copy_file_into_cde_root(ld_linux_filename, tcp->current_dir);
+      copy_file_into_cde_root(ld_linux_filename, tcp->fs->current_dir);
+    }
+
+    // resolve the rest of the shared libs in the background, rather than
+    // copying them one by one as ld-linux.so.2 opens them.  the child's
+    // LD_LIBRARY_PATH comes from the envp that it's exec'ing with
+    char* ld_library_path = NULL;
+    if (CDE_lib_prefetch_workers > 0) {
+      ld_library_path = getenv_from_child(tcp, (long)tcp->u_arg[2], "LD_LIBRARY_PATH");
+    }
+    if (is_elf_binary) {
+      queue_lib_prefetch(path_to_executable, ld_library_path);
     }
 
     // very subtle!  if we're executing a textual script with a #!, we
@@ -2074,12 +2572,17 @@ void CDE_begin_execve(struct tcb* tcp) {
       for (p = strtok(script_command, " "); p; p = strtok(NULL, " ")) {
         struct stat p_stat;
         if (stat(p, &p_stat) == 0) {
-          copy_file_into_cde_root(p, tcp->current_dir);
+          copy_file_into_cde_root(p, tcp->fs->current_dir);
+          queue_lib_prefetch(p, ld_library_path);
         }
         break;
       }
     }
 
+    if (ld_library_path) {
+      free(ld_library_path);
+    }
+
   }
 
 done:
@@ -2120,6 +2623,21 @@ done:
 }
 
 
+// if tcp is entering the execve of an ignored process whose procs are all
+// PI_TRACE_DETACH, then detach it (with provenance of the execve), and
+// return true
+//
+// (the proc that ptu started, which it did not attach to, stays traced, so
+// that ptu still waits for it)
+static bool detach_ignored_process(struct tcb* tcp) {
+  if (tcp->p_ignores->tracing != PI_TRACE_DETACH || !(tcp->flags & TCB_ATTACHED)) {
+    return false;
+  }
+  print_begin_execve_prov(tcp); // print provenance before ptrace disconnected
+  detach(tcp, 0);
+  return true;
+}
+
 void CDE_end_execve(struct tcb* tcp) {
   if (Cde_verbose_mode) {
     vbprintf("[%d] CDE_end_execve\n", tcp->pid);
@@ -2133,7 +2651,21 @@ void CDE_end_execve(struct tcb* tcp) {
   }
   if (tcp->u_rval == 0) {
     print_end_execve_prov(tcp);
-  }
+
+    // digimokan: like the kernel, stop sharing open files with CLONE_FILES
+    // clones (their paths are still copied on write)
+    if (tcp->files->refcount > 1) {
+      struct tcb_files* files = new_tcb_files(tcp->files);
+      put_tcb_files(tcp->files);
+      tcp->files = files;
+    }
+
+    // digimokan: an ignored process may run without syscall stops from here
+    // on (PI_TRACE_DETACH ones that could not be detached, too)
+    if (tcp->p_ignores && tcp->p_ignores->tracing != PI_TRACE_SYSCALLS) {
+      tcp->untraced = (tcp->p_ignores->tracing == PI_TRACE_CHILDREN) ? PI_TRACE_CHILDREN : PI_TRACE_NONE;
+    }
+  }
 
 }
 
@@ -2149,14 +2681,19 @@ void CDE_begin_file_unlink(struct tcb* tcp) {
     modify_syscall_single_arg(tcp, 1, filename);
   }
   else {
-    char* redirected_path = redirect_filename_into_cderoot(filename, tcp->current_dir, tcp);
+    char* redirected_path = redirect_filename_into_cderoot(filename, tcp->fs->current_dir, tcp);
     if (redirected_path) {
       unlink(redirected_path);
       free(redirected_path);
+      forget_captured_file(filename, tcp->fs->current_dir);
     }
   }
 }
 
+void CDE_end_file_unlink(struct tcb* tcp) {
+  forget_redirects(tcp);
+}
+
 // copy-and-paste from CDE_begin_file_unlink,
 // except adjusting for unlinkat signature:
 //   int unlinkat(int dirfd, const char *pathname, int flags);
@@ -2167,7 +2704,7 @@ void CDE_begin_file_unlinkat(struct tcb* tcp) {
     vbprintf("[%d] BEGIN unlinkat '%s'\n", tcp->pid, filename);
   }
 
-  if (!IS_ABSPATH(filename) && tcp->u_arg[0] != AT_FDCWD) {
+  if (!IS_ABSPATH(filename) && (int)tcp->u_arg[0] != AT_FDCWD) {
     fprintf(stderr, "CDE WARNING: unlinkat '%s' is a relative path and dirfd != AT_FDCWD\n", filename);
     return; // punt early!
   }
@@ -2176,10 +2713,11 @@ void CDE_begin_file_unlinkat(struct tcb* tcp) {
     modify_syscall_single_arg(tcp, 2, filename);
   }
   else {
-    char* redirected_path = redirect_filename_into_cderoot(filename, tcp->current_dir, tcp);
+    char* redirected_path = redirect_filename_into_cderoot(filename, tcp->fs->current_dir, tcp);
     if (redirected_path) {
       unlink(redirected_path);
       free(redirected_path);
+      forget_captured_file(filename, tcp->fs->current_dir);
     }
   }
 }
@@ -2200,13 +2738,13 @@ void CDE_begin_file_link(struct tcb* tcp) {
 
     char* filename1 = strcpy_from_child(tcp, tcp->u_arg[0]);
     char* redirected_filename1 =
-      redirect_filename_into_cderoot(filename1, tcp->current_dir, tcp);
+      redirect_filename_into_cderoot(filename1, tcp->fs->current_dir, tcp);
     // first copy the origin file into cde-root/ before trying to link it
-    copy_file_into_cde_root(filename1, tcp->current_dir);
+    copy_file_into_cde_root(filename1, tcp->fs->current_dir);
 
     char* filename2 = strcpy_from_child(tcp, tcp->u_arg[1]);
     char* redirected_filename2 =
-      redirect_filename_into_cderoot(filename2, tcp->current_dir, tcp);
+      redirect_filename_into_cderoot(filename2, tcp->fs->current_dir, tcp);
 
     link(redirected_filename1, redirected_filename2);
 
@@ -2229,13 +2767,13 @@ void CDE_begin_file_linkat(struct tcb* tcp) {
     vbprintf("[%d] BEGIN linkat(%s, %s)\n", tcp->pid, oldpath, newpath);
   }
 
-  if (!IS_ABSPATH(oldpath) && tcp->u_arg[0] != AT_FDCWD) {
+  if (!IS_ABSPATH(oldpath) && (int)tcp->u_arg[0] != AT_FDCWD) {
     fprintf(stderr,
             "CDE WARNING: linkat '%s' is a relative path and dirfd != AT_FDCWD\n",
             oldpath);
     goto done; // punt early!
   }
-  if (!IS_ABSPATH(newpath) && tcp->u_arg[2] != AT_FDCWD) {
+  if (!IS_ABSPATH(newpath) && (int)tcp->u_arg[2] != AT_FDCWD) {
     fprintf(stderr,
             "CDE WARNING: linkat '%s' is a relative path and dirfd != AT_FDCWD\n",
             newpath);
@@ -2251,11 +2789,11 @@ void CDE_begin_file_linkat(struct tcb* tcp) {
     // TODO: is this too early since the original link hasn't been done yet?
     // (I don't think so ...)
     //
-    char* redirected_oldpath = redirect_filename_into_cderoot(oldpath, tcp->current_dir, tcp);
+    char* redirected_oldpath = redirect_filename_into_cderoot(oldpath, tcp->fs->current_dir, tcp);
     // first copy the origin file into cde-root/ before trying to link it
-    copy_file_into_cde_root(oldpath, tcp->current_dir);
+    copy_file_into_cde_root(oldpath, tcp->fs->current_dir);
 
-    char* redirected_newpath = redirect_filename_into_cderoot(newpath, tcp->current_dir, tcp);
+    char* redirected_newpath = redirect_filename_into_cderoot(newpath, tcp->fs->current_dir, tcp);
 
     link(redirected_oldpath, redirected_newpath);
 
@@ -2283,7 +2821,7 @@ void CDE_begin_file_symlink(struct tcb* tcp) {
     // path should be munged to '../../lib/libc.so.6' within the CDE package???
     char* oldname = strcpy_from_child(tcp, tcp->u_arg[0]);
     char* newname = strcpy_from_child(tcp, tcp->u_arg[1]);
-    char* newname_redirected = redirect_filename_into_cderoot(newname, tcp->current_dir, tcp);
+    char* newname_redirected = redirect_filename_into_cderoot(newname, tcp->fs->current_dir, tcp);
 
     symlink(oldname, newname_redirected);
 
@@ -2304,7 +2842,7 @@ void CDE_begin_file_symlinkat(struct tcb* tcp) {
 
   char* newpath = strcpy_from_child(tcp, tcp->u_arg[2]);
 
-  if (!IS_ABSPATH(newpath) && tcp->u_arg[1] != AT_FDCWD) {
+  if (!IS_ABSPATH(newpath) && (int)tcp->u_arg[1] != AT_FDCWD) {
     fprintf(stderr, "CDE WARNING: symlinkat '%s' is a relative path and dirfd != AT_FDCWD\n", newpath);
     free(newpath);
     return; // punt early!
@@ -2315,7 +2853,7 @@ void CDE_begin_file_symlinkat(struct tcb* tcp) {
   }
   else {
     char* oldname = strcpy_from_child(tcp, tcp->u_arg[0]);
-    char* newpath_redirected = redirect_filename_into_cderoot(newpath, tcp->current_dir, tcp);
+    char* newpath_redirected = redirect_filename_into_cderoot(newpath, tcp->fs->current_dir, tcp);
     symlink(oldname, newpath_redirected);
 
     free(oldname);
@@ -2342,23 +2880,24 @@ void CDE_end_file_rename(struct tcb* tcp) {
   }
 
   if (Cde_exec_mode) {
-    // empty
+    forget_redirects(tcp);
   }
   else {
     if (tcp->u_rval == 0) {
       char* filename1 = strcpy_from_child(tcp, tcp->u_arg[0]);
       char* redirected_filename1 =
-        redirect_filename_into_cderoot(filename1, tcp->current_dir, tcp);
-      free(filename1);
+        redirect_filename_into_cderoot(filename1, tcp->fs->current_dir, tcp);
       // remove original file from cde-root/
       if (redirected_filename1) {
         unlink(redirected_filename1);
         free(redirected_filename1);
+        forget_captured_file(filename1, tcp->fs->current_dir);
       }
+      free(filename1);
 
       // copy the destination file into cde-root/
       char* dst_filename = strcpy_from_child(tcp, tcp->u_arg[1]);
-      copy_file_into_cde_root(dst_filename, tcp->current_dir);
+      copy_file_into_cde_root(dst_filename, tcp->fs->current_dir);
       free(dst_filename);
     }
   }
@@ -2376,13 +2915,13 @@ void CDE_begin_file_renameat(struct tcb* tcp) {
   char* oldpath = strcpy_from_child(tcp, tcp->u_arg[1]);
   char* newpath = strcpy_from_child(tcp, tcp->u_arg[3]);
 
-  if (!IS_ABSPATH(oldpath) && tcp->u_arg[0] != AT_FDCWD) {
+  if (!IS_ABSPATH(oldpath) && (int)tcp->u_arg[0] != AT_FDCWD) {
     fprintf(stderr,
             "CDE WARNING: renameat '%s' is a relative path and dirfd != AT_FDCWD\n",
             oldpath);
     goto done; // punt early!
   }
-  if (!IS_ABSPATH(newpath) && tcp->u_arg[2] != AT_FDCWD) {
+  if (!IS_ABSPATH(newpath) && (int)tcp->u_arg[2] != AT_FDCWD) {
     fprintf(stderr,
             "CDE WARNING: renameat '%s' is a relative path and dirfd != AT_FDCWD\n",
             newpath);
@@ -2404,23 +2943,24 @@ void CDE_end_file_renameat(struct tcb* tcp) {
   }
 
   if (Cde_exec_mode) {
-    // empty
+    forget_redirects(tcp);
   }
   else {
     if (tcp->u_rval == 0) {
       char* filename1 = strcpy_from_child(tcp, tcp->u_arg[1]);
       char* redirected_filename1 =
-        redirect_filename_into_cderoot(filename1, tcp->current_dir, tcp);
-      free(filename1);
+        redirect_filename_into_cderoot(filename1, tcp->fs->current_dir, tcp);
       // remove original file from cde-root/
       if (redirected_filename1) {
         unlink(redirected_filename1);
         free(redirected_filename1);
+        forget_captured_file(filename1, tcp->fs->current_dir);
       }
+      free(filename1);
 
       // copy the destination file into cde-root/
       char* dst_filename = strcpy_from_child(tcp, tcp->u_arg[3]);
-      copy_file_into_cde_root(dst_filename, tcp->current_dir);
+      copy_file_into_cde_root(dst_filename, tcp->fs->current_dir);
       free(dst_filename);
     }
   }
@@ -2434,7 +2974,7 @@ void CDE_begin_chdir(struct tcb* tcp) {
 void CDE_end_fchdir(struct tcb* tcp);
 
 void CDE_end_chdir(struct tcb* tcp) {
-  CDE_end_fchdir(tcp); // this will update tcp->current_dir
+  CDE_end_fchdir(tcp); // this will update tcp->fs->current_dir
 }
 
 void CDE_end_fchdir(struct tcb* tcp) {
@@ -2445,11 +2985,13 @@ void CDE_end_fchdir(struct tcb* tcp) {
     // A reliable way to get the current directory is using /proc/<pid>/cwd
     char* cwd_symlink_name = format("/proc/%d/cwd", tcp->pid);
 
-    tcp->current_dir[0] = '\0';
-    int len = readlink(cwd_symlink_name, tcp->current_dir, MAXPATHLEN);
-    assert(tcp->current_dir[0] != '\0');
+    char cwd[MAXPATHLEN];
+    cwd[0] = '\0';
+    int len = readlink(cwd_symlink_name, cwd, MAXPATHLEN - 1);
+    assert(cwd[0] != '\0');
     assert(len >= 0);
-    tcp->current_dir[len] = '\0'; // wow, readlink doesn't put the cap on the end!!!
+    cwd[len] = '\0'; // wow, readlink doesn't put the cap on the end!!!
+    set_current_dir(tcp->fs, cwd); // digimokan: stop sharing it with forked procs
 
     free(cwd_symlink_name);
 
@@ -2457,13 +2999,13 @@ void CDE_end_fchdir(struct tcb* tcp) {
     // now copy into cde-root/ if necessary
     if (!Cde_exec_mode) {
       char* redirected_path =
-        redirect_filename_into_cderoot(tcp->current_dir, tcp->current_dir, tcp);
-      if (redirected_path && get_repo_path_id(tcp->current_dir)<0) {
-        make_mirror_dirs_in_cde_package(tcp->current_dir, 0);
+        redirect_filename_into_cderoot(tcp->fs->current_dir, tcp->fs->current_dir, tcp);
+      if (redirected_path && get_repo_path_id(tcp->fs->current_dir)<0) {
+        make_mirror_dirs_in_cde_package(tcp->fs->current_dir, 0);
         free(redirected_path);
       }
     } else { // quanpt - update repo id of current tcp
-      tcp->current_repo_ind = get_repo_path_id(tcp->current_dir);
+      tcp->fs->current_repo_ind = get_tcb_repo_path_id(tcp->fs->current_dir, tcp);
     }
   }
 }
@@ -2487,7 +3029,7 @@ void CDE_end_mkdir(struct tcb* tcp, int input_buffer_arg_index) {
     if ((tcp->u_rval == 0) || (tcp->u_rval == EEXIST)) {
       // sometimes mkdir is called with a BOGUS argument, so silently skip those cases
       char* dirname_arg = strcpy_from_child(tcp, tcp->u_arg[input_buffer_arg_index]);
-      char* dirname_abspath = canonicalize_path(dirname_arg, tcp->current_dir);
+      char* dirname_abspath = canonicalize_path(dirname_arg, tcp->fs->current_dir);
       make_mirror_dirs_in_cde_package(dirname_abspath, 0);
       free(dirname_abspath);
       free(dirname_arg);
@@ -2517,13 +3059,13 @@ void CDE_end_rmdir(struct tcb* tcp, int input_buffer_arg_index) {
   }
 
   if (Cde_exec_mode) {
-    // empty
+    forget_redirects(tcp);
   }
   else {
     if (tcp->u_rval == 0) {
       char* dirname_arg = strcpy_from_child(tcp, tcp->u_arg[input_buffer_arg_index]);
       char* redirected_path =
-        redirect_filename_into_cderoot(dirname_arg, tcp->current_dir, tcp);
+        redirect_filename_into_cderoot(dirname_arg, tcp->fs->current_dir, tcp);
       if (redirected_path) {
         rmdir(redirected_path);
         free(redirected_path);
@@ -2602,9 +3144,32 @@ static void* find_free_addr(int pid, int prot, unsigned long size) {
 //
 // WARNING: this code is very tricky and gross!
 static void begin_setup_shmat(struct tcb* tcp) {
-  assert(tcp->localshm);
   assert(!tcp->childshm); // avoid duplicate calls
 
+  // digimokan: create the segment (and attach our end) on first use
+  if (!tcp->localshm) {
+    key_t key;
+    // randomly probe for a valid shm key
+    do {
+      errno = 0;
+      key = rand();
+      tcp->shmid = shmget(key, shared_page_size, IPC_CREAT|IPC_EXCL|0600);
+    } while (tcp->shmid == -1 && errno == EEXIST);
+
+    tcp->localshm = (char*)shmat(tcp->shmid, NULL, 0);
+
+    if ((long)tcp->localshm == -1) {
+      perror("shmat");
+      exit(1);
+    }
+
+    if (shmctl(tcp->shmid, IPC_RMID, NULL) == -1) {
+      perror("shmctl(IPC_RMID)");
+      exit(1);
+    }
+  }
+  assert(tcp->localshm);
+
   // stash away original registers so that we can restore them later
   struct user_regs_struct cur_regs;
   EXITIF(ptrace(PTRACE_GETREGS, tcp->pid, NULL, (long)&cur_regs) < 0);
@@ -2778,10 +3343,41 @@ char* strcpy_from_child(struct tcb* tcp, long addr) {
   return ret;
 }
 
+// look up the env var 'name' in an envp array in the child's address space
+// (e.g., the 3rd arg of execve), and malloc a copy of its value.
+// returns NULL if not found
+static char* getenv_from_child(struct tcb* tcp, long child_envp, const char* name) {
+  int name_len = strlen(name);
+  int i;
+  for (i = 0; child_envp; i++) {
+    char* cur_env = NULL;
+    if (umoven(tcp, child_envp + (i * personality_wordsize[current_personality]),
+               personality_wordsize[current_personality], (void*)&cur_env) < 0) {
+      return NULL;
+    }
+    if (cur_env == NULL) {
+      return NULL;
+    }
+
+    char* env_str = strcpy_from_child_or_null(tcp, (long)cur_env);
+    if (env_str && strncmp(env_str, name, name_len) == 0 && env_str[name_len] == '=') {
+      char* val = strdup(env_str + name_len + 1);
+      free(env_str);
+      return val;
+    }
+    free(env_str);
+  }
+  return NULL;
+}
+
 
 // adapted from the Goanna project by Spillane et al.
 // dst_in_child is a pointer in the child's address space
 void memcpy_to_child(int pid, char* dst_child, char* src, int size) {
+  if (Sysprofile_mode) {
+    sysprofile_count_child_write(size);
+  }
+
   while (size >= sizeof(int)) {
     long w = *((long*)src);
     EXITIF(ptrace(PTRACE_POKEDATA, pid, dst_child, (long)w) < 0);
@@ -2819,7 +3415,7 @@ void memcpy_to_child(int pid, char* dst_child, char* src, int size) {
 void CDE_end_getcwd(struct tcb* tcp) {
   if (!syserror(tcp)) {
     if (Cde_exec_mode) {
-      char* sandboxed_pwd = extract_sandboxed_pwd(tcp->current_dir, tcp);
+      char* sandboxed_pwd = extract_sandboxed_pwd(tcp->fs->current_dir, tcp);
       memcpy_to_child(tcp->pid, (char*)tcp->u_arg[0],
                       sandboxed_pwd, strlen(sandboxed_pwd) + 1);
 
@@ -2832,9 +3428,11 @@ void CDE_end_getcwd(struct tcb* tcp) {
     }
     else {
       char* tmp = strcpy_from_child(tcp, tcp->u_arg[0]);
-      strcpy(tcp->current_dir, tmp);
+      if (strcmp(tmp, tcp->fs->current_dir) != 0) { // (don't copy an unchanged shared cwd)
+        set_current_dir(tcp->fs, tmp);
+      }
       free(tmp);
-      //printf("[%d] CDE_end_getcwd: %s\n", tcp->pid, tcp->current_dir);
+      //printf("[%d] CDE_end_getcwd: %s\n", tcp->pid, tcp->fs->current_dir);
     }
   }
 }
@@ -2847,13 +3445,13 @@ void CDE_end_getcwd(struct tcb* tcp) {
 // 'bin' in cde-root/ and point it to ./KNOPPIX/bin
 //
 // DO THIS AT THE VERY BEGINNING OF EXECUTION!
-static void CDE_create_path_symlink_dirs() {
-  char *p;
+static void CDE_create_path_symlink_dirs(const char* path_envvar) {
+  const char *p;
   int m, n;
   struct stat st;
   char tmp_buf[MAXPATHLEN];
 
-  for (p = getenv("PATH"); p && *p; p += m) {
+  for (p = path_envvar; p && *p; p += m) {
     if (strchr(p, ':')) {
       n = strchr(p, ':') - p;
       m = n + 1;
@@ -2944,29 +3542,72 @@ static void CDE_create_toplevel_symlink_dirs() {
 }
 
 
-void CDE_init_tcb_dir_fields(struct tcb* tcp) {
-  // malloc new entries, and then decide whether to inherit from parent
-  // process entry or directly initialize
-  assert(!tcp->current_dir);
-  tcp->current_dir = malloc(MAXPATHLEN); // big boy!
+// clone_flags: flags of the clone() that created tcp (0 if it was fork()ed)
+void CDE_init_tcb_dir_fields(struct tcb* tcp, unsigned long clone_flags) {
+  // share entries of the parent process entry (for clone(CLONE_FS/CLONE_FILES))
+  // or copy them on write (for fork()), as the kernel does, or directly initialize
+  assert(!tcp->fs && !tcp->files);
 
   // if parent exists, then its fields MUST be legit, so grab them
   if (tcp->parent) {
-    assert(tcp->parent->current_dir);
-    strcpy(tcp->current_dir, tcp->parent->current_dir);
-    //printf("inherited %s [%d]\n", tcp->current_dir, tcp->pid);
-    tcp->current_repo_ind = tcp->parent->current_repo_ind; // quanpt
+    assert(tcp->parent->fs && tcp->parent->files);
+    pthread_mutex_lock(&tcb_fs_mut);
+    if (clone_flags & CLONE_FS) {
+      tcp->fs = tcp->parent->fs;
+      tcp->fs->refcount++;
+    }
+    else {
+      tcp->fs = new_tcb_fs(tcp->parent->fs);
+    }
+    pthread_mutex_unlock(&tcb_fs_mut);
+    if (clone_flags & CLONE_FILES) {
+      tcp->files = tcp->parent->files;
+      tcp->files->refcount++;
+    }
+    else {
+      tcp->files = new_tcb_files(tcp->parent->files);
+    }
+    //printf("inherited %s [%d]\n", tcp->fs->current_dir, tcp->pid);
+    tcp->env_repo_ind = tcp->parent->env_repo_ind;
 
     // inherit from parent since you're executing the same program after
     // forking (at least until you do an exec)
     tcp->p_ignores = tcp->parent->p_ignores;
+
+    // digimokan: procs forked by an untraced proc are traced (unless it is
+    // PI_TRACE_NONE), but since its chdir()s went unseen, ask for their pwd.
+    // its threads run the same program, so are untraced like it
+    if (tcp->parent->untraced == PI_TRACE_NONE ||
+        (tcp->parent->untraced && (clone_flags & CLONE_THREAD))) {
+      tcp->untraced = tcp->parent->untraced;
+    }
+    else if (tcp->parent->untraced) {
+      char* cwd_link = format("/proc/%d/cwd", tcp->pid);
+      char cwd[MAXPATHLEN];
+      ssize_t len = readlink(cwd_link, cwd, sizeof(cwd) - 1);
+      free(cwd_link);
+      if (len > 0) {
+        cwd[len] = '\0';
+        set_current_dir(tcp->fs, cwd);
+        tcp->fs->current_repo_ind = get_repo_path_id(tcp->fs->current_dir);
+      }
+    }
   }
   else {
     // otherwise create fresh fields derived from master (cde) process
-    getcwd(tcp->current_dir, MAXPATHLEN);
-    //printf("fresh %s [%d]\n", tcp->current_dir, tcp->pid);
-    tcp->current_repo_ind = get_repo_path_id(tcp->current_dir); // quanpt
-    //printf("rid %s %d\n", tcp->current_dir, tcp->current_repo_ind);
+    char cwd[MAXPATHLEN];
+    struct tcb_fs* fs = new_tcb_fs(NULL);
+    if (getcwd(cwd, MAXPATHLEN)) {
+      set_current_dir(fs, cwd);
+    }
+    pthread_mutex_lock(&tcb_fs_mut);
+    tcp->fs = fs;
+    pthread_mutex_unlock(&tcb_fs_mut);
+    tcp->files = new_tcb_files(NULL);
+    //printf("fresh %s [%d]\n", tcp->fs->current_dir, tcp->pid);
+    tcp->fs->current_repo_ind = get_repo_path_id(tcp->fs->current_dir); // quanpt
+    tcp->env_repo_ind = tcp->fs->current_repo_ind;
+    //printf("rid %s %d\n", tcp->fs->current_dir, tcp->fs->current_repo_ind);
   }
 
 
@@ -2981,6 +3622,68 @@ void CDE_init_tcb_dir_fields(struct tcb* tcp) {
 }
 
 
+// load cached_files_trie from locally-cached-files.txt (only relevant for
+// "cde-exec -s")
+static void load_cached_files_trie(void) {
+  cached_files_trie = TrieNew();
+
+  char* p = format("%s/../locally-cached-files.txt", cde_cderoot_dir);
+  cached_files_fp = fopen(p, "r");
+
+  if (cached_files_fp) {
+    char* line = NULL;
+    size_t len = 0;
+    ssize_t read;
+    while ((read = getline(&line, &len, cached_files_fp)) != -1) {
+      assert(line[read-1] == '\n');
+      line[read-1] = '\0'; // strip of trailing newline
+      if (line[0] != '\0') {
+        // pre-seed cached_files_trie:
+        TrieInsert(cached_files_trie, line);
+      }
+    }
+    fclose(cached_files_fp);
+  }
+
+  // always open in append mode so that we can be ready to add more
+  // entries on subsequent runs ...
+  cached_files_fp = fopen(p, "a");
+
+  free(p);
+}
+
+// open the startup snapshot of the package, if it was saved from the same
+// cde-exec, cde.options, and full environment on this kernel, else start
+// building a new one (you must run this AFTER CDE_init_pseudo_root_dir())
+static void CDE_open_startup_snapshot(void) {
+  assert(Cde_exec_mode && *cde_cderoot_dir);
+
+  uint64_t key = STARTSNAP_HASH_INIT;
+  key = startsnap_hash_file(key, CDE_proc_self_exe);
+  char* options_file = format("%s/../cde.options", cde_cderoot_dir);
+  key = startsnap_hash_file(key, options_file);
+  free(options_file);
+  char* env_file = format("%s/../cde.full-environment.%s", cde_cderoot_dir, CDE_ROOT_NAME);
+  key = startsnap_hash_file(key, env_file);
+  free(env_file);
+  // (the PTRACE_SETOPTIONS probe result depends on the kernel)
+  struct utsname uname_info;
+  if (uname(&uname_info) >= 0) {
+    key = startsnap_hash(key, uname_info.release, strlen(uname_info.release));
+    key = startsnap_hash(key, uname_info.version, strlen(uname_info.version));
+    key = startsnap_hash(key, uname_info.machine, strlen(uname_info.machine));
+  }
+  startup_snap_key = key;
+
+  char* snap_file = format("%s/../cde.startup.%s", cde_cderoot_dir, CDE_ROOT_NAME);
+  startup_snap = startsnap_open(snap_file, key);
+  free(snap_file);
+  if (!startup_snap) {
+    startup_snap_writer = startsnap_writer_new();
+  }
+  vbp(1, "startup snapshot: %s\n", startup_snap ? "hit" : "miss");
+}
+
 // find the absolute path to the cde-root/ directory, since that
 // will be where our fake filesystem starts.  e.g., if our real pwd is:
 //   /home/bob/cde-package/cde-root/home/alice/cool-experiment
@@ -3053,6 +3756,64 @@ void CDE_init_pseudo_root_dir() {
 }
 
 
+// called by libdeps prefetch workers (NOT the tracer thread) on each shared lib
+static void prefetch_lib_into_cde_root(char* lib_abspath) {
+  vbp(2, "prefetch lib: %s\n", lib_abspath);
+  copy_file_into_cde_root(lib_abspath, cde_starting_pwd);
+}
+
+// write the files of the package that the audit itself does not need (cde-exec,
+// convenience scripts, cde.log, full environment), on package_files_thread
+// while the app starts up
+static void* CDE_create_package_files(void* arg) {
+  (void)arg;
+  // pgbovine - copy 'cde' executable to CDE_PACKAGE_DIR and rename
+  // it 'cde-exec', so that it can be included in the executable
+  //
+  // use /proc/self/exe since argv[0] might be simply 'cde'
+  // (if the cde binary is in $PATH and we're invoking it only by its name)
+  char* fn = format("%s/cde-exec", CDE_PACKAGE_DIR);
+  okapi_copy_file((char*)"/proc/self/exe", fn, 0777);
+  free(fn);
+
+  CDE_create_convenience_scripts(package_files_argv, package_files_optind);
+
+
+  // make a cde.log file that contains commands to reproduce original
+  // run within cde-package
+  struct stat tmp;
+  FILE* log_f;
+  char* log_filename = format("%s/cde.log", CDE_PACKAGE_DIR);
+  if (stat(log_filename, &tmp)) {
+    log_f = fopen(log_filename, "w");
+    fprintf(log_f, "cd '%s%s'", CDE_ROOT_NAME, cde_starting_pwd);
+    fputc('\n', log_f);
+  }
+  else {
+    log_f = fopen(log_filename, "a");
+  }
+  free(log_filename);
+
+  // write cmd name to cde.log, quoting it if it contains unsafe chars
+  char* safed_cmd = malloc_quoted_arg_str(basename(package_files_argv[package_files_optind]));
+  fprintf(log_f, "./%s.cde", safed_cmd);
+  free(safed_cmd);
+  // write cmd args to cde.log, quoting any that contain unsafe chars
+  for (int i = package_files_optind + 1; package_files_argv[i] != NULL; i++) {
+    char* safed_arg = malloc_quoted_arg_str(package_files_argv[i]);
+    fprintf(log_f, " %s", safed_arg);
+    free(safed_arg);
+  }
+  fputc('\n', log_f);
+  fclose(log_f);
+
+  // copy /proc/self/environ to capture the FULL set of environment vars
+  char* fullenviron_fn = format("%s/cde.full-environment.%s", CDE_PACKAGE_DIR, CDE_ROOT_NAME);
+  okapi_copy_file((char*)"/proc/self/environ", fullenviron_fn, 0666);
+  free(fullenviron_fn);
+  return NULL;
+}
+
 // pgbovine - do all CDE initialization here after command-line options
 // have been processed (argv[optind] is the name of the target program)
 void CDE_init(char** argv, int optind) {
@@ -3086,6 +3847,7 @@ void CDE_init(char** argv, int optind) {
   if (Cde_exec_mode) {
     // must do this before running CDE_init_options()
     CDE_init_pseudo_root_dir();
+    CDE_open_startup_snapshot();
 
     if (CDE_exec_streaming_mode) {
       char* tmp = strdup(cde_cderoot_dir);
@@ -3101,32 +3863,9 @@ void CDE_init(char** argv, int optind) {
         exit(1);
       }
 
-      // initialize trie
-      cached_files_trie = TrieNew();
-
-      char* p = format("%s/../locally-cached-files.txt", cde_cderoot_dir);
-      cached_files_fp = fopen(p, "r");
-
-      if (cached_files_fp) {
-        char* line = NULL;
-        size_t len = 0;
-        ssize_t read;
-        while ((read = getline(&line, &len, cached_files_fp)) != -1) {
-          assert(line[read-1] == '\n');
-          line[read-1] = '\0'; // strip of trailing newline
-          if (line[0] != '\0') {
-            // pre-seed cached_files_trie:
-            TrieInsert(cached_files_trie, line);
-          }
-        }
-        fclose(cached_files_fp);
-      }
-
-      // always open in append mode so that we can be ready to add more
-      // entries on subsequent runs ...
-      cached_files_fp = fopen(p, "a");
-
-      free(p);
+      // (cached_files_trie is loaded when first needed, by
+      // load_cached_files_trie(), so commands that touch no remote
+      // files start without reading it)
     }
 
   }
@@ -3222,6 +3961,13 @@ void CDE_init(char** argv, int optind) {
       fputs("#ignore_exact=/etc/ld.so.preload\n", f);
       fputs("#ignore_exact=/etc/ld.so.nohwcap\n", f);
 
+      fputs("\n# un-comment to only capture the size/mode/times of files that are\n", f);
+      fputs("# stat()-ed but never read, and to leave huge files on the real system:\n", f);
+      fputs("#capture_policy=metadata_placeholders\n", f);
+      fputs("#reference_files_larger_than=1G\n", f);
+      fputs("# un-comment to copy files in bulk when the app exits, rather than as it runs:\n", f);
+      fputs("#capture_timing=deferred\n", f);
+
       fputs("\n# Ignore .Xauthority to allow X Windows programs to work\n", f);
       fputs("ignore_substr=.Xauthority\n", f);
 
@@ -3278,58 +4024,318 @@ void CDE_init(char** argv, int optind) {
   CDE_init_options();
 
   if (!Cde_exec_mode) {
-    // pgbovine - copy 'cde' executable to CDE_PACKAGE_DIR and rename
-    // it 'cde-exec', so that it can be included in the executable
-    //
-    // use /proc/self/exe since argv[0] might be simply 'cde'
-    // (if the cde binary is in $PATH and we're invoking it only by its name)
-    char* fn = format("%s/cde-exec", CDE_PACKAGE_DIR);
-    okapi_copy_file((char*)"/proc/self/exe", fn, 0777);
-    free(fn);
+    if (!Prov_no_app_capture) {
+      CDE_load_placeholder_paths();
+      CDE_load_capture_manifest();
+    }
 
-    CDE_create_convenience_scripts(argv, optind);
+    // mirror the symlinked dirs of $PATH and / before the app starts, since
+    // the paths it captures go through them
+    CDE_create_path_symlink_dirs(getenv("PATH"));
+    CDE_create_toplevel_symlink_dirs();
 
+    // start threads that copy shared lib closures as soon as execve is seen
+    if (!Prov_no_app_capture) {
+      start_lib_prefetch(CDE_lib_prefetch_workers, prefetch_lib_into_cde_root);
+    }
 
-    // make a cde.log file that contains commands to reproduce original
-    // run within cde-package
-    struct stat tmp;
-    FILE* log_f;
-    char* log_filename = format("%s/cde.log", CDE_PACKAGE_DIR);
-    if (stat(log_filename, &tmp)) {
-      log_f = fopen(log_filename, "w");
-      fprintf(log_f, "cd '%s%s'", CDE_ROOT_NAME, cde_starting_pwd);
-      fputc('\n', log_f);
+    package_files_argv = argv;
+    package_files_optind = optind;
+    package_files_thread_started =
+      (pthread_create(&package_files_thread, NULL, CDE_create_package_files, NULL) == 0);
+    if (!package_files_thread_started) {
+      CDE_create_package_files(NULL);
     }
-    else {
-      log_f = fopen(log_filename, "a");
+  }
+}
+
+
+// replace the host's ld.so.cache in cde-root/ with one that lists only the
+// libs in the package, so that during cde-exec, the packaged ld-linux.so.2
+// opens each lib directly, rather than probing every dir on its search path
+static void CDE_create_ld_so_cache(void) {
+  char* etc_dir = format("%s/etc", CDE_ROOT_DIR);
+  mkdir(etc_dir, 0777);
+  char* cache_fn = format("%s/ld.so.cache", etc_dir);
+
+  int nlibs = write_ld_so_cache(CDE_ROOT_DIR, cache_fn);
+  vbp(1, "wrote %d libs to %s\n", nlibs, cache_fn);
+
+  // make sure cde-exec redirects /etc/ld.so.cache into cde-root/, even if
+  // the user un-comments the 'ignore_exact=/etc/ld.so.cache' default
+  if (nlibs >= 0) {
+    if (!pathrules_match_exact(&redirect_rules, "/etc/ld.so.cache")) {
+      char* options_fn = format("%s/cde.options", CDE_PACKAGE_DIR);
+      FILE* f = fopen(options_fn, "a");
+      if (f) {
+        fputs("\n# ld.so.cache generated by cde for the libs within cde-root/\n", f);
+        fputs("redirect_exact=/etc/ld.so.cache\n", f);
+        fclose(f);
+      }
+      free(options_fn);
     }
-    free(log_filename);
+  }
+
+  free(cache_fn);
+  free(etc_dir);
+}
 
-    // write cmd name to cde.log, quoting it if it contains unsafe chars
-    char* safed_cmd = malloc_quoted_arg_str(basename(argv[optind]));
-    fprintf(log_f, "./%s.cde", safed_cmd);
-    free(safed_cmd);
-    // write cmd args to cde.log, quoting any that contain unsafe chars
-    for (int i = optind + 1; argv[i] != NULL; i++) {
-      char* safed_arg = malloc_quoted_arg_str(argv[i]);
-      fprintf(log_f, " %s", safed_arg);
-      free(safed_arg);
+// placeholders from an earlier audit into the same package must still be
+// replaced by full copies if this audit reads them
+static void CDE_load_placeholder_paths(void) {
+  char* fn = format("%s/cde.placeholders", CDE_PACKAGE_DIR);
+  FILE* f = fopen(fn, "r");
+  free(fn);
+  if (!f) {
+    return;
+  }
+
+  char* line = NULL;
+  size_t len = 0;
+  ssize_t read;
+  while ((read = getline(&line, &len, f)) != -1) {
+    if (read > 0 && line[read-1] == '\n') {
+      line[read-1] = '\0';
     }
-    fputc('\n', log_f);
-    fclose(log_f);
+    if (IS_ABSPATH(line)) {
+      strmap_put(placeholder_paths, line, NULL);
+    }
+  }
+  free(line);
+  fclose(f);
+}
 
-    CDE_create_path_symlink_dirs();
+// load cde.manifest, which lists the files that earlier audits into this
+// package have fully copied into cde-root/
+static void CDE_load_capture_manifest(void) {
+  struct stat root_stat;
+  stat(CDE_ROOT_DIR, &root_stat);
+
+  char* fn = format("%s/cde.manifest", CDE_PACKAGE_DIR);
+  manifest_free(capture_manifest);
+  capture_manifest = manifest_load(fn, &root_stat);
+  vbp(1, "loaded %d entries from %s\n", (int)strmap_size(capture_manifest), fn);
+  free(fn);
+}
 
-    CDE_create_toplevel_symlink_dirs();
+// hash the cde-root/ copy of each file captured during this audit
+static void hash_manifest_entry(const char* path, void* val, void* arg) {
+  (void)arg;
+  ManifestEntry* entry = (ManifestEntry*)val;
+  if (entry->touched && !entry->has_hash) {
+    char* dst_path = format("%s%s", CDE_ROOT_DIR, path);
+    entry->has_hash = (hash_file_contents(dst_path, &entry->hash) == 0);
+    free(dst_path);
+  }
+}
+
+// save cde.manifest, and list the captured files that this audit did not
+// access in cde.untouched
+static void CDE_save_capture_manifest(void) {
+  struct stat root_stat;
+  if (stat(CDE_ROOT_DIR, &root_stat) != 0) {
+    return;
+  }
+
+  strmap_foreach(capture_manifest, hash_manifest_entry, NULL);
+
+  char* untouched_fn = format("%s/cde.untouched", CDE_PACKAGE_DIR);
+  manifest_save_untouched(capture_manifest, untouched_fn);
+  free(untouched_fn);
+
+  char* fn = format("%s/cde.manifest", CDE_PACKAGE_DIR);
+  if (manifest_save(capture_manifest, fn, &root_stat) != 0) {
+    fprintf(stderr, "WARNING: cannot save capture manifest to '%s'\n", fn);
+  }
+  free(fn);
+}
+
+static void save_placeholder_path(const char* path, void* val, void* f) {
+  (void)val;
+  fprintf((FILE*)f, "%s\n", path);
+}
+
+static void count_referenced_path(const char* path, void* added_by_audit, void* count) {
+  (void)path;
+  if (added_by_audit) {
+    (*(int*)count)++;
+  }
+}
+
+static void save_referenced_path(const char* path, void* added_by_audit, void* f) {
+  if (added_by_audit) {
+    fprintf((FILE*)f, "reference_exact=%s\n", path);
+  }
+}
+
+// list placeholders in cde.placeholders, and make cde-exec use files that
+// were too big to copy from the real system
+static void CDE_save_capture_policy_state(void) {
+  char* fn = format("%s/cde.placeholders", CDE_PACKAGE_DIR);
+  if (strmap_size(placeholder_paths) > 0) {
+    FILE* f = fopen(fn, "w");
+    if (f) {
+      strmap_foreach(placeholder_paths, save_placeholder_path, f);
+      fclose(f);
+    }
+  }
+  else {
+    unlink(fn);
+  }
+  free(fn);
+
+  int num_referenced = 0;
+  strmap_foreach(referenced_paths, count_referenced_path, &num_referenced);
+  if (num_referenced == 0) {
+    return;
+  }
+
+  char* options_fn = format("%s/cde.options", CDE_PACKAGE_DIR);
+  FILE* f = fopen(options_fn, "a");
+  if (f) {
+    fputs("\n# files bigger than reference_files_larger_than, so not copied into cde-root/\n", f);
+    strmap_foreach(referenced_paths, save_referenced_path, f);
+    fclose(f);
+  }
+  free(options_fn);
+}
+
+typedef struct {
+  char* path;
+  intptr_t kind;
+  dev_t dev;
+  ino_t ino;
+} DeferredCapture;
+
+static DeferredCapture* deferred_list = NULL;
+static int deferred_list_len = 0;
+static int deferred_list_next = 0;   // next entry for a capture thread to take
+
+static void collect_deferred_capture(const char* path, void* kind, void* arg) {
+  (void)arg;
+  deferred_list[deferred_list_len].path = strdup(path);
+  deferred_list[deferred_list_len].kind = (intptr_t)kind;
+  deferred_list_len++;
+}
+
+static int compare_deferred_paths(const void* a, const void* b) {
+  return strcmp(((const DeferredCapture*)a)->path, ((const DeferredCapture*)b)->path);
+}
+
+// files are copied in (dev, inode) order, which mostly follows their order on disk
+static int compare_deferred_inodes(const void* a, const void* b) {
+  const DeferredCapture* d1 = (const DeferredCapture*)a;
+  const DeferredCapture* d2 = (const DeferredCapture*)b;
+  if (d1->dev != d2->dev) {
+    return (d1->dev < d2->dev) ? -1 : 1;
+  }
+  if (d1->ino != d2->ino) {
+    return (d1->ino < d2->ino) ? -1 : 1;
+  }
+  return 0;
+}
+
+static void* deferred_capture_worker(void* arg) {
+  (void)arg;
+  int i;
+  while ((i = __sync_fetch_and_add(&deferred_list_next, 1)) < deferred_list_len) {
+    if (deferred_list[i].kind == CAPTURE_METADATA) {
+      capture_file_metadata_abspath(deferred_list[i].path);
+    }
+    else {
+      capture_file_abspath(deferred_list[i].path);
+    }
+  }
+  return NULL;
+}
+
+// with 'capture_timing=deferred', capture every file recorded during the
+// audit: create all their dirs in one sorted pass, then copy the files in
+// (dev, inode) order using CDE_lib_prefetch_workers threads
+static void CDE_finish_deferred_captures(void) {
+  // from now on, capture files right away
+  capture_deferred = 0;
+
+  deferred_list = (DeferredCapture*)malloc((strmap_size(deferred_captures) + 1) * sizeof(DeferredCapture));
+  deferred_list_len = 0;
+  deferred_list_next = 0;
+  strmap_foreach(deferred_captures, collect_deferred_capture, NULL);
+  strmap_free(deferred_captures, NULL);
+  deferred_captures = strmap_new();
+
+  vbp(1, "capturing %d deferred files\n", deferred_list_len);
+
+  // siblings are adjacent once sorted, so each dir is mirrored only once
+  qsort(deferred_list, deferred_list_len, sizeof(DeferredCapture), compare_deferred_paths);
+  char* prev_dir = NULL;
+  for (int i = 0; i < deferred_list_len; i++) {
+    char* path = deferred_list[i].path;
+    struct stat st;
+    if (lstat(path, &st) != 0) {
+      // okapi skips missing files, so don't create their dirs either
+      deferred_list[i].dev = 0;
+      deferred_list[i].ino = 0;
+      continue;
+    }
+    deferred_list[i].dev = st.st_dev;
+    deferred_list[i].ino = st.st_ino;
+
+    size_t dir_len = strrchr(path, '/') - path;
+    if (!prev_dir || strlen(prev_dir) != dir_len || strncmp(prev_dir, path, dir_len) != 0) {
+      make_mirror_dirs_in_cde_package(path, 1);
+      free(prev_dir);
+      prev_dir = strndup(path, dir_len);
+    }
+  }
+  free(prev_dir);
+
+  qsort(deferred_list, deferred_list_len, sizeof(DeferredCapture), compare_deferred_inodes);
 
+  int num_workers = (CDE_lib_prefetch_workers > 0) ? CDE_lib_prefetch_workers : 1;
+  pthread_t* workers = (pthread_t*)malloc(num_workers * sizeof(pthread_t));
+  int num_started = 0;
+  for (int i = 0; i < num_workers; i++) {
+    if (pthread_create(&workers[num_started], NULL, deferred_capture_worker, NULL) == 0) {
+      num_started++;
+    }
+  }
+  if (num_started == 0) {
+    deferred_capture_worker(NULL);
+  }
+  for (int i = 0; i < num_started; i++) {
+    pthread_join(workers[i], NULL);
+  }
+  free(workers);
 
-    // copy /proc/self/environ to capture the FULL set of environment vars
-    char* fullenviron_fn = format("%s/cde.full-environment.%s", CDE_PACKAGE_DIR, CDE_ROOT_NAME);
-    okapi_copy_file((char*)"/proc/self/environ", fullenviron_fn, 0666);
-    free(fullenviron_fn);
+  for (int i = 0; i < deferred_list_len; i++) {
+    free(deferred_list[i].path);
   }
+  free(deferred_list);
+  deferred_list = NULL;
+  deferred_list_len = 0;
+  ctlsock_clear_pending_copies();
+}
 
+// do all CDE work that must finish before exit, after the traced app is done
+void CDE_finish(void) {
+  if (!Cde_exec_mode) {
+    // wait for background copies, so that the package is complete on exit
+    if (package_files_thread_started) {
+      pthread_join(package_files_thread, NULL);
+      package_files_thread_started = false;
+    }
+    finish_lib_prefetch();
+
+    if (capture_deferred && !Prov_no_app_capture) {
+      CDE_finish_deferred_captures();
+    }
 
+    if (!Prov_no_app_capture) {
+      CDE_save_capture_policy_state();
+      CDE_save_capture_manifest();
+      CDE_create_ld_so_cache();
+    }
+  }
 }
 
 
@@ -3431,27 +4437,27 @@ static void _add_to_array_internal(char** my_array, int* p_len, char* p, char* a
 }
 
 void CDE_add_ignore_exact_path(char* p) {
-  _add_to_array_internal(ignore_exact_paths, &ignore_exact_paths_ind, p, (char*)"ignore_exact_paths");
+  _add_to_array_internal(ignore_rules.exact_paths, &ignore_rules.exact_paths_ind, p, (char*)"ignore_exact_paths");
 }
 
 void CDE_add_ignore_prefix_path(char* p) {
-  _add_to_array_internal(ignore_prefix_paths, &ignore_prefix_paths_ind, p, (char*)"ignore_prefix_paths");
+  _add_to_array_internal(ignore_rules.prefix_paths, &ignore_rules.prefix_paths_ind, p, (char*)"ignore_prefix_paths");
 }
 
 void CDE_add_ignore_substr_path(char* p) {
-  _add_to_array_internal(ignore_substr_paths, &ignore_substr_paths_ind, p, (char*)"ignore_substr_paths");
+  _add_to_array_internal(ignore_rules.substr_paths, &ignore_rules.substr_paths_ind, p, (char*)"ignore_substr_paths");
 }
 
 void CDE_add_redirect_exact_path(char* p) {
-  _add_to_array_internal(redirect_exact_paths, &redirect_exact_paths_ind, p, (char*)"redirect_exact_paths");
+  _add_to_array_internal(redirect_rules.exact_paths, &redirect_rules.exact_paths_ind, p, (char*)"redirect_exact_paths");
 }
 
 void CDE_add_redirect_prefix_path(char* p) {
-  _add_to_array_internal(redirect_prefix_paths, &redirect_prefix_paths_ind, p, (char*)"redirect_prefix_paths");
+  _add_to_array_internal(redirect_rules.prefix_paths, &redirect_rules.prefix_paths_ind, p, (char*)"redirect_prefix_paths");
 }
 
 void CDE_add_redirect_substr_path(char* p) {
-  _add_to_array_internal(redirect_substr_paths, &redirect_substr_paths_ind, p, (char*)"redirect_substr_paths");
+  _add_to_array_internal(redirect_rules.substr_paths, &redirect_rules.substr_paths_ind, p, (char*)"redirect_substr_paths");
 }
 
 void CDE_add_ignore_envvar(char* p) {
@@ -3468,6 +4474,7 @@ void CDE_add_ignore_process(char* p){
   assert(process_ignores[process_ignores_ind].process_name == NULL);
   process_ignores[process_ignores_ind].process_name = strdup(p);
   process_ignores[process_ignores_ind].process_ignore_prefix_paths_ind = 0;
+  process_ignores[process_ignores_ind].tracing = PI_TRACE_SYSCALLS;
 
   // debug printf
   //fprintf(stderr, "process_ignores[%d] = '%s'\n",
@@ -3482,8 +4489,34 @@ void CDE_add_ignore_process(char* p){
 
 void CDE_add_multi_repo_path(char* p) {
   char* tmp = format("%s/%s", Cde_app_dir, p);
+  for (char* c = tmp; *c; c++) {
+    if ((unsigned char)*c >= 128) {
+      fprintf(stderr, "Fatal error in cde.options: non-ASCII 'multi_repo_path' '%s'\n", tmp);
+      exit(1);
+    }
+  }
   _add_to_array_internal(multi_repo_paths, &multi_repo_paths_ind, tmp, (char*)"multi_repo_paths");
   free(tmp);
+
+  const int id = multi_repo_paths_ind - 1;
+  multi_repo_names[id] = strdup(p);
+  multi_repo_paths_len[id] = strlen(multi_repo_paths[id]);
+  for (int i = 0; i < id; i++) {
+    if (strncmp(multi_repo_paths[i], multi_repo_paths[id], multi_repo_paths_len[i]) == 0) {
+      multi_repo_paths_nested[i] = true;
+    }
+    if (strncmp(multi_repo_paths[id], multi_repo_paths[i], multi_repo_paths_len[id]) == 0) {
+      multi_repo_paths_nested[id] = true;
+    }
+  }
+
+  if (!multi_repo_trie) {
+    multi_repo_trie = TrieNew();
+  }
+  // (a repo listed twice keeps its first index)
+  if (!TrieContains(multi_repo_trie, multi_repo_paths[id])) {
+    TrieInsertValue(multi_repo_trie, multi_repo_paths[id], id);
+  }
 }
 
 
@@ -3496,23 +4529,157 @@ void CDE_add_multi_repo_path(char* p) {
 // redirect_prefix=<path prefix to allow>
 // redirect_substr=<path substring to allow>
 // ignore_environment_var=<environment variable to ignore>
+// capture_policy=<full|metadata_placeholders>
+// reference_files_larger_than=<size, e.g., 512M or 2G>
+// reference_exact=<exact path to use from the real system, never copied>
+// capture_timing=<inline|deferred>
 //
 // On 2011-06-22, added support for process-specific ignores, with the following syntax:
 // ignore_process=<exact path to ignore>
 // {
 //   process_ignore_prefix=<path prefix to ignore for the given process>
 // }
+// apply value p of the cde.options directive numbered set_id (as numbered by
+// CDE_init_options())
+static void apply_option(char set_id, char* p) {
+  struct PI* cur = NULL;
+
+  switch (set_id) {
+    case 1:
+      CDE_add_ignore_exact_path(p);
+      break;
+    case 2:
+      CDE_add_ignore_prefix_path(p);
+      break;
+    case 3:
+      CDE_add_ignore_envvar(p);
+      break;
+    case 4:
+      CDE_add_redirect_exact_path(p);
+      break;
+    case 5:
+      CDE_add_redirect_prefix_path(p);
+      break;
+    case 6:
+      CDE_add_ignore_substr_path(p);
+      break;
+    case 7:
+      CDE_add_redirect_substr_path(p);
+      break;
+    case 8:
+      CDE_add_ignore_process(p);
+      break;
+    case 9: // quanpt
+      CDE_add_multi_repo_path(p);
+      break;
+    case 10:
+      if (strcmp(p, "metadata_placeholders") == 0) {
+        capture_metadata_placeholders = 1;
+      }
+      else if (strcmp(p, "full") == 0) {
+        capture_metadata_placeholders = 0;
+      }
+      else {
+        fprintf(stderr, "Fatal error in cde.options: 'capture_policy' must be 'full' or 'metadata_placeholders'\n");
+        exit(1);
+      }
+      break;
+    case 11:
+      reference_files_larger_than = str_to_bytes(p);
+      if (reference_files_larger_than < 0) {
+        fprintf(stderr, "Fatal error in cde.options: invalid size '%s' for 'reference_files_larger_than'\n", p);
+        exit(1);
+      }
+      break;
+    case 12:
+      strmap_put(referenced_paths, p, NULL);
+      break;
+    case 13:
+      if (strcmp(p, "deferred") == 0) {
+        capture_deferred = 1;
+      }
+      else if (strcmp(p, "inline") == 0) {
+        capture_deferred = 0;
+      }
+      else {
+        fprintf(stderr, "Fatal error in cde.options: 'capture_timing' must be 'inline' or 'deferred'\n");
+        exit(1);
+      }
+      break;
+    case 100:
+      assert(process_ignores_ind > 0);
+      // attach to the LATEST element in process_ignores
+      cur = &process_ignores[process_ignores_ind-1];
+      assert(cur->process_name);
+      cur->process_ignore_prefix_paths[cur->process_ignore_prefix_paths_ind] = strdup(p);
+
+      // debug printf
+      //fprintf(stderr, "process_ignores[%s][%d] = '%s'\n",
+      //        cur->process_name,
+      //        cur->process_ignore_prefix_paths_ind,
+      //        cur->process_ignore_prefix_paths[cur->process_ignore_prefix_paths_ind]);
+
+      cur->process_ignore_prefix_paths_ind++;
+      if (cur->process_ignore_prefix_paths_ind >= 20) {
+        fprintf(stderr, "Fatal error in cde.options: more than 20 'process_ignore_prefix' entries\n");
+        exit(1);
+      }
+      break;
+    case 101:
+      assert(process_ignores_ind > 0);
+      cur = &process_ignores[process_ignores_ind-1];
+      if (strcmp(p, "syscalls") == 0) {
+        cur->tracing = PI_TRACE_SYSCALLS;
+      }
+      else if (strcmp(p, "children") == 0) {
+        cur->tracing = PI_TRACE_CHILDREN;
+      }
+      else if (strcmp(p, "none") == 0) {
+        cur->tracing = PI_TRACE_NONE;
+      }
+      else if (strcmp(p, "detach") == 0) {
+        cur->tracing = PI_TRACE_DETACH;
+      }
+      else {
+        fprintf(stderr, "Fatal error in cde.options: 'process_tracing' must be 'syscalls', 'children', 'none', or 'detach'\n");
+        exit(1);
+      }
+      break;
+    default:
+      assert(0);
+  }
+}
+
 static void CDE_init_options() {
 
   char in_braces = false;
 
   FILE* f = NULL;
 
+  placeholder_paths = strmap_new();
+  referenced_paths = strmap_new();
+  capture_manifest = strmap_new();
+  deferred_captures = strmap_new();
+  captured_before_write = strmap_new();
+
   if (Cde_exec_mode) {
     // look for a cde.options file in the package
 
     // you must run this AFTER running CDE_init_pseudo_root_dir()
     assert(*cde_cderoot_dir);
+
+    // if the startup snapshot is current, replay the options it recorded as
+    // parsed, each as [set_id][value\0], instead of parsing the file again
+    size_t options_size = 0;
+    const char* options = startup_snap ? (const char*)startsnap_section(startup_snap, "options", &options_size) : NULL;
+    if (options && (options_size == 0 || options[options_size - 1] == '\0')) {
+      for (const char* o = options; o < options + options_size; o += strlen(o + 1) + 2) {
+        apply_option(o[0], (char*)(o + 1));
+      }
+      cde_options_initialized = 1;
+      return;
+    }
+
     char* options_file = format("%s/../cde.options", cde_cderoot_dir);
     f = fopen(options_file, "r");
     if (!f) {
@@ -3521,6 +4688,9 @@ static void CDE_init_options() {
       exit(1);
     }
     free(options_file);
+    if (startup_snap_writer) {
+      startsnap_add(startup_snap_writer, "options", NULL, 0);
+    }
   }
   else {
     // look for a cde.options file in pwd
@@ -3619,6 +4789,18 @@ static void CDE_init_options() {
         else if (strcmp(p, "multi_repo_path") == 0) { // quanpt
           set_id = 9;
         }
+        else if (strcmp(p, "capture_policy") == 0) {
+          set_id = 10;
+        }
+        else if (strcmp(p, "reference_files_larger_than") == 0) {
+          set_id = 11;
+        }
+        else if (strcmp(p, "reference_exact") == 0) {
+          set_id = 12;
+        }
+        else if (strcmp(p, "capture_timing") == 0) {
+          set_id = 13;
+        }
         else if (strcmp(p, "process_ignore_prefix") == 0) {
           if (!in_braces) {
             fprintf(stderr, "Fatal error in cde.options: 'process_ignore_prefix' must be enclosed in { } after an 'ignore_process' directive\n");
@@ -3626,70 +4808,30 @@ static void CDE_init_options() {
           }
           set_id = 100;
         }
+        else if (strcmp(p, "process_tracing") == 0) {
+          if (!in_braces) {
+            fprintf(stderr, "Fatal error in cde.options: 'process_tracing' must be enclosed in { } after an 'ignore_process' directive\n");
+            exit(1);
+          }
+          set_id = 101;
+        }
         else {
           fprintf(stderr, "Fatal error in cde.options: unrecognized token '%s'\n", p);
           exit(1);
         }
 
-        if (in_braces && set_id != 100) {
-          fprintf(stderr, "Fatal error in cde.options: Only 'process_ignore_prefix' is allowed within { } after an 'ignore_process' directive\n");
+        if (in_braces && set_id != 100 && set_id != 101) {
+          fprintf(stderr, "Fatal error in cde.options: Only 'process_ignore_prefix' and 'process_tracing' are allowed within { } after an 'ignore_process' directive\n");
           exit(1);
         }
 
         is_first_token = 0;
       }
       else {
-        struct PI* cur = NULL;
-
-        switch (set_id) {
-          case 1:
-            CDE_add_ignore_exact_path(p);
-            break;
-          case 2:
-            CDE_add_ignore_prefix_path(p);
-            break;
-          case 3:
-            CDE_add_ignore_envvar(p);
-            break;
-          case 4:
-            CDE_add_redirect_exact_path(p);
-            break;
-          case 5:
-            CDE_add_redirect_prefix_path(p);
-            break;
-          case 6:
-            CDE_add_ignore_substr_path(p);
-            break;
-          case 7:
-            CDE_add_redirect_substr_path(p);
-            break;
-          case 8:
-            CDE_add_ignore_process(p);
-            break;
-          case 9: // quanpt
-            CDE_add_multi_repo_path(p);
-            break;
-          case 100:
-            assert(process_ignores_ind > 0);
-            // attach to the LATEST element in process_ignores
-            cur = &process_ignores[process_ignores_ind-1];
-            assert(cur->process_name);
-            cur->process_ignore_prefix_paths[cur->process_ignore_prefix_paths_ind] = strdup(p);
-
-            // debug printf
-            //fprintf(stderr, "process_ignores[%s][%d] = '%s'\n",
-            //        cur->process_name,
-            //        cur->process_ignore_prefix_paths_ind,
-            //        cur->process_ignore_prefix_paths[cur->process_ignore_prefix_paths_ind]);
-
-            cur->process_ignore_prefix_paths_ind++;
-            if (cur->process_ignore_prefix_paths_ind >= 20) {
-              fprintf(stderr, "Fatal error in cde.options: more than 20 'process_ignore_prefix' entries\n");
-              exit(1);
-            }
-            break;
-          default:
-            assert(0);
+        apply_option(set_id, p);
+        if (startup_snap_writer) {
+          startsnap_append(startup_snap_writer, &set_id, 1);
+          startsnap_append(startup_snap_writer, p, strlen(p) + 1);
         }
 
         break;
@@ -3709,78 +4851,141 @@ static void CDE_init_options() {
   cde_options_initialized = 1;
 }
 
-void load_environment_vars_from_mem(char* environ_start) {
-  
-  for (char* environ_str = environ_start; *environ_str;
-       environ_str = strchr(environ_str, '\0') + 1) {
-
-    // format: "name=value"
-    // note that 'value' might itself contain '=' characters,
-    // so only split on the FIRST '='
-    char* sp = strchr(environ_str, '=');
-
-    // ignore an invalid variable with an empty name or a name
-    // that's simply a newline character (some files have a trailing
-    // newline, which strtok picks up, ugh):
-    if (sp == NULL || sp == environ_str)
-      continue;
-
-    char* name = strndup(environ_str, sp - environ_str);
-    char* val = sp + 1;
+// return environment of the cde-root named repo_name (caller frees), or
+// NULL on error (errno set)
+static EnvBlock* load_environment (char* repo_name) {
+  char* env_path = format("%s/../cde.full-environment.%s", cde_cderoot_dir, repo_name);
+  EnvBlock* env = envblock_load(env_path, ignore_envvars, ignore_envvars_values, ignore_envvars_ind);
+  const int err = errno;
+  free(env_path);
+  errno = err;
+  return env;
+}
 
-    // make sure we're not ignoring this environment var:
-    int i;
-    int ignore_me = 0;
-    for (i = 0; i < ignore_envvars_ind; i++) {
-      if (strcmp(name, ignore_envvars[i]) == 0) {
-        if (ignore_envvars_values[i]) {
-          setenv(name, ignore_envvars_values[i], 0);
-        }
-        ignore_me = 1;
-        break;
-      }
+void CDE_load_environment_vars(char* repo_name) {
+  EnvBlock* env = NULL;
+  bool is_startup_root = (strcmp(repo_name, CDE_ROOT_NAME) == 0);
+  size_t env_size = 0;
+  const char* env_mem = (is_startup_root && startup_snap) ?
+    (const char*)startsnap_section(startup_snap, "environment", &env_size) : NULL;
+  if (env_mem) {
+    env = envblock_parse(env_mem, env_size, ignore_envvars, ignore_envvars_values, ignore_envvars_ind);
+  }
+  else if (is_startup_root && startup_snap_writer) {
+    // (keep the file as read, since ignored vars take this machine's values)
+    char* env_path = format("%s/../cde.full-environment.%s", cde_cderoot_dir, repo_name);
+    char* mem = envblock_read(env_path, &env_size);
+    free(env_path);
+    if (mem) {
+      startsnap_add(startup_snap_writer, "environment", mem, env_size);
+      env = envblock_parse(mem, env_size, ignore_envvars, ignore_envvars_values, ignore_envvars_ind);
+      free(mem);
     }
+  }
+  else {
+    env = load_environment(repo_name);
+  }
+  if (!env) {
+    fprintf(stderr, "Fatal error: cannot load %s/../cde.full-environment.%s: %s\n",
+            cde_cderoot_dir, repo_name, strerror(errno));
+    exit(1);
+  }
 
-    if (!ignore_me) {
-      setenv(name, val, 0);
+#ifdef HAVE_CLEARENV
+  clearenv();
+#else
+  extern char **environ;
+  environ = NULL;
+#endif
+  for (size_t i = 0; i < envblock_num_vars(env); i++) {
+    const char* var = envblock_var(env, i);
+    const char* sp = strchr(var, '=');
+    char* name = strndup(var, sp - var);
+    setenv(name, sp + 1, 1);
+    free(name);
+  }
+
+  envblock_free(env);
+}
+
+// return the PTRACE_SETOPTIONS options probed on an earlier run, as saved in
+// the startup snapshot, or -1 if there is none
+int CDE_get_snapshot_ptrace_setoptions(void) {
+  size_t size = 0;
+  const void* val = startup_snap ? startsnap_section(startup_snap, "ptrace_setoptions", &size) : NULL;
+  int ptrace_setoptions = -1;
+  if (val && size == sizeof(ptrace_setoptions)) {
+    memcpy(&ptrace_setoptions, val, size);
+  }
+  return ptrace_setoptions;
+}
+
+// save the startup snapshot built during this startup (with the probed
+// ptrace_setoptions, if not -1), then let go of it
+void CDE_finish_startup_snapshot(int ptrace_setoptions) {
+  if (startup_snap_writer) {
+    if (ptrace_setoptions >= 0) {
+      startsnap_add(startup_snap_writer, "ptrace_setoptions", &ptrace_setoptions, sizeof(ptrace_setoptions));
     }
-    else {
-      if (Cde_verbose_mode) {
-        vbprintf("ignored envvar '%s' => '%s'\n", name, val);
-      }
+    // (e.g., a read-only package just keeps starting without one)
+    char* snap_file = format("%s/../cde.startup.%s", cde_cderoot_dir, CDE_ROOT_NAME);
+    if (startsnap_save(startup_snap_writer, snap_file, startup_snap_key) != 0) {
+      vbp(1, "cannot save startup snapshot %s: %s\n", snap_file, strerror(errno));
     }
-
-    free(name);
+    free(snap_file);
+    startsnap_writer_free(startup_snap_writer);
+    startup_snap_writer = NULL;
   }
+  startsnap_close(startup_snap);
+  startup_snap = NULL;
 }
 
-void CDE_load_environment_vars(char* repo_name) {
-  static char cde_full_environment_abspath[MAXPATHLEN];
-  sprintf(cde_full_environment_abspath, "%s/../cde.full-environment.%s", cde_cderoot_dir, repo_name);
-//  strcpy(cde_full_environment_abspath, cde_cderoot_dir);
-//  strcat(cde_full_environment_abspath, "/../cde.full-environment.");
-//  strcat(cde_full_environment_abspath, multi_repo_paths[i]);
-  struct stat env_file_stat;
-  if (stat(cde_full_environment_abspath, &env_file_stat)) {
-    perror(cde_full_environment_abspath);
-    exit(1);
+// return environment of repo id, loaded on first use (NULL if it has none)
+static EnvBlock* get_repo_environment (int id) {
+  if (!multi_repo_envs_loaded[id]) {
+    multi_repo_envs_loaded[id] = true;
+    multi_repo_envs[id] = load_environment(multi_repo_names[id]);
+    if (!multi_repo_envs[id]) {
+      fprintf(stderr, "Warning: cannot load environment of repo '%s' (%s), so its programs inherit the environment of their parents\n",
+              multi_repo_names[id], strerror(errno));
+    }
   }
+  return multi_repo_envs[id];
+}
 
-  int full_environment_fd = open(cde_full_environment_abspath, O_RDONLY);
+// make the execve tcp is entering pass the environment of repo id (laid out
+// in the upper half of its shared page) instead of its own envp
+static void inject_repo_environment (struct tcb* tcp, int id) {
+  assert(tcp->childshm);
+  EnvBlock* env = get_repo_environment(id);
+  if (!env) {
+    return;
+  }
 
-  void* environ_start =
-    (char*)mmap(0, env_file_stat.st_size, PROT_READ, MAP_PRIVATE, full_environment_fd, 0);
+  const long envp_offset = envblock_layout(env, tcp->localshm + shared_env_offset,
+                                           shared_page_size - shared_env_offset,
+                                           (unsigned long)tcp->childshm + shared_env_offset,
+                                           personality_wordsize[current_personality]);
+  if (envp_offset < 0) {
+    fprintf(stderr, "Warning: environment of repo '%s' is too large to pass to [%d]\n",
+            multi_repo_names[id], tcp->pid);
+    return;
+  }
+  const long child_envp = (long)tcp->childshm + shared_env_offset + envp_offset;
 
-#ifdef HAVE_CLEARENV
-  clearenv();
-#else
-  extern char **environ;
-  environ = NULL;
+  struct user_regs_struct cur_regs;
+  EXITIF(ptrace(PTRACE_GETREGS, tcp->pid, NULL, (long)&cur_regs) < 0);
+#if defined (I386)
+  cur_regs.edx = child_envp;
+#elif defined(X86_64)
+  cur_regs.rdx = child_envp; // (edx of a 32-bit target process, too)
 #endif
-  load_environment_vars_from_mem(environ_start);
+  ptrace(PTRACE_SETREGS, tcp->pid, NULL, (long)&cur_regs);
 
-  munmap(environ_start, env_file_stat.st_size);
-  close(full_environment_fd);
+  tcp->env_repo_ind = id;
+  if (Cde_verbose_mode) {
+    vbprintf("[%d] environment of repo '%s' passed to execve\n", tcp->pid, multi_repo_names[id]);
+  }
 }
 
 
@@ -3831,7 +5036,7 @@ void CDE_begin_socket_bind_or_connect(struct tcb *tcp) {
         //printf("original_path='%s'\n", original_path);
 
         char* redirected_path =
-          redirect_filename_into_cderoot(original_path, tcp->current_dir, tcp);
+          redirect_filename_into_cderoot(original_path, tcp->fs->current_dir, tcp);
 
         // could be null if path is being ignored by cde.options
         if (redirected_path) {
@@ -3981,10 +5186,10 @@ void make_mirror_dirs_in_cde_package(char* original_abspath, int pop_one) {
 // return 1 if the path is in a different repo
 // return 0 if no repo or current repo contains the path
 int is_in_another_repo(char* path, struct tcb* tcp) {
-  //return (get_repo_path_id(path) == tcp->current_repo_ind) ? 1 : 0;
-  int id=get_repo_path_id(path);
+  //return (get_repo_path_id(path) == tcp->fs->current_repo_ind) ? 1 : 0;
+  int id=get_tcb_repo_path_id(path, tcp);
   //printf("%s -> %s\n", path, multi_repo_paths[id]);
-  return (id >= 0 && id != tcp->current_repo_ind) ? 1 : 0;
+  return (id >= 0 && id != tcp->fs->current_repo_ind) ? 1 : 0;
 }
 
 // return (index+1) (so it is >0) if the path is a repo name
@@ -3995,18 +5200,22 @@ int is_a_repo_name(char* path) {
   return 0;
 }
 
+// return index of the repo path is in (the one with the longest root, if
+// repos are nested), or -1 if none
 int get_repo_path_id(char* path) {
-  int i, path_len, repo_path_len;
-
-  if (path==NULL) return -1;
+  int id;
+  if (path == NULL || multi_repo_trie == NULL) return -1;
+  return (TrieLongestPrefix(multi_repo_trie, path, &id) >= 0) ? id : -1;
+}
 
-  path_len = strlen(path);
-  for (i=0; i<multi_repo_paths_ind; i++) {
-    repo_path_len = strlen(multi_repo_paths[i]);
-    //DD(multi_repo_paths[i]);
-    if (strncmp(path, multi_repo_paths[i], repo_path_len) == 0 && path_len >= repo_path_len)
-      return i;
+// get_repo_path_id(), but first check the repo of tcp's cwd (which most paths
+// it accesses are in): a path in it is in no other, unless one is nested
+static int get_tcb_repo_path_id(char* path, struct tcb* tcp) {
+  const int cur = tcp ? tcp->fs->current_repo_ind : -1;
+  if (path && cur >= 0 && !multi_repo_paths_nested[cur] &&
+      strncmp(path, multi_repo_paths[cur], multi_repo_paths_len[cur]) == 0) {
+    return cur;
   }
-  return -1;
+  return get_repo_path_id(path);
 }
 
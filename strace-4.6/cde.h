@@ -6,6 +6,7 @@
  ******************************************************************************/
 
 #include <stdbool.h>     // C99: bool, true, false
+#include <stddef.h>      // C99: size_t
 
 /*******************************************************************************
  * EXTERNALLY-DEFINED VARIABLES
@@ -40,6 +41,10 @@ extern char Cde_restore_mode;
 void alloc_tcb_cde_fields (struct tcb* tcp);
 // free heap-allocated cde fields in a tcb
 void free_tcb_cde_fields (struct tcb* tcp);
+// copy the cwd of tcp into buf (of size bytes), from any thread
+void CDE_copy_current_dir (struct tcb* tcp, char* buf, size_t size);
+// make tcp's open files the only user of their fd->path table, before changing it
+void CDE_own_opened_file_paths (struct tcb* tcp);
 // use local network hostnames/etc during audit/exec
 void use_local_network_settings (bool new_setting);
 
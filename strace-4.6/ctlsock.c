@@ -0,0 +1,356 @@
+/*******************************************************************************
+module:   ctlsock
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  optional control socket (a local UNIX stream socket in the package
+          dir) that serves live tracer statistics, and accepts commands to dump
+          the tcb table or toggle verbose tracing for one pid
+*******************************************************************************/
+
+/*******************************************************************************
+ * SYSTEM INCLUDES
+ ******************************************************************************/
+
+#include <errno.h>          // ISOC: errno
+#include <pthread.h>        // P2001: pthread_create(), pthread_mutex_lock(), pthread_sigmask()
+#include <signal.h>         // P2001: sigfillset()
+#include <stdlib.h>         // ISOC: free(), qsort(), atexit()
+#include <string.h>         // ISOC: strcmp(), strncpy(), strdup()
+#include <sys/socket.h>     // P2001: socket(), bind(), listen(), accept(), shutdown()
+#include <sys/un.h>         // P2001: struct sockaddr_un
+#include <time.h>           // P2001: clock_gettime(), nanosleep()
+#include <unistd.h>         // P2001: close(), unlink(), dup()
+
+/*******************************************************************************
+ * USER INCLUDES
+ ******************************************************************************/
+
+#include "ctlsock.h"
+#include "perftimers.h"     // set_perf_counters(), get_perf_count()
+#include "strutils.h"       // str_print_json()
+
+/*******************************************************************************
+ * PRIVATE TYPES / CONSTANTS / VARIABLES
+ ******************************************************************************/
+
+#define NSEC_PER_SEC 1000000000.0
+#define MAX_WATCH_SECS 3600
+
+// one handled trace stop
+typedef struct {
+  int pid;
+  const char* syscall_name;   // static string (from sysent[]), or NULL
+  uint64_t handler_ns;
+} RecentStop;
+
+static bool serving = false;
+static pid_t owner_pid = 0;   // forked children must not remove the socket
+static int listen_fd = -1;
+static char* sock_path = NULL;
+static CtlTcbDumper tcb_dumper = NULL;
+static CtlVerboseSetter verbose_setter = NULL;
+
+static int cur_nprocs = 0;
+static long long pending_copy_files = 0;
+static long long pending_copy_bytes = 0;
+
+// ring of most recent stops (written by the tracing thread, read by clients)
+static RecentStop recent_stops[CTLSOCK_RECENT_STOPS];
+static int recent_stops_next = 0;
+static int recent_stops_len = 0;
+static pthread_mutex_t recent_stops_mut = PTHREAD_MUTEX_INITIALIZER;
+
+// trace stops at the previous "stats", to report stops/sec since then
+static double last_sample_time = 0.0;
+static long long last_sample_stops = 0;
+static pthread_mutex_t sample_mut = PTHREAD_MUTEX_INITIALIZER;
+
+/*******************************************************************************
+ * PRIVATE MACROS / FUNCTIONS
+ ******************************************************************************/
+
+static double now_secs (void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + (ts.tv_nsec / NSEC_PER_SEC);
+}
+
+// slowest handler first
+static int compare_stops (const void* a, const void* b) {
+  const uint64_t ha = ((const RecentStop*)a)->handler_ns;
+  const uint64_t hb = ((const RecentStop*)b)->handler_ns;
+  return (ha > hb) ? -1 : ((ha < hb) ? 1 : 0);
+}
+
+// return stops/sec since the previous call (or since the socket was started)
+static double sample_stops_per_sec (long long trace_stops) {
+  const double now = now_secs();
+  pthread_mutex_lock(&sample_mut);
+  const double elapsed = now - last_sample_time;
+  const double rate = (elapsed > 0.0) ? ((trace_stops - last_sample_stops) / elapsed) : 0.0;
+  last_sample_time = now;
+  last_sample_stops = trace_stops;
+  pthread_mutex_unlock(&sample_mut);
+  return rate;
+}
+
+static void print_slowest_recent (FILE* f) {
+  RecentStop stops[CTLSOCK_RECENT_STOPS];
+  pthread_mutex_lock(&recent_stops_mut);
+  const int len = recent_stops_len;
+  memcpy(stops, recent_stops, len * sizeof(RecentStop));
+  pthread_mutex_unlock(&recent_stops_mut);
+
+  qsort(stops, len, sizeof(RecentStop), compare_stops);
+  fprintf(f, "[");
+  for (int i = 0; i < len && i < CTLSOCK_SLOWEST_STOPS; i++) {
+    fprintf(f, "%s{\"pid\":%d,\"syscall\":", (i ? "," : ""), stops[i].pid);
+    str_print_json(f, stops[i].syscall_name ? stops[i].syscall_name : "?");
+    fprintf(f, ",\"handler_us\":%.3f}", stops[i].handler_ns / 1000.0);
+  }
+  fprintf(f, "]");
+}
+
+static void print_error (FILE* f, const char* msg, const char* arg) {
+  fprintf(f, "{\"error\":");
+  if (arg) {
+    char buf[256];
+    snprintf(buf, sizeof(buf), "%s '%s'", msg, arg);
+    str_print_json(f, buf);
+  } else {
+    str_print_json(f, msg);
+  }
+  fprintf(f, "}\n");
+}
+
+static void run_verbose_command (const char* args, FILE* f) {
+  int pid;
+  char state[8];
+  if (sscanf(args, "%d %7s", &pid, state) != 2 ||
+      (strcmp(state, "on") != 0 && strcmp(state, "off") != 0)) {
+    print_error(f, "usage: verbose <pid> on|off", NULL);
+  } else if (!verbose_setter || verbose_setter(pid, strcmp(state, "on") == 0) != 0) {
+    print_error(f, "no traced process with pid", args);
+  } else {
+    fprintf(f, "{\"ok\":true}\n");
+  }
+}
+
+// print stats to f every secs, until the client disconnects or we stop serving
+static void run_watch_command (const char* args, FILE* f) {
+  int secs = 1;
+  if (*args && (sscanf(args, "%d", &secs) != 1 || secs < 1 || secs > MAX_WATCH_SECS)) {
+    print_error(f, "usage: watch [<sec>]", NULL);
+    return;
+  }
+
+  const struct timespec interval = { secs, 0 };
+  while (__atomic_load_n(&serving, __ATOMIC_RELAXED)) {
+    ctlsock_print_stats(f);
+    if (fflush(f) != 0 || ferror(f)) {
+      break;
+    }
+    nanosleep(&interval, NULL);
+  }
+}
+
+// serve commands of one client, until it disconnects
+static void* serve_client (void* arg) {
+  const int fd = (int)(intptr_t)arg;
+  const int out_fd = dup(fd);
+  FILE* in = fdopen(fd, "r");
+  FILE* out = (out_fd >= 0) ? fdopen(out_fd, "w") : NULL;
+  if (!in || !out) {
+    if (in) fclose(in); else close(fd);
+    if (out) fclose(out); else if (out_fd >= 0) close(out_fd);
+    return NULL;
+  }
+
+  char* line = NULL;
+  size_t line_size = 0;
+  while (getline(&line, &line_size, in) > 0) {
+    line[strcspn(line, "\r\n")] = '\0';
+    if (strncmp(line, "watch", 5) == 0 && (line[5] == '\0' || line[5] == ' ')) {
+      run_watch_command(line + 5 + (line[5] == ' '), out);
+      break;
+    }
+    ctlsock_run_command(line, out);
+    if (fflush(out) != 0) {
+      break;
+    }
+  }
+
+  free(line);
+  fclose(in);
+  fclose(out);
+  return NULL;
+}
+
+// accept clients on the listening socket (arg), until it is shut down
+static void* accept_clients (void* arg) {
+  const int lfd = (int)(intptr_t)arg;
+  while (__atomic_load_n(&serving, __ATOMIC_RELAXED)) {
+    const int fd = accept(lfd, NULL, NULL);
+    if (fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) {
+        continue;
+      }
+      break;    // lfd was shut down by ctlsock_stop()
+    }
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, serve_client, (void*)(intptr_t)fd) == 0) {
+      pthread_detach(thread);
+    } else {
+      close(fd);
+    }
+  }
+  close(lfd);
+  return NULL;
+}
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+int ctlsock_start (const char* path, CtlTcbDumper dump_tcbs, CtlVerboseSetter set_verbose) {
+  struct sockaddr_un addr;
+  if (serving || strlen(path) >= sizeof(addr.sun_path)) {
+    errno = serving ? EBUSY : ENAMETOOLONG;
+    return -1;
+  }
+
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+
+  // remove socket left behind by an earlier (killed) run
+  unlink(path);
+  listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (listen_fd < 0) {
+    return -1;
+  }
+  if (bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(listen_fd, 8) != 0) {
+    const int err = errno;
+    close(listen_fd);
+    listen_fd = -1;
+    errno = err;
+    return -1;
+  }
+
+  sock_path = strdup(path);
+  owner_pid = getpid();
+  tcb_dumper = dump_tcbs;
+  verbose_setter = set_verbose;
+  set_perf_counters(ENABLED);
+  last_sample_time = now_secs();
+  last_sample_stops = 0;
+  __atomic_store_n(&serving, true, __ATOMIC_RELAXED);
+
+  // serving threads must not take signals meant for the tracer (SIGINT,
+  // SIGCHLD, ...), and get EPIPE rather than SIGPIPE from gone clients
+  sigset_t all_sigs, old_sigs;
+  sigfillset(&all_sigs);
+  pthread_sigmask(SIG_SETMASK, &all_sigs, &old_sigs);
+  pthread_t thread;
+  const int err = pthread_create(&thread, NULL, accept_clients, (void*)(intptr_t)listen_fd);
+  pthread_sigmask(SIG_SETMASK, &old_sigs, NULL);
+  if (err != 0) {
+    const int lfd = listen_fd;
+    ctlsock_stop();
+    close(lfd);
+    errno = err;
+    return -1;
+  }
+  pthread_detach(thread);
+
+  atexit(ctlsock_stop);
+  return 0;
+}
+
+void ctlsock_stop (void) {
+  if (getpid() != owner_pid || !__atomic_exchange_n(&serving, false, __ATOMIC_RELAXED)) {
+    return;
+  }
+
+  // wakes up accept_clients(), which then closes it
+  shutdown(listen_fd, SHUT_RDWR);
+  listen_fd = -1;
+  unlink(sock_path);
+  free(sock_path);
+  sock_path = NULL;
+}
+
+bool ctlsock_enabled (void) {
+  return __atomic_load_n(&serving, __ATOMIC_RELAXED);
+}
+
+void ctlsock_record_stop (int pid, const char* syscall_name, uint64_t handler_ns, int nprocs) {
+  __atomic_store_n(&cur_nprocs, nprocs, __ATOMIC_RELAXED);
+
+  pthread_mutex_lock(&recent_stops_mut);
+  recent_stops[recent_stops_next].pid = pid;
+  recent_stops[recent_stops_next].syscall_name = syscall_name;
+  recent_stops[recent_stops_next].handler_ns = handler_ns;
+  recent_stops_next = (recent_stops_next + 1) % CTLSOCK_RECENT_STOPS;
+  if (recent_stops_len < CTLSOCK_RECENT_STOPS) {
+    recent_stops_len++;
+  }
+  pthread_mutex_unlock(&recent_stops_mut);
+}
+
+void ctlsock_add_pending_copies (long long nfiles, long long nbytes) {
+  __atomic_add_fetch(&pending_copy_files, nfiles, __ATOMIC_RELAXED);
+  __atomic_add_fetch(&pending_copy_bytes, nbytes, __ATOMIC_RELAXED);
+}
+
+void ctlsock_clear_pending_copies (void) {
+  __atomic_store_n(&pending_copy_files, 0, __ATOMIC_RELAXED);
+  __atomic_store_n(&pending_copy_bytes, 0, __ATOMIC_RELAXED);
+}
+
+void ctlsock_print_stats (FILE* f) {
+  const long long trace_stops = get_perf_count(TRACE_STOPS);
+  const long long hits = get_perf_count(CAPTURE_CACHE_HITS);
+  const long long misses = get_perf_count(CAPTURE_CACHE_MISSES);
+
+  fprintf(f, "{\"nprocs\":%d", __atomic_load_n(&cur_nprocs, __ATOMIC_RELAXED));
+  fprintf(f, ",\"trace_stops\":%lld", trace_stops);
+  fprintf(f, ",\"stops_per_sec\":%.1f", sample_stops_per_sec(trace_stops));
+  fprintf(f, ",\"pending_copy_files\":%lld", __atomic_load_n(&pending_copy_files, __ATOMIC_RELAXED));
+  fprintf(f, ",\"pending_copy_bytes\":%lld", __atomic_load_n(&pending_copy_bytes, __ATOMIC_RELAXED));
+  fprintf(f, ",\"files_copied\":%lld", get_perf_count(FILES_COPIED));
+  fprintf(f, ",\"bytes_copied\":%lld", get_perf_count(BYTES_COPIED));
+  fprintf(f, ",\"provenance_records\":%lld", get_perf_count(PROVENANCE_RECORDS));
+  fprintf(f, ",\"capture_cache_hits\":%lld", hits);
+  fprintf(f, ",\"capture_cache_misses\":%lld", misses);
+  fprintf(f, ",\"capture_cache_hit_rate\":%.3f", (hits + misses) ? (double)hits / (hits + misses) : 0.0);
+  fprintf(f, ",\"slowest_recent\":");
+  print_slowest_recent(f);
+  fprintf(f, "}\n");
+}
+
+void ctlsock_run_command (const char* line, FILE* f) {
+  while (*line == ' ') {
+    line++;
+  }
+
+  if (*line == '\0') {
+    return;
+  } else if (strcmp(line, "stats") == 0) {
+    ctlsock_print_stats(f);
+  } else if (strcmp(line, "tcbs") == 0) {
+    fprintf(f, "{\"tcbs\":");
+    if (tcb_dumper) {
+      tcb_dumper(f);
+    } else {
+      fprintf(f, "[]");
+    }
+    fprintf(f, "}\n");
+  } else if (strncmp(line, "verbose ", 8) == 0) {
+    run_verbose_command(line + 8, f);
+  } else if (strcmp(line, "help") == 0) {
+    fprintf(f, "{\"commands\":[\"stats\",\"watch [<sec>]\",\"tcbs\",\"verbose <pid> on|off\",\"help\"]}\n");
+  } else {
+    print_error(f, "unknown command", line);
+  }
+}
@@ -0,0 +1,88 @@
+/*******************************************************************************
+module:   ctlsock
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  optional control socket (a local UNIX stream socket in the package
+          dir) that serves live tracer statistics, and accepts commands to dump
+          the tcb table or toggle verbose tracing for one pid
+protocol: one command per line, answered with one json line:
+            stats                  live counters (see ctlsock_print_stats())
+            watch [<sec>]          stats every <sec> secs (default 1), until
+                                   the client disconnects
+            tcbs                   one entry per traced process
+            verbose <pid> on|off   toggle verbose tracing for pid
+            help                   list of commands
+*******************************************************************************/
+
+#ifndef CTLSOCK_H
+#define CTLSOCK_H 1
+
+// allow this header to be included from c++ source file
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*******************************************************************************
+ * SYSTEM INCLUDES
+ ******************************************************************************/
+
+#include <stdbool.h>    // ISOC: bool
+#include <stdint.h>     // ISOC: uint64_t
+#include <stdio.h>      // ISOC: FILE
+
+/*******************************************************************************
+ * PUBLIC TYPES / CONSTANTS / VARIABLES
+ ******************************************************************************/
+
+// name of the control socket (created in the package dir)
+#define CTLSOCK_NAME "ptu-ctl.sock"
+
+// num most recent stops that the slowest handlers are picked from
+#define CTLSOCK_RECENT_STOPS 256
+
+// num slowest recent handlers reported
+#define CTLSOCK_SLOWEST_STOPS 5
+
+// writes the json array of traced processes (for the "tcbs" command) to f
+// NOTE called from the control socket thread, not the tracing thread
+typedef void (*CtlTcbDumper) (FILE* f);
+
+// enables/disables verbose tracing of pid, returns 0 or -1 if no such pid
+// NOTE called from the control socket thread, not the tracing thread
+typedef int (*CtlVerboseSetter) (int pid, bool on);
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+// create control socket at path, and serve it from a background thread
+// (also enables perf counters, which the live counters come from)
+// return 0 on success, -1 (with errno set) if the socket cannot be created
+int ctlsock_start (const char* path, CtlTcbDumper dump_tcbs, CtlVerboseSetter set_verbose);
+
+// stop serving, and remove the control socket
+void ctlsock_stop (void);
+
+// return true if the control socket is being served
+bool ctlsock_enabled (void);
+
+// record one handled trace stop (called by the tracing thread)
+void ctlsock_record_stop (int pid, const char* syscall_name, uint64_t handler_ns, int nprocs);
+
+// add nfiles (of nbytes total) to the files waiting to be copied into the
+// package (e.g., deferred captures), or forget all of them
+void ctlsock_add_pending_copies (long long nfiles, long long nbytes);
+void ctlsock_clear_pending_copies (void);
+
+// print one json object of live counters (and a newline) to f
+void ctlsock_print_stats (FILE* f);
+
+// run one command line (without "watch"), and print its json reply to f
+void ctlsock_run_command (const char* line, FILE* f);
+
+// allow this header to be included from c++ source file
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CTLSOCK_H
@@ -375,8 +375,56 @@ struct PI {
   char* process_name;
   char* process_ignore_prefix_paths[20];
   int process_ignore_prefix_paths_ind;
+  char tracing; // digimokan: PI_TRACE_* ('process_tracing' option)
 };
 
+// digimokan: how an ignored process (and procs it forks) is traced once it
+// has exec'd
+#define PI_TRACE_SYSCALLS 0 // stops at each syscall (default)
+#define PI_TRACE_CHILDREN 1 // no syscall stops, but procs it forks are traced
+#define PI_TRACE_NONE     2 // no syscall stops for it or procs it forks
+#define PI_TRACE_DETACH   3 // detached (with procs it forks) at its execve
+
+
+/* digimokan: bytes read and written via one opened file (-B) */
+struct io_bytes {
+	unsigned long long read;
+	unsigned long long written;
+};
+
+/* digimokan: a cwd, shared copy-on-write by the cwds of procs forked
+   from the one that set it (see set_current_dir() in cde.c) */
+struct shared_cwd {
+	int refcount;
+	char path[];		/* (a MAXPATHLEN block) */
+};
+
+/* digimokan: abs paths used to open fds, shared copy-on-write by the open
+   files of procs forked from the one that opened them (see
+   CDE_own_opened_file_paths()) */
+struct shared_fd_paths {
+	int refcount;
+	char *path[];		/* by fd (max_open_files() of them) */
+};
+
+/* digimokan: cwd of a traced proc, shared by the procs it clones with
+   CLONE_FS (like the kernel's fs_struct), and freed with the last of them */
+struct tcb_fs {
+	int refcount;
+	struct shared_cwd *cwd;
+	char *current_dir;	/* REAL current directory (cwd->path, read-only) */
+	int current_repo_ind;	/* quanpt: multi repo (of current_dir) */
+};
+
+/* digimokan: open files of a traced proc, shared by the procs it clones
+   with CLONE_FILES (like the kernel's files_struct) */
+struct tcb_files {
+	int refcount;
+	struct shared_fd_paths *fd_paths;
+	char **opened_file_paths;	/* abs paths used to open its currently open files
+					   (fd_paths->path, read-only) */
+	struct io_bytes *opened_file_bytes; /* bytes read/written via each of opened_file_paths (-B) */
+};
 
 /* Trace Control Block */
 struct tcb {
@@ -431,10 +479,9 @@ struct tcb {
   // new fields added by pgbovine
   // handle memory management in alloc_tcb_cde_fields() and free_tcb_cde_fields()
 
-  // inherited from parent during fork()
-  // TODO: careful with memory leaks for these strdup'ed strings!
-  // if non-null, just malloc a block of size MAXPATHLEN and strcpy into it
-  char* current_dir; // REAL current directory of this child process
+  // digimokan: cwd, copied (on write) from parent during fork(), shared
+  // with it by clone(CLONE_FS) (see CDE_init_tcb_dir_fields())
+  struct tcb_fs* fs;
 
   // if we prepended the dynamic linker to a program name to invoke it,
   // then set this to the full program path from the original execution,
@@ -461,9 +508,14 @@ struct tcb {
 
   struct PI* p_ignores; // point to an element within process_ignores if
                         // this traced process has custom ignore options
-
-  int current_repo_ind;     // quanpt: multi repo
-  char** opened_file_paths; // digimokan: abs paths used to open this proc's currently open files
+  char untraced;        // digimokan: PI_TRACE_CHILDREN or PI_TRACE_NONE if resumed
+                        // without syscall stops (see ptrace_resume()), else 0
+
+  int env_repo_ind;         // digimokan: repo whose environment this proc has (-1 if the app's own)
+  struct tcb_files* files;  // digimokan: open files, copied (on write) from parent during
+                            // fork(), shared with it by clone(CLONE_FILES)
+  unsigned long long sysprofile_entered_ns; // digimokan: end of last syscall-entry stop (-R profile)
+  char ctl_verbose;          // digimokan: verbose tracing toggled on via control socket (-k)
 };
 
 /* TCB flags */
@@ -600,10 +652,12 @@ extern void expand_tcbtab(void);
 extern void set_sortby(const char *);
 extern void set_overhead(int);
 extern void qualify(const char *);
+extern int qualify_syscall_if_known(const char *);
 extern int get_scno(struct tcb *);
 extern long known_scno(struct tcb *);
 extern long do_ptrace(int request, struct tcb *tcp, void *addr, void *data);
 extern int ptrace_restart(int request, struct tcb *tcp, int sig);
+extern int ptrace_resume(struct tcb *tcp, int sig);
 extern int force_result(struct tcb *, int, long);
 extern int trace_syscall(struct tcb *);
 extern int count_syscall(struct tcb *, struct timeval *);
@@ -0,0 +1,189 @@
+/*******************************************************************************
+module:   envblock
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  environment block of a cde-package root (its saved
+          cde.full-environment.<root> file), parsed once, to set as the
+          environment of the tracer or to lay out as the envp of a traced
+          proc's execve
+*******************************************************************************/
+
+/*******************************************************************************
+ * SYSTEM INCLUDES
+ ******************************************************************************/
+
+#include <errno.h>      // ISOC: errno
+#include <stdio.h>      // ISOC: FILE, fopen(), fread(), fclose()
+#include <stdlib.h>     // ISOC: calloc(), realloc(), free()
+#include <string.h>     // ISOC: memchr(), memcpy(), strcmp(), strlen()
+
+/*******************************************************************************
+ * USER INCLUDES
+ ******************************************************************************/
+
+#include "envblock.h"
+#include "strmap.h"     // StrMap, strmap_new(), strmap_put(), strmap_contains(), ...
+
+/*******************************************************************************
+ * PRIVATE TYPES / CONSTANTS / VARIABLES
+ ******************************************************************************/
+
+struct EnvBlock {
+  char* strings;            // the vars, each "name=value\0"
+  size_t strings_len;
+  size_t* var_offsets;      // offset of each var in strings
+  size_t num_vars;
+};
+
+/*******************************************************************************
+ * PRIVATE MACROS / FUNCTIONS
+ ******************************************************************************/
+
+// append var "name=value" to env (name of name_len bytes)
+static void add_var (EnvBlock* env, size_t* strings_cap, const char* name, size_t name_len,
+                     const char* value, size_t value_len) {
+  const size_t len = name_len + 1 + value_len + 1;
+  while (env->strings_len + len > *strings_cap) {
+    *strings_cap = (*strings_cap > 0) ? (*strings_cap * 2) : 4096;
+    env->strings = (char*)realloc(env->strings, *strings_cap);
+  }
+  char* s = env->strings + env->strings_len;
+  memcpy(s, name, name_len);
+  s[name_len] = '=';
+  memcpy(s + name_len + 1, value, value_len);
+  s[len - 1] = '\0';
+
+  env->var_offsets = (size_t*)realloc(env->var_offsets, (env->num_vars + 1) * sizeof(size_t));
+  env->var_offsets[env->num_vars++] = env->strings_len;
+  env->strings_len += len;
+}
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+EnvBlock* envblock_parse (const char* mem, size_t size, char* const* ignore_names,
+                          char* const* ignore_values, int num_ignores) {
+  EnvBlock* env = (EnvBlock*)calloc(1, sizeof(EnvBlock));
+  size_t strings_cap = 0;
+  StrMap* seen = strmap_new();
+  char* name = NULL;
+  size_t name_cap = 0;
+
+  const char* end = mem + size;
+  for (const char* s = mem; s < end && *s; ) {
+    const char* nul = (const char*)memchr(s, '\0', end - s);
+    const char* s_end = nul ? nul : end;
+    const char* eq = (const char*)memchr(s, '=', s_end - s);
+
+    // skip strings with an empty name, or none (e.g., a trailing newline)
+    if (eq && eq != s) {
+      const size_t name_len = eq - s;
+      if (name_len + 1 > name_cap) {
+        name_cap = name_len + 1;
+        name = (char*)realloc(name, name_cap);
+      }
+      memcpy(name, s, name_len);
+      name[name_len] = '\0';
+
+      if (!strmap_contains(seen, name)) {
+        strmap_put(seen, name, NULL);
+        int i = 0;
+        while (i < num_ignores && strcmp(name, ignore_names[i]) != 0) {
+          i++;
+        }
+        if (i == num_ignores) {
+          add_var(env, &strings_cap, s, name_len, eq + 1, s_end - (eq + 1));
+        } else if (ignore_values[i]) {
+          add_var(env, &strings_cap, s, name_len, ignore_values[i], strlen(ignore_values[i]));
+        }
+      }
+    }
+    s = s_end + 1;
+  }
+
+  free(name);
+  strmap_free(seen, NULL);
+  return env;
+}
+
+char* envblock_read (const char* path, size_t* size) {
+  FILE* f = fopen(path, "rb");
+  if (!f) {
+    return NULL;
+  }
+  char* mem = NULL;
+  size_t cap = 0;
+  size_t n;
+  *size = 0;
+  do {
+    if (*size == cap) {
+      cap = (cap > 0) ? (cap * 2) : 4096;
+      mem = (char*)realloc(mem, cap);
+    }
+    n = fread(mem + *size, 1, cap - *size, f);
+    *size += n;
+  } while (n > 0);
+  const int err = ferror(f) ? errno : 0;
+  fclose(f);
+  if (err) {
+    free(mem);
+    errno = err;
+    return NULL;
+  }
+  return mem;
+}
+
+EnvBlock* envblock_load (const char* path, char* const* ignore_names,
+                         char* const* ignore_values, int num_ignores) {
+  size_t size;
+  char* mem = envblock_read(path, &size);
+  if (!mem) {
+    return NULL;
+  }
+  EnvBlock* env = envblock_parse(mem, size, ignore_names, ignore_values, num_ignores);
+  free(mem);
+  return env;
+}
+
+void envblock_free (EnvBlock* env) {
+  if (env) {
+    free(env->strings);
+    free(env->var_offsets);
+    free(env);
+  }
+}
+
+size_t envblock_num_vars (const EnvBlock* env) {
+  return env->num_vars;
+}
+
+const char* envblock_var (const EnvBlock* env, size_t i) {
+  return env->strings + env->var_offsets[i];
+}
+
+long envblock_layout (const EnvBlock* env, char* buf, size_t buf_size,
+                      unsigned long child_addr, size_t word_size) {
+  // strings first, then the array, aligned to a word
+  const size_t array_offset = (env->strings_len + word_size - 1) / word_size * word_size;
+  const size_t total = array_offset + (env->num_vars + 1) * word_size;
+  if (total > buf_size) {
+    return -1;
+  }
+
+  if (env->strings_len > 0) {
+    memcpy(buf, env->strings, env->strings_len);
+  }
+  char* array = buf + array_offset;
+  for (size_t i = 0; i <= env->num_vars; i++) {
+    const unsigned long addr = (i < env->num_vars) ? (child_addr + env->var_offsets[i]) : 0;
+    // (a 32-bit proc traced by a 64-bit tracer takes 4-byte pointers)
+    if (word_size == sizeof(unsigned int)) {
+      const unsigned int addr32 = (unsigned int)addr;
+      memcpy(array + i * word_size, &addr32, word_size);
+    } else {
+      memcpy(array + i * word_size, &addr, word_size);
+    }
+  }
+  return (long)array_offset;
+}
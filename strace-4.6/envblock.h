@@ -0,0 +1,75 @@
+/*******************************************************************************
+module:   envblock
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  environment block of a cde-package root (its saved
+          cde.full-environment.<root> file), parsed once, to set as the
+          environment of the tracer or to lay out as the envp of a traced
+          proc's execve
+notes:    - the file holds "name=value" strings, each NUL-terminated; the
+            first string of a name wins, and strings without a name are
+            skipped (as setenv() without overwrite, after clearenv(), did)
+          - ignored vars (cde.options ignore_environment_var) keep the value
+            they have on this machine, or are left out if unset here
+*******************************************************************************/
+
+#ifndef ENVBLOCK_H
+#define ENVBLOCK_H 1
+
+// allow this header to be included from c++ source file
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*******************************************************************************
+ * SYSTEM INCLUDES
+ ******************************************************************************/
+
+#include <stddef.h>     // ISOC: size_t
+
+/*******************************************************************************
+ * PUBLIC TYPES / CONSTANTS / VARIABLES
+ ******************************************************************************/
+
+// opaque environment block type
+typedef struct EnvBlock EnvBlock;
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+// parse the size bytes of environment file contents at mem, replacing each of
+// the num_ignores vars named in ignore_names with its value in ignore_values
+// (or leaving it out if NULL), return new block
+EnvBlock* envblock_parse (const char* mem, size_t size, char* const* ignore_names,
+                          char* const* ignore_values, int num_ignores);
+
+// return contents of the environment file at path (caller frees), and set
+// *size to its size, or return NULL on error (errno set)
+char* envblock_read (const char* path, size_t* size);
+
+// parse the environment file at path (as envblock_parse does), return new
+// block, or NULL on error (errno set)
+EnvBlock* envblock_load (const char* path, char* const* ignore_names,
+                         char* const* ignore_values, int num_ignores);
+void envblock_free (EnvBlock* env);
+
+// return num vars in env
+size_t envblock_num_vars (const EnvBlock* env);
+
+// return var i of env, as "name=value" (owned by env)
+const char* envblock_var (const EnvBlock* env, size_t i);
+
+// lay out the strings of env, then a NULL-terminated array of pointers to
+// them (each word_size bytes, as addresses in a proc that sees buf at
+// child_addr), into buf[buf_size]
+// return offset of the array in buf, or -1 if env does not fit
+long envblock_layout (const EnvBlock* env, char* buf, size_t buf_size,
+                      unsigned long child_addr, size_t word_size);
+
+// allow this header to be included from c++ source file
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ENVBLOCK_H
@@ -42,6 +42,7 @@ extern void CDE_begin_at_fileop(struct tcb* tcp, const char* syscall_name);
 
 extern void CDE_begin_file_unlink(struct tcb* tcp);
 extern void CDE_begin_file_unlinkat(struct tcb* tcp);
+extern void CDE_end_file_unlink(struct tcb* tcp);
 
 extern void CDE_begin_file_link(struct tcb* tcp);
 extern void CDE_begin_file_linkat(struct tcb* tcp);
@@ -2067,6 +2068,8 @@ int sys_unlink (struct tcb* tcp) {
   // modified by pgbovine
   if (entering(tcp)) {
     CDE_begin_file_unlink(tcp);
+  } else {
+    CDE_end_file_unlink(tcp);
   }
   return 0;
 }
@@ -2090,6 +2093,8 @@ int sys_unlinkat (struct tcb* tcp) {
     // act like unlink()
     if (entering(tcp)) {
       CDE_begin_file_unlinkat(tcp);
+    } else {
+      CDE_end_file_unlink(tcp);
     }
   }
 
@@ -31,6 +31,7 @@
  */
 
 #include "defs.h"
+#include "provenance.h"
 
 #include <fcntl.h>
 #if HAVE_SYS_UIO_H
@@ -51,11 +52,15 @@ extern void CDEnet_write(struct tcb* tcp);
 extern int printllval (struct tcb*, const char*, int);  // from strace util.c
 
 int sys_read (struct tcb* tcp) {
+	if (exiting(tcp))
+		account_read_prov(tcp);
 	return 0;
 }
 
 int sys_write (struct tcb* tcp) {
-    return 0;
+	if (exiting(tcp))
+		account_write_prov(tcp);
+	return 0;
 }
 
 #if HAVE_SYS_UIO_H
@@ -133,6 +138,8 @@ unsigned long addr;
 int
 sys_readv(struct tcb *tcp)
 {
+	if (exiting(tcp))
+		account_read_prov(tcp);
 	if (entering(tcp)) {
 		printfd(tcp, tcp->u_arg[0]);
 		tprintf(", ");
@@ -151,6 +158,8 @@ sys_readv(struct tcb *tcp)
 int
 sys_writev(struct tcb *tcp)
 {
+	if (exiting(tcp))
+		account_write_prov(tcp);
 	if (entering(tcp)) {
 		printfd(tcp, tcp->u_arg[0]);
 		tprintf(", ");
@@ -159,6 +168,22 @@ sys_writev(struct tcb *tcp)
 	}
 	return 0;
 }
+
+int
+sys_preadv(struct tcb *tcp)
+{
+	if (exiting(tcp))
+		account_read_prov(tcp);
+	return printargs(tcp);
+}
+
+int
+sys_pwritev(struct tcb *tcp)
+{
+	if (exiting(tcp))
+		account_write_prov(tcp);
+	return printargs(tcp);
+}
 #endif
 
 #if defined(SVR4)
@@ -166,6 +191,8 @@ sys_writev(struct tcb *tcp)
 int
 sys_pread(struct tcb *tcp)
 {
+	if (exiting(tcp))
+		account_read_prov(tcp);
 	if (entering(tcp)) {
 		printfd(tcp, tcp->u_arg[0]);
 		tprintf(", ");
@@ -188,6 +215,8 @@ sys_pread(struct tcb *tcp)
 int
 sys_pwrite(struct tcb *tcp)
 {
+	if (exiting(tcp))
+		account_write_prov(tcp);
 	if (entering(tcp)) {
 		printfd(tcp, tcp->u_arg[0]);
 		tprintf(", ");
@@ -264,6 +293,8 @@ sys_sendfile(struct tcb *tcp)
 int
 sys_pread(struct tcb *tcp)
 {
+	if (exiting(tcp))
+		account_read_prov(tcp);
 	if (entering(tcp)) {
 		printfd(tcp, tcp->u_arg[0]);
 		tprintf(", ");
@@ -281,6 +312,8 @@ sys_pread(struct tcb *tcp)
 int
 sys_pwrite(struct tcb *tcp)
 {
+	if (exiting(tcp))
+		account_write_prov(tcp);
 	if (entering(tcp)) {
 		printfd(tcp, tcp->u_arg[0]);
 		tprintf(", ");
@@ -339,6 +372,8 @@ sys_sendfile64(struct tcb *tcp)
 int
 sys_pread64(struct tcb *tcp)
 {
+	if (exiting(tcp))
+		account_read_prov(tcp);
 	if (entering(tcp)) {
 		printfd(tcp, tcp->u_arg[0]);
 		tprintf(", ");
@@ -356,6 +391,8 @@ sys_pread64(struct tcb *tcp)
 int
 sys_pwrite64(struct tcb *tcp)
 {
+	if (exiting(tcp))
+		account_write_prov(tcp);
 	if (entering(tcp)) {
 		printfd(tcp, tcp->u_arg[0]);
 		tprintf(", ");
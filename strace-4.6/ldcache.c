@@ -0,0 +1,507 @@
+/*******************************************************************************
+module:   ldcache
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  generate an ld.so.cache for the shared libs present in a cde-root,
+          so that a replayed ld-linux finds each lib with a single open()
+ref:      glibc sysdeps/generic/dl-cache.h (struct cache_file_new)
+*******************************************************************************/
+
+/*******************************************************************************
+ * SYSTEM INCLUDES
+ ******************************************************************************/
+
+#include <dirent.h>       // P2001: DIR, struct dirent, opendir(), readdir(), closedir()
+#include <elf.h>          // GLIBC: Elf32_Ehdr, Elf64_Ehdr, Elf*_Phdr, Elf*_Dyn, PT_DYNAMIC, DT_SONAME
+#include <fcntl.h>        // P2001: open(), O_RDONLY
+#include <glob.h>         // P2001: glob(), globfree()
+#include <stdbool.h>      // ISOC: bool
+#include <stdint.h>       // ISOC: uint32_t, uint64_t
+#include <stdio.h>        // ISOC: fopen(), fwrite(), rename(), snprintf(), getline()
+#include <stdlib.h>       // ISOC: malloc(), realloc(), free(), qsort(), realpath()
+#include <string.h>       // ISOC: strdup(), strlen(), strstr(), strncmp(), memcpy()
+#include <sys/stat.h>     // P2001: stat(), lstat(), S_ISREG(), S_ISLNK()
+#include <unistd.h>       // P2001: read(), pread(), close(), unlink()
+
+/*******************************************************************************
+ * USER INCLUDES
+ ******************************************************************************/
+
+#include "ldcache.h"
+
+/*******************************************************************************
+ * PRIVATE TYPES / CONSTANTS / VARIABLES
+ ******************************************************************************/
+
+#define CACHEMAGIC_NEW "glibc-ld.so.cache"
+#define CACHE_VERSION "1.1"
+#define CACHE_FLAGS_ENDIAN_LITTLE 2     // cache_file_new.flags
+
+#define FLAG_ELF_LIBC6 0x0003           // file_entry_new.flags
+#define FLAG_X8664_LIB64 0x0300
+
+#define MAX_CONF_DEPTH 8                // of nested "include"s in ld.so.conf
+#define MAX_SONAME_LEN 256
+
+// on-disk header of a "new format only" cache (glibc 2.3+ understands it)
+typedef struct {
+  char magic[sizeof(CACHEMAGIC_NEW) - 1];
+  char version[sizeof(CACHE_VERSION) - 1];
+  uint32_t nlibs;
+  uint32_t len_strings;
+  uint8_t flags;
+  uint8_t padding_unused[3];
+  uint32_t extension_offset;
+  uint32_t unused[3];
+} CacheFileNew;
+
+// on-disk entry: key/value are string offsets from the start of the file
+typedef struct {
+  int32_t flags;
+  uint32_t key;
+  uint32_t value;
+  uint32_t osversion_unused;
+  uint64_t hwcap;
+} FileEntryNew;
+
+typedef struct {
+  char* lib;      // DT_SONAME (or file name, if none), e.g., "libc.so.6"
+  char* path;     // e.g., "/lib/x86_64-linux-gnu/libc.so.6"
+  int32_t flags;
+  int dir_rank;   // order its dir was scanned in (first wins, as in ldconfig)
+  bool is_soname; // its file name is lib (the soname link, which ld.so opens)
+} LibEntry;
+
+typedef struct {
+  LibEntry* libs;
+  int num;
+  int max;
+} LibList;
+
+typedef struct {
+  char** dirs;    // e.g., "/usr/lib/x86_64-linux-gnu"
+  char** reals;   // their real paths within root (for dropping aliases)
+  int num;
+  int max;
+} DirList;
+
+// dirs that ld.so searches without ld.so.conf (trusted dirs of ldconfig)
+static const char* const default_lib_dirs[] = {
+  "/lib/x86_64-linux-gnu", "/usr/lib/x86_64-linux-gnu", "/lib64", "/usr/lib64",
+  "/lib/i386-linux-gnu", "/usr/lib/i386-linux-gnu", "/lib32", "/usr/lib32",
+  "/lib", "/usr/lib", NULL
+};
+
+/*******************************************************************************
+ * PRIVATE MACROS / FUNCTIONS
+ ******************************************************************************/
+
+// return cache entry flags if path is an x86/x86_64 ELF shared lib, else -1
+static int32_t shared_lib_flags (const char* path) {
+  struct stat st;
+  if (stat(path, &st) != 0 || !S_ISREG(st.st_mode))
+    return -1;
+
+  Elf32_Ehdr ehdr;  // fields up to e_machine are the same for 32 and 64-bit
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return -1;
+  ssize_t n = read(fd, &ehdr, sizeof(ehdr));
+  close(fd);
+
+  if (n != sizeof(ehdr) || memcmp(ehdr.e_ident, ELFMAG, SELFMAG) != 0 ||
+      ehdr.e_ident[EI_DATA] != ELFDATA2LSB || ehdr.e_type != ET_DYN)
+    return -1;
+
+  if (ehdr.e_ident[EI_CLASS] == ELFCLASS64 && ehdr.e_machine == EM_X86_64)
+    return FLAG_ELF_LIBC6 | FLAG_X8664_LIB64;
+  if (ehdr.e_ident[EI_CLASS] == ELFCLASS32 && ehdr.e_machine == EM_386)
+    return FLAG_ELF_LIBC6;
+  return -1;
+}
+
+// read program header i of an ELF of class is64 (from its ehdr fields) as 64-bit
+static bool read_phdr (int fd, bool is64, uint64_t phoff, unsigned phentsize, unsigned i,
+                       Elf64_Phdr* ph) {
+  const off_t at = (off_t)(phoff + (uint64_t)i * phentsize);
+  if (is64)
+    return pread(fd, ph, sizeof(*ph), at) == (ssize_t)sizeof(*ph);
+  Elf32_Phdr ph32;
+  if (pread(fd, &ph32, sizeof(ph32), at) != (ssize_t)sizeof(ph32))
+    return false;
+  ph->p_type = ph32.p_type;
+  ph->p_offset = ph32.p_offset;
+  ph->p_vaddr = ph32.p_vaddr;
+  ph->p_filesz = ph32.p_filesz;
+  return true;
+}
+
+// return file offset of vaddr (in a PT_LOAD segment of the ELF), or 0
+static uint64_t vaddr_offset (int fd, bool is64, uint64_t phoff, unsigned phentsize,
+                              unsigned phnum, uint64_t vaddr) {
+  Elf64_Phdr ph;
+  for (unsigned i = 0; i < phnum; i++) {
+    if (read_phdr(fd, is64, phoff, phentsize, i, &ph) && ph.p_type == PT_LOAD &&
+        vaddr >= ph.p_vaddr && vaddr < ph.p_vaddr + ph.p_filesz)
+      return vaddr - ph.p_vaddr + ph.p_offset;
+  }
+  return 0;
+}
+
+// return malloc-ed DT_SONAME of the ELF shared lib at path, or NULL if none
+// (found as ld.so finds it: via PT_DYNAMIC, so stripped libs work too)
+static char* read_soname (const char* path) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return NULL;
+
+  char* soname = NULL;
+  Elf64_Ehdr eh64;
+  Elf32_Ehdr* eh32 = (Elf32_Ehdr*)&eh64;
+  if (pread(fd, &eh64, sizeof(eh64), 0) != (ssize_t)sizeof(eh64)) {
+    close(fd);
+    return NULL;
+  }
+  const bool is64 = (eh64.e_ident[EI_CLASS] == ELFCLASS64);
+  const uint64_t phoff = is64 ? eh64.e_phoff : eh32->e_phoff;
+  const unsigned phentsize = is64 ? eh64.e_phentsize : eh32->e_phentsize;
+  const unsigned phnum = is64 ? eh64.e_phnum : eh32->e_phnum;
+
+  Elf64_Phdr dyn_ph;
+  bool found = false;
+  for (unsigned i = 0; i < phnum && !found; i++)
+    found = read_phdr(fd, is64, phoff, phentsize, i, &dyn_ph) && dyn_ph.p_type == PT_DYNAMIC;
+
+  // DT_SONAME is an offset into the string table at DT_STRTAB (a vaddr)
+  uint64_t strtab = 0, soname_off = 0;
+  bool has_soname = false;
+  const size_t dyn_size = is64 ? sizeof(Elf64_Dyn) : sizeof(Elf32_Dyn);
+  for (uint64_t off = 0; found && off + dyn_size <= dyn_ph.p_filesz; off += dyn_size) {
+    int64_t tag;
+    uint64_t val;
+    if (is64) {
+      Elf64_Dyn d;
+      if (pread(fd, &d, sizeof(d), (off_t)(dyn_ph.p_offset + off)) != (ssize_t)sizeof(d))
+        break;
+      tag = d.d_tag;
+      val = d.d_un.d_val;
+    }
+    else {
+      Elf32_Dyn d;
+      if (pread(fd, &d, sizeof(d), (off_t)(dyn_ph.p_offset + off)) != (ssize_t)sizeof(d))
+        break;
+      tag = d.d_tag;
+      val = d.d_un.d_val;
+    }
+    if (tag == DT_NULL)
+      break;
+    if (tag == DT_STRTAB)
+      strtab = val;
+    if (tag == DT_SONAME) {
+      soname_off = val;
+      has_soname = true;
+    }
+  }
+
+  const uint64_t strtab_off = (has_soname && strtab) ?
+                              vaddr_offset(fd, is64, phoff, phentsize, phnum, strtab) : 0;
+  if (strtab_off) {
+    char buf[MAX_SONAME_LEN];
+    ssize_t n = pread(fd, buf, sizeof(buf), (off_t)(strtab_off + soname_off));
+    if (n > 0 && memchr(buf, '\0', n) && buf[0] != '\0' && !strchr(buf, '/'))
+      soname = strdup(buf);
+  }
+  close(fd);
+  return soname;
+}
+
+// add dir (abs path within root) to dirs, unless it is missing, is outside of
+// root, or is the same dir as one already in dirs (e.g., /lib -> usr/lib)
+static void add_dir (DirList* dirs, const char* root, const char* real_root, const char* dir) {
+  char* full = (char*)malloc(strlen(root) + strlen(dir) + 2);
+  sprintf(full, "%s/%s", root, dir);
+  char* real = realpath(full, NULL);
+  free(full);
+  size_t len = (real && strcmp(real_root, "/") != 0) ? strlen(real_root) : 0;
+  if (!real || strncmp(real, real_root, len) != 0 || (real[len] != '/' && real[len] != '\0')) {
+    free(real);
+    return;
+  }
+  for (int i = 0; i < dirs->num; i++) {
+    if (strcmp(dirs->reals[i], real) == 0) {
+      free(real);
+      return;
+    }
+  }
+  if (dirs->num == dirs->max) {
+    dirs->max = dirs->max ? dirs->max * 2 : 32;
+    dirs->dirs = (char**)realloc(dirs->dirs, dirs->max * sizeof(char*));
+    dirs->reals = (char**)realloc(dirs->reals, dirs->max * sizeof(char*));
+  }
+  // (without trailing '/', so values join as "<dir>/<lib>")
+  len = strlen(dir);
+  while (len > 1 && dir[len - 1] == '/')
+    len--;
+  dirs->dirs[dirs->num] = strndup(dir, len);
+  dirs->reals[dirs->num] = real;
+  dirs->num++;
+}
+
+// add the dirs of ld.so.conf file conf (abs path within root), and of the
+// files it includes, to dirs
+static void add_conf_dirs (DirList* dirs, const char* root, const char* real_root,
+                           const char* conf, int depth) {
+  char* full = (char*)malloc(strlen(root) + strlen(conf) + 2);
+  sprintf(full, "%s/%s", root, conf);
+  FILE* f = (depth < MAX_CONF_DEPTH) ? fopen(full, "r") : NULL;
+  free(full);
+  if (!f)
+    return;
+
+  char* line = NULL;
+  size_t cap = 0;
+  while (getline(&line, &cap, f) > 0) {
+    line[strcspn(line, "#\n")] = '\0';
+    char* s = line + strspn(line, " \t");
+    if (strncmp(s, "include", 7) == 0 && (s[7] == ' ' || s[7] == '\t')) {
+      // (a relative pattern is relative to the dir of conf, as in ldconfig)
+      char* pattern = s + 8 + strspn(s + 8, " \t");
+      pattern[strcspn(pattern, " \t")] = '\0';
+      const char* slash = strrchr(conf, '/');
+      const size_t conf_dir_len = (pattern[0] == '/' || !slash) ? 0 : (size_t)(slash - conf) + 1;
+      char* glob_path = (char*)malloc(strlen(root) + conf_dir_len + strlen(pattern) + 2);
+      sprintf(glob_path, "%s/%.*s%s", root, (int)conf_dir_len, conf, pattern);
+      glob_t g;
+      if (glob(glob_path, 0, NULL, &g) == 0) {
+        for (size_t i = 0; i < g.gl_pathc; i++)
+          add_conf_dirs(dirs, root, real_root, g.gl_pathv[i] + strlen(root), depth + 1);
+        globfree(&g);
+      }
+      free(glob_path);
+    }
+    else if (s[0] == '/') {
+      s[strcspn(s, " \t=")] = '\0';  // (old "dir=TYPE" syntax)
+      add_dir(dirs, root, real_root, s);
+    }
+  }
+  free(line);
+  fclose(f);
+}
+
+// add the shared libs directly in dir (abs path within root) to libs
+static void scan_dir (LibList* libs, const char* root, const char* dir, int dir_rank) {
+  char* full_dir = (char*)malloc(strlen(root) + strlen(dir) + 2);
+  sprintf(full_dir, "%s/%s", root, dir);
+  DIR* d = opendir(full_dir);
+  if (!d) {
+    free(full_dir);
+    return;
+  }
+
+  struct dirent* de;
+  while ((de = readdir(d)) != NULL) {
+    const char* name = de->d_name;
+    if (name[0] == '.' || !strstr(name, ".so"))
+      continue;
+
+    // follows symlinks, which okapi makes relative, so they stay in root
+    // (a "<lib>.so" link for ld(1) is listed by its name, as ldconfig does)
+    char* full = (char*)malloc(strlen(full_dir) + strlen(name) + 2);
+    sprintf(full, "%s/%s", full_dir, name);
+    int32_t flags = shared_lib_flags(full);
+    struct stat lst;
+    const size_t name_len = strlen(name);
+    const bool is_dev_link = (lstat(full, &lst) == 0 && S_ISLNK(lst.st_mode) &&
+                              strcmp(name + name_len - 3, ".so") == 0);
+    char* soname = (flags < 0 || is_dev_link) ? NULL : read_soname(full);
+    free(full);
+    if (flags < 0)
+      continue;
+
+    if (libs->num == libs->max) {
+      libs->max = libs->max ? libs->max * 2 : 256;
+      libs->libs = (LibEntry*)realloc(libs->libs, libs->max * sizeof(LibEntry));
+    }
+    LibEntry* e = &libs->libs[libs->num++];
+    e->lib = soname ? soname : strdup(name);
+    e->path = (char*)malloc(strlen(dir) + strlen(name) + 2);
+    sprintf(e->path, "%s/%s", (strcmp(dir, "/") == 0) ? "" : dir, name);
+    e->flags = flags;
+    e->dir_rank = dir_rank;
+    e->is_soname = (strcmp(e->lib, name) == 0);
+  }
+  closedir(d);
+  free(full_dir);
+}
+
+// sort order of ldconfig: decreasing lib name, then decreasing flags (then
+// the soname link, and the first dir scanned, as the one ldconfig keeps)
+static int compare_entries (const void* a, const void* b) {
+  const LibEntry* e1 = (const LibEntry*)a;
+  const LibEntry* e2 = (const LibEntry*)b;
+
+  int res = ld_cache_libcmp(e2->lib, e1->lib);
+  if (res != 0)
+    return res;
+  if (e1->flags != e2->flags)
+    return (e1->flags < e2->flags) ? 1 : -1;
+  if (e1->is_soname != e2->is_soname)
+    return e1->is_soname ? -1 : 1;
+  if (e1->dir_rank != e2->dir_rank)
+    return (e1->dir_rank < e2->dir_rank) ? -1 : 1;
+  return strcmp(e1->path, e2->path);
+}
+
+static void free_lib_list (LibList* libs) {
+  for (int i = 0; i < libs->num; i++) {
+    free(libs->libs[i].lib);
+    free(libs->libs[i].path);
+  }
+  free(libs->libs);
+}
+
+static void free_dir_list (DirList* dirs) {
+  for (int i = 0; i < dirs->num; i++) {
+    free(dirs->dirs[i]);
+    free(dirs->reals[i]);
+  }
+  free(dirs->dirs);
+  free(dirs->reals);
+}
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+// same as _dl_cache_libcmp() in glibc elf/dl-cache.c
+int ld_cache_libcmp (const char* p1, const char* p2) {
+  while (*p1 != '\0') {
+    if (*p1 >= '0' && *p1 <= '9') {
+      if (*p2 >= '0' && *p2 <= '9') {
+        // must compare this numerically
+        int val1 = *p1++ - '0';
+        int val2 = *p2++ - '0';
+        while (*p1 >= '0' && *p1 <= '9')
+          val1 = val1 * 10 + *p1++ - '0';
+        while (*p2 >= '0' && *p2 <= '9')
+          val2 = val2 * 10 + *p2++ - '0';
+        if (val1 != val2)
+          return val1 - val2;
+      }
+      else {
+        return 1;
+      }
+    }
+    else if (*p2 >= '0' && *p2 <= '9') {
+      return -1;
+    }
+    else if (*p1 != *p2) {
+      return *p1 - *p2;
+    }
+    else {
+      ++p1;
+      ++p2;
+    }
+  }
+  return *p1 - *p2;
+}
+
+int write_ld_so_cache (const char* root_dir, const char* cache_path) {
+  int ret = -1;
+  FILE* f = NULL;
+  char* tmp_path = NULL;
+
+  LibList libs = { NULL, 0, 0 };
+  DirList dirs = { NULL, 0, 0 };
+  char* real_root = realpath(root_dir, NULL);
+  if (!real_root)
+    goto done;
+
+  // scan the dirs that ldconfig would (not app-private dirs, e.g. of RPATHs,
+  // whose libs ld.so finds without the cache)
+  add_conf_dirs(&dirs, root_dir, real_root, "/etc/ld.so.conf", 0);
+  for (int i = 0; default_lib_dirs[i]; i++)
+    add_dir(&dirs, root_dir, real_root, default_lib_dirs[i]);
+  for (int i = 0; i < dirs.num; i++)
+    scan_dir(&libs, root_dir, dirs.dirs[i], i);
+
+  qsort(libs.libs, libs.num, sizeof(LibEntry), compare_entries);
+
+  // drop duplicate (lib, flags) pairs, since ld.so would only use one of them
+  int nlibs = 0;
+  for (int i = 0; i < libs.num; i++) {
+    if (nlibs > 0 && libs.libs[i].flags == libs.libs[nlibs - 1].flags &&
+        strcmp(libs.libs[i].lib, libs.libs[nlibs - 1].lib) == 0) {
+      free(libs.libs[i].lib);
+      free(libs.libs[i].path);
+      continue;
+    }
+    libs.libs[nlibs++] = libs.libs[i];
+  }
+  libs.num = nlibs;
+
+  uint32_t strings_offset = sizeof(CacheFileNew) + nlibs * sizeof(FileEntryNew);
+  uint32_t len_strings = 0;
+  for (int i = 0; i < nlibs; i++)
+    len_strings += strlen(libs.libs[i].lib) + 1 + strlen(libs.libs[i].path) + 1;
+
+  CacheFileNew header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, CACHEMAGIC_NEW, sizeof(header.magic));
+  memcpy(header.version, CACHE_VERSION, sizeof(header.version));
+  header.nlibs = nlibs;
+  header.len_strings = len_strings;
+  header.flags = CACHE_FLAGS_ENDIAN_LITTLE;
+
+  // write to a temp file and rename it over cache_path, so that we never
+  // write through a hard link to the host's /etc/ld.so.cache
+  size_t tmp_path_len = strlen(cache_path) + 5;
+  tmp_path = (char*)malloc(tmp_path_len);
+  snprintf(tmp_path, tmp_path_len, "%s.tmp", cache_path);
+  f = fopen(tmp_path, "wb");
+  if (!f)
+    goto done;
+
+  fwrite(&header, sizeof(header), 1, f);
+
+  uint32_t str_pos = strings_offset;
+  for (int i = 0; i < nlibs; i++) {
+    FileEntryNew entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.flags = libs.libs[i].flags;
+    entry.key = str_pos;
+    str_pos += strlen(libs.libs[i].lib) + 1;
+    entry.value = str_pos;
+    str_pos += strlen(libs.libs[i].path) + 1;
+    fwrite(&entry, sizeof(entry), 1, f);
+  }
+
+  for (int i = 0; i < nlibs; i++) {
+    fwrite(libs.libs[i].lib, strlen(libs.libs[i].lib) + 1, 1, f);
+    fwrite(libs.libs[i].path, strlen(libs.libs[i].path) + 1, 1, f);
+  }
+
+  if (fclose(f) != 0) {
+    f = NULL;
+    unlink(tmp_path);
+    goto done;
+  }
+  f = NULL;
+
+  if (rename(tmp_path, cache_path) != 0) {
+    unlink(tmp_path);
+    goto done;
+  }
+
+  ret = nlibs;
+
+done:
+  if (f)
+    fclose(f);
+  free(tmp_path);
+  free_lib_list(&libs);
+  free_dir_list(&dirs);
+  free(real_root);
+  return ret;
+}
+
@@ -0,0 +1,41 @@
+/*******************************************************************************
+module:   ldcache
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  generate an ld.so.cache for the shared libs present in a cde-root,
+          so that a replayed ld-linux finds each lib with a single open()
+ref:      glibc sysdeps/generic/dl-cache.h (struct cache_file_new)
+*******************************************************************************/
+
+#ifndef LDCACHE_H
+#define LDCACHE_H 1
+
+// allow this header to be included from c++ source file
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*******************************************************************************
+ * PUBLIC MACROS / FUNCTIONS
+ ******************************************************************************/
+
+// compare lib names the way ld.so does (digit runs compared numerically)
+// NOTE ld.so.cache entries are sorted in DEcreasing order of this comparison
+int ld_cache_libcmp (const char* p1, const char* p2);
+
+// scan the lib dirs of root_dir that ldconfig would (those listed in its
+// /etc/ld.so.conf, then the default lib dirs, e.g. /usr/lib) for x86/x86_64
+// shared libs (names containing ".so"), and write an ld.so.cache to
+// cache_path that maps the DT_SONAME of each lib (or its name, if none) to its
+// path relative to root_dir (e.g., "libc.so.6" -> "/lib/x86_64-linux-gnu/libc.so.6")
+// NOTE cache_path is replaced (never written through, in case it's a hard link)
+// return num libs in written cache, or -1 on error
+int write_ld_so_cache (const char* root_dir, const char* cache_path);
+
+// allow this header to be included from c++ source file
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LDCACHE_H
+
@@ -0,0 +1,416 @@
+/*******************************************************************************
+module:   libdeps
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  resolve the shared library closure of ELF binaries (DT_NEEDED,
+          DT_RPATH, DT_RUNPATH), and prefetch it in background threads
+*******************************************************************************/
+
+/*******************************************************************************
+ * SYSTEM INCLUDES
+ ******************************************************************************/
+
+#include <elf.h>          // GLIBC: EI_NIDENT, EI_CLASS, ELFCLASS32, ELFCLASS64
+#include <fcntl.h>        // P2001: open(), O_RDONLY
+#include <pthread.h>      // P2001: pthread_t, pthread_mutex_t, pthread_cond_t
+#include <stdbool.h>      // ISOC: bool, true, false
+#include <stdio.h>        // ISOC: snprintf()
+#include <stdlib.h>       // ISOC: malloc(), calloc(), free(), realpath()
+#include <string.h>       // ISOC: strdup(), strlen(), strchr(), strncmp()
+#include <sys/param.h>    // P2001: MAXPATHLEN
+#include <sys/stat.h>     // P2001: stat(), S_ISREG()
+#include <unistd.h>       // P2001: read(), close()
+
+/*******************************************************************************
+ * USER INCLUDES
+ ******************************************************************************/
+
+#include "libdeps.h"
+#include "perftimers.h"   // start_perf_timer(), stop_perf_timer(), count_perf_event()
+
+/*******************************************************************************
+ * EXTERNALLY-DEFINED FUNCTIONS
+ ******************************************************************************/
+
+// from ../readelf-mini/readelf-mini.c
+extern int find_ELF_dynamic_deps (char* file_name, char*** needed,
+                                  char** rpath, char** runpath);
+
+/*******************************************************************************
+ * PUBLIC VARIABLES
+ ******************************************************************************/
+
+pthread_mutex_t mut_findelf = PTHREAD_MUTEX_INITIALIZER; // make find_ELF_* calls threadsafe
+
+/*******************************************************************************
+ * PRIVATE TYPES / CONSTANTS / VARIABLES
+ ******************************************************************************/
+
+#define MAX_PREFETCH_WORKERS 64
+#define SEEN_BUCKETS 4096       // buckets in hash set of already-queued paths
+
+// default search dirs of ld.so, used after rpath/LD_LIBRARY_PATH/runpath
+static const char* const default_lib_dirs_64[] = {
+  "/lib/x86_64-linux-gnu", "/usr/lib/x86_64-linux-gnu",
+  "/lib64", "/usr/lib64", "/lib", "/usr/lib", NULL
+};
+static const char* const default_lib_dirs_32[] = {
+  "/lib/i386-linux-gnu", "/usr/lib/i386-linux-gnu",
+  "/lib32", "/usr/lib32", "/lib", "/usr/lib", NULL
+};
+
+// one ELF object whose DT_NEEDED entries are still to be resolved
+typedef struct PrefetchJob {
+  char* elf_abspath;
+  char* ld_library_path;        // from env of exec'd process, or NULL
+  char* exe_rpath;              // DT_RPATH of the executable, or NULL
+  struct PrefetchJob* next;
+} PrefetchJob;
+
+// node in hash set of paths already queued (so each lib is handled once)
+typedef struct SeenPath {
+  char* path;
+  struct SeenPath* next;
+} SeenPath;
+
+static pthread_mutex_t mut_prefetch = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cond_prefetch = PTHREAD_COND_INITIALIZER;
+static pthread_t workers[MAX_PREFETCH_WORKERS];
+static int num_workers_started = 0;
+static int num_workers_busy = 0;
+static bool shutting_down = false;
+static LibPrefetchFunc prefetch_func_cb = NULL;
+static PrefetchJob* queue_head = NULL;
+static PrefetchJob* queue_tail = NULL;
+static SeenPath* seen_paths[SEEN_BUCKETS];
+
+/*******************************************************************************
+ * PRIVATE MACROS / FUNCTIONS
+ ******************************************************************************/
+
+static char* strdup_or_null (const char* s) {
+  return s ? strdup(s) : NULL;
+}
+
+// return the ELF class (32/64) of an existing regular file, or -1 otherwise
+static int elf_class_of_file (const char* path) {
+  struct stat st;
+  if (stat(path, &st) != 0 || !S_ISREG(st.st_mode))
+    return -1;
+
+  unsigned char ident[EI_NIDENT];
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return -1;
+  ssize_t n = read(fd, ident, sizeof(ident));
+  close(fd);
+
+  if (n != sizeof(ident) || strncmp((char*)ident, ELFMAG, SELFMAG) != 0)
+    return -1;
+  if (ident[EI_CLASS] == ELFCLASS32)
+    return 32;
+  if (ident[EI_CLASS] == ELFCLASS64)
+    return 64;
+  return -1;
+}
+
+// expand $ORIGIN and ${ORIGIN} in one search dir, return malloc'd string
+static char* expand_origin (const char* dir, size_t dir_len, const char* origin_dir) {
+  char* expanded = (char*)malloc(MAXPATHLEN);
+  size_t out = 0;
+  size_t i = 0;
+
+  while (i < dir_len && out < MAXPATHLEN - 1) {
+    size_t tok_len = 0;
+    if (strncmp(&dir[i], "$ORIGIN", 7) == 0)
+      tok_len = 7;
+    else if (strncmp(&dir[i], "${ORIGIN}", 9) == 0)
+      tok_len = 9;
+
+    if (tok_len && origin_dir && i + tok_len <= dir_len) {
+      size_t origin_len = strlen(origin_dir);
+      if (out + origin_len >= MAXPATHLEN - 1)
+        break;
+      memcpy(&expanded[out], origin_dir, origin_len);
+      out += origin_len;
+      i += tok_len;
+    }
+    else {
+      expanded[out++] = dir[i++];
+    }
+  }
+
+  expanded[out] = '\0';
+  return expanded;
+}
+
+// look for lib_name in each dir of colon-separated search_path
+static char* search_lib_path (const char* lib_name, const char* search_path,
+                              const char* origin_dir, int elf_class) {
+  if (!search_path)
+    return NULL;
+
+  const char* dir = search_path;
+  while (true) {
+    const char* end = strchr(dir, ':');
+    size_t dir_len = end ? (size_t)(end - dir) : strlen(dir);
+
+    // empty entry means current dir in ld.so, which we can't know here
+    if (dir_len > 0) {
+      char* expanded = expand_origin(dir, dir_len, origin_dir);
+      char candidate[MAXPATHLEN];
+      int len = snprintf(candidate, sizeof(candidate), "%s/%s", expanded, lib_name);
+      free(expanded);
+      if (len > 0 && len < (int)sizeof(candidate) && candidate[0] == '/' &&
+          elf_class_of_file(candidate) == elf_class) {
+        return strdup(candidate);
+      }
+    }
+
+    if (!end)
+      break;
+    dir = end + 1;
+  }
+
+  return NULL;
+}
+
+static unsigned long hash_path (const char* path) {
+  unsigned long h = 5381;
+  while (*path)
+    h = ((h << 5) + h) + (unsigned char)*path++;
+  return h;
+}
+
+// add path to seen set; return true if it was NOT already there
+// NOTE caller must hold mut_prefetch
+static bool mark_seen (const char* path) {
+  unsigned long b = hash_path(path) % SEEN_BUCKETS;
+  for (SeenPath* s = seen_paths[b]; s; s = s->next) {
+    if (strcmp(s->path, path) == 0)
+      return false;
+  }
+  SeenPath* s = (SeenPath*)malloc(sizeof(SeenPath));
+  s->path = strdup(path);
+  s->next = seen_paths[b];
+  seen_paths[b] = s;
+  return true;
+}
+
+// append job to queue and wake up a worker
+// NOTE caller must hold mut_prefetch
+static void enqueue_job (char* elf_abspath, char* ld_library_path, char* exe_rpath) {
+  PrefetchJob* job = (PrefetchJob*)malloc(sizeof(PrefetchJob));
+  job->elf_abspath = elf_abspath;
+  job->ld_library_path = ld_library_path;
+  job->exe_rpath = exe_rpath;
+  job->next = NULL;
+
+  if (queue_tail)
+    queue_tail->next = job;
+  else
+    queue_head = job;
+  queue_tail = job;
+
+  pthread_cond_signal(&cond_prefetch);
+}
+
+static void free_job (PrefetchJob* job) {
+  free(job->elf_abspath);
+  free(job->ld_library_path);
+  free(job->exe_rpath);
+  free(job);
+}
+
+// resolve DT_NEEDED entries of one object: copy and queue each new lib
+static void process_job (PrefetchJob* job) {
+  char** needed = NULL;
+  char* rpath = NULL;
+  char* runpath = NULL;
+
+  pthread_mutex_lock(&mut_findelf);
+  start_perf_timer(ELF_PARSING);
+  int elf_class = find_ELF_dynamic_deps(job->elf_abspath, &needed, &rpath, &runpath);
+  stop_perf_timer(ELF_PARSING);
+  count_perf_event(ELF_FILES_PARSED, 1);
+  pthread_mutex_unlock(&mut_findelf);
+
+  if (elf_class < 0)
+    goto done;
+
+  // the first job of a closure is the executable itself: its DT_RPATH
+  // applies to all of its deps (unless they have their own DT_RUNPATH)
+  char* exe_rpath = job->exe_rpath;
+  if (!exe_rpath && !runpath && rpath)
+    exe_rpath = rpath;
+
+  char origin_dir[MAXPATHLEN];
+  if (!realpath(job->elf_abspath, origin_dir))
+    strncpy(origin_dir, job->elf_abspath, sizeof(origin_dir) - 1);
+  origin_dir[sizeof(origin_dir) - 1] = '\0';
+  char* slash = strrchr(origin_dir, '/');
+  if (slash)
+    *(slash == origin_dir ? slash + 1 : slash) = '\0';
+
+  for (char** n = needed; n && *n; n++) {
+    char* lib = NULL;
+
+    if (strchr(*n, '/')) {
+      if ((*n)[0] == '/' && elf_class_of_file(*n) == elf_class)
+        lib = strdup(*n);
+    }
+    else {
+      // DT_RPATH is ignored by ld.so if this object has a DT_RUNPATH
+      if (!runpath)
+        lib = search_lib_path(*n, rpath, origin_dir, elf_class);
+      if (!lib && !runpath && exe_rpath != rpath)
+        lib = search_lib_path(*n, exe_rpath, origin_dir, elf_class);
+      if (!lib)
+        lib = resolve_needed_lib(*n, origin_dir, NULL, job->ld_library_path, runpath, elf_class);
+    }
+
+    if (!lib)
+      continue;
+
+    pthread_mutex_lock(&mut_prefetch);
+    bool is_new = mark_seen(lib);
+    if (is_new) {
+      enqueue_job(strdup(lib), strdup_or_null(job->ld_library_path),
+                  strdup_or_null(exe_rpath));
+    }
+    pthread_mutex_unlock(&mut_prefetch);
+
+    if (is_new)
+      prefetch_func_cb(lib);
+
+    free(lib);
+  }
+
+done:
+  for (char** n = needed; n && *n; n++)
+    free(*n);
+  free(needed);
+  free(rpath);
+  free(runpath);
+}
+
+static void* prefetch_worker (void* arg) {
+  (void)arg;
+
+  pthread_mutex_lock(&mut_prefetch);
+  while (true) {
+    while (!queue_head && !(shutting_down && num_workers_busy == 0))
+      pthread_cond_wait(&cond_prefetch, &mut_prefetch);
+
+    // no more work, and no busy worker that could queue more
+    if (!queue_head)
+      break;
+
+    PrefetchJob* job = queue_head;
+    queue_head = job->next;
+    if (!queue_head)
+      queue_tail = NULL;
+    num_workers_busy++;
+    pthread_mutex_unlock(&mut_prefetch);
+
+    process_job(job);
+    free_job(job);
+
+    pthread_mutex_lock(&mut_prefetch);
+    num_workers_busy--;
+    pthread_cond_broadcast(&cond_prefetch);
+  }
+  pthread_mutex_unlock(&mut_prefetch);
+
+  return NULL;
+}
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+char* resolve_needed_lib (const char* lib_name, const char* origin_dir,
+                          const char* rpath, const char* ld_library_path,
+                          const char* runpath, int elf_class) {
+  char* lib = NULL;
+
+  if (strchr(lib_name, '/')) {
+    if (lib_name[0] == '/' && elf_class_of_file(lib_name) == elf_class)
+      return strdup(lib_name);
+    return NULL;
+  }
+
+  if (!runpath && (lib = search_lib_path(lib_name, rpath, origin_dir, elf_class)))
+    return lib;
+
+  // $ORIGIN in LD_LIBRARY_PATH isn't expanded for setuid progs, but close enough
+  if ((lib = search_lib_path(lib_name, ld_library_path, origin_dir, elf_class)))
+    return lib;
+
+  if ((lib = search_lib_path(lib_name, runpath, origin_dir, elf_class)))
+    return lib;
+
+  const char* const* dirs = (elf_class == 32) ? default_lib_dirs_32 : default_lib_dirs_64;
+  for (int i = 0; dirs[i]; i++) {
+    if ((lib = search_lib_path(lib_name, dirs[i], NULL, elf_class)))
+      return lib;
+  }
+
+  return NULL;
+}
+
+void start_lib_prefetch (int num_workers, LibPrefetchFunc prefetch_func) {
+  if (num_workers <= 0 || num_workers_started > 0)
+    return;
+  if (num_workers > MAX_PREFETCH_WORKERS)
+    num_workers = MAX_PREFETCH_WORKERS;
+
+  prefetch_func_cb = prefetch_func;
+  shutting_down = false;
+
+  for (int i = 0; i < num_workers; i++) {
+    if (pthread_create(&workers[i], NULL, prefetch_worker, NULL) != 0)
+      break;
+    num_workers_started++;
+  }
+}
+
+void queue_lib_prefetch (const char* elf_abspath, const char* ld_library_path) {
+  if (num_workers_started == 0 || !elf_abspath || elf_abspath[0] != '/')
+    return;
+
+  // an executable is only re-resolved if it's exec'd with a new LD_LIBRARY_PATH
+  char exe_key[MAXPATHLEN * 2];
+  snprintf(exe_key, sizeof(exe_key), "%s\n%s", elf_abspath,
+           ld_library_path ? ld_library_path : "");
+
+  pthread_mutex_lock(&mut_prefetch);
+  mark_seen(elf_abspath);
+  if (mark_seen(exe_key))
+    enqueue_job(strdup(elf_abspath), strdup_or_null(ld_library_path), NULL);
+  pthread_mutex_unlock(&mut_prefetch);
+}
+
+void finish_lib_prefetch (void) {
+  if (num_workers_started == 0)
+    return;
+
+  pthread_mutex_lock(&mut_prefetch);
+  shutting_down = true;
+  pthread_cond_broadcast(&cond_prefetch);
+  pthread_mutex_unlock(&mut_prefetch);
+
+  for (int i = 0; i < num_workers_started; i++)
+    pthread_join(workers[i], NULL);
+  num_workers_started = 0;
+
+  for (int b = 0; b < SEEN_BUCKETS; b++) {
+    while (seen_paths[b]) {
+      SeenPath* s = seen_paths[b];
+      seen_paths[b] = s->next;
+      free(s->path);
+      free(s);
+    }
+  }
+}
+
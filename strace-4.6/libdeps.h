@@ -0,0 +1,58 @@
+/*******************************************************************************
+module:   libdeps
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  resolve the shared library closure of ELF binaries (DT_NEEDED,
+          DT_RPATH, DT_RUNPATH), and prefetch it in background threads
+*******************************************************************************/
+
+#ifndef LIBDEPS_H
+#define LIBDEPS_H 1
+
+#include <pthread.h>      // P2001: pthread_mutex_t
+
+// allow this header to be included from c++ source file
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*******************************************************************************
+ * PUBLIC TYPES / CONSTANTS / VARIABLES
+ ******************************************************************************/
+
+// called by prefetch workers on each resolved library (an absolute path)
+typedef void (*LibPrefetchFunc) (char* lib_abspath);
+
+// readelf-mini keeps global state: hold this lock around all find_ELF_* calls
+extern pthread_mutex_t mut_findelf;
+
+/*******************************************************************************
+ * PUBLIC MACROS / FUNCTIONS
+ ******************************************************************************/
+
+// resolve needed lib name (e.g. "libc.so.6") of an object in origin_dir, the
+// way ld.so does: rpath (NULL if runpath present), ld_library_path, runpath,
+// then default lib dirs for elf_class (32/64).  $ORIGIN expanded in paths.
+// return malloc'd abs path of the lib, or NULL if not found
+char* resolve_needed_lib (const char* lib_name, const char* origin_dir,
+                          const char* rpath, const char* ld_library_path,
+                          const char* runpath, int elf_class);
+
+// start num_workers threads, which call prefetch_func once per resolved lib
+// NOTE does nothing if num_workers <= 0, or if workers already started
+void start_lib_prefetch (int num_workers, LibPrefetchFunc prefetch_func);
+
+// queue an ELF binary for background resolution of its library closure
+// NOTE ld_library_path is the value in the env of the exec'd process (or NULL)
+void queue_lib_prefetch (const char* elf_abspath, const char* ld_library_path);
+
+// wait for all queued work to finish, then stop and join all workers
+void finish_lib_prefetch (void);
+
+// allow this header to be included from c++ source file
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LIBDEPS_H
+
@@ -71,7 +71,7 @@ int sys_getpgid(), sys_fchdir(), sys_bdflush();
 int sys_sysfs(), sys_personality(), sys_afs_syscall();
 int sys_setfsuid(), sys_setfsgid(), sys_llseek();
 int sys_getdents(), sys_flock(), sys_msync();
-int sys_readv(), sys_writev(), sys_select();
+int sys_readv(), sys_writev(), sys_preadv(), sys_pwritev(), sys_select();
 int sys_getsid(), sys_fdatasync(), sys_sysctl();
 int sys_mlock(), sys_munlock(), sys_mlockall(), sys_munlockall(), sys_madvise();
 int sys_sched_setparam(), sys_sched_getparam();
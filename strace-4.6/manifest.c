@@ -0,0 +1,255 @@
+/*******************************************************************************
+module:   manifest
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  persistent list of the files captured into a cde-root, so that a
+          later audit into the same package can skip unchanged files
+*******************************************************************************/
+
+/*******************************************************************************
+ * SYSTEM INCLUDES
+ ******************************************************************************/
+
+#include <fcntl.h>        // P2001: open(), O_RDONLY
+#include <inttypes.h>     // ISOC: PRIx64, SCNx64
+#include <stdio.h>        // ISOC: fopen(), fprintf(), sscanf(), rename()
+#include <stdlib.h>       // ISOC: malloc(), free(), qsort()
+#include <string.h>       // ISOC: strcmp(), strchr(), strlen()
+#include <unistd.h>       // P2001: read(), close(), unlink()
+
+/*******************************************************************************
+ * USER INCLUDES
+ ******************************************************************************/
+
+#include "manifest.h"
+
+/*******************************************************************************
+ * PRIVATE TYPES / CONSTANTS / VARIABLES
+ ******************************************************************************/
+
+// first line of a manifest, followed by dev and inode of its cde-root
+#define MANIFEST_HEADER "# ptu capture manifest v1, cde-root:"
+
+#define FNV64_OFFSET_BASIS 0xcbf29ce484222325ULL
+#define FNV64_PRIME 0x100000001b3ULL
+
+#define HASH_BUF_SIZE (1 << 16)
+
+// used to collect map entries for sorting
+typedef struct {
+  const char** paths;
+  int num_paths;
+} PathList;
+
+/*******************************************************************************
+ * PRIVATE MACROS / FUNCTIONS
+ ******************************************************************************/
+
+static void free_entry (void* entry) {
+  free(entry);
+}
+
+static void collect_path (const char* path, void* entry, void* paths) {
+  (void)entry;
+  PathList* list = (PathList*)paths;
+  list->paths[list->num_paths++] = path;
+}
+
+static int compare_paths (const void* a, const void* b) {
+  return strcmp(*(const char* const*)a, *(const char* const*)b);
+}
+
+// return sorted list of the paths in manifest (caller frees list.paths)
+static PathList sorted_paths (const StrMap* manifest) {
+  PathList list;
+  list.num_paths = 0;
+  list.paths = (const char**)malloc((strmap_size(manifest) + 1) * sizeof(char*));
+  strmap_foreach(manifest, collect_path, &list);
+  qsort(list.paths, list.num_paths, sizeof(char*), compare_paths);
+  return list;
+}
+
+// parse one manifest line: "dev ino size mtime_sec.mtime_nsec hash path"
+// (hash is '-' if unknown), return 0 on success
+static int parse_entry (char* line, ManifestEntry* entry, char** path) {
+  unsigned long long dev, ino;
+  long long size, mtime_sec;
+  long mtime_nsec;
+  char hash_str[17];
+  int path_pos = 0;
+
+  if (sscanf(line, "%llu %llu %lld %lld.%ld %16s %n",
+             &dev, &ino, &size, &mtime_sec, &mtime_nsec, hash_str, &path_pos) != 6 ||
+      path_pos == 0 || line[path_pos] != '/') {
+    return -1;
+  }
+
+  entry->dev = (dev_t)dev;
+  entry->ino = (ino_t)ino;
+  entry->size = (off_t)size;
+  entry->mtime.tv_sec = (time_t)mtime_sec;
+  entry->mtime.tv_nsec = mtime_nsec;
+  entry->has_hash = (sscanf(hash_str, "%" SCNx64, &entry->hash) == 1);
+  entry->touched = false;
+  *path = line + path_pos;
+  return 0;
+}
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+StrMap* manifest_load (const char* manifest_path, const struct stat* root_stat) {
+  StrMap* manifest = strmap_new();
+
+  FILE* f = fopen(manifest_path, "r");
+  if (!f) {
+    return manifest;
+  }
+
+  char* line = NULL;
+  size_t len = 0;
+  ssize_t read;
+
+  // a manifest of another cde-root would make us skip files that are missing
+  unsigned long long root_dev, root_ino;
+  if ((read = getline(&line, &len, f)) == -1 ||
+      sscanf(line, MANIFEST_HEADER " %llu %llu", &root_dev, &root_ino) != 2 ||
+      root_dev != (unsigned long long)root_stat->st_dev ||
+      root_ino != (unsigned long long)root_stat->st_ino) {
+    goto done;
+  }
+
+  while ((read = getline(&line, &len, f)) != -1) {
+    if (read > 0 && line[read-1] == '\n') {
+      line[read-1] = '\0';
+    }
+
+    ManifestEntry entry;
+    char* path = NULL;
+    if (parse_entry(line, &entry, &path) != 0) {
+      continue;
+    }
+
+    ManifestEntry* new_entry = (ManifestEntry*)malloc(sizeof(ManifestEntry));
+    *new_entry = entry;
+    free(strmap_put(manifest, path, new_entry));
+  }
+
+done:
+  free(line);
+  fclose(f);
+  return manifest;
+}
+
+int manifest_save (const StrMap* manifest, const char* manifest_path, const struct stat* root_stat) {
+  PathList list = sorted_paths(manifest);
+
+  // write to a temp file and rename it, so a crash never truncates a manifest
+  size_t tmp_path_len = strlen(manifest_path) + 5;
+  char* tmp_path = (char*)malloc(tmp_path_len);
+  snprintf(tmp_path, tmp_path_len, "%s.tmp", manifest_path);
+
+  int ret = -1;
+  FILE* f = fopen(tmp_path, "w");
+  if (!f) {
+    goto done;
+  }
+
+  fprintf(f, MANIFEST_HEADER " %llu %llu\n",
+          (unsigned long long)root_stat->st_dev, (unsigned long long)root_stat->st_ino);
+
+  for (int i = 0; i < list.num_paths; i++) {
+    // paths with newlines can't be listed, so they just get re-copied
+    if (strchr(list.paths[i], '\n')) {
+      continue;
+    }
+    const ManifestEntry* e = (const ManifestEntry*)strmap_get(manifest, list.paths[i]);
+    fprintf(f, "%llu %llu %lld %lld.%09ld ",
+            (unsigned long long)e->dev, (unsigned long long)e->ino, (long long)e->size,
+            (long long)e->mtime.tv_sec, (long)e->mtime.tv_nsec);
+    if (e->has_hash) {
+      fprintf(f, "%016" PRIx64 " %s\n", e->hash, list.paths[i]);
+    }
+    else {
+      fprintf(f, "- %s\n", list.paths[i]);
+    }
+  }
+
+  if (fclose(f) != 0 || rename(tmp_path, manifest_path) != 0) {
+    unlink(tmp_path);
+    goto done;
+  }
+
+  ret = 0;
+
+done:
+  free(tmp_path);
+  free(list.paths);
+  return ret;
+}
+
+int manifest_save_untouched (const StrMap* manifest, const char* list_path) {
+  FILE* f = fopen(list_path, "w");
+  if (!f) {
+    return -1;
+  }
+
+  PathList list = sorted_paths(manifest);
+  for (int i = 0; i < list.num_paths; i++) {
+    const ManifestEntry* e = (const ManifestEntry*)strmap_get(manifest, list.paths[i]);
+    if (!e->touched) {
+      fprintf(f, "%s\n", list.paths[i]);
+    }
+  }
+  free(list.paths);
+
+  return (fclose(f) == 0) ? 0 : -1;
+}
+
+void manifest_free (StrMap* manifest) {
+  strmap_free(manifest, free_entry);
+}
+
+void manifest_entry_set_stat (ManifestEntry* entry, const struct stat* st) {
+  entry->dev = st->st_dev;
+  entry->ino = st->st_ino;
+  entry->size = st->st_size;
+  entry->mtime = st->st_mtim;
+  entry->has_hash = false;
+}
+
+bool manifest_entry_matches (const ManifestEntry* entry, const struct stat* st) {
+  return entry->dev == st->st_dev &&
+         entry->ino == st->st_ino &&
+         entry->size == st->st_size &&
+         entry->mtime.tv_sec == st->st_mtim.tv_sec &&
+         entry->mtime.tv_nsec == st->st_mtim.tv_nsec;
+}
+
+int hash_file_contents (const char* path, uint64_t* hash) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return -1;
+  }
+
+  unsigned char* buf = (unsigned char*)malloc(HASH_BUF_SIZE);
+  uint64_t h = FNV64_OFFSET_BASIS;
+  ssize_t n;
+  while ((n = read(fd, buf, HASH_BUF_SIZE)) > 0) {
+    for (ssize_t i = 0; i < n; i++) {
+      h ^= buf[i];
+      h *= FNV64_PRIME;
+    }
+  }
+
+  free(buf);
+  close(fd);
+  if (n < 0) {
+    return -1;
+  }
+
+  *hash = h;
+  return 0;
+}
+
@@ -0,0 +1,81 @@
+/*******************************************************************************
+module:   manifest
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  persistent list of the files captured into a cde-root, so that a
+          later audit into the same package can skip unchanged files
+*******************************************************************************/
+
+#ifndef MANIFEST_H
+#define MANIFEST_H 1
+
+// allow this header to be included from c++ source file
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*******************************************************************************
+ * SYSTEM INCLUDES
+ ******************************************************************************/
+
+#include <stdbool.h>    // ISOC: bool
+#include <stdint.h>     // ISOC: uint64_t
+#include <sys/stat.h>   // P2001: struct stat
+#include <time.h>       // P2008: struct timespec
+
+/*******************************************************************************
+ * USER INCLUDES
+ ******************************************************************************/
+
+#include "strmap.h"     // StrMap
+
+/*******************************************************************************
+ * PUBLIC TYPES / CONSTANTS / VARIABLES
+ ******************************************************************************/
+
+// state of one original (host) file when it was captured
+typedef struct {
+  dev_t dev;
+  ino_t ino;
+  off_t size;
+  struct timespec mtime;
+  uint64_t hash;      // hash of file contents (only valid if has_hash)
+  bool has_hash;
+  bool touched;       // accessed during the current audit (not persisted)
+} ManifestEntry;
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+// return map of abspath -> ManifestEntry* loaded from manifest_path, or an
+// empty map if there is no manifest, or if it was saved for another cde-root
+// (e.g., because cde-root was deleted and re-created since)
+StrMap* manifest_load (const char* manifest_path, const struct stat* root_stat);
+
+// save manifest (sorted by path) to manifest_path, return 0 on success
+int manifest_save (const StrMap* manifest, const char* manifest_path, const struct stat* root_stat);
+
+// write the (sorted) paths of entries not touched during this audit to
+// list_path, one per line, return 0 on success
+int manifest_save_untouched (const StrMap* manifest, const char* list_path);
+
+// free manifest and its entries
+void manifest_free (StrMap* manifest);
+
+// set entry to the state of a file, as given by its stat (clears the hash)
+void manifest_entry_set_stat (ManifestEntry* entry, const struct stat* st);
+
+// return true if entry was captured from the file with this stat
+bool manifest_entry_matches (const ManifestEntry* entry, const struct stat* st);
+
+// compute 64-bit FNV-1a hash of contents of file at path, return 0 on success
+int hash_file_contents (const char* path, uint64_t* hash);
+
+// allow this header to be included from c++ source file
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MANIFEST_H
+
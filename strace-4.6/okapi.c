@@ -268,12 +268,19 @@ static char* canonicalize_relpath(char* relpath, char* base) {
 }
 
 char* canonicalize_path(char* path, char* relpath_base) {
+  char* ret;
+
+  // optionally track time of canonicalizing paths
+  start_perf_timer(PATH_CANONICALIZATION);
   if (IS_ABSPATH(path)) {
-    return canonicalize_abspath(path);
+    ret = canonicalize_abspath(path);
   }
   else {
-    return canonicalize_relpath(path, relpath_base);
+    ret = canonicalize_relpath(path, relpath_base);
   }
+  stop_perf_timer(PATH_CANONICALIZATION);
+
+  return ret;
 }
 
 
@@ -826,7 +833,7 @@ void okapi_copy_file(char* src_filename, char* dst_filename, int perms) {
   start_perf_timer(AUDIT_FILE_COPYING);
 
   inF = open(src_filename, O_RDONLY); // note that we might not have permission to open src_filename
-  if ((outF = open(dst_filename, O_WRONLY | O_CREAT, perms)) < 0) {
+  if ((outF = open(dst_filename, O_WRONLY | O_CREAT | O_TRUNC, perms)) < 0) {
     fprintf(stderr, "Error in copy_file: cannot create '%s'\n", dst_filename);
     exit(1);
   }
@@ -835,8 +842,10 @@ void okapi_copy_file(char* src_filename, char* dst_filename, int perms) {
   if (inF >= 0) {
     while ((bytes = read(inF, buf, sizeof(buf))) > 0) {
       write(outF, buf, bytes);
+      count_perf_event(BYTES_COPIED, bytes);
     }
     close(inF);
+    count_perf_event(FILES_COPIED, 1);
   }
   else {
     // always print this message regardless of OKAPI_VERBOSE
@@ -0,0 +1,50 @@
+/*******************************************************************************
+module:   pathrules
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  lists of exact/prefix/substring path rules (e.g., the ignore_* and
+          redirect_* directives of cde.options), and matching paths to them
+*******************************************************************************/
+
+/*******************************************************************************
+ * SYSTEM INCLUDES
+ ******************************************************************************/
+
+#include <string.h>     // ISOC: strcmp(), strncmp(), strstr(), strlen()
+
+/*******************************************************************************
+ * USER INCLUDES
+ ******************************************************************************/
+
+#include "pathrules.h"
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+bool pathrules_match_exact (const PathRules* rules, const char* path) {
+  for (int i = 0; i < rules->exact_paths_ind; i++) {
+    if (strcmp(path, rules->exact_paths[i]) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool pathrules_match (const PathRules* rules, const char* path) {
+  if (pathrules_match_exact(rules, path)) {
+    return true;
+  }
+  for (int i = 0; i < rules->prefix_paths_ind; i++) {
+    const char* p = rules->prefix_paths[i];
+    if (strncmp(path, p, strlen(p)) == 0) {
+      return true;
+    }
+  }
+  for (int i = 0; i < rules->substr_paths_ind; i++) {
+    if (strstr(path, rules->substr_paths[i])) {
+      return true;
+    }
+  }
+  return false;
+}
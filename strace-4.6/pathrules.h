@@ -0,0 +1,56 @@
+/*******************************************************************************
+module:   pathrules
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  lists of exact/prefix/substring path rules (e.g., the ignore_* and
+          redirect_* directives of cde.options), and matching paths to them
+*******************************************************************************/
+
+#ifndef PATHRULES_H
+#define PATHRULES_H 1
+
+// allow this header to be included from c++ source file
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*******************************************************************************
+ * SYSTEM INCLUDES
+ ******************************************************************************/
+
+#include <stdbool.h>    // ISOC: bool
+
+/*******************************************************************************
+ * PUBLIC TYPES / CONSTANTS / VARIABLES
+ ******************************************************************************/
+
+// max num rules of each kind
+#define MAX_PATH_RULES 100
+
+// yeah, statically-sized arrays are dumb but easy to implement :)
+typedef struct {
+  char* exact_paths[MAX_PATH_RULES];
+  char* prefix_paths[MAX_PATH_RULES];
+  char* substr_paths[MAX_PATH_RULES];
+  int exact_paths_ind;
+  int prefix_paths_ind;
+  int substr_paths_ind;
+} PathRules;
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+// return true if path is one of the exact paths of rules
+bool pathrules_match_exact (const PathRules* rules, const char* path);
+
+// return true if path is one of the exact paths, starts with one of the
+// prefix paths, or contains one of the substr paths of rules
+bool pathrules_match (const PathRules* rules, const char* path);
+
+// allow this header to be included from c++ source file
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PATHRULES_H
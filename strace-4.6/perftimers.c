@@ -3,14 +3,25 @@ module:   perftimers
 author:   digimokan
 date:     14 JUL 2017 (created)
 purpose:  start, stop, and output specific pre-configured performance timers
+          and event counters (accumulated per thread, summed when reported)
 timers:   AUDIT_FILE_COPYING (track total time spent copying files during audit)
+          TRACE_STOP_HANDLING (handling a ptrace syscall stop of a child)
+          CHILD_MEMORY_READS (reading strings/buffers out of child memory)
+          PATH_CANONICALIZATION (turning child paths into absolute paths)
+          PATH_RULE_MATCHING (matching paths against cde.options rules)
+          PROVENANCE_WRITES (formatting and writing provenance log records)
+          ELF_PARSING (reading interpreters and deps out of ELF files)
 *******************************************************************************/
 
 /*******************************************************************************
  * SYSTEM INCLUDES
  ******************************************************************************/
 
+#include <pthread.h>        // P2001: pthread_mutex_lock(), pthread_mutex_unlock()
 #include <stdbool.h>        // ISOC: for bool data type
+#include <stdint.h>         // ISOC: uint64_t
+#include <stdlib.h>         // ISOC: calloc()
+#include <sys/resource.h>   // P2001: getrusage()
 #include <time.h>           // P2001: for struct timespec, clock_gettime
 
 /*******************************************************************************
@@ -23,13 +34,55 @@ timers:   AUDIT_FILE_COPYING (track total time spent copying files during audit)
  * PRIVATE TYPES / CONSTANTS / VARIABLES
  ******************************************************************************/
 
-#define NSEC_PER_SEC 1000000000     // nanosec per sec: for timespec arithmetic
+#define NSEC_PER_SEC 1000000000     // nanosec per sec: for converting totals
 #define NO_TIMERS 0                 // if no perf timers are enabled/started
 
+// use the raw hw clock if available: it is not slewed by ntp adjustments
+#ifdef CLOCK_MONOTONIC_RAW
+#  define PERF_CLOCK CLOCK_MONOTONIC_RAW
+#else
+#  define PERF_CLOCK CLOCK_MONOTONIC
+#endif
+
+// timer/counter state of one thread (only the owning thread starts, stops, or
+// adds to it; other threads read it, and zero it out when a timer is enabled)
+typedef struct ThreadTimes {
+  int timers_running;               // bit flags track which timers started/stopped
+  uint64_t start_times[NUM_TIMERS]; // save timer start times (nanosec)
+  uint64_t total_times[NUM_TIMERS]; // save timer cumulative start-to-stop times (nanosec)
+  long long counts[NUM_COUNTERS];   // save counter totals
+  struct ThreadTimes* next;
+} ThreadTimes;
+
 static int timers_status = NO_TIMERS;   // bit flags track which timers enabled/disabled
-static int timers_running = NO_TIMERS;  // bit flags track which timers started/stopped
-static struct timespec start_times[NUM_TIMERS]; // save timer start times
-static struct timespec total_times[NUM_TIMERS]; // save timer cumulative start-to-stop times
+static int counters_status = DISABLED;  // counters are enabled/disabled all together
+
+static __thread ThreadTimes* this_thread_times = NULL;  // state of calling thread
+static ThreadTimes* all_thread_times = NULL;            // states of all threads that used timers
+static pthread_mutex_t mut_thread_times = PTHREAD_MUTEX_INITIALIZER;  // guards all_thread_times
+
+static const char* timer_names[NUM_TIMERS] = {
+  "file copying",
+  "trace stop handling",
+  "child memory reads",
+  "path canonicalization",
+  "path rule matching",
+  "provenance writes",
+  "ELF parsing"
+};
+
+static const char* counter_names[NUM_COUNTERS] = {
+  "trace stops",
+  "child memory reads",
+  "files copied",
+  "bytes copied",
+  "provenance records",
+  "ELF files parsed",
+  "capture cache hits",
+  "capture cache misses",
+  "redirect cache hits",
+  "redirect cache misses"
+};
 
 /*******************************************************************************
  * PRIVATE MACROS / FUNCTIONS
@@ -49,54 +102,53 @@ static inline int get_index (const PerfTimer pt) {
   return index;
 }
 
+// return current time of the perf clock in nanosec
+static inline uint64_t now_ns (void) {
+  struct timespec ts;
+  clock_gettime(PERF_CLOCK, &ts);
+  return ((uint64_t)ts.tv_sec * NSEC_PER_SEC) + (uint64_t)ts.tv_nsec;
+}
+
+// return timer/counter state of calling thread (create it on first use)
+static ThreadTimes* get_thread_times (void) {
+  if (!this_thread_times) {
+    ThreadTimes* tt = (ThreadTimes*)calloc(1, sizeof(ThreadTimes));
+    pthread_mutex_lock(&mut_thread_times);
+    tt->next = all_thread_times;
+    all_thread_times = tt;
+    pthread_mutex_unlock(&mut_thread_times);
+    this_thread_times = tt;
+  }
+  return this_thread_times;
+}
+
 // return true if specific perf timer bit flag is "enabled"
 static inline bool is_enabled (const PerfTimer pt) {
-  return ( (bool) (timers_status & pt) );
+  return ( (bool) (__atomic_load_n(&timers_status, __ATOMIC_RELAXED) & pt) );
 }
 
 // set specific perf timer "enabled" bit flag
 static inline void set_enabled (const PerfTimer pt) {
-  timers_status |= pt;
+  __atomic_fetch_or(&timers_status, pt, __ATOMIC_RELAXED);
 }
 
 // unset specific perf timer "enabled" bit flag
 static inline void set_disabled (const PerfTimer pt) {
-  timers_status &= (~pt);
+  __atomic_fetch_and(&timers_status, ~pt, __ATOMIC_RELAXED);
 }
 
-// return true if specific perf timer bit flag is "started"
+// return true if specific perf timer bit flag is "started" in calling thread
 static inline bool is_started (const PerfTimer pt) {
-  return ( (bool) (timers_running & pt) );
-}
-
-// set specific perf timer "started" bit flag
-static inline void set_started (const PerfTimer pt) {
-  timers_running |= pt;
-}
-
-// unset specific perf timer "started" bit flag
-static inline void set_stopped (const PerfTimer pt) {
-  timers_running &= (~pt);
+  return ( this_thread_times && (this_thread_times->timers_running & pt) );
 }
 
-// subtract two timespecs: tstotal = tsa - tsb
-static inline void sub_ts (struct timespec* const tstotal, const struct timespec* const tsa, const struct timespec* const tsb) {
-  tstotal->tv_sec = tsa->tv_sec - tsb->tv_sec;
-  tstotal->tv_nsec = tsa->tv_nsec - tsb->tv_nsec;
-  if (tstotal->tv_nsec < 0) {
-    tstotal->tv_sec--;
-    tstotal->tv_nsec += NSEC_PER_SEC;
-  }
-}
-
-// add two timespecs: tstotal = tsa + tsb
-static inline void add_ts (struct timespec* const tstotal, const struct timespec* const tsa, const struct timespec* const tsb) {
-  tstotal->tv_sec = tsa->tv_sec + tsb->tv_sec;
-  tstotal->tv_nsec = tsa->tv_nsec + tsb->tv_nsec;
-  if (tstotal->tv_nsec > NSEC_PER_SEC) {
-    tstotal->tv_sec++;
-    tstotal->tv_nsec -= NSEC_PER_SEC;
+// zero out accumulated time of specific perf timer in all threads
+static void zero_total_times (const int ptindex) {
+  pthread_mutex_lock(&mut_thread_times);
+  for (ThreadTimes* tt = all_thread_times; tt; tt = tt->next) {
+    __atomic_store_n(&tt->total_times[ptindex], 0, __ATOMIC_RELAXED);
   }
+  pthread_mutex_unlock(&mut_thread_times);
 }
 
 // enable or disable specific perf timer and return success/error of the action
@@ -109,9 +161,7 @@ static inline TimerAction set_timer (const PerfTimer pt, const TimerStatus stat_
     act = ERR_TIMER_ALREADY_ENABLED;
   // trying to enable timer that's currently disabled: enable it
   } else if ( (stat_req == ENABLED) && (!pt_enabled) ) {
-    const int ptindex = get_index(pt);
-    total_times[ptindex].tv_sec = 0;
-    total_times[ptindex].tv_nsec = 0;
+    zero_total_times(get_index(pt));
     set_enabled(pt);
     act = SUCCESS_TIMER_ENABLED;
   // trying to disable timer that's currently enabled: disable it
@@ -138,9 +188,9 @@ static inline TimerAction start_timer (const PerfTimer pt) {
     act = ERR_TIMER_ALREADY_STARTED;
   // timer is enabled but not currently running: start it
   } else {
-    const int ptindex = get_index(pt);
-    clock_gettime(CLOCK_MONOTONIC, &start_times[ptindex]);
-    set_started(pt);
+    ThreadTimes* tt = get_thread_times();
+    tt->start_times[get_index(pt)] = now_ns();
+    tt->timers_running |= pt;
     act = SUCCESS_TIMER_STARTED;
   }
 
@@ -150,8 +200,6 @@ static inline TimerAction start_timer (const PerfTimer pt) {
 // stop specific perf timer and return success/error of the action
 static inline TimerAction stop_timer (const PerfTimer pt) {
   TimerAction act = ERR_UNKNOWN_ERROR;
-  struct timespec tsstop;
-  struct timespec tssubtotal;
 
   // trying to stop timer that's not yet enabled: return err
   if (!is_enabled(pt)) {
@@ -161,11 +209,13 @@ static inline TimerAction stop_timer (const PerfTimer pt) {
     act = ERR_TIMER_ALREADY_STOPPED;
   // timer is enabled and running: stop it and accumulate the run time
   } else {
-    clock_gettime(CLOCK_MONOTONIC, &tsstop);
+    const uint64_t stop_time = now_ns();
+    ThreadTimes* tt = this_thread_times;
     const int ptindex = get_index(pt);
-    sub_ts(&tssubtotal, &tsstop, &start_times[ptindex]);
-    add_ts(&total_times[ptindex], &total_times[ptindex], &tssubtotal);
-    set_stopped(pt);
+    __atomic_store_n(&tt->total_times[ptindex],
+                     tt->total_times[ptindex] + (stop_time - tt->start_times[ptindex]),
+                     __ATOMIC_RELAXED);
+    tt->timers_running &= (~pt);
     act = SUCCESS_TIMER_STOPPED;
   }
 
@@ -173,6 +223,7 @@ static inline TimerAction stop_timer (const PerfTimer pt) {
 }
 
 // get total accum time of specific perf timer and return success/error of the action
+// NOTE runs of the timer still in progress in other threads are not included
 static inline TimerAction get_total_time (const PerfTimer pt, double* total_time) {
   TimerAction act = ERR_UNKNOWN_ERROR;
 
@@ -185,8 +236,13 @@ static inline TimerAction get_total_time (const PerfTimer pt, double* total_time
   // timer is enabled and stopped: return the total accumulated run time
   } else {
     const int ptindex = get_index(pt);
-    *total_time = (double)total_times[ptindex].tv_sec +
-                  ( (double)total_times[ptindex].tv_nsec / NSEC_PER_SEC );
+    uint64_t total = 0;
+    pthread_mutex_lock(&mut_thread_times);
+    for (ThreadTimes* tt = all_thread_times; tt; tt = tt->next) {
+      total += __atomic_load_n(&tt->total_times[ptindex], __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&mut_thread_times);
+    *total_time = (double)total / NSEC_PER_SEC;
     act = SUCCESS_TIMER_TOTAL_RETURNED;
   }
 
@@ -218,3 +274,93 @@ inline TimerAction get_total_perf_time (PerfTimer pt, double* total_time) {
   return get_total_time(pt, total_time);
 }
 
+// enable or disable all perf timers and perf counters (zeroes them out if enabling)
+void set_all_perf_timers (TimerStatus stat_req) {
+  for (int i = 0; i < NUM_TIMERS; i++) {
+    set_timer((PerfTimer)(1 << i), stat_req);
+  }
+  set_perf_counters(stat_req);
+}
+
+// return true if any perf timer is enabled
+int any_perf_timer_enabled (void) {
+  return ( __atomic_load_n(&timers_status, __ATOMIC_RELAXED) != NO_TIMERS );
+}
+
+// enable or disable all perf counters
+// NOTE enabling will zero out the counters
+void set_perf_counters (TimerStatus stat_req) {
+  if (stat_req == ENABLED) {
+    pthread_mutex_lock(&mut_thread_times);
+    for (ThreadTimes* tt = all_thread_times; tt; tt = tt->next) {
+      for (int i = 0; i < NUM_COUNTERS; i++) {
+        __atomic_store_n(&tt->counts[i], 0, __ATOMIC_RELAXED);
+      }
+    }
+    pthread_mutex_unlock(&mut_thread_times);
+  }
+  __atomic_store_n(&counters_status, stat_req, __ATOMIC_RELAXED);
+}
+
+// add n to specific perf counter (in calling thread), if perf counters are enabled
+void count_perf_event (PerfCounter pc, long long n) {
+  if (__atomic_load_n(&counters_status, __ATOMIC_RELAXED) == ENABLED) {
+    ThreadTimes* tt = get_thread_times();
+    __atomic_store_n(&tt->counts[pc], tt->counts[pc] + n, __ATOMIC_RELAXED);
+  }
+}
+
+// get total count (of all threads) of specific perf counter
+long long get_perf_count (PerfCounter pc) {
+  long long total = 0;
+  pthread_mutex_lock(&mut_thread_times);
+  for (ThreadTimes* tt = all_thread_times; tt; tt = tt->next) {
+    total += __atomic_load_n(&tt->counts[pc], __ATOMIC_RELAXED);
+  }
+  pthread_mutex_unlock(&mut_thread_times);
+  return total;
+}
+
+// return short readable name of specific perf timer
+const char* perf_timer_name (PerfTimer pt) {
+  return timer_names[get_index(pt)];
+}
+
+// return short readable name of specific perf counter
+const char* perf_counter_name (PerfCounter pc) {
+  return counter_names[pc];
+}
+
+// print totals of all enabled perf timers, and perf counters and cpu/memory
+// usage of this process (if counters enabled), to f
+// NOTE timers nest (e.g., file copying happens during trace stop handling), so
+// the totals are inclusive and do not add up to the total run time
+void print_perf_report (FILE* f) {
+  if (any_perf_timer_enabled()) {
+    fprintf(f, "ptu perf timers (inclusive seconds, summed over threads):\n");
+    for (int i = 0; i < NUM_TIMERS; i++) {
+      double total_time;
+      if (get_total_time((PerfTimer)(1 << i), &total_time) == SUCCESS_TIMER_TOTAL_RETURNED) {
+        fprintf(f, "  %-26s %12.6f\n", timer_names[i], total_time);
+      }
+    }
+  }
+
+  if (__atomic_load_n(&counters_status, __ATOMIC_RELAXED) == ENABLED) {
+    fprintf(f, "ptu perf counters:\n");
+    for (int i = 0; i < NUM_COUNTERS; i++) {
+      fprintf(f, "  %-26s %12lld\n", counter_names[i], get_perf_count((PerfCounter)i));
+    }
+
+    // cpu and memory of ptu itself (not of the traced app)
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) == 0) {
+      fprintf(f, "ptu process usage:\n");
+      fprintf(f, "  %-26s %12.6f\n", "tracer user cpu",
+              ru.ru_utime.tv_sec + (ru.ru_utime.tv_usec / 1e6));
+      fprintf(f, "  %-26s %12.6f\n", "tracer system cpu",
+              ru.ru_stime.tv_sec + (ru.ru_stime.tv_usec / 1e6));
+      fprintf(f, "  %-26s %12ld\n", "tracer peak rss (KiB)", ru.ru_maxrss);
+    }
+  }
+}
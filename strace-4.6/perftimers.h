@@ -3,7 +3,14 @@ module:   perftimers
 author:   digimokan
 date:     14 JUL 2017 (created)
 purpose:  start, stop, and output specific pre-configured performance timers
+          and event counters (accumulated per thread, summed when reported)
 timers:   AUDIT_FILE_COPYING (track total time spent copying files during audit)
+          TRACE_STOP_HANDLING (handling a ptrace syscall stop of a child)
+          CHILD_MEMORY_READS (reading strings/buffers out of child memory)
+          PATH_CANONICALIZATION (turning child paths into absolute paths)
+          PATH_RULE_MATCHING (matching paths against cde.options rules)
+          PROVENANCE_WRITES (formatting and writing provenance log records)
+          ELF_PARSING (reading interpreters and deps out of ELF files)
 *******************************************************************************/
 
 #ifndef PERFTIMERS_H
@@ -14,16 +21,44 @@ timers:   AUDIT_FILE_COPYING (track total time spent copying files during audit)
 extern "C" {
 #endif
 
+/*******************************************************************************
+ * SYSTEM INCLUDES
+ ******************************************************************************/
+
+#include <stdio.h>      // ISOC: FILE
+
 /*******************************************************************************
  * PUBLIC TYPES / CONSTANTS / VARIABLES
  ******************************************************************************/
 
 // the current set of pre-defined perf timers
 typedef enum {
-  AUDIT_FILE_COPYING =  0x01,
+  AUDIT_FILE_COPYING =    0x01,
+  TRACE_STOP_HANDLING =   0x02,
+  CHILD_MEMORY_READS =    0x04,
+  PATH_CANONICALIZATION = 0x08,
+  PATH_RULE_MATCHING =    0x10,
+  PROVENANCE_WRITES =     0x20,
+  ELF_PARSING =           0x40
 } PerfTimer;
 // current num timers defined in PerfTimer enum
-#define NUM_TIMERS 1
+#define NUM_TIMERS 7
+
+// the current set of pre-defined perf counters (counted while enabled)
+typedef enum {
+  TRACE_STOPS,              // num syscall stops handled
+  CHILD_MEMORY_READ_CALLS,  // num reads of child memory (strings or buffers)
+  FILES_COPIED,             // num files copied (not hard-linked) into package
+  BYTES_COPIED,             // num bytes copied into package
+  PROVENANCE_RECORDS,       // num records written to provenance log
+  ELF_FILES_PARSED,         // num ELF files parsed
+  CAPTURE_CACHE_HITS,       // num captures skipped (package already has file)
+  CAPTURE_CACHE_MISSES,     // num captures that copied file into package
+  REDIRECT_CACHE_HITS,      // num cde-exec path redirections found cached
+  REDIRECT_CACHE_MISSES     // num cde-exec path redirections computed
+} PerfCounter;
+// current num counters defined in PerfCounter enum
+#define NUM_COUNTERS 10
 
 // for enabling, disabling, or getting status of specific perf timer
 typedef enum {
@@ -55,19 +90,42 @@ typedef enum {
 // NOTE successful enable will zero out a timer's accumulated time
 TimerAction set_perf_timer (PerfTimer pt, TimerStatus stat_req);
 
-// start specific enabled perf timer and return success/error of the action
+// start specific enabled perf timer (in calling thread) and return success/error of the action
 TimerAction start_perf_timer (PerfTimer pt);
 
-// stop specific enabled perf timer and return success/error of the action
+// stop specific enabled perf timer (in calling thread) and return success/error of the action
 TimerAction stop_perf_timer (PerfTimer pt);
 
-// get total accum time of specific enabled perf timer and return success/error of the action
+// get total accum time (of all threads) of specific enabled perf timer and return success/error of the action
 TimerAction get_total_perf_time (PerfTimer pt, double* total_time);
 
+// enable or disable all perf timers and perf counters (zeroes them out if enabling)
+void set_all_perf_timers (TimerStatus stat_req);
+
+// return true if any perf timer is enabled
+int any_perf_timer_enabled (void);
+
+// enable or disable all perf counters
+// NOTE enabling will zero out the counters
+void set_perf_counters (TimerStatus stat_req);
+
+// add n to specific perf counter (in calling thread), if perf counters are enabled
+void count_perf_event (PerfCounter pc, long long n);
+
+// get total count (of all threads) of specific perf counter
+long long get_perf_count (PerfCounter pc);
+
+// return short readable name of specific perf timer / perf counter
+const char* perf_timer_name (PerfTimer pt);
+const char* perf_counter_name (PerfCounter pc);
+
+// print totals of all enabled perf timers, and perf counters and cpu/memory
+// usage of this process (if counters enabled), to f
+void print_perf_report (FILE* f);
+
 // allow this header to be included from c++ source file
 #ifdef __cplusplus
 }
 #endif
 
 #endif // PERFTIMERS_H
-
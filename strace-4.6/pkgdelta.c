@@ -0,0 +1,1051 @@
+/*******************************************************************************
+module:   pkgdelta
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  ship a re-captured cde-package as a delta against the old package:
+          export a patch of the files of the new package that are not in the
+          old one, and apply the patch to (a copy of) the old package to
+          reconstruct the new one
+*******************************************************************************/
+
+/*******************************************************************************
+ * SYSTEM INCLUDES
+ ******************************************************************************/
+
+#include <dirent.h>     // P2001: DIR, struct dirent, opendir(), readdir(), closedir()
+#include <errno.h>      // ISOC: errno, EIO
+#include <fcntl.h>      // P2001: open(), O_RDONLY, O_WRONLY, O_CREAT, O_EXCL, O_NOFOLLOW
+#include <inttypes.h>   // ISOC: PRIx64, PRIu64
+#include <limits.h>     // P2001: PATH_MAX
+#include <pthread.h>    // P2001: pthread_create(), pthread_join(), pthread_mutex_*()
+#include <stdbool.h>    // ISOC: bool
+#include <stdlib.h>     // ISOC: malloc(), realloc(), calloc(), free(), qsort()
+#include <string.h>     // ISOC: strcmp(), strlen(), strdup(), strerror(), memcmp(), strrchr()
+#include <sys/mman.h>   // P2001: mmap(), munmap()
+#include <sys/stat.h>   // P2001: struct stat, lstat(), fstat(), mkdir(), chmod(), futimens()
+#include <unistd.h>     // P2001: read(), write(), close(), lseek(), ftruncate(), readlink(), symlink()
+
+/*******************************************************************************
+ * USER INCLUDES
+ ******************************************************************************/
+
+#include "pkgdelta.h"
+#include "manifest.h"   // hash_file_contents()
+#include "strmap.h"     // StrMap, strmap_new(), strmap_put(), strmap_get(), strmap_free()
+
+/*******************************************************************************
+ * PRIVATE TYPES / CONSTANTS / VARIABLES
+ ******************************************************************************/
+
+#define PATCH_MAGIC "PTUDELTA 1\n"
+
+// records: kind byte, then its fields
+#define REC_DIR       'D'   // path, mode
+#define REC_LINK      'L'   // path, target
+#define REC_FILE      'F'   // path, mode, mtime sec, mtime nsec, size, hash, how (below)
+#define REC_END       'E'
+
+// how a file is sent (after its REC_FILE fields)
+#define FILE_SAME     's'   // (nothing: same as the old file at its path)
+#define FILE_MOVED    'm'   // path of the old file it is a copy of
+#define FILE_PATCHED  'p'   // ops (on the old file at its path)
+#define FILE_LITERAL  'n'   // ops (data only)
+
+// ops that build a patched or literal file
+#define OP_COPY       'c'   // offset, len (of the old file)
+#define OP_DATA       'd'   // len, bytes
+#define OP_ZERO       'z'   // len (of zero bytes, applied as a hole)
+#define OP_END        'e'
+
+// runs of zero bytes at least this long are sent as zero ops (a file system
+// block, since a shorter hole takes as much disk as its data)
+#define MIN_ZERO_RUN 4096
+
+// changed files smaller than this are sent whole
+#define MIN_PATCHED_SIZE (16 * 1024)
+
+// block size of the rolling checksum is about sqrt(old size), within these
+#define MIN_BLOCK_SIZE 512
+#define MAX_BLOCK_SIZE (64 * 1024)
+
+// added to each byte summed by the rolling checksum (as rsync does), so runs
+// of zero bytes do not all sum to 0
+#define CHAR_OFFSET 31
+
+#define COPY_BUF_SIZE (1024 * 1024)
+
+// one dir, regular file, or symlink of a package
+typedef struct {
+  const char* pkg_dir;
+  char* path;               // relative to pkg_dir
+  struct stat st;
+  uint64_t hash;            // content hash (regular files only)
+  int hash_err;             // errno of hashing it, or 0
+} PkgEntry;
+
+// entries of a package, in path order (each dir before what is in it)
+typedef struct {
+  PkgEntry** entries;
+  size_t num;
+  size_t cap;
+} PkgEntryList;
+
+// regular files left to hash, shared by the hashing threads
+typedef struct {
+  PkgEntry** entries;
+  size_t num;
+  size_t next;
+  pthread_mutex_t lock;
+} HashQueue;
+
+// patch being written (counts its bytes, since it may be a pipe)
+typedef struct {
+  FILE* f;
+  uint64_t bytes;
+} PatchOut;
+
+// patch being read
+typedef struct {
+  FILE* f;
+  bool err;                 // read error, or unexpected end
+} PatchIn;
+
+// a file mapped for reading
+typedef struct {
+  const unsigned char* data;
+  size_t size;
+} Mapped;
+
+// copy op of a block delta not yet written (so consecutive ones merge)
+typedef struct {
+  uint64_t off;
+  uint64_t len;
+} PendingCopy;
+
+/*******************************************************************************
+ * PRIVATE MACROS / FUNCTIONS
+ ******************************************************************************/
+
+// return malloc-ed "<dir>/<path>" (or dir, if path is "")
+static char* join_path (const char* dir, const char* path) {
+  const size_t len = strlen(dir) + strlen(path) + 2;
+  char* s = (char*)malloc(len);
+  snprintf(s, len, (path[0] == '\0') ? "%s%s" : "%s/%s", dir, path);
+  return s;
+}
+
+static int compare_names (const void* a, const void* b) {
+  return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+static void add_entry (PkgEntryList* list, PkgEntry* e) {
+  if (list->num == list->cap) {
+    list->cap = list->cap ? list->cap * 2 : 256;
+    list->entries = (PkgEntry**)realloc(list->entries, list->cap * sizeof(PkgEntry*));
+  }
+  list->entries[list->num++] = e;
+}
+
+// add the dirs, regular files, and symlinks under path (relative to pkg_dir)
+// to list, sorted by name, each dir followed by what is in it
+static int list_dir (const char* pkg_dir, const char* path, PkgEntryList* list) {
+  char* full = join_path(pkg_dir, path);
+  DIR* d = opendir(full);
+  if (!d) {
+    fprintf(stderr, "ptu-prov: cannot read %s: %s\n", full, strerror(errno));
+    free(full);
+    return -1;
+  }
+  char** names = NULL;
+  size_t num_names = 0;
+  size_t cap = 0;
+  struct dirent* de;
+  while ((de = readdir(d)) != NULL) {
+    if (strcmp(de->d_name, ".") == 0 || strcmp(de->d_name, "..") == 0) {
+      continue;
+    }
+    if (num_names == cap) {
+      cap = cap ? cap * 2 : 32;
+      names = (char**)realloc(names, cap * sizeof(char*));
+    }
+    names[num_names++] = strdup(de->d_name);
+  }
+  closedir(d);
+  free(full);
+  qsort(names, num_names, sizeof(char*), compare_names);
+
+  int rc = 0;
+  for (size_t i = 0; i < num_names; i++) {
+    PkgEntry* e = (PkgEntry*)calloc(1, sizeof(PkgEntry));
+    e->pkg_dir = pkg_dir;
+    e->path = (path[0] == '\0') ? strdup(names[i]) : join_path(path, names[i]);
+    full = join_path(pkg_dir, e->path);
+    const int lrc = lstat(full, &e->st);
+    free(full);
+    if (lrc != 0 || !(S_ISDIR(e->st.st_mode) || S_ISREG(e->st.st_mode) || S_ISLNK(e->st.st_mode))) {
+      free(e->path);
+      free(e);
+    } else {
+      add_entry(list, e);
+      if (S_ISDIR(e->st.st_mode) && rc == 0) {
+        rc = list_dir(pkg_dir, e->path, list);
+      }
+    }
+    free(names[i]);
+  }
+  free(names);
+  return rc;
+}
+
+static void free_entries (PkgEntryList* list) {
+  for (size_t i = 0; i < list->num; i++) {
+    free(list->entries[i]->path);
+    free(list->entries[i]);
+  }
+  free(list->entries);
+}
+
+static int compare_sizes_desc (const void* a, const void* b) {
+  const off_t sa = (*(PkgEntry* const*)a)->st.st_size;
+  const off_t sb = (*(PkgEntry* const*)b)->st.st_size;
+  return (sa < sb) ? 1 : (sa > sb) ? -1 : 0;
+}
+
+static void* hash_worker (void* arg) {
+  HashQueue* q = (HashQueue*)arg;
+  while (true) {
+    pthread_mutex_lock(&q->lock);
+    const size_t i = q->next++;
+    pthread_mutex_unlock(&q->lock);
+    if (i >= q->num) {
+      break;
+    }
+    PkgEntry* e = q->entries[i];
+    char* full = join_path(e->pkg_dir, e->path);
+    errno = 0;
+    if (hash_file_contents(full, &e->hash) != 0) {
+      e->hash_err = errno ? errno : EIO;
+    }
+    free(full);
+  }
+  return NULL;
+}
+
+// hash the regular files of the lists on num_jobs threads (biggest first, so
+// no thread is left hashing a big file after the others are done)
+static void hash_entries (PkgEntryList* a, PkgEntryList* b, uint32_t num_jobs) {
+  HashQueue q;
+  q.entries = (PkgEntry**)malloc((a->num + b->num + 1) * sizeof(PkgEntry*));
+  q.num = 0;
+  q.next = 0;
+  pthread_mutex_init(&q.lock, NULL);
+  for (size_t i = 0; i < a->num + b->num; i++) {
+    PkgEntry* e = (i < a->num) ? a->entries[i] : b->entries[i - a->num];
+    if (S_ISREG(e->st.st_mode)) {
+      q.entries[q.num++] = e;
+    }
+  }
+  qsort(q.entries, q.num, sizeof(PkgEntry*), compare_sizes_desc);
+
+  // (no more threads than files to hash)
+  if (num_jobs > q.num) {
+    num_jobs = (uint32_t)q.num;
+  }
+  pthread_t* threads = (pthread_t*)malloc(((size_t)num_jobs + 1) * sizeof(pthread_t));
+  uint32_t num_started = 0;
+  for (uint32_t i = 1; i < num_jobs; i++) {
+    if (pthread_create(&threads[num_started], NULL, hash_worker, &q) == 0) {
+      num_started++;
+    }
+  }
+  hash_worker(&q);
+  for (uint32_t i = 0; i < num_started; i++) {
+    pthread_join(threads[i], NULL);
+  }
+  free(threads);
+  pthread_mutex_destroy(&q.lock);
+  free(q.entries);
+}
+
+// key of a file's contents: its hash and size
+static void content_key (const PkgEntry* e, char* key, size_t len) {
+  snprintf(key, len, "%016" PRIx64 ":%" PRIu64, e->hash, (uint64_t)e->st.st_size);
+}
+
+static void put_byte (PatchOut* out, int c) {
+  putc(c, out->f);
+  out->bytes++;
+}
+
+// (LEB128: 7 bits per byte, low bits first, high bit set on all but the last)
+static void put_uint (PatchOut* out, uint64_t v) {
+  while (v >= 0x80) {
+    put_byte(out, (int)((v & 0x7f) | 0x80));
+    v >>= 7;
+  }
+  put_byte(out, (int)v);
+}
+
+static void put_bytes (PatchOut* out, const void* p, size_t len) {
+  fwrite(p, 1, len, out->f);
+  out->bytes += len;
+}
+
+static void put_str (PatchOut* out, const char* s) {
+  const size_t len = strlen(s);
+  put_uint(out, len);
+  put_bytes(out, s, len);
+}
+
+static int get_byte (PatchIn* in) {
+  const int c = getc(in->f);
+  if (c == EOF) {
+    in->err = true;
+  }
+  return c;
+}
+
+static uint64_t get_uint (PatchIn* in) {
+  uint64_t v = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    const int c = get_byte(in);
+    if (c == EOF) {
+      return 0;
+    }
+    v |= (uint64_t)(c & 0x7f) << shift;
+    if (!(c & 0x80)) {
+      return v;
+    }
+  }
+  in->err = true;
+  return 0;
+}
+
+// return malloc-ed string (or NULL on error)
+static char* get_str (PatchIn* in) {
+  const uint64_t len = get_uint(in);
+  if (in->err || len >= PATH_MAX) {
+    in->err = true;
+    return NULL;
+  }
+  char* s = (char*)malloc(len + 1);
+  if (fread(s, 1, len, in->f) != len || memchr(s, '\0', len)) {
+    in->err = true;
+    free(s);
+    return NULL;
+  }
+  s[len] = '\0';
+  return s;
+}
+
+// map file at path (size 0: no data), return 0 on success
+static int map_file (const char* path, Mapped* m) {
+  m->data = NULL;
+  m->size = 0;
+  const int fd = open(path, O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) != 0) {
+    if (fd >= 0) {
+      close(fd);
+    }
+    return -1;
+  }
+  m->size = st.st_size;
+  if (m->size > 0) {
+    void* p = mmap(NULL, m->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED) {
+      close(fd);
+      return -1;
+    }
+    m->data = (const unsigned char*)p;
+  }
+  close(fd);
+  return 0;
+}
+
+static void unmap_file (Mapped* m) {
+  if (m->data) {
+    munmap((void*)m->data, m->size);
+  }
+}
+
+// rolling checksum of len bytes at p (a: sum of the bytes, b: sum of the
+// bytes weighted by their distance from the end), as rsync's
+static uint32_t weak_sum (const unsigned char* p, size_t len, uint32_t* a, uint32_t* b) {
+  uint32_t sa = 0;
+  uint32_t sb = 0;
+  for (size_t i = 0; i < len; i++) {
+    sa += p[i] + CHAR_OFFSET;
+    sb += (uint32_t)(len - i) * (p[i] + CHAR_OFFSET);
+  }
+  *a = sa & 0xffff;
+  *b = sb & 0xffff;
+  return *a | (*b << 16);
+}
+
+static uint32_t bucket_of (uint32_t weak, uint32_t mask) {
+  return ((weak ^ (weak >> 15)) * 2654435761u) & mask;
+}
+
+static size_t block_size_of (size_t old_size) {
+  size_t len = MIN_BLOCK_SIZE;
+  while (len < MAX_BLOCK_SIZE && len * len < old_size) {
+    len *= 2;
+  }
+  return len;
+}
+
+// return the num of zero bytes at the start of the len bytes at p
+static size_t zero_run (const unsigned char* p, size_t len) {
+  size_t n = 0;
+  while (n < len && p[n] == 0) {
+    n++;
+  }
+  return n;
+}
+
+static void put_zeros (PatchOut* out, uint64_t len) {
+  if (len > 0) {
+    put_byte(out, OP_ZERO);
+    put_uint(out, len);
+  }
+}
+
+// write the ops for len bytes at p: zero ops for its runs of zero bytes (of
+// at least MIN_ZERO_RUN), and data ops for the bytes between
+static void put_contents (PatchOut* out, const unsigned char* p, size_t len) {
+  size_t start = 0;
+  size_t i = 0;
+  while (i < len) {
+    const size_t run = zero_run(p + i, len - i);
+    if (run >= MIN_ZERO_RUN) {
+      if (i > start) {
+        put_byte(out, OP_DATA);
+        put_uint(out, i - start);
+        put_bytes(out, p + start, i - start);
+      }
+      put_zeros(out, run);
+      start = i + run;
+    }
+    i += (run > 0) ? run : 1;
+  }
+  if (len > start) {
+    put_byte(out, OP_DATA);
+    put_uint(out, len - start);
+    put_bytes(out, p + start, len - start);
+  }
+}
+
+// return the start of the next data of fd (size bytes) at or after pos (size
+// if none), and set end to the hole after it (all of fd is data where the
+// file system cannot SEEK_DATA)
+static off_t next_data (int fd, off_t pos, off_t size, off_t* end) {
+  off_t start = lseek(fd, pos, SEEK_DATA);
+  if (start < 0) {
+    start = (errno == ENXIO) ? size : pos;
+  }
+  *end = (start < size) ? lseek(fd, start, SEEK_HOLE) : size;
+  if (*end < start || *end > size) {
+    *end = size;
+  }
+  return start;
+}
+
+static void flush_copy (PatchOut* out, PendingCopy* copy) {
+  if (copy->len > 0) {
+    put_byte(out, OP_COPY);
+    put_uint(out, copy->off);
+    put_uint(out, copy->len);
+    copy->len = 0;
+  }
+}
+
+static void add_copy (PatchOut* out, PendingCopy* copy, uint64_t off, uint64_t len, uint64_t* copied) {
+  if (copy->len > 0 && copy->off + copy->len == off) {
+    copy->len += len;
+  } else {
+    flush_copy(out, copy);
+    copy->off = off;
+    copy->len = len;
+  }
+  *copied += len;
+}
+
+static void add_data (PatchOut* out, PendingCopy* copy, const unsigned char* p, size_t len) {
+  if (len > 0) {
+    flush_copy(out, copy);
+    put_contents(out, p, len);
+  }
+}
+
+// write the ops that build file cur from the blocks of file old it still has
+// (found by rolling checksum, and checked byte by byte) and the bytes between
+// (runs of zero bytes are never matched, so they are sent as zero ops)
+static void write_block_delta (PatchOut* out, const Mapped* old, const Mapped* cur, uint64_t* copied) {
+  const size_t len = block_size_of(old->size);
+  const size_t num_blocks = old->size / len;
+  uint32_t mask = 15;
+  while (mask < num_blocks * 2) {
+    mask = mask * 2 + 1;
+  }
+  int64_t* heads = (int64_t*)malloc((mask + 1) * sizeof(int64_t));
+  int64_t* nexts = (int64_t*)malloc((num_blocks + 1) * sizeof(int64_t));
+  uint32_t* weaks = (uint32_t*)malloc((num_blocks + 1) * sizeof(uint32_t));
+  for (uint32_t i = 0; i <= mask; i++) {
+    heads[i] = -1;
+  }
+  uint32_t a, b;
+  for (size_t j = num_blocks; j-- > 0; ) {
+    weaks[j] = weak_sum(old->data + j * len, len, &a, &b);
+    const uint32_t k = bucket_of(weaks[j], mask);
+    nexts[j] = heads[k];
+    heads[k] = (int64_t)j;
+  }
+
+  PendingCopy copy = { 0, 0 };
+  size_t pos = 0;
+  size_t data_start = 0;
+  size_t expected = 0;      // block after the last one matched
+  size_t zeros_end = 0;     // end of the run of zero bytes at pos (if any)
+  uint32_t weak = (num_blocks > 0 && cur->size >= len) ? weak_sum(cur->data, len, &a, &b) : 0;
+  while (num_blocks > 0 && pos + len <= cur->size) {
+    if (zeros_end <= pos) {
+      zeros_end = pos + zero_run(cur->data + pos, cur->size - pos);
+    }
+    if (zeros_end - pos >= MIN_ZERO_RUN) {
+      pos = zeros_end;
+      if (pos + len <= cur->size) {
+        weak = weak_sum(cur->data + pos, len, &a, &b);
+      }
+      continue;
+    }
+
+    int64_t match = -1;
+    if (expected < num_blocks && weaks[expected] == weak &&
+        memcmp(old->data + expected * len, cur->data + pos, len) == 0) {
+      match = (int64_t)expected;
+    }
+    for (int64_t j = heads[bucket_of(weak, mask)]; j >= 0 && match < 0; j = nexts[j]) {
+      if (weaks[j] == weak && memcmp(old->data + j * len, cur->data + pos, len) == 0) {
+        match = j;
+      }
+    }
+
+    if (match >= 0) {
+      add_data(out, &copy, cur->data + data_start, pos - data_start);
+      add_copy(out, &copy, (uint64_t)match * len, len, copied);
+      expected = (size_t)match + 1;
+      pos += len;
+      data_start = pos;
+      if (pos + len <= cur->size) {
+        weak = weak_sum(cur->data + pos, len, &a, &b);
+      }
+    } else {
+      if (pos + len < cur->size) {
+        const uint32_t c_out = cur->data[pos] + CHAR_OFFSET;
+        const uint32_t c_in = cur->data[pos + len] + CHAR_OFFSET;
+        a = (a - c_out + c_in) & 0xffff;
+        b = (b - (uint32_t)len * c_out + a) & 0xffff;
+        weak = a | (b << 16);
+      }
+      pos++;
+    }
+  }
+
+  // (the partial last block of old is not indexed, so match it here)
+  const size_t tail = old->size - num_blocks * len;
+  size_t end = cur->size;
+  if (tail > 0 && cur->size - data_start >= tail &&
+      memcmp(old->data + old->size - tail, cur->data + cur->size - tail, tail) == 0) {
+    end -= tail;
+  }
+  add_data(out, &copy, cur->data + data_start, end - data_start);
+  if (end < cur->size) {
+    add_copy(out, &copy, old->size - tail, tail, copied);
+  }
+  flush_copy(out, &copy);
+  put_byte(out, OP_END);
+
+  free(heads);
+  free(nexts);
+  free(weaks);
+}
+
+// write the ops that build the file at path from its bytes alone (its holes,
+// e.g. all of a stub, are sent as zero ops without reading them)
+static int write_literal (PatchOut* out, const char* path) {
+  const int fd = open(path, O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) != 0) {
+    if (fd >= 0) {
+      close(fd);
+    }
+    return -1;
+  }
+  unsigned char* buf = (unsigned char*)malloc(COPY_BUF_SIZE);
+  off_t size = st.st_size;
+  off_t pos = 0;
+  int rc = 0;
+  while (rc == 0 && pos < size) {
+    off_t end;
+    const off_t start = next_data(fd, pos, size, &end);
+    put_zeros(out, (uint64_t)(start - pos));
+    pos = start;
+    if (pos < end && lseek(fd, pos, SEEK_SET) != pos) {
+      rc = -1;
+    }
+    while (rc == 0 && pos < end) {
+      const size_t want = (end - pos < COPY_BUF_SIZE) ? (size_t)(end - pos) : COPY_BUF_SIZE;
+      const ssize_t n = read(fd, buf, want);
+      if (n < 0) {
+        rc = -1;
+      } else if (n == 0) {
+        size = end = pos;   // (shrunk since hashed: caught when applied)
+      } else {
+        put_contents(out, buf, (size_t)n);
+        pos += n;
+      }
+    }
+  }
+  put_byte(out, OP_END);
+  free(buf);
+  close(fd);
+  return rc;
+}
+
+// return true if regular files a and b have the same bytes (their content
+// keys match, but a 64-bit hash may collide)
+static bool same_contents (const PkgEntry* a, const PkgEntry* b) {
+  if (a->st.st_size != b->st.st_size) {
+    return false;
+  }
+  char* a_full = join_path(a->pkg_dir, a->path);
+  char* b_full = join_path(b->pkg_dir, b->path);
+  Mapped a_map, b_map;
+  bool same = false;
+  if (map_file(a_full, &a_map) == 0) {
+    if (map_file(b_full, &b_map) == 0) {
+      same = (a_map.size == b_map.size) &&
+             (a_map.size == 0 || memcmp(a_map.data, b_map.data, a_map.size) == 0);
+      unmap_file(&b_map);
+    }
+    unmap_file(&a_map);
+  }
+  free(a_full);
+  free(b_full);
+  return same;
+}
+
+// write the record of regular file e of the new package
+static int write_file_record (PatchOut* out, const PkgEntry* e, const StrMap* old_by_path,
+                              const StrMap* old_by_content, PkgDeltaReport* report) {
+  if (e->hash_err) {
+    fprintf(stderr, "ptu-prov: cannot read %s/%s: %s\n", e->pkg_dir, e->path, strerror(e->hash_err));
+    return -1;
+  }
+  char key[64];
+  content_key(e, key, sizeof(key));
+  const PkgEntry* old = (const PkgEntry*)strmap_get(old_by_path, e->path);
+  const PkgEntry* moved = (e->st.st_size > 0) ? (const PkgEntry*)strmap_get(old_by_content, key) : NULL;
+  const uint64_t size = (uint64_t)e->st.st_size;
+
+  put_byte(out, REC_FILE);
+  put_str(out, e->path);
+  put_uint(out, e->st.st_mode & 07777);
+  put_uint(out, (uint64_t)e->st.st_mtim.tv_sec);
+  put_uint(out, (uint64_t)e->st.st_mtim.tv_nsec);
+  put_uint(out, size);
+  put_uint(out, e->hash);
+  report->bytes_new += size;
+
+  if (old && old->hash == e->hash && same_contents(old, e)) {
+    put_byte(out, FILE_SAME);
+    report->num_same++;
+    report->bytes_copied += size;
+    return 0;
+  }
+  if (moved && same_contents(moved, e)) {
+    put_byte(out, FILE_MOVED);
+    put_str(out, moved->path);
+    report->num_moved++;
+    report->bytes_copied += size;
+    return 0;
+  }
+
+  char* full = join_path(e->pkg_dir, e->path);
+  int rc = -1;
+  if (old && size >= MIN_PATCHED_SIZE) {
+    char* old_full = join_path(old->pkg_dir, old->path);
+    Mapped old_map, cur_map;
+    if (map_file(old_full, &old_map) == 0) {
+      if (map_file(full, &cur_map) == 0) {
+        put_byte(out, FILE_PATCHED);
+        write_block_delta(out, &old_map, &cur_map, &report->bytes_copied);
+        report->num_patched++;
+        unmap_file(&cur_map);
+        rc = 0;
+      }
+      unmap_file(&old_map);
+    }
+    free(old_full);
+  } else {
+    put_byte(out, FILE_LITERAL);
+    rc = write_literal(out, full);
+    report->num_literal++;
+  }
+  if (rc != 0) {
+    fprintf(stderr, "ptu-prov: cannot read %s: %s\n", full, strerror(errno));
+  }
+  free(full);
+  return rc;
+}
+
+// return true if path is relative, and has no "", ".", or ".." part
+static bool is_safe_path (const char* path) {
+  if (path[0] == '\0' || path[0] == '/') {
+    return false;
+  }
+  for (const char* p = path; *p; ) {
+    const size_t len = strcspn(p, "/");
+    if (len == 0 || (len == 1 && p[0] == '.') || (len == 2 && p[0] == '.' && p[1] == '.')) {
+      return false;
+    }
+    p += len;
+    if (*p == '/') {
+      p++;
+      if (*p == '\0') {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// return true if path is safe, and its parent is a dir created from the
+// patch (so nothing is written through a symlink)
+static bool is_new_path (const StrMap* made_dirs, const char* path) {
+  if (!is_safe_path(path)) {
+    return false;
+  }
+  const char* slash = strrchr(path, '/');
+  if (!slash) {
+    return strmap_contains(made_dirs, "");
+  }
+  char* parent = strndup(path, slash - path);
+  const bool ok = strmap_contains(made_dirs, parent);
+  free(parent);
+  return ok;
+}
+
+static int write_all (int fd, const void* p, size_t len) {
+  const char* c = (const char*)p;
+  while (len > 0) {
+    const ssize_t n = write(fd, c, len);
+    if (n <= 0) {
+      return -1;
+    }
+    c += n;
+    len -= (size_t)n;
+  }
+  return 0;
+}
+
+// copy contents of file at path to fd (its holes stay holes)
+static int copy_contents (const char* path, int fd) {
+  const int in = open(path, O_RDONLY);
+  struct stat st;
+  if (in < 0 || fstat(in, &st) != 0) {
+    if (in >= 0) {
+      close(in);
+    }
+    return -1;
+  }
+  char* buf = (char*)malloc(COPY_BUF_SIZE);
+  off_t size = st.st_size;
+  off_t pos = 0;
+  int rc = 0;
+  while (rc == 0 && pos < size) {
+    off_t end;
+    pos = next_data(in, pos, size, &end);
+    if (pos < end && (lseek(in, pos, SEEK_SET) != pos || lseek(fd, pos, SEEK_SET) != pos)) {
+      rc = -1;
+    }
+    while (rc == 0 && pos < end) {
+      const size_t want = (end - pos < COPY_BUF_SIZE) ? (size_t)(end - pos) : COPY_BUF_SIZE;
+      const ssize_t n = read(in, buf, want);
+      if (n < 0) {
+        rc = -1;
+      } else if (n == 0) {
+        size = end = pos;
+      } else {
+        rc = write_all(fd, buf, (size_t)n);
+        pos += n;
+      }
+    }
+  }
+  if (rc == 0 && ftruncate(fd, size) != 0) {
+    rc = -1;
+  }
+  free(buf);
+  close(in);
+  return rc;
+}
+
+// read ops from in, and write the file they build (from old, if not NULL) to
+// fd (zero ops leave holes); return 0 on success, -2 if an op copies from
+// past the end of old, else -1
+static int apply_ops (PatchIn* in, const Mapped* old, int fd) {
+  char* buf = (char*)malloc(COPY_BUF_SIZE);
+  int rc = 0;
+  while (rc == 0) {
+    const int op = get_byte(in);
+    if (op == OP_END) {
+      break;
+    } else if (op == OP_COPY && old) {
+      const uint64_t off = get_uint(in);
+      const uint64_t len = get_uint(in);
+      if (in->err) {
+        rc = -1;
+      } else if (off > old->size || len > old->size - off) {
+        rc = -2;
+      } else {
+        rc = write_all(fd, old->data + off, len);
+      }
+    } else if (op == OP_DATA) {
+      uint64_t len = get_uint(in);
+      rc = in->err ? -1 : 0;
+      while (rc == 0 && len > 0) {
+        const size_t n = (len < COPY_BUF_SIZE) ? len : COPY_BUF_SIZE;
+        if (fread(buf, 1, n, in->f) != n) {
+          in->err = true;
+          rc = -1;
+        } else {
+          rc = write_all(fd, buf, n);
+        }
+        len -= n;
+      }
+    } else if (op == OP_ZERO) {
+      const uint64_t len = get_uint(in);
+      if (in->err || len > (uint64_t)INT64_MAX) {
+        in->err = true;
+        rc = -1;
+      } else {
+        rc = (lseek(fd, (off_t)len, SEEK_CUR) >= 0) ? 0 : -1;
+      }
+    } else {
+      in->err = true;
+      rc = -1;
+    }
+  }
+
+  // (extend fd over a hole at its end)
+  if (rc == 0) {
+    const off_t end = lseek(fd, 0, SEEK_CUR);
+    rc = (end >= 0 && ftruncate(fd, end) == 0) ? 0 : -1;
+  }
+  free(buf);
+  return rc;
+}
+
+// read the rest of a REC_FILE record from in, and create its file at path
+// (in new_dir) from it and old_dir
+static int apply_file (PatchIn* in, const char* old_dir, const char* new_dir, const char* path) {
+  const mode_t mode = (mode_t)get_uint(in) & 07777;
+  struct timespec times[2];
+  times[1].tv_sec = (time_t)get_uint(in);
+  times[1].tv_nsec = (long)get_uint(in);
+  times[0] = times[1];
+  const uint64_t size = get_uint(in);
+  const uint64_t hash = get_uint(in);
+  const int how = get_byte(in);
+  if (in->err || times[1].tv_nsec >= 1000000000L) {
+    return -1;
+  }
+
+  char* full = join_path(new_dir, path);
+  const int fd = open(full, O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW, 0600);
+  int rc = (fd >= 0) ? 0 : -1;
+  if (rc == 0 && (how == FILE_SAME || how == FILE_MOVED)) {
+    char* old_path = (how == FILE_SAME) ? strdup(path) : get_str(in);
+    if (old_path && is_safe_path(old_path)) {
+      char* old_full = join_path(old_dir, old_path);
+      rc = copy_contents(old_full, fd);
+      free(old_full);
+    } else {
+      in->err = true;
+      rc = -1;
+    }
+    free(old_path);
+  } else if (rc == 0 && how == FILE_PATCHED) {
+    char* old_full = join_path(old_dir, path);
+    Mapped old;
+    rc = map_file(old_full, &old);
+    if (rc == 0) {
+      rc = apply_ops(in, &old, fd);
+      unmap_file(&old);
+    }
+    free(old_full);
+  } else if (rc == 0 && how == FILE_LITERAL) {
+    rc = apply_ops(in, NULL, fd);
+  } else if (rc == 0) {
+    in->err = true;
+    rc = -1;
+  }
+
+  struct stat st;
+  if (rc == 0) {
+    rc = (fchmod(fd, mode) == 0 && futimens(fd, times) == 0 && fstat(fd, &st) == 0) ? 0 : -1;
+  }
+  if (fd >= 0 && close(fd) != 0) {
+    rc = -1;
+  }
+  uint64_t new_hash = 0;
+  if (rc == -2 || (rc == 0 && ((uint64_t)st.st_size != size ||
+                               hash_file_contents(full, &new_hash) != 0 || new_hash != hash))) {
+    fprintf(stderr, "ptu-prov: %s does not match the patch (was it made against another "
+                    "package than %s?)\n", path, old_dir);
+    rc = -2;
+  }
+  free(full);
+  return rc;
+}
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+int pkgdelta_export (const char* old_dir, const char* new_dir, uint32_t num_jobs,
+                     FILE* patch, PkgDeltaReport* report) {
+  memset(report, 0, sizeof(PkgDeltaReport));
+  PkgEntryList old_list = { NULL, 0, 0 };
+  PkgEntryList new_list = { NULL, 0, 0 };
+  if (list_dir(old_dir, "", &old_list) != 0 || list_dir(new_dir, "", &new_list) != 0) {
+    free_entries(&old_list);
+    free_entries(&new_list);
+    return -1;
+  }
+  hash_entries(&old_list, &new_list, (num_jobs > 0) ? num_jobs : 1);
+
+  StrMap* old_by_path = strmap_new();
+  StrMap* old_by_content = strmap_new();
+  for (size_t i = 0; i < old_list.num; i++) {
+    PkgEntry* e = old_list.entries[i];
+    if (S_ISREG(e->st.st_mode) && !e->hash_err) {
+      char key[64];
+      content_key(e, key, sizeof(key));
+      strmap_put(old_by_path, e->path, e);
+      if (!strmap_contains(old_by_content, key)) {
+        strmap_put(old_by_content, key, e);
+      }
+    }
+  }
+
+  PatchOut out = { patch, 0 };
+  put_bytes(&out, PATCH_MAGIC, strlen(PATCH_MAGIC));
+  int rc = 0;
+  for (size_t i = 0; i < new_list.num && rc == 0; i++) {
+    const PkgEntry* e = new_list.entries[i];
+    if (S_ISDIR(e->st.st_mode)) {
+      put_byte(&out, REC_DIR);
+      put_str(&out, e->path);
+      put_uint(&out, e->st.st_mode & 07777);
+    } else if (S_ISLNK(e->st.st_mode)) {
+      char target[PATH_MAX];
+      char* full = join_path(new_dir, e->path);
+      const ssize_t len = readlink(full, target, sizeof(target) - 1);
+      if (len < 0) {
+        fprintf(stderr, "ptu-prov: cannot read %s: %s\n", full, strerror(errno));
+        rc = -1;
+      } else {
+        target[len] = '\0';
+        put_byte(&out, REC_LINK);
+        put_str(&out, e->path);
+        put_str(&out, target);
+      }
+      free(full);
+    } else {
+      rc = write_file_record(&out, e, old_by_path, old_by_content, report);
+    }
+  }
+  if (rc == 0) {
+    put_byte(&out, REC_END);
+    if (fflush(patch) != 0 || ferror(patch)) {
+      fprintf(stderr, "ptu-prov: cannot write patch: %s\n", strerror(errno));
+      rc = -1;
+    }
+  }
+  report->bytes_patch = out.bytes;
+
+  strmap_free(old_by_path, NULL);
+  strmap_free(old_by_content, NULL);
+  free_entries(&old_list);
+  free_entries(&new_list);
+  return rc;
+}
+
+int pkgdelta_apply (const char* old_dir, FILE* patch, const char* new_dir) {
+  char magic[sizeof(PATCH_MAGIC)];
+  if (fread(magic, 1, strlen(PATCH_MAGIC), patch) != strlen(PATCH_MAGIC) ||
+      memcmp(magic, PATCH_MAGIC, strlen(PATCH_MAGIC)) != 0) {
+    fprintf(stderr, "ptu-prov: not a package patch (see 'ptu-prov delta')\n");
+    return -1;
+  }
+  if (mkdir(new_dir, 0777) != 0) {
+    fprintf(stderr, "ptu-prov: cannot create %s: %s\n", new_dir, strerror(errno));
+    return -1;
+  }
+
+  // (dirs are made writable until the end, in case their mode is not)
+  StrMap* made_dirs = strmap_new();
+  strmap_put(made_dirs, "", NULL);
+  PkgEntryList dirs = { NULL, 0, 0 };
+  PatchIn in = { patch, false };
+  int rc = 0;
+  bool done = false;
+  while (rc == 0 && !done) {
+    const int kind = get_byte(&in);
+    char* path = (kind == REC_END || in.err) ? NULL : get_str(&in);
+    if (kind == REC_END) {
+      done = true;
+    } else if (!path || !is_new_path(made_dirs, path)) {
+      rc = -1;
+    } else if (kind == REC_DIR) {
+      PkgEntry* e = (PkgEntry*)calloc(1, sizeof(PkgEntry));
+      e->path = join_path(new_dir, path);
+      e->st.st_mode = (mode_t)get_uint(&in) & 07777;
+      add_entry(&dirs, e);
+      rc = (!in.err && mkdir(e->path, 0700) == 0) ? 0 : -1;
+      if (rc == 0) {
+        strmap_put(made_dirs, path, NULL);
+      }
+    } else if (kind == REC_LINK) {
+      char* target = get_str(&in);
+      char* full = join_path(new_dir, path);
+      rc = (target && symlink(target, full) == 0) ? 0 : -1;
+      free(full);
+      free(target);
+    } else if (kind == REC_FILE) {
+      rc = apply_file(&in, old_dir, new_dir, path);
+    } else {
+      rc = -1;
+    }
+    if (rc == -1) {
+      fprintf(stderr, "ptu-prov: cannot apply patch%s%s: %s\n", path ? " at " : "", path ? path : "",
+              in.err ? "patch is truncated or corrupt" : strerror(errno));
+    }
+    free(path);
+  }
+
+  for (size_t i = dirs.num; i-- > 0; ) {
+    if (chmod(dirs.entries[i]->path, dirs.entries[i]->st.st_mode) != 0 && rc == 0) {
+      fprintf(stderr, "ptu-prov: cannot chmod %s: %s\n", dirs.entries[i]->path, strerror(errno));
+      rc = -1;
+    }
+  }
+  if (rc != 0) {
+    fprintf(stderr, "ptu-prov: %s is incomplete\n", new_dir);
+  }
+  strmap_free(made_dirs, NULL);
+  free_entries(&dirs);
+  return (rc == 0) ? 0 : -1;
+}
@@ -0,0 +1,79 @@
+/*******************************************************************************
+module:   pkgdelta
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  ship a re-captured cde-package as a delta against the old package:
+          export a patch of the files of the new package that are not in the
+          old one, and apply the patch to (a copy of) the old package to
+          reconstruct the new one
+notes:    - a file of the new package is sent as: the same as the old file at
+            its path, a copy of another old file (same content hash, size,
+            and bytes, e.g. a moved file), the blocks of its old file it still
+            has (found with a rolling checksum) and the bytes between them,
+            or (if small, or new) all of its bytes
+          - the contents of both packages are hashed in parallel before
+            exporting, then the patch is written in one pass, in path order,
+            so it can be piped (e.g., "ptu-prov delta old new - | ssh host
+            ptu-prov apply old - new")
+          - patch: "PTUDELTA 1\n", then records of: kind byte, varint ints,
+            and varint-length strings (see pkgdelta.c)
+          - holes (e.g., all of a stub, see pkgtrim.h) and runs of zero
+            bytes are sent as zero ops, which apply leaves as holes, so
+            sparse files stay sparse (so do same and moved files)
+          - each file applied is checked against the content hash of the file
+            it reconstructs, so a patch applied to another old package fails
+          - dirs, regular files (mode, mtime), and symlinks are sent; hard
+            links between files, owners, and other kinds of files are not
+*******************************************************************************/
+
+#ifndef PKGDELTA_H
+#define PKGDELTA_H 1
+
+// allow this header to be included from c++ source file
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*******************************************************************************
+ * SYSTEM INCLUDES
+ ******************************************************************************/
+
+#include <stdint.h>     // ISOC: uint32_t, uint64_t
+#include <stdio.h>      // ISOC: FILE
+
+/*******************************************************************************
+ * PUBLIC TYPES / CONSTANTS / VARIABLES
+ ******************************************************************************/
+
+// how the files of the new package were sent, and what the patch cost
+typedef struct {
+  uint64_t num_same;        // same as the old file at their path
+  uint64_t num_moved;       // copies of another old file
+  uint64_t num_patched;     // blocks of their old file, and bytes between
+  uint64_t num_literal;     // all of their bytes
+  uint64_t bytes_new;       // size of the files of the new package
+  uint64_t bytes_copied;    // of those, copied from the old package
+  uint64_t bytes_patch;     // size of the patch
+} PkgDeltaReport;
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+// write to patch the delta of package new_dir against package old_dir,
+// hashing their files on num_jobs threads
+// return 0 on success, -1 on error (reason printed to stderr)
+int pkgdelta_export (const char* old_dir, const char* new_dir, uint32_t num_jobs,
+                     FILE* patch, PkgDeltaReport* report);
+
+// create package new_dir (which must not exist) from package old_dir and
+// patch (written by pkgdelta_export() against old_dir)
+// return 0 on success, -1 on error (reason printed to stderr)
+int pkgdelta_apply (const char* old_dir, FILE* patch, const char* new_dir);
+
+// allow this header to be included from c++ source file
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PKGDELTA_H
@@ -0,0 +1,554 @@
+/*******************************************************************************
+module:   pkgtrim
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  compact a cde-package after its audit: classify each file captured
+          into its cde-root by how the app accessed it, and stub or prune the
+          files the app does not need the data of
+*******************************************************************************/
+
+/*******************************************************************************
+ * SYSTEM INCLUDES
+ ******************************************************************************/
+
+#include <dirent.h>     // P2001: DIR, struct dirent, opendir(), readdir(), closedir()
+#include <elf.h>        // GLIBC: Elf32_Ehdr, Elf64_Ehdr, Elf32_Phdr, Elf64_Phdr, PT_INTERP
+#include <errno.h>      // ISOC: errno
+#include <fcntl.h>      // P2001: open(), O_RDONLY, O_WRONLY, O_CREAT, O_EXCL
+#include <inttypes.h>   // ISOC: PRIu64
+#include <limits.h>     // P2001: PATH_MAX
+#include <stdlib.h>     // ISOC: malloc(), realloc(), free(), qsort(), realpath()
+#include <string.h>     // ISOC: strcmp(), strncmp(), strlen(), strerror(), memcmp()
+#include <sys/stat.h>   // P2001: struct stat, stat(), lstat(), S_ISREG(), S_ISDIR(), futimens()
+#include <unistd.h>     // P2001: pread(), close(), unlink(), rmdir(), rename(), ftruncate()
+
+/*******************************************************************************
+ * USER INCLUDES
+ ******************************************************************************/
+
+#include "pkgtrim.h"
+#include "manifest.h"   // ManifestEntry, manifest_load(), manifest_save(), manifest_save_untouched()
+#include "strmap.h"     // StrMap, strmap_new(), strmap_put(), strmap_get(), strmap_foreach()
+
+/*******************************************************************************
+ * PRIVATE TYPES / CONSTANTS / VARIABLES
+ ******************************************************************************/
+
+// one captured file (a regular file in cde-root)
+typedef struct {
+  PkgTrimClass cls;
+  PkgTrimPolicy action;     // what was (or would be) done with it
+  struct stat st;
+} TrimFile;
+
+// list of map keys
+typedef struct {
+  const char** keys;
+  size_t num;
+} KeyList;
+
+// state of one trim of a package
+typedef struct {
+  char* root;               // real path of cde-root
+  size_t root_len;
+  StrMap* files;            // real path -> TrimFile* of each captured file
+  StrMap* file_of_entry;    // manifest path -> TrimFile* (aliased) of its file
+  StrMap* untouched;        // manifest paths listed in cde.untouched
+  StrMap* accessed_dirs;    // real paths of dirs opened by, or cwds of, procs
+  const PkgTrimOptions* opts;
+  FILE* listing;
+  PkgTrimReport* report;
+} Trim;
+
+static const char* class_names[PKGTRIM_NUM_CLASSES] = { "executed", "read", "metadata", "unused" };
+static const char* policy_names[] = { "keep", "stub", "prune" };
+
+/*******************************************************************************
+ * PRIVATE MACROS / FUNCTIONS
+ ******************************************************************************/
+
+// return malloc-ed "<dir>/<name><path>"
+static char* join_path (const char* dir, const char* name, const char* path) {
+  const size_t len = strlen(dir) + strlen(name) + strlen(path) + 2;
+  char* s = (char*)malloc(len);
+  snprintf(s, len, "%s/%s%s", dir, name, path);
+  return s;
+}
+
+// return malloc-ed real path of abs path within cde-root, or NULL if it does
+// not exist there (or resolves to outside of cde-root)
+static char* resolve_in_root (const Trim* t, const char* path) {
+  char* p = join_path(t->root, "", path + 1);
+  char* real = realpath(p, NULL);
+  free(p);
+  if (real && (strncmp(real, t->root, t->root_len) != 0 || real[t->root_len] != '/')) {
+    free(real);
+    real = NULL;
+  }
+  return real;
+}
+
+static void collect_key (const char* key, void* val, void* arg) {
+  (void)val;
+  KeyList* list = (KeyList*)arg;
+  list->keys[list->num++] = key;
+}
+
+static int compare_keys (const void* a, const void* b) {
+  return strcmp(*(const char* const*)a, *(const char* const*)b);
+}
+
+// return keys of map, sorted (valid until map changes; caller frees list.keys)
+static KeyList sorted_keys (const StrMap* map) {
+  KeyList list;
+  list.num = 0;
+  list.keys = (const char**)malloc((strmap_size(map) + 1) * sizeof(char*));
+  strmap_foreach(map, collect_key, &list);
+  qsort(list.keys, list.num, sizeof(char*), compare_keys);
+  return list;
+}
+
+// load the lines of list_path (if any) as keys of a new map
+static StrMap* load_path_list (const char* list_path) {
+  StrMap* map = strmap_new();
+  FILE* f = fopen(list_path, "r");
+  if (f) {
+    char* line = NULL;
+    size_t cap = 0;
+    ssize_t len;
+    while ((len = getline(&line, &cap, f)) > 0) {
+      if (line[len - 1] == '\n') {
+        line[len - 1] = '\0';
+      }
+      if (line[0] == '/') {
+        strmap_put(map, line, NULL);
+      }
+    }
+    free(line);
+    fclose(f);
+  }
+  return map;
+}
+
+// add paths to the list in placeholders_fn (the placeholders of earlier
+// audits stay listed), in sorted order
+static int save_placeholders (const char* placeholders_fn, char** paths, size_t num_paths) {
+  StrMap* placeholders = load_path_list(placeholders_fn);
+  for (size_t i = 0; i < num_paths; i++) {
+    strmap_put(placeholders, paths[i], NULL);
+  }
+  KeyList keys = sorted_keys(placeholders);
+  int rc = -1;
+  FILE* f = fopen(placeholders_fn, "w");
+  if (f) {
+    for (size_t i = 0; i < keys.num; i++) {
+      fprintf(f, "%s\n", keys.keys[i]);
+    }
+    rc = (fclose(f) == 0) ? 0 : -1;
+  }
+  free(keys.keys);
+  strmap_free(placeholders, NULL);
+  return rc;
+}
+
+// return malloc-ed interpreter that the kernel loads to run file (its ELF
+// PT_INTERP, or the program of its #! line), or NULL if none
+static char* read_interpreter (const char* file) {
+  int fd = open(file, O_RDONLY);
+  if (fd < 0) {
+    return NULL;
+  }
+  char* interp = NULL;
+  unsigned char head[256];
+  const ssize_t n = pread(fd, head, sizeof(head) - 1, 0);
+
+  if (n > 2 && head[0] == '#' && head[1] == '!') {
+    head[n] = '\0';
+    char* s = (char*)head + 2;
+    s += strspn(s, " \t");
+    const size_t len = strcspn(s, " \t\r\n");
+    if (len > 0) {
+      interp = strndup(s, len);
+    }
+  } else if (n >= (ssize_t)sizeof(Elf64_Ehdr) && memcmp(head, ELFMAG, SELFMAG) == 0) {
+    // (fields of 32 and 64-bit headers differ in size, so read each kind)
+    const bool is64 = (head[EI_CLASS] == ELFCLASS64);
+    off_t phoff;
+    unsigned phentsize, phnum;
+    if (is64) {
+      const Elf64_Ehdr* eh = (const Elf64_Ehdr*)head;
+      phoff = eh->e_phoff;
+      phentsize = eh->e_phentsize;
+      phnum = eh->e_phnum;
+    } else {
+      const Elf32_Ehdr* eh = (const Elf32_Ehdr*)head;
+      phoff = eh->e_phoff;
+      phentsize = eh->e_phentsize;
+      phnum = eh->e_phnum;
+    }
+    for (unsigned i = 0; i < phnum && !interp; i++) {
+      Elf64_Phdr ph64;
+      Elf32_Phdr ph32;
+      off_t off;
+      size_t size;
+      const off_t at = phoff + (off_t)i * phentsize;
+      if (is64) {
+        if (pread(fd, &ph64, sizeof(ph64), at) != (ssize_t)sizeof(ph64) || ph64.p_type != PT_INTERP) {
+          continue;
+        }
+        off = ph64.p_offset;
+        size = ph64.p_filesz;
+      } else {
+        if (pread(fd, &ph32, sizeof(ph32), at) != (ssize_t)sizeof(ph32) || ph32.p_type != PT_INTERP) {
+          continue;
+        }
+        off = ph32.p_offset;
+        size = ph32.p_filesz;
+      }
+      if (size > 0 && size < PATH_MAX) {
+        interp = (char*)malloc(size + 1);
+        if (pread(fd, interp, size, off) != (ssize_t)size) {
+          free(interp);
+          interp = NULL;
+          break;
+        }
+        interp[size] = '\0';
+      }
+    }
+  }
+
+  close(fd);
+  return interp;
+}
+
+// add the file that manifest path key was captured into (if still there)
+static void add_captured_file (const char* key, void* val, void* arg) {
+  Trim* t = (Trim*)arg;
+  ManifestEntry* entry = (ManifestEntry*)val;
+  entry->touched = !strmap_contains(t->untouched, key);
+
+  char* real = resolve_in_root(t, key);
+  struct stat st;
+  if (!real || stat(real, &st) != 0 || !S_ISREG(st.st_mode)) {
+    free(real);
+    return;
+  }
+
+  TrimFile* f = (TrimFile*)strmap_get(t->files, real);
+  if (!f) {
+    f = (TrimFile*)malloc(sizeof(TrimFile));
+    f->cls = entry->touched ? PKGTRIM_METADATA : PKGTRIM_UNUSED;
+    f->action = PKGTRIM_KEEP;
+    f->st = st;
+    strmap_put(t->files, real, f);
+  } else if (entry->touched && f->cls == PKGTRIM_UNUSED) {
+    f->cls = PKGTRIM_METADATA;  // (touched via another of its paths)
+  }
+  strmap_put(t->file_of_entry, key, f);
+  free(real);
+}
+
+// raise the class of the captured file at real path (if any) to cls
+static void raise_class (Trim* t, const char* real, PkgTrimClass cls) {
+  TrimFile* f = (TrimFile*)strmap_get(t->files, real);
+  if (f && cls < f->cls) {
+    f->cls = cls;
+  }
+}
+
+// mark real path as an accessed dir, if it is a dir
+static void add_accessed_dir (Trim* t, const char* real) {
+  struct stat st;
+  if (stat(real, &st) == 0 && S_ISDIR(st.st_mode)) {
+    strmap_put(t->accessed_dirs, real, NULL);
+  }
+}
+
+// classify the captured files by the events of idx on them
+static void classify_by_events (Trim* t, const ProvIndex* idx) {
+  for (uint32_t path = 0; path < provindex_num_paths(idx); path++) {
+    const char* name = provindex_path(idx, path);
+    char* real = (name[0] == '/') ? resolve_in_root(t, name) : NULL;
+    if (!real) {
+      continue;
+    }
+    for (uint64_t e = provindex_last_event_of_path(idx, path); e != PROVIDX_NO_EVENT; ) {
+      const ProvEvent* ev = provindex_event(idx, e);
+      switch (ev->kind) {
+        case PROVIDX_EXECVE:
+          raise_class(t, real, PKGTRIM_EXECUTED);
+          break;
+        case PROVIDX_READ: case PROVIDX_WRITE: case PROVIDX_READWRITE:
+        case PROVIDX_UNKNOWNIO: case PROVIDX_CLOSE: case PROVIDX_IOBYTES:
+          raise_class(t, real, PKGTRIM_READ);
+          break;
+        default:
+          break;
+      }
+      e = ev->prev_of_path;
+    }
+    add_accessed_dir(t, real);
+    free(real);
+  }
+
+  for (uint32_t proc = 0; proc < provindex_num_procs(idx); proc++) {
+    const char* program;
+    const char* cwd;
+    const char* args;
+    if (provindex_proc_cmd(idx, proc, &program, &cwd, &args) && cwd[0] == '/') {
+      char* real = resolve_in_root(t, cwd);
+      if (real) {
+        add_accessed_dir(t, real);
+        free(real);
+      }
+    }
+  }
+}
+
+static void collect_executed (const char* key, void* val, void* arg) {
+  if (((TrimFile*)val)->cls == PKGTRIM_EXECUTED) {
+    KeyList* list = (KeyList*)arg;
+    list->keys[list->num++] = strdup(key);
+  }
+}
+
+// mark the interpreters of executed files (and theirs) executed
+static void classify_interpreters (Trim* t) {
+  // (each file is added to work once, when it becomes executed)
+  KeyList work;
+  work.num = 0;
+  work.keys = (const char**)malloc((strmap_size(t->files) + 1) * sizeof(char*));
+  strmap_foreach(t->files, collect_executed, &work);
+
+  for (size_t i = 0; i < work.num; i++) {
+    char* interp = read_interpreter(work.keys[i]);
+    char* real = (interp && interp[0] == '/') ? resolve_in_root(t, interp) : NULL;
+    TrimFile* f = real ? (TrimFile*)strmap_get(t->files, real) : NULL;
+    if (f && f->cls != PKGTRIM_EXECUTED) {
+      f->cls = PKGTRIM_EXECUTED;
+      work.keys[work.num++] = real;
+      real = NULL;
+    }
+    free(interp);
+    free(real);
+  }
+  for (size_t i = 0; i < work.num; i++) {
+    free((char*)work.keys[i]);
+  }
+  free(work.keys);
+}
+
+// replace the file at real path with a stub of st (via a new file, renamed
+// over it), return 0 on success
+static int stub_file (const char* real, const struct stat* st) {
+  char* tmp = join_path(real, "", ".ptu-trim");
+  tmp[strlen(real)] = '.';  // "<real>.ptu-trim"
+  int fd = open(tmp, O_WRONLY | O_CREAT | O_EXCL, st->st_mode & 07777);
+  int rc = -1;
+  if (fd >= 0) {
+    const struct timespec times[2] = { st->st_atim, st->st_mtim };
+    rc = (ftruncate(fd, st->st_size) == 0 && fchmod(fd, st->st_mode & 07777) == 0 &&
+          futimens(fd, times) == 0) ? 0 : -1;
+    rc = (close(fd) == 0) ? rc : -1;
+    if (rc == 0) {
+      rc = rename(tmp, real);
+    }
+    if (rc != 0) {
+      unlink(tmp);
+    }
+  }
+  free(tmp);
+  return rc;
+}
+
+// stub or prune the captured file at real path as its class's policy says
+static void trim_file (Trim* t, const char* real, TrimFile* f) {
+  const PkgTrimOptions* opts = t->opts;
+  PkgTrimReport* report = t->report;
+  const PkgTrimPolicy policy = (f->cls == PKGTRIM_METADATA) ? opts->metadata :
+                               (f->cls == PKGTRIM_UNUSED) ? opts->unused : PKGTRIM_KEEP;
+  const uint64_t bytes = (uint64_t)f->st.st_blocks * 512;
+  report->num_files[f->cls]++;
+  report->bytes[f->cls] += bytes;
+
+  int rc = 0;
+  if (!opts->dry_run && policy == PKGTRIM_STUB) {
+    rc = stub_file(real, &f->st);
+  } else if (!opts->dry_run && policy == PKGTRIM_PRUNE) {
+    rc = unlink(real);
+  }
+  if (rc != 0) {
+    fprintf(stderr, "ptu-prov: cannot %s %s: %s\n", policy_names[policy], real, strerror(errno));
+  } else if (policy != PKGTRIM_KEEP) {
+    f->action = policy;
+    report->bytes_saved += bytes;
+    if (policy == PKGTRIM_STUB) {
+      report->num_stubbed++;
+    } else {
+      report->num_pruned++;
+    }
+  }
+
+  if (t->listing) {
+    fprintf(t->listing, "%s %s %" PRIu64 " %s\n", class_names[f->cls], policy_names[f->action],
+            bytes, real + t->root_len);
+  }
+}
+
+// prune (or count, if a dry run) the dirs under dir (a real path in cde-root)
+// that are left with nothing in them and that no proc accessed; return true
+// if dir itself is left with nothing in it
+static bool trim_empty_dirs (Trim* t, const char* dir) {
+  DIR* d = opendir(dir);
+  if (!d) {
+    return false;
+  }
+  bool empty = true;
+  struct dirent* de;
+  while ((de = readdir(d)) != NULL) {
+    if (strcmp(de->d_name, ".") == 0 || strcmp(de->d_name, "..") == 0) {
+      continue;
+    }
+    char* p = join_path(dir, "", de->d_name);
+    struct stat st;
+    if (lstat(p, &st) == 0 && S_ISDIR(st.st_mode)) {
+      if (!trim_empty_dirs(t, p)) {
+        empty = false;
+      } else if (t->opts->dry_run || rmdir(p) == 0) {
+        t->report->num_dirs_pruned++;
+        if (t->listing) {
+          fprintf(t->listing, "dir prune 0 %s\n", p + t->root_len);
+        }
+      } else {
+        empty = false;
+      }
+    } else {
+      const TrimFile* f = (const TrimFile*)strmap_get(t->files, p);
+      if (!f || f->action != PKGTRIM_PRUNE) {
+        empty = false;
+      }
+    }
+    free(p);
+  }
+  closedir(d);
+  return empty && !strmap_contains(t->accessed_dirs, dir);
+}
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+const char* pkgtrim_class_name (PkgTrimClass cls) {
+  return class_names[cls];
+}
+
+const char* pkgtrim_policy_name (PkgTrimPolicy policy) {
+  return policy_names[policy];
+}
+
+int pkgtrim_parse_policy (const char* s, PkgTrimPolicy* policy) {
+  for (int i = PKGTRIM_KEEP; i <= PKGTRIM_PRUNE; i++) {
+    if (strcmp(s, policy_names[i]) == 0) {
+      *policy = (PkgTrimPolicy)i;
+      return 0;
+    }
+  }
+  return -1;
+}
+
+int pkgtrim_package (const ProvIndex* idx, const char* package_dir, const PkgTrimOptions* opts,
+                     FILE* listing, PkgTrimReport* report) {
+  memset(report, 0, sizeof(PkgTrimReport));
+  char* root = join_path(package_dir, "cde-root", "");
+  char* manifest_fn = join_path(package_dir, "cde.manifest", "");
+  char* untouched_fn = join_path(package_dir, "cde.untouched", "");
+  char* placeholders_fn = join_path(package_dir, "cde.placeholders", "");
+  struct stat root_stat;
+  struct stat manifest_stat;
+  int rc = -1;
+
+  Trim t;
+  memset(&t, 0, sizeof(t));
+  if (stat(root, &root_stat) != 0 || !(t.root = realpath(root, NULL))) {
+    fprintf(stderr, "ptu-prov: no cde-root in %s\n", package_dir);
+    goto done;
+  }
+  if (stat(manifest_fn, &manifest_stat) != 0) {
+    fprintf(stderr, "ptu-prov: no capture manifest (cde.manifest) in %s\n", package_dir);
+    goto done;
+  }
+  t.root_len = strlen(t.root);
+  t.files = strmap_new();
+  t.file_of_entry = strmap_new();
+  t.untouched = load_path_list(untouched_fn);
+  t.accessed_dirs = strmap_new();
+  t.opts = opts;
+  t.listing = listing;
+  t.report = report;
+
+  // (a manifest of another cde-root loads as empty, so nothing is trimmed)
+  StrMap* manifest = manifest_load(manifest_fn, &root_stat);
+  strmap_foreach(manifest, add_captured_file, &t);
+  classify_by_events(&t, idx);
+  classify_interpreters(&t);
+
+  KeyList files = sorted_keys(t.files);
+  for (size_t i = 0; i < files.num; i++) {
+    trim_file(&t, files.keys[i], (TrimFile*)strmap_get(t.files, files.keys[i]));
+  }
+  free(files.keys);
+  if (opts->metadata == PKGTRIM_PRUNE) {
+    trim_empty_dirs(&t, t.root);
+  }
+
+  // drop stubbed and pruned files from the manifest (and so cde.untouched),
+  // and list stubs in cde.placeholders, so that a later audit that reads
+  // them replaces them with full copies (okapi never updates a stub, since
+  // it has the original's mtime)
+  rc = 0;
+  if (!opts->dry_run && (report->num_stubbed > 0 || report->num_pruned > 0)) {
+    KeyList entries = sorted_keys(manifest);
+    char** dropped = (char**)malloc((entries.num + 1) * sizeof(char*));
+    char** stubbed = (char**)malloc((entries.num + 1) * sizeof(char*));
+    size_t num_dropped = 0;
+    size_t num_stubbed = 0;
+    for (size_t i = 0; i < entries.num; i++) {
+      const TrimFile* f = (const TrimFile*)strmap_get(t.file_of_entry, entries.keys[i]);
+      if (f && f->action != PKGTRIM_KEEP) {
+        dropped[num_dropped++] = strdup(entries.keys[i]);
+        if (f->action == PKGTRIM_STUB) {
+          stubbed[num_stubbed++] = dropped[num_dropped - 1];
+        }
+      }
+    }
+    free(entries.keys);
+    if (num_stubbed > 0 && save_placeholders(placeholders_fn, stubbed, num_stubbed) != 0) {
+      fprintf(stderr, "ptu-prov: cannot update %s: %s\n", placeholders_fn, strerror(errno));
+      rc = -1;
+    }
+    for (size_t i = 0; i < num_dropped; i++) {
+      free(strmap_remove(manifest, dropped[i]));
+      free(dropped[i]);
+    }
+    free(dropped);
+    free(stubbed);
+    if (manifest_save(manifest, manifest_fn, &root_stat) != 0 ||
+        manifest_save_untouched(manifest, untouched_fn) != 0) {
+      fprintf(stderr, "ptu-prov: cannot update %s: %s\n", manifest_fn, strerror(errno));
+      rc = -1;
+    }
+  }
+  manifest_free(manifest);
+
+done:
+  strmap_free(t.files, free);
+  strmap_free(t.file_of_entry, NULL);
+  strmap_free(t.untouched, NULL);
+  strmap_free(t.accessed_dirs, NULL);
+  free(t.root);
+  free(root);
+  free(manifest_fn);
+  free(untouched_fn);
+  free(placeholders_fn);
+  return rc;
+}
@@ -0,0 +1,114 @@
+/*******************************************************************************
+module:   pkgtrim
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  compact a cde-package after its audit: classify each file captured
+          into its cde-root (as listed in its capture manifest) by how the
+          app accessed it (as recorded in a provenance index), and stub or
+          prune the files the app does not need the data of
+notes:    - executed: exec-ed by a proc, or the ELF interpreter or #!
+            interpreter of an executed file (which the kernel loads unlogged)
+          - read: opened by a proc (to read, write, or both)
+          - metadata-only: captured, but never opened or exec-ed (e.g., it was
+            only stat-ed, or its lib was prefetched but never mapped)
+          - unused: captured by an earlier audit into the package, but not
+            touched by the last one (listed in cde.untouched)
+          - a path of the index matches a captured file if both resolve to
+            the same file within cde-root (e.g., via /lib -> usr/lib)
+          - a stub keeps the size, mode and times of its file, but none of
+            its data (it is a sparse file), so stat() of it still works.  it
+            is a new file, since a captured file may be a hard link to the
+            original (host) file
+          - stubbed and pruned files are dropped from the capture manifest,
+            and stubs are listed in cde.placeholders, so a later audit that
+            reads them captures them again (as full copies)
+          - accesses of procs run untraced (see "process_tracing" in
+            cde.options) are not in the index, so their files look unused
+*******************************************************************************/
+
+#ifndef PKGTRIM_H
+#define PKGTRIM_H 1
+
+// allow this header to be included from c++ source file
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*******************************************************************************
+ * SYSTEM INCLUDES
+ ******************************************************************************/
+
+#include <stdbool.h>    // ISOC: bool
+#include <stdint.h>     // ISOC: uint64_t
+#include <stdio.h>      // ISOC: FILE
+
+/*******************************************************************************
+ * USER INCLUDES
+ ******************************************************************************/
+
+#include "provindex.h"  // ProvIndex
+
+/*******************************************************************************
+ * PUBLIC TYPES / CONSTANTS / VARIABLES
+ ******************************************************************************/
+
+// how the app accessed a captured file (most needed first)
+typedef enum {
+  PKGTRIM_EXECUTED,
+  PKGTRIM_READ,
+  PKGTRIM_METADATA,
+  PKGTRIM_UNUSED,
+  PKGTRIM_NUM_CLASSES
+} PkgTrimClass;
+
+// what to do with the files of a class
+typedef enum {
+  PKGTRIM_KEEP,
+  PKGTRIM_STUB,             // replace with a stub (same size, mode, times)
+  PKGTRIM_PRUNE             // delete (and, for metadata-only, delete the
+                            // dirs left empty that no proc accessed)
+} PkgTrimPolicy;
+
+typedef struct {
+  PkgTrimPolicy metadata;   // for metadata-only files
+  PkgTrimPolicy unused;     // for unused files
+  bool dry_run;             // only classify and report
+} PkgTrimOptions;
+
+// files of each class, and what trimming them saved (in bytes allocated on
+// disk, which is what copying or archiving the package costs)
+typedef struct {
+  uint64_t num_files[PKGTRIM_NUM_CLASSES];
+  uint64_t bytes[PKGTRIM_NUM_CLASSES];
+  uint64_t num_stubbed;
+  uint64_t num_pruned;
+  uint64_t num_dirs_pruned;
+  uint64_t bytes_saved;
+} PkgTrimReport;
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+// name of class ("executed", "read", "metadata", "unused") / of policy
+// ("keep", "stub", "prune")
+const char* pkgtrim_class_name (PkgTrimClass cls);
+const char* pkgtrim_policy_name (PkgTrimPolicy policy);
+
+// parse policy name s, return 0 on success, -1 if it is not one
+int pkgtrim_parse_policy (const char* s, PkgTrimPolicy* policy);
+
+// classify the files captured into package_dir/cde-root by the accesses of
+// idx, and stub or prune them (unless opts->dry_run) as opts says; list each
+// captured file to listing (if not NULL) as "<class> <action> <bytes> <path>",
+// and each dir pruned as "dir prune 0 <path>"
+// return 0 on success, -1 on error (reason printed to stderr)
+int pkgtrim_package (const ProvIndex* idx, const char* package_dir, const PkgTrimOptions* opts,
+                     FILE* listing, PkgTrimReport* report);
+
+// allow this header to be included from c++ source file
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PKGTRIM_H
@@ -139,7 +139,7 @@
 // pgbovine
 extern void CDE_begin_execve(struct tcb* tcp);
 extern void CDE_end_execve(struct tcb* tcp);
-extern void CDE_init_tcb_dir_fields(struct tcb* tcp);
+extern void CDE_init_tcb_dir_fields(struct tcb* tcp, unsigned long clone_flags);
 
 /*******************************************************************************
  * IMPLEMENTATION
@@ -554,7 +554,7 @@ struct tcb *tcp;
 		if (syserror(tcp))
 			return 0;
 		tcpchild = alloctcb(tcp->u_rval);
-    CDE_init_tcb_dir_fields(tcpchild); // pgbovine
+    CDE_init_tcb_dir_fields(tcpchild, 0); // pgbovine
     printSpawnprov(tcpchild); // quanpt
 		if (proc_open(tcpchild, 2) < 0)
 			droptcb(tcpchild);
@@ -835,6 +835,50 @@ change_syscall(struct tcb *tcp, int new)
 }
 
 #ifdef LINUX
+/* digimokan: flags of the clone() or clone3() TCP is in (0 if fork/vfork).
+   an untraced TCP made no syscall-entry stop, so its scno and u_arg are
+   stale: where we can, read them from its registers at this stop instead */
+static unsigned long
+clone_call_flags(struct tcb *tcp)
+{
+#if defined(X86_64) || defined(I386)
+	struct user_regs_struct regs;
+	if (ptrace(PTRACE_GETREGS, tcp->pid, NULL, &regs) == 0) {
+		unsigned long long flags;
+# ifdef X86_64
+		int is32 = (regs.cs == 0x23);	/* (i386 personality) */
+		long nr = regs.orig_rax;
+		unsigned long arg0 = is32 ? (unsigned int) regs.rbx : regs.rdi;
+		long nr_clone = is32 ? 120 : __NR_clone;
+# else
+		long nr = regs.orig_eax;
+		unsigned long arg0 = regs.ebx;
+		long nr_clone = __NR_clone;
+# endif
+		if (nr == nr_clone)
+			return arg0;
+# ifdef __NR_clone3
+		/* (same number in both personalities) */
+		if (nr == __NR_clone3 && umove(tcp, arg0, &flags) == 0)
+			return flags;
+# endif
+		return 0;
+	}
+#endif
+	if (tcp->scno >= 0 && tcp->scno < nsyscalls &&
+	    sysent[tcp->scno].sys_func == sys_clone)
+		return tcp->u_arg[ARG_FLAGS];
+#ifdef __NR_clone3
+	/* (not in sysent) its struct clone_args starts with the u64 flags */
+	if (tcp->scno == __NR_clone3) {
+		unsigned long long flags;
+		if (umove(tcp, tcp->u_arg[0], &flags) == 0)
+			return flags;
+	}
+#endif
+	return 0;
+}
+
 int
 handle_new_child(struct tcb *tcp, int pid, int bpt)
 {
@@ -884,7 +928,9 @@ handle_new_child(struct tcb *tcp, int pid, int bpt)
 	}
 	tcpchild->parent = tcp;
 
-  CDE_init_tcb_dir_fields(tcpchild); // pgbovine - do it AFTER you init parent
+  /* digimokan: read now, in case we point TCP to our parent below */
+  unsigned long call_flags = clone_call_flags(tcp);
+  CDE_init_tcb_dir_fields(tcpchild, call_flags); // pgbovine - do it AFTER you init parent
   print_spawn_prov(tcpchild); // quanpt
 
 	tcp->nchildren++;
@@ -895,7 +941,7 @@ handle_new_child(struct tcb *tcp, int pid, int bpt)
 			clearbpt(tcpchild);
 
 		tcpchild->flags &= ~(TCB_SUSPENDED|TCB_STARTUP);
-		if (ptrace_restart(PTRACE_SYSCALL, tcpchild, 0) < 0)
+		if (ptrace_resume(tcpchild, 0) < 0)
 			return -1;
 
 		if (!qflag)
@@ -909,13 +955,9 @@ Process %u resumed (parent %d ready)\n",
 	}
 
 #ifdef TCB_CLONE_THREAD
-	if (sysent[tcp->scno].sys_func == sys_clone)
+	/* digimokan: (call_flags is 0 for fork/vfork, as sys_clone was checked) */
+	if (call_flags != 0)
 	{
-		/*
-		 * Save the flags used in this call,
-		 * in case we point TCP to our parent below.
-		 */
-		int call_flags = tcp->u_arg[ARG_FLAGS];
 		if ((tcp->flags & TCB_CLONE_THREAD) &&
 		    tcp->parent != NULL) {
 			/* The parent in this clone is itself a
@@ -0,0 +1,383 @@
+/*******************************************************************************
+module:   procsampler
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  sample memory, cpu time, and io of a growable set of processes from
+          a background thread, at a configurable interval
+*******************************************************************************/
+
+/*******************************************************************************
+ * SYSTEM INCLUDES
+ ******************************************************************************/
+
+#include <errno.h>          // ISOC: errno
+#include <fcntl.h>          // P2001: open(), O_RDONLY, O_CLOEXEC
+#include <pthread.h>        // P2001: pthread_create(), pthread_join(), pthread_cond_timedwait()
+#include <signal.h>         // P2001: sigfillset(), pthread_sigmask()
+#include <stdio.h>          // ISOC: snprintf(), sscanf()
+#include <stdlib.h>         // ISOC: realloc(), free()
+#include <string.h>         // ISOC: strrchr(), strstr(), memmove()
+#include <time.h>           // P2001: clock_gettime()
+#include <unistd.h>         // P2001: pread(), close(), sysconf()
+
+/*******************************************************************************
+ * USER INCLUDES
+ ******************************************************************************/
+
+#include "procsampler.h"
+#include "syslimits.h"      // max_open_files()
+
+/*******************************************************************************
+ * PRIVATE TYPES / CONSTANTS / VARIABLES
+ ******************************************************************************/
+
+#define NUM_PROC_FILES 3
+#define PROC_BUF_SIZE 2048
+
+typedef enum { PROC_STAT, PROC_STATUS, PROC_IO } ProcFile;
+
+static const char* proc_file_names[NUM_PROC_FILES] = { "stat", "status", "io" };
+
+// one sampled process (the set is sorted by pid)
+typedef struct {
+  pid_t pid;
+  int fds[NUM_PROC_FILES];    // -1 if not kept open
+} ProcEntry;
+
+// one queued change to the set
+typedef struct {
+  pid_t pid;
+  bool add;
+} ProcOp;
+
+// only touched by the sampler thread
+static ProcEntry* entries = NULL;
+static int entries_len = 0;
+static int entries_cap = 0;
+static long open_fds = 0;
+static long fd_budget = 0;
+static unsigned int interval_ms = 0;
+static ProcSampleSink sample_sink = NULL;
+
+// shared by the tracing thread (which queues ops) and the sampler thread
+static ProcOp* ops = NULL;
+static int ops_len = 0;
+static int ops_cap = 0;
+static bool sampling = false;
+static pthread_t sampler_thread;
+static pthread_mutex_t ops_mut = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t wake_cond;
+
+/*******************************************************************************
+ * PRIVATE MACROS / FUNCTIONS
+ ******************************************************************************/
+
+// return index of pid in entries, or -(insertion index + 1) if not found
+static int find_entry (pid_t pid) {
+  int lo = 0;
+  int hi = entries_len - 1;
+  while (lo <= hi) {
+    const int mid = lo + (hi - lo) / 2;
+    if (entries[mid].pid == pid) {
+      return mid;
+    } else if (entries[mid].pid < pid) {
+      lo = mid + 1;
+    } else {
+      hi = mid - 1;
+    }
+  }
+  return -(lo + 1);
+}
+
+static int open_proc_file (pid_t pid, ProcFile pf) {
+  char path[64];
+  snprintf(path, sizeof(path), "/proc/%d/%s", (int)pid, proc_file_names[pf]);
+  return open(path, O_RDONLY | O_CLOEXEC);
+}
+
+// read /proc/<pid>/<pf> of e into buf (NUL-terminated), return 0 or -1
+static int read_proc_file (ProcEntry* e, ProcFile pf, char* buf, size_t size) {
+  int fd = e->fds[pf];
+  const bool is_kept = (fd >= 0);
+  if (!is_kept && (fd = open_proc_file(e->pid, pf)) < 0) {
+    return -1;
+  }
+
+  const ssize_t n = pread(fd, buf, size - 1, 0);
+  if (!is_kept) {
+    close(fd);
+  }
+  if (n <= 0) {
+    return -1;
+  }
+  buf[n] = '\0';
+  return 0;
+}
+
+static void close_entry (ProcEntry* e) {
+  for (int i = 0; i < NUM_PROC_FILES; i++) {
+    if (e->fds[i] >= 0) {
+      close(e->fds[i]);
+      open_fds--;
+    }
+  }
+}
+
+// sample e into s, return 0, or -1 if the process is gone
+static int sample_entry (ProcEntry* e, ProcSample* s) {
+  char buf[PROC_BUF_SIZE];
+  memset(s, 0, sizeof(*s));
+  s->pid = e->pid;
+
+  if (read_proc_file(e, PROC_STAT, buf, sizeof(buf)) != 0 || procsampler_parse_stat(buf, s) != 0) {
+    return -1;
+  }
+  if (read_proc_file(e, PROC_STATUS, buf, sizeof(buf)) == 0) {
+    procsampler_parse_status(buf, s);
+  }
+  if (read_proc_file(e, PROC_IO, buf, sizeof(buf)) == 0) {
+    procsampler_parse_io(buf, s);
+  }
+  return 0;
+}
+
+static void add_entry (pid_t pid) {
+  int i = find_entry(pid);
+  if (i >= 0) {
+    return;   // e.g., a process that execs more than once
+  }
+  i = -(i + 1);
+
+  if (entries_len == entries_cap) {
+    entries_cap = entries_cap ? (2 * entries_cap) : 64;
+    entries = (ProcEntry*)realloc(entries, entries_cap * sizeof(ProcEntry));
+  }
+  memmove(&entries[i + 1], &entries[i], (entries_len - i) * sizeof(ProcEntry));
+  entries_len++;
+
+  ProcEntry* e = &entries[i];
+  e->pid = pid;
+  for (int f = 0; f < NUM_PROC_FILES; f++) {
+    e->fds[f] = -1;
+    if (open_fds < fd_budget && (e->fds[f] = open_proc_file(pid, (ProcFile)f)) >= 0) {
+      open_fds++;
+    }
+  }
+}
+
+static void erase_entry (int i) {
+  close_entry(&entries[i]);
+  memmove(&entries[i], &entries[i + 1], (entries_len - i - 1) * sizeof(ProcEntry));
+  entries_len--;
+}
+
+// apply one queued change (a removed pid gets a last sample)
+static void apply_op (const ProcOp* op) {
+  if (op->add) {
+    add_entry(op->pid);
+    return;
+  }
+
+  const int i = find_entry(op->pid);
+  if (i >= 0) {
+    ProcSample s;
+    if (sample_entry(&entries[i], &s) == 0) {
+      sample_sink(&s, false);
+    }
+    erase_entry(i);
+  }
+}
+
+// sample all entries, and drop the ones that are gone
+static void sample_all (void) {
+  int kept = 0;
+  for (int i = 0; i < entries_len; i++) {
+    ProcSample s;
+    if (sample_entry(&entries[i], &s) == 0) {
+      sample_sink(&s, false);
+      entries[kept++] = entries[i];
+    } else {
+      s.pid = entries[i].pid;
+      sample_sink(&s, true);
+      close_entry(&entries[i]);
+    }
+  }
+  entries_len = kept;
+}
+
+// take the queued changes (caller holds ops_mut)
+static ProcOp* take_ops (int* len) {
+  ProcOp* taken = ops;
+  *len = ops_len;
+  ops = NULL;
+  ops_len = 0;
+  ops_cap = 0;
+  return taken;
+}
+
+static void apply_ops (ProcOp* taken, int len) {
+  for (int i = 0; i < len; i++) {
+    apply_op(&taken[i]);
+  }
+  free(taken);
+}
+
+static void* run_sampler (void* arg) {
+  (void)arg;
+  struct timespec deadline;
+
+  pthread_mutex_lock(&ops_mut);
+  while (sampling) {
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += interval_ms / 1000;
+    deadline.tv_nsec += (interval_ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+      deadline.tv_sec++;
+      deadline.tv_nsec -= 1000000000L;
+    }
+    while (sampling && pthread_cond_timedwait(&wake_cond, &ops_mut, &deadline) != ETIMEDOUT) {
+    }
+
+    int len;
+    ProcOp* taken = take_ops(&len);
+    pthread_mutex_unlock(&ops_mut);
+    apply_ops(taken, len);
+    sample_all();
+    pthread_mutex_lock(&ops_mut);
+  }
+
+  // pids removed since the last sample still get their last sample
+  int len;
+  ProcOp* taken = take_ops(&len);
+  pthread_mutex_unlock(&ops_mut);
+  apply_ops(taken, len);
+
+  for (int i = 0; i < entries_len; i++) {
+    close_entry(&entries[i]);
+  }
+  free(entries);
+  entries = NULL;
+  entries_len = entries_cap = 0;
+  return NULL;
+}
+
+static void queue_op (pid_t pid, bool add) {
+  pthread_mutex_lock(&ops_mut);
+  if (sampling) {
+    if (ops_len == ops_cap) {
+      ops_cap = ops_cap ? (2 * ops_cap) : 64;
+      ops = (ProcOp*)realloc(ops, ops_cap * sizeof(ProcOp));
+    }
+    ops[ops_len].pid = pid;
+    ops[ops_len].add = add;
+    ops_len++;
+  }
+  pthread_mutex_unlock(&ops_mut);
+}
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+int procsampler_start (unsigned int interval, ProcSampleSink sink) {
+  if (interval == 0 || sampling) {
+    return 0;
+  }
+
+  interval_ms = interval;
+  sample_sink = sink;
+  fd_budget = max_open_files() / 4;
+  open_fds = 0;
+
+  pthread_condattr_t attr;
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  pthread_cond_init(&wake_cond, &attr);
+  pthread_condattr_destroy(&attr);
+
+  // the sampler thread must not take signals meant for the tracer
+  sigset_t all_sigs, old_sigs;
+  sigfillset(&all_sigs);
+  pthread_sigmask(SIG_SETMASK, &all_sigs, &old_sigs);
+  sampling = true;
+  const int err = pthread_create(&sampler_thread, NULL, run_sampler, NULL);
+  pthread_sigmask(SIG_SETMASK, &old_sigs, NULL);
+  if (err != 0) {
+    sampling = false;
+    pthread_cond_destroy(&wake_cond);
+    return -1;
+  }
+  return 0;
+}
+
+void procsampler_add_pid (pid_t pid) {
+  queue_op(pid, true);
+}
+
+void procsampler_remove_pid (pid_t pid) {
+  queue_op(pid, false);
+}
+
+void procsampler_stop (void) {
+  pthread_mutex_lock(&ops_mut);
+  const bool was_sampling = sampling;
+  sampling = false;
+  pthread_cond_signal(&wake_cond);
+  pthread_mutex_unlock(&ops_mut);
+
+  if (was_sampling) {
+    pthread_join(sampler_thread, NULL);
+    pthread_cond_destroy(&wake_cond);
+  }
+}
+
+int procsampler_parse_stat (const char* buf, ProcSample* s) {
+  // comm (field 2) is in parens, and may itself contain spaces or parens
+  const char* p = strrchr(buf, ')');
+  char state;
+  unsigned long long utime, stime, vsize;
+  long rss;
+  if (!p || sscanf(p + 1, " %c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu"
+                   " %*d %*d %*d %*d %*d %*d %*u %llu %ld",
+                   &state, &utime, &stime, &vsize, &rss) != 5) {
+    return -1;
+  }
+  // a zombie (or dead) process has released its memory: nothing to sample
+  if (state == 'Z' || state == 'X') {
+    return -1;
+  }
+
+  const long ticks_per_sec = sysconf(_SC_CLK_TCK);
+  const long page_kb = sysconf(_SC_PAGESIZE) / 1024;
+  s->utime_ms = (ticks_per_sec > 0) ? (utime * 1000 / ticks_per_sec) : 0;
+  s->stime_ms = (ticks_per_sec > 0) ? (stime * 1000 / ticks_per_sec) : 0;
+  s->vsize_bytes = vsize;
+  s->rss_kb = rss * page_kb;
+  if (s->peak_rss_kb < s->rss_kb) {
+    s->peak_rss_kb = s->rss_kb;
+  }
+  return 0;
+}
+
+int procsampler_parse_status (const char* buf, ProcSample* s) {
+  const char* p = strstr(buf, "\nVmHWM:");
+  long peak_kb;
+  if (!p || sscanf(p, "\nVmHWM: %ld kB", &peak_kb) != 1) {
+    return -1;
+  }
+  if (s->peak_rss_kb < peak_kb) {
+    s->peak_rss_kb = peak_kb;
+  }
+  return 0;
+}
+
+int procsampler_parse_io (const char* buf, ProcSample* s) {
+  const char* r = strstr(buf, "read_bytes:");
+  const char* w = strstr(buf, "\nwrite_bytes:");
+  if (!r || !w ||
+      sscanf(r, "read_bytes: %llu", &s->read_bytes) != 1 ||
+      sscanf(w, "\nwrite_bytes: %llu", &s->write_bytes) != 1) {
+    return -1;
+  }
+  return 0;
+}
@@ -0,0 +1,80 @@
+/*******************************************************************************
+module:   procsampler
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  sample memory, cpu time, and io of a growable set of processes from
+          a background thread, at a configurable interval
+notes:    - the tracing thread only queues pids to add/remove (it never waits
+            for a sample)
+          - /proc/<pid>/{stat,status,io} are opened once per pid and re-read
+            with pread(), while within a fd budget (a quarter of the max num
+            of open files), and opened per sample beyond it
+*******************************************************************************/
+
+#ifndef PROCSAMPLER_H
+#define PROCSAMPLER_H 1
+
+// allow this header to be included from c++ source file
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*******************************************************************************
+ * SYSTEM INCLUDES
+ ******************************************************************************/
+
+#include <stdbool.h>    // ISOC: bool
+#include <sys/types.h>  // P2001: pid_t
+
+/*******************************************************************************
+ * PUBLIC TYPES / CONSTANTS / VARIABLES
+ ******************************************************************************/
+
+// default interval between samples
+#define PROCSAMPLER_DEFAULT_INTERVAL_MS 1000
+
+// one sample of one process
+typedef struct {
+  pid_t pid;
+  unsigned long long vsize_bytes;   // virtual memory size
+  long rss_kb;                      // resident set size
+  long peak_rss_kb;                 // peak resident set size (VmHWM)
+  unsigned long long utime_ms;      // user cpu time
+  unsigned long long stime_ms;      // system cpu time
+  unsigned long long read_bytes;    // bytes read from storage
+  unsigned long long write_bytes;   // bytes written to storage
+} ProcSample;
+
+// receives each sample (lost is true, and only s->pid is set, if the process
+// disappeared without being removed); called from the sampler thread
+typedef void (*ProcSampleSink) (const ProcSample* s, bool lost);
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+// start sampling every interval_ms (0 disables sampling), pass samples to sink
+// return 0 on success, -1 if the sampler thread could not be created
+int procsampler_start (unsigned int interval_ms, ProcSampleSink sink);
+
+// queue pid to be added to / removed from the sampled set (a removed pid
+// gets one last sample, if it can still be read)
+void procsampler_add_pid (pid_t pid);
+void procsampler_remove_pid (pid_t pid);
+
+// stop sampling, and wait for the sampler thread to finish
+void procsampler_stop (void);
+
+// parse contents of /proc/<pid>/stat, /proc/<pid>/status, /proc/<pid>/io
+// into s, return 0 on success, -1 if buf is malformed (or, for stat, if the
+// process is a zombie)
+int procsampler_parse_stat (const char* buf, ProcSample* s);
+int procsampler_parse_status (const char* buf, ProcSample* s);
+int procsampler_parse_io (const char* buf, ProcSample* s);
+
+// allow this header to be included from c++ source file
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PROCSAMPLER_H
@@ -0,0 +1,164 @@
+/*******************************************************************************
+module:   provcoalesce
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  coalesce repeated file provenance records (e.g., a process that
+          re-opens the same config file in a loop) of the same (pid, path,
+          action) into one record with first/last times and a repeat count
+*******************************************************************************/
+
+/*******************************************************************************
+ * SYSTEM INCLUDES
+ ******************************************************************************/
+
+#include <stdbool.h>    // ISOC: bool
+#include <stdlib.h>     // ISOC: malloc(), free()
+#include <string.h>     // ISOC: strcmp(), strdup()
+
+/*******************************************************************************
+ * USER INCLUDES
+ ******************************************************************************/
+
+#include "provcoalesce.h"
+#include "strmap.h"     // StrMap, strmap_new(), strmap_get(), strmap_put(), strmap_remove()
+
+/*******************************************************************************
+ * PRIVATE TYPES / CONSTANTS / VARIABLES
+ ******************************************************************************/
+
+// one pending record, in the list of all pending records (in order of first
+// time), and in the list of pending records of its path
+typedef struct Pending {
+  CoalescedRecord rec;
+  struct Pending* prev;
+  struct Pending* next;
+  struct Pending* next_of_path;
+} Pending;
+
+static CoalescedRecordWriter record_writer = NULL;
+static Pending* oldest = NULL;
+static Pending* newest = NULL;
+static int num_pending = 0;
+static StrMap* pending_of_path = NULL;    // path -> first Pending of path
+
+/*******************************************************************************
+ * PRIVATE MACROS / FUNCTIONS
+ ******************************************************************************/
+
+static inline bool is_close (const char* action) {
+  return (strcmp(action, "CLOSE") == 0);
+}
+
+// return true if action must not be reordered with the pending action
+static inline bool conflicts (const char* action, const char* pending_action) {
+  return ( !is_close(action) && !is_close(pending_action) &&
+           (strcmp(action, pending_action) != 0) );
+}
+
+// write p, and remove it from both lists
+static void flush_pending (Pending* p) {
+  if (record_writer) {
+    record_writer(&p->rec);
+  }
+
+  Pending* first = (Pending*)strmap_get(pending_of_path, p->rec.path);
+  if (first == p) {
+    if (p->next_of_path) {
+      strmap_put(pending_of_path, p->rec.path, p->next_of_path);
+    } else {
+      strmap_remove(pending_of_path, p->rec.path);
+    }
+  } else {
+    while (first->next_of_path != p) {
+      first = first->next_of_path;
+    }
+    first->next_of_path = p->next_of_path;
+  }
+
+  if (p->prev) p->prev->next = p->next; else oldest = p->next;
+  if (p->next) p->next->prev = p->prev; else newest = p->prev;
+  num_pending--;
+
+  free((char*)p->rec.path);
+  free(p);
+}
+
+// flush pending records of path, and the records older than them, so that
+// the log stays in order of first time (its list is newest first)
+static void flush_path (const char* path) {
+  Pending* newest_of_path = (Pending*)strmap_get(pending_of_path, path);
+  while (oldest != newest_of_path) {
+    flush_pending(oldest);
+  }
+  flush_pending(newest_of_path);
+}
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+void coalesce_set_writer (CoalescedRecordWriter writer) {
+  record_writer = writer;
+}
+
+void coalesce_record (int now, pid_t pid, const char* action, const char* path) {
+  if (!pending_of_path) {
+    pending_of_path = strmap_new();
+  }
+  if (oldest && ((now - oldest->rec.first_time >= COALESCE_MAX_SECS) ||
+                 (num_pending >= COALESCE_MAX_PENDING))) {
+    coalesce_flush_all();
+  }
+
+  // same record is pending: count it.  different access of path is
+  // pending: write pending records of path first
+  for (Pending* p = (Pending*)strmap_get(pending_of_path, path); p; p = p->next_of_path) {
+    if (p->rec.pid == pid && strcmp(p->rec.action, action) == 0) {
+      p->rec.count++;
+      p->rec.last_time = now;
+      return;
+    }
+    if (conflicts(action, p->rec.action)) {
+      flush_path(path);
+      break;
+    }
+  }
+
+  Pending* p = (Pending*)malloc(sizeof(Pending));
+  p->rec.first_time = now;
+  p->rec.last_time = now;
+  p->rec.pid = pid;
+  p->rec.action = action;
+  p->rec.path = strdup(path);
+  p->rec.count = 1;
+  p->prev = newest;
+  p->next = NULL;
+  p->next_of_path = (Pending*)strmap_get(pending_of_path, path);
+  if (newest) newest->next = p; else oldest = p;
+  newest = p;
+  strmap_put(pending_of_path, path, p);
+  num_pending++;
+}
+
+void coalesce_flush_pid (pid_t pid) {
+  Pending* p = oldest;
+  while (p) {
+    Pending* next = p->next;
+    if (p->rec.pid == pid) {
+      flush_pending(p);
+    }
+    p = next;
+  }
+}
+
+void coalesce_flush_before (int now) {
+  while (oldest && oldest->rec.first_time < now) {
+    flush_pending(oldest);
+  }
+}
+
+void coalesce_flush_all (void) {
+  while (oldest) {
+    flush_pending(oldest);
+  }
+}
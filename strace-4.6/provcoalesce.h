@@ -0,0 +1,79 @@
+/*******************************************************************************
+module:   provcoalesce
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  coalesce repeated file provenance records (e.g., a process that
+          re-opens the same config file in a loop) of the same (pid, path,
+          action) into one record with first/last times and a repeat count
+flushes:  - all records of a pid: when it execs or exits
+          - all records of a path: when a different access (READ, WRITE,
+            READ-WRITE) of the path arrives, so reads and writes of a path
+            keep their order (CLOSE never conflicts), after all older records
+          - all records of earlier secs: before any other record (e.g., SPAWN,
+            EXECVE, MEM) is logged, so the log stays in order of time (but a
+            REPEAT record, at its last time, may go before records that
+            started earlier)
+          - all records: every COALESCE_MAX_SECS, or when COALESCE_MAX_PENDING
+            records are pending, or at exit
+NOTE:     NOT threadsafe (callers serialize calls, with the log file)
+*******************************************************************************/
+
+#ifndef PROVCOALESCE_H
+#define PROVCOALESCE_H 1
+
+// allow this header to be included from c++ source file
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*******************************************************************************
+ * SYSTEM INCLUDES
+ ******************************************************************************/
+
+#include <sys/types.h>  // P2001: pid_t
+
+/*******************************************************************************
+ * PUBLIC TYPES / CONSTANTS / VARIABLES
+ ******************************************************************************/
+
+// max secs a record stays pending (provlog times are in whole secs)
+#define COALESCE_MAX_SECS 5
+
+// max num records pending at once
+#define COALESCE_MAX_PENDING 4096
+
+// one coalesced record: action happened count times from first to last time
+typedef struct {
+  int first_time;
+  int last_time;
+  pid_t pid;
+  const char* action;   // "READ", "WRITE", "READ-WRITE", "UNKNOWNIO", "CLOSE"
+  const char* path;
+  unsigned long count;
+} CoalescedRecord;
+
+// writes one coalesced record (to the provlog)
+typedef void (*CoalescedRecordWriter) (const CoalescedRecord* rec);
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+// set the writer that flushed records are passed to
+void coalesce_set_writer (CoalescedRecordWriter writer);
+
+// add one record of pid doing action (a static string) on path at time now
+void coalesce_record (int now, pid_t pid, const char* action, const char* path);
+
+// flush pending records of pid / first logged before time now / of all pids
+// (in order of first time)
+void coalesce_flush_pid (pid_t pid);
+void coalesce_flush_before (int now);
+void coalesce_flush_all (void);
+
+// allow this header to be included from c++ source file
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PROVCOALESCE_H
@@ -7,9 +7,11 @@
 #include <fcntl.h>       // P2001: O_RDONLY, O_WRONLY, O_RDWR
 #include <pthread.h>     // P2001: PTHREAD_MUTEX_INITIALIZER, pthread_mutex_init/lock/unlock/create/destroy()
 #include <pwd.h>         // P2001: getpwuid()
+#include <stdarg.h>      // ISOC: va_list, va_start(), va_end()
 #include <sys/param.h>   // UNK: PATH_MAX
+#include <sys/utsname.h> // P2001: struct utsname, uname()
 #include <strings.h>     // P2001: bzero()
-#include <unistd.h>      // P2001: usleep()
+#include <unistd.h>      // P2001: access(), getuid()
 
 /*******************************************************************************
  * USER INCLUDES
@@ -19,6 +21,11 @@
 #include "cde.h"
 #include "okapi.h"      // canonicalize_path()
 #include "const.h"
+#include "perftimers.h"  // start_perf_timer(), stop_perf_timer(), count_perf_event()
+#include "sysprofile.h"  // Sysprofile_mode, sysprofile_now(), sysprofile_add_prov_time()
+#include "procsampler.h" // procsampler_start(), procsampler_add_pid(), procsampler_stop()
+#include "provcoalesce.h" // coalesce_record(), coalesce_flush_before(), coalesce_flush_pid(), ...
+#include "syslimits.h"    // max_open_files()
 
 /*******************************************************************************
  * EXTERNALLY-DEFINED FUNCTIONS
@@ -35,25 +42,19 @@ extern int string_quote (const char* instr, char* outstr, int len, int size); //
 
 char Prov_prov_mode = 0;       // true if auditing (opposite of Cde_exec_mode)
 char Prov_no_app_capture = 0;  // if true, run cde to collect prov but don't capture app
+unsigned int Prov_sample_interval_ms = PROCSAMPLER_DEFAULT_INTERVAL_MS; // 0 = no MEM/USAGE records
+char Prov_fd_byte_accounting = 0; // if true, log IOBYTES record of each opened file at close/exit
 
 /*******************************************************************************
  * PRIVATE TYPES / CONSTANTS / VARIABLES
  ******************************************************************************/
 
-// private types
-typedef struct {
-  pid_t pv[1000]; // array of pid's
-  int pc;         // current num pid's in array
-} PidList;
-
 // private constants
 #define ENV_LEN 16384     // max length of str to hold environ vars
 
 // private variables
 static FILE* prov_logfile = NULL; // provenance log file
-static PidList pidlist;
 static pthread_mutex_t mut_logfile = PTHREAD_MUTEX_INITIALIZER; // atomically update log file
-static pthread_mutex_t mut_pidlist = PTHREAD_MUTEX_INITIALIZER; // atomically update pidlist
 
 /*******************************************************************************
  * PRIVATE MACROS / FUNCTIONS
@@ -67,71 +68,118 @@ static pthread_mutex_t mut_pidlist = PTHREAD_MUTEX_INITIALIZER; // atomically up
 #  define MIN(a,b) (((a) < (b)) ? (a) : (b))
 #endif
 
-// print something (? pidlist ?) to provlog
-static void print_curr_prov (PidList* pidlist_p) {
-  int i, curr_time;
-  FILE *f;
-  char buff[1024];
-  long unsigned int rss;
-
-  pthread_mutex_lock(&mut_pidlist);
-  curr_time = (int)time(0);
-  for (i = 0; i < pidlist_p->pc; i++) {
-    sprintf(buff, "/proc/%d/stat", pidlist_p->pv[i]);
-    f = fopen(buff, "r");
-    if (f==NULL) { // remove this invalid pid
-      fprintf(prov_logfile, "%d %u LEXIT\n", curr_time, pidlist_p->pv[i]); // lost_pid exit
-      pidlist_p->pv[i] = pidlist_p->pv[pidlist_p->pc-1];
-      pidlist_p->pc--;
-      continue;
-    }
-    if (fgets(buff, 1024, f) == NULL)
-      rss= 0;
-    else
-      // details of format: http://git.kernel.org/?p=linux/kernel/git/stable/linux-stable.git;a=blob_plain;f=fs/proc/array.c;hb=d1c3ed669a2d452cacfb48c2d171a1f364dae2ed
-      sscanf(buff, "%*d %*s %*c %*d %*d %*d %*d %*d %*u %*u "
-          "%*u %*u %*u %*u %*u %*d %*d %*d %*d %*d %*d %*u %lu ", &rss);
-    fclose(f);
-    fprintf(prov_logfile, "%d %u MEM %lu\n", curr_time, pidlist_p->pv[i], rss);
-    sprintf(buff, "/proc/%d/io", pidlist_p->pv[i]);
-    f = fopen(buff, "r");
-    if (f==NULL) continue; 
-
-    fclose(f);
+// write one record to provlog, optionally tracking time of writing it
+static void vlog_prov_record (const char* fmt, va_list args) {
+  const uint64_t begin_ns = Sysprofile_mode ? sysprofile_now() : 0;
+  start_perf_timer(PROVENANCE_WRITES);
+  vfprintf(prov_logfile, fmt, args);
+  stop_perf_timer(PROVENANCE_WRITES);
+  count_perf_event(PROVENANCE_RECORDS, 1);
+  if (Sysprofile_mode) {
+    sysprofile_add_prov_time(sysprofile_now() - begin_ns);
+  }
+}
+
+// write one coalesced record to provlog (mut_logfile is held)
+static void log_prov_record (const char* fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  vlog_prov_record(fmt, args);
+  va_end(args);
+}
+
+// write one record that is not coalesced to provlog (from any thread), after
+// the coalesced records of earlier secs, so provlog stays in order of time
+static void log_prov_event (const char* fmt, ...) {
+  va_list args;
+  pthread_mutex_lock(&mut_logfile);
+  coalesce_flush_before((int)time(0));
+  va_start(args, fmt);
+  vlog_prov_record(fmt, args);
+  va_end(args);
+  pthread_mutex_unlock(&mut_logfile);
+}
+
+// add a file access to the coalesced records of provlog
+static void coalesce_prov (const pid_t pid, const char* action, const char* path) {
+  pthread_mutex_lock(&mut_logfile);
+  coalesce_record((int)time(0), pid, action, path);
+  pthread_mutex_unlock(&mut_logfile);
+}
+
+// write the coalesced records of pid to provlog (after those of earlier secs)
+static void flush_coalesced_prov (const pid_t pid) {
+  pthread_mutex_lock(&mut_logfile);
+  coalesce_flush_before((int)time(0));
+  coalesce_flush_pid(pid);
+  pthread_mutex_unlock(&mut_logfile);
+}
+
+// log sample of a traced proc to provlog (called by the sampler thread)
+static void print_sample_prov (const ProcSample* sample, bool lost) {
+  const int curr_time = (int)time(0);
+  if (lost) {
+    log_prov_event("%d %u LEXIT\n", curr_time, sample->pid); // lost_pid exit
+    return;
   }
-  pthread_mutex_unlock(&mut_pidlist);
+  log_prov_event("%d %u MEM %llu\n", curr_time, sample->pid, sample->vsize_bytes);
+  log_prov_event("%d %u USAGE %ld %ld %llu %llu %llu %llu\n", curr_time, sample->pid,
+      sample->rss_kb, sample->peak_rss_kb, sample->utime_ms, sample->stime_ms,
+      sample->read_bytes, sample->write_bytes);
 }
 
-// add input pid to end of pidlist array
+// start sampling input pid (does not wait for a sample)
 static void add_pid_prov (const pid_t pid) {
-  pthread_mutex_lock(&mut_pidlist);
-  pidlist.pv[pidlist.pc] = pid;
-  pidlist.pc++;
-  pthread_mutex_unlock(&mut_pidlist);
-  print_curr_prov(&pidlist);
+  procsampler_add_pid(pid);
 }
 
-// remove input pid from pidlist array
+// stop sampling input pid, after one last sample (does not wait for it)
 static void rm_pid_prov (const pid_t pid) {
-  int i=0;
-  if (pidlist.pc<=0) return;
-  print_curr_prov(&pidlist);
-  pthread_mutex_lock(&mut_pidlist);
-  while (pidlist.pv[i] != pid && i < pidlist.pc) i++;
-  if (i < pidlist.pc) {
-    pidlist.pv[i] = pidlist.pv[pidlist.pc-1];
-    pidlist.pc--;
+  procsampler_remove_pid(pid);
+}
+
+// log coalesced file access to provlog: a run of n > 1 identical records is
+// logged as its first record, and a REPEAT record with its last time and n
+static void print_coalesced_prov (const CoalescedRecord* rec) {
+  log_prov_record("%d %u %s %s\n", rec->first_time, rec->pid, rec->action, rec->path);
+  if (rec->count > 1) {
+    log_prov_record("%d %u REPEAT %s %lu %s\n", rec->last_time, rec->pid, rec->action,
+        rec->count, rec->path);
   }
-  pthread_mutex_unlock(&mut_pidlist);
 }
 
 // log file read/write/rw to provlog
+// log bytes read/written via opened fd since it was opened, and reset them
+static void print_io_bytes_prov (struct tcb* tcp, const int fd) {
+  struct io_bytes* b = tcp->files->opened_file_bytes ? &tcp->files->opened_file_bytes[fd] : NULL;
+  if (b && (b->read || b->written)) {
+    log_prov_event("%d %u IOBYTES %llu %llu %s\n", (int)time(0), tcp->pid,
+        b->read, b->written, tcp->files->opened_file_paths[fd]);
+    b->read = 0;
+    b->written = 0;
+  }
+}
+
+// return byte counts of the fd a read/write syscall used, or NULL if not
+// accounting it (accounting off, syscall failed, or fd not opened by this proc)
+static struct io_bytes* io_bytes_of_syscall (struct tcb* tcp) {
+  const long fd = tcp->u_arg[0];
+  if ( !Prov_prov_mode || !Prov_fd_byte_accounting || tcp->u_error || (tcp->u_rval <= 0) ||
+       (fd < 0) || (fd >= max_open_files()) || (tcp->files->opened_file_paths[fd] == NULL) ) {
+    return NULL;
+  }
+  if (!tcp->files->opened_file_bytes) {
+    tcp->files->opened_file_bytes = (struct io_bytes*) calloc(max_open_files(), sizeof(struct io_bytes));
+  }
+  return &tcp->files->opened_file_bytes[fd];
+}
+
 static void print_io_prov (struct tcb* tcp, const int path_index, const int action) {
   char *filename = strcpy_from_child_or_null(tcp, tcp->u_arg[path_index]);
-  char *filename_abspath = canonicalize_path(filename, tcp->current_dir);
+  char *filename_abspath = canonicalize_path(filename, tcp->fs->current_dir);
   assert(filename_abspath);
 
-  fprintf(prov_logfile, "%d %u %s %s\n", (int)time(0), tcp->pid,
+  coalesce_prov(tcp->pid,
       (action == PRV_RDONLY ? "READ" : (
         action == PRV_WRONLY ? "WRITE" : (
         action == PRV_RDWR ? "READ-WRITE" : "UNKNOWNIO"))),
@@ -142,21 +190,42 @@ static void print_io_prov (struct tcb* tcp, const int path_index, const int acti
 }
 
 /*
- * Print string specified by address `addr' and length `len'.
+ * Like snprintf(), but return the number of chars actually written to dest
+ * (not counting the NUL), so it can be added to a running length.
+ */
+static int
+snprintf_prov(char *dest, size_t size, const char *fmt, ...)
+{
+	va_list ap;
+	int n;
+
+	if (size == 0)
+		return 0;
+	va_start(ap, fmt);
+	n = vsnprintf(dest, size, fmt, ap);
+	va_end(ap);
+	if (n < 0) {
+		dest[0] = '\0';
+		return 0;
+	}
+	return ((size_t) n >= size) ? (int) (size - 1) : n;
+}
+
+/*
+ * Print string specified by address `addr' and length `len' into dest (at
+ * most `size' chars, including the NUL).
  * If `len' < 0, treat the string as a NUL-terminated string.
  * If string length exceeds `max_strlen', append `...' to the output.
  */
 int
-get_str_prov(char *dest, struct tcb *tcp, long addr, int len)
+get_str_prov(char *dest, size_t size, struct tcb *tcp, long addr, int len)
 {
 	static char *str = NULL;
 	static char *outstr;
-	int size;
-  int len_written = 0;
+	int n;
 
 	if (!addr) {
-		len_written += sprintf(dest+len_written, "NULL");
-		return len_written;
+		return snprintf_prov(dest, size, "NULL");
 	}
 	/* Allocate static buffers if they are not allocated yet. */
 	if (!str)
@@ -165,8 +234,7 @@ get_str_prov(char *dest, struct tcb *tcp, long addr, int len)
 		outstr = malloc(4 * max_strlen + sizeof "\"...\"");
 	if (!str || !outstr) {
 		fprintf(stderr, "out of memory\n");
-		len_written += sprintf(dest+len_written, "%#lx", addr);
-		return len_written;
+		return snprintf_prov(dest, size, "%#lx", addr);
 	}
 
 	if (len < 0) {
@@ -174,31 +242,32 @@ get_str_prov(char *dest, struct tcb *tcp, long addr, int len)
 		 * Treat as a NUL-terminated string: fetch one byte more
 		 * because string_quote() quotes one byte less.
 		 */
-		size = max_strlen + 1;
+		n = max_strlen + 1;
 		str[max_strlen] = '\0';
-		if (umovestr(tcp, addr, size, str) < 0) {
-			len_written += sprintf(dest+len_written, "%#lx", addr);
-			return len_written;
+		if (umovestr(tcp, addr, n, str) < 0) {
+			return snprintf_prov(dest, size, "%#lx", addr);
 		}
 	}
 	else {
-		size = MIN(len, max_strlen);
-		if (umoven(tcp, addr, size, str) < 0) {
-			len_written += sprintf(dest+len_written, "%#lx", addr);
-			return len_written;
+		n = MIN(len, max_strlen);
+		if (umoven(tcp, addr, n, str) < 0) {
+			return snprintf_prov(dest, size, "%#lx", addr);
 		}
 	}
 
-	if (string_quote(str, outstr, len, size) &&
+	if (string_quote(str, outstr, len, n) &&
 	    (len < 0 || len > max_strlen))
 		strcat(outstr, "...");
 
-	len_written += sprintf(dest+len_written, "%s", outstr);
-  return len_written;
+	return snprintf_prov(dest, size, "%s", outstr);
 }
 
+/*
+ * Print argv array at address `addr' into argstr (at most `argstr_size' chars,
+ * including the NUL). Args that do not fit are replaced by `...'.
+ */
 void
-print_arg_prov(char *argstr, struct tcb *tcp, long addr)
+print_arg_prov(char *argstr, size_t argstr_size, struct tcb *tcp, long addr)
 {
 	union {
 		unsigned int p32;
@@ -207,50 +276,32 @@ print_arg_prov(char *argstr, struct tcb *tcp, long addr)
 	} cp;
 	const char *sep;
 	int n = 0;
-  unsigned int len = 0;
+	size_t len = 0;
+	/* always leave room to close a truncated list */
+	const size_t tail = sizeof ", ...]";
 
-  len += sprintf(argstr+len, "[");
+	len += snprintf_prov(argstr+len, argstr_size-len, "[");
 	cp.p64 = 1;
 	for (sep = ""; !abbrev(tcp) || n < max_strlen / 2; sep = ", ", ++n) {
+		if (len + tail + 1 >= argstr_size)
+			break;
 		if (umoven(tcp, addr, personality_wordsize[current_personality],
 			   cp.data) < 0) {
-			len += sprintf(argstr+len, "%#lx\n", addr);
+			len += snprintf_prov(argstr+len, argstr_size-len, "%#lx\n", addr);
 			return;
 		}
 		if (personality_wordsize[current_personality] == 4)
 			cp.p64 = cp.p32;
 		if (cp.p64 == 0)
 			break;
-		len += sprintf(argstr+len, "%s", sep);
-		len += get_str_prov(argstr+len, tcp, cp.p64, -1);
+		len += snprintf_prov(argstr+len, argstr_size-len-tail, "%s", sep);
+		len += get_str_prov(argstr+len, argstr_size-len-tail, tcp, cp.p64, -1);
 		addr += personality_wordsize[current_personality];
 	}
 	if (cp.p64)
-		len += sprintf(argstr+len, "%s...", sep);
-
-	len += sprintf(argstr+len, "]");
-}
-
-void *capture_cont_prov(void* ptr) {
-  PidList *pidlist_p = (PidList*) ptr;
-  // Wait till we have the first pid, which should be the traced process.
-  // Start recording memory footprint.
-  // Ok to stop when there is no more pid, since by then,
-  // the original tracded process should have stopped.
-  while (pidlist_p->pc == 0) usleep(100000);
-  while (pidlist_p->pc > 0) { // recording
-    print_curr_prov(pidlist_p);
-    sleep(1); // TODO: configurable
-  } // done recording: pidlist.pc == 0
-  pthread_mutex_destroy(&mut_pidlist);
-
-	if (prov_logfile) {
-    vbprintf("=== Close log file ===\n");
-  	fclose(prov_logfile);
-  }
-  pthread_mutex_destroy(&mut_logfile);
+		len += snprintf_prov(argstr+len, argstr_size-len, "%s...", sep);
 
-  return NULL;
+	len += snprintf_prov(argstr+len, argstr_size-len, "]");
 }
 
 void rstrip(char *s) {
@@ -275,7 +326,6 @@ void rstrip(char *s) {
 
 // initialize provlog file
 void init_prov () {
-  pthread_t ptid;
   char *env_prov_mode = getenv("IN_CDE_PROVENANCE_MODE");
   char path[PATH_MAX];
   int subns=1;
@@ -308,17 +358,26 @@ void init_prov () {
     fcntl(plf_fd, F_SETFD, fcntl(plf_fd, F_GETFD) | FD_CLOEXEC);
     
     struct passwd *pw = getpwuid(getuid()); // don't free this pointer
-    FILE *fp;
-    char uname[PATH_MAX];
-    fp = popen("uname -a", "r");
-    if (fgets(uname, PATH_MAX, fp) == NULL)
-      sprintf(uname, "(unknown architecture)");
-    pclose(fp);
-    rstrip(uname);
+    // (as 'uname -a' prints it, without running it)
+    char uname_str[PATH_MAX];
+    struct utsname uname_info;
+    if (uname(&uname_info) == 0) {
+#ifdef __gnu_linux__
+      const char* os_name = " GNU/Linux";
+#else
+      const char* os_name = "";
+#endif
+      snprintf(uname_str, sizeof(uname_str), "%s %s %s %s %s%s",
+               uname_info.sysname, uname_info.nodename, uname_info.release,
+               uname_info.version, uname_info.machine, os_name);
+    }
+    else {
+      sprintf(uname_str, "(unknown architecture)");
+    }
     char fullns[PATH_MAX];
     sprintf(fullns, "%s.%d", CDE_ROOT_NAME, subns);
     fprintf(prov_logfile, "# @agent: %s\n", pw == NULL ? "(noone)" : pw->pw_name);
-    fprintf(prov_logfile, "# @machine: %s\n", uname);
+    fprintf(prov_logfile, "# @machine: %s\n", uname_str);
     fprintf(prov_logfile, "# @namespace: %s\n", CDE_ROOT_NAME);
     fprintf(prov_logfile, "# @subns: %d\n", subns);
     fprintf(prov_logfile, "# @fullns: %s\n", fullns);
@@ -326,9 +385,21 @@ void init_prov () {
 
     setenv("CDE_PROV_NAMESPACE", fullns, 1);
 
-    pthread_mutex_init(&mut_pidlist, NULL);
-    pidlist.pc = 0;
-    pthread_create( &ptid, NULL, capture_cont_prov, &pidlist);
+    coalesce_set_writer(print_coalesced_prov);
+    if (procsampler_start(Prov_sample_interval_ms, print_sample_prov) != 0) {
+      fprintf(stderr, "Provenance sampler could not be started, no MEM/USAGE records\n");
+    }
+  }
+}
+
+// stop sampling procs, and close provlog file
+void finish_prov () {
+  procsampler_stop();
+  coalesce_flush_all();
+  if (prov_logfile) {
+    vbprintf("=== Close log file ===\n");
+    fclose(prov_logfile);
+    prov_logfile = NULL;
   }
 }
 
@@ -336,14 +407,15 @@ void init_prov () {
 void print_begin_execve_prov (struct tcb* tcp) {
   if (Prov_prov_mode) {
     char *opened_filename = strcpy_from_child_or_null(tcp, tcp->u_arg[0]);
-    char *filename_abspath = canonicalize_path(opened_filename, tcp->current_dir);
+    char *filename_abspath = canonicalize_path(opened_filename, tcp->fs->current_dir);
     assert(filename_abspath);
     int parentPid = tcp->parent == NULL ? getpid() : tcp->parent->pid;
     char args[KEYLEN*10];
-    print_arg_prov(args, tcp, tcp->u_arg[1]);
+    print_arg_prov(args, sizeof(args), tcp, tcp->u_arg[1]);
 
-    fprintf(prov_logfile, "%d %d EXECVE %u %s %s %s\n", (int)time(0),
-      parentPid, tcp->pid, filename_abspath, tcp->current_dir, args);
+    flush_coalesced_prov(tcp->pid);
+    log_prov_event("%d %d EXECVE %u %s %s %s\n", (int)time(0),
+      parentPid, tcp->pid, filename_abspath, tcp->fs->current_dir, args);
 
     if (Cde_verbose_mode) {
       vbprintf("[%d-prov] BEGIN %s '%s'\n", tcp->pid, "execve", opened_filename);
@@ -360,7 +432,7 @@ void print_end_execve_prov (struct tcb* tcp) {
     int ppid = -1;
     if (tcp->parent) ppid = tcp->parent->pid;
 
-    fprintf(prov_logfile, "%d %u EXECVE2 %d\n", (int)time(0), tcp->pid, ppid);
+    log_prov_event("%d %u EXECVE2 %d\n", (int)time(0), tcp->pid, ppid);
     add_pid_prov(tcp->pid);
     if (Cde_verbose_mode) {
       vbprintf("[%d-prov] BEGIN execve2\n", tcp->pid);
@@ -371,14 +443,14 @@ void print_end_execve_prov (struct tcb* tcp) {
 // log proc creation of new proc to provlog if auditing
 void print_spawn_prov(struct tcb *tcp) {
   if (Prov_prov_mode) {
-    fprintf(prov_logfile, "%d %u SPAWN %u\n", (int)time(0), tcp->parent->pid, tcp->pid);
+    log_prov_event("%d %u SPAWN %u\n", (int)time(0), tcp->parent->pid, tcp->pid);
   }
 }
 
 // log proc ptrace call (if end of cell) to provlog if auditing
 void print_ptrace_prov(struct tcb *tcp) {
   if (Prov_prov_mode) {
-    fprintf(prov_logfile, "%d %u PTRACE\n", (int)time(0), tcp->pid);
+    log_prov_event("%d %u PTRACE\n", (int)time(0), tcp->pid);
   }
 }
 
@@ -386,7 +458,14 @@ void print_ptrace_prov(struct tcb *tcp) {
 void print_exit_prov (struct tcb* tcp) {
   if (Prov_prov_mode) { // not handle exit by signal yet
     rm_pid_prov(tcp->pid);
-    fprintf(prov_logfile, "%d %u EXIT\n", (int)time(0), tcp->pid);
+    // (bytes via open files shared with a CLONE_FILES clone are logged by the last of them)
+    if (tcp->files && (tcp->files->refcount == 1) && tcp->files->opened_file_bytes) {
+      for (int fd = 0; fd < max_open_files(); fd++) {
+        print_io_bytes_prov(tcp, fd);
+      }
+    }
+    flush_coalesced_prov(tcp->pid);
+    log_prov_event("%d %u EXIT\n", (int)time(0), tcp->pid);
   }
 }
 
@@ -411,7 +490,7 @@ void print_open_prov (struct tcb* tcp, const char* syscall_name) {
 
   // get abs path used to open file
   char* filename = strcpy_from_child_or_null(tcp, tcp->u_arg[path_index-1]);
-  char* filename_abspath = canonicalize_path(filename, tcp->current_dir);
+  char* filename_abspath = canonicalize_path(filename, tcp->fs->current_dir);
 
   // log prov if in prov mode and successful open call (on valid file)
   if (Prov_prov_mode && (tcp->u_rval >= 0)) {
@@ -431,9 +510,14 @@ void print_open_prov (struct tcb* tcp, const char* syscall_name) {
     // log the open call to prov log
     print_io_prov(tcp, path_index - 1, action);
 
-    // store exact abs path used to open the file
-    freeifnn(tcp->opened_file_paths[tcp->u_rval]);
-    tcp->opened_file_paths[tcp->u_rval] = strdup(filename_abspath);
+    // store exact abs path used to open the file (fd may be reused without
+    // a traced close, e.g. via dup2: log bytes via its previous path first)
+    if (tcp->files->opened_file_paths[tcp->u_rval]) {
+      print_io_bytes_prov(tcp, tcp->u_rval);
+    }
+    CDE_own_opened_file_paths(tcp); // stop sharing them with forked procs
+    freeifnn(tcp->files->opened_file_paths[tcp->u_rval]);
+    tcp->files->opened_file_paths[tcp->u_rval] = strdup(filename_abspath);
   }
 
   // log to stderr if verbose
@@ -459,6 +543,22 @@ void print_write_prov (struct tcb* tcp, const char* syscall_name, const int path
   }
 }
 
+// add bytes read by read/readv/pread/preadv (at its exit) to its fd
+void account_read_prov (struct tcb* tcp) {
+  struct io_bytes* b = io_bytes_of_syscall(tcp);
+  if (b) {
+    b->read += (unsigned long long)tcp->u_rval;
+  }
+}
+
+// add bytes written by write/writev/pwrite/pwritev (at its exit) to its fd
+void account_write_prov (struct tcb* tcp) {
+  struct io_bytes* b = io_bytes_of_syscall(tcp);
+  if (b) {
+    b->written += (unsigned long long)tcp->u_rval;
+  }
+}
+
 // log file hardlink/symlink to provlog if auditing
 void print_link_prov (struct tcb* tcp, const char* syscall_name,
                       const int realpath_index, const int linkpath_index) {
@@ -496,19 +596,26 @@ void print_close_prov (struct tcb* tcp) {
 
   // exit early if closing an fd this proc did NOT open
   //  --> there is no prov value in a close without a matching open
-  if (tcp->opened_file_paths[closefd] == NULL) {
+  if ( (closefd < 0) || (closefd >= max_open_files()) ||
+       (tcp->files->opened_file_paths[closefd] == NULL) ) {
     return;
   // close sys call WAS called on an fd that this proc opened
   } else {
-    openpath = tcp->opened_file_paths[closefd];
+    openpath = tcp->files->opened_file_paths[closefd];
   }
 
   // log to provlog
-  fprintf(prov_logfile, "%d %u %s %s\n", (int)time(0), tcp->pid, "CLOSE", openpath);
+  print_io_bytes_prov(tcp, closefd);
+  coalesce_prov(tcp->pid, "CLOSE", openpath);
 
   // log to stderr if verbose
   if (Cde_verbose_mode) {
     vbprintf("[%d-prov] CLOSE %s\n", tcp->pid, openpath);
   }
+
+  // fd is free to be reused (by e.g. a pipe, whose io is not accounted)
+  CDE_own_opened_file_paths(tcp); // (stop sharing paths with forked procs first)
+  free(tcp->files->opened_file_paths[closefd]);
+  tcp->files->opened_file_paths[closefd] = NULL;
 }
 
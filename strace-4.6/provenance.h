@@ -13,6 +13,8 @@ struct tcb;       // defs.h (strace module): process trace control block
 
 extern char Prov_prov_mode;        // true if auditing (opposite of Cde_exec_mode)
 extern char Prov_no_app_capture;   // if true, run cde to collect prov but don't capture app
+extern unsigned int Prov_sample_interval_ms; // interval of MEM/USAGE records (0 = none)
+extern char Prov_fd_byte_accounting;  // if true, log IOBYTES record of each opened file at close/exit
 
 /*******************************************************************************
  * PUBLIC MACROS / FUNCTIONS
@@ -20,6 +22,8 @@ extern char Prov_no_app_capture;   // if true, run cde to collect prov but don't
 
 // initialize provlog file
 void init_prov ();
+// stop sampling procs, and close provlog file
+void finish_prov ();
 // log proc exec call to provlog if auditing, to stderr if verbose
 void print_begin_execve_prov (struct tcb* tcp);
 // log ending proc exec call to provlog if auditing, to stderr if verbose
@@ -36,6 +40,9 @@ void print_open_prov (struct tcb* tcp, const char* syscall_name);
 void print_read_prov (struct tcb* tcp, const char* syscall_name, const int path_index);
 // log file write to provlog if auditing, to stderr if verbose
 void print_write_prov (struct tcb* tcp, const char* syscall_name, const int path_index);
+// add bytes read/written by a read/write syscall (at its exit) to its fd, if -B
+void account_read_prov (struct tcb* tcp);
+void account_write_prov (struct tcb* tcp);
 // log file hardlink/symlink to provlog if auditing
 void print_link_prov (struct tcb* tcp, const char* syscall_name, const int realpath_index, const int linkpath_index);
 // log file rename/move to provlog if auditing
@@ -0,0 +1,811 @@
+/*******************************************************************************
+module:   provindex
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  stream a provenance log once into an on-disk index (path dictionary,
+          per-path and per-proc event postings, process tree), and answer
+          lineage queries (ancestors, descendants, file closure) from it
+layout:   [header] [events] [procs] [paths] [path names, cmds] [path ids by name]
+*******************************************************************************/
+
+/*******************************************************************************
+ * SYSTEM INCLUDES
+ ******************************************************************************/
+
+#include <errno.h>      // ISOC: errno
+#include <fcntl.h>      // P2001: open(), O_RDONLY
+#include <inttypes.h>   // ISOC: uintptr_t
+#include <stdio.h>      // ISOC: FILE, fopen(), fwrite(), getline(), tmpfile()
+#include <stdlib.h>     // ISOC: malloc(), realloc(), free(), qsort(), strtoll()
+#include <string.h>     // ISOC: strcmp(), strchr(), strerror(), memset(), memchr()
+#include <sys/mman.h>   // P2001: mmap(), munmap()
+#include <sys/stat.h>   // P2001: fstat()
+#include <unistd.h>     // P2001: close()
+
+/*******************************************************************************
+ * USER INCLUDES
+ ******************************************************************************/
+
+#include "provindex.h"
+#include "strmap.h"     // StrMap, strmap_new(), strmap_get(), strmap_put(), strmap_foreach()
+
+/*******************************************************************************
+ * PRIVATE TYPES / CONSTANTS / VARIABLES
+ ******************************************************************************/
+
+#define INDEX_MAGIC "PTUPIDX"
+#define INDEX_VERSION 2
+
+// start of index file
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint32_t num_procs;
+  uint32_t num_paths;
+  uint32_t pad;
+  uint64_t num_events;
+  uint64_t off_events;
+  uint64_t off_procs;
+  uint64_t off_paths;
+  uint64_t off_names;
+  uint64_t off_sorted;
+  uint64_t size;
+} IndexHeader;
+
+// one indexed path
+typedef struct {
+  uint64_t name_off;        // offset of its name in the path names
+  uint64_t last_event;      // newest event of path
+  uint64_t num_events;
+} IndexPath;
+
+// state while streaming a provlog into an index (only procs and paths are
+// held in memory, events go straight to the index file)
+typedef struct {
+  FILE* out;
+  FILE* names;              // path names (copied into index at the end)
+  uint64_t names_len;
+  StrMap* path_ids;         // path -> path index + 1
+  IndexPath* paths;
+  uint32_t num_paths;
+  uint32_t cap_paths;
+  StrMap* proc_of_pid;      // pid -> index + 1 of the newest proc of pid
+  ProvProc* procs;
+  uint32_t num_procs;
+  uint32_t cap_procs;
+  uint64_t num_events;
+  uint64_t num_records;     // num of the record being added
+} Builder;
+
+struct ProvIndex {
+  const char* base;         // mmap-ed index file
+  size_t size;
+  const IndexHeader* hdr;
+  const ProvEvent* events;
+  const ProvProc* procs;
+  const IndexPath* paths;
+  const char* names;
+  const uint32_t* sorted;   // path indexes, sorted by name
+  uint32_t* first_child;    // process tree (children in order of index)
+  uint32_t* next_sibling;
+};
+
+// path record kinds, by name
+static const struct {
+  const char* name;
+  ProvRecordKind kind;
+} io_kinds[] = {
+  { "READ", PROVIDX_READ },
+  { "WRITE", PROVIDX_WRITE },
+  { "READ-WRITE", PROVIDX_READWRITE },
+  { "UNKNOWNIO", PROVIDX_UNKNOWNIO },
+  { "CLOSE", PROVIDX_CLOSE },
+};
+
+/*******************************************************************************
+ * PRIVATE MACROS / FUNCTIONS
+ ******************************************************************************/
+
+// return io kind named name, or PROVIDX_OTHER
+static ProvRecordKind io_kind (const char* name) {
+  for (size_t i = 0; i < sizeof(io_kinds) / sizeof(io_kinds[0]); i++) {
+    if (strcmp(io_kinds[i].name, name) == 0) {
+      return io_kinds[i].kind;
+    }
+  }
+  return PROVIDX_OTHER;
+}
+
+// return next space-separated token of *s (NUL-terminated in place), advance
+// *s past it, or return NULL if *s is empty
+static char* next_token (char** s) {
+  if (**s == '\0') {
+    return NULL;
+  }
+  char* token = *s;
+  char* space = strchr(token, ' ');
+  if (space) {
+    *space = '\0';
+    *s = space + 1;
+  } else {
+    *s = token + strlen(token);
+  }
+  return token;
+}
+
+// parse next token of *s as a (decimal) number into *val
+static int next_number (char** s, long long* val) {
+  char* token = next_token(s);
+  char* end;
+  if (!token) {
+    return -1;
+  }
+  errno = 0;
+  *val = strtoll(token, &end, 10);
+  return (end == token || *end != '\0' || errno) ? -1 : 0;
+}
+
+// grow *arr (of elements of elt_size) to hold at least need elements
+static void* grow (void* arr, uint32_t* cap, size_t elt_size, uint32_t need) {
+  if (need <= *cap) {
+    return arr;
+  }
+  uint32_t new_cap = (*cap == 0) ? 256 : (*cap * 2);
+  while (new_cap < need) {
+    new_cap *= 2;
+  }
+  void* grown = realloc(arr, new_cap * elt_size);
+  if (!grown) {
+    perror("realloc in provindex");
+    exit(1);
+  }
+  *cap = new_cap;
+  return grown;
+}
+
+// return index of newest proc of pid, or PROVIDX_NONE
+static uint32_t find_proc (Builder* b, pid_t pid) {
+  char key[32];
+  snprintf(key, sizeof(key), "%d", (int)pid);
+  return (uint32_t)((uintptr_t)strmap_get(b->proc_of_pid, key) - 1);
+}
+
+// add a new proc of pid (which becomes the newest proc of pid)
+static uint32_t add_proc (Builder* b, pid_t pid, uint32_t parent, int32_t time) {
+  b->procs = (ProvProc*)grow(b->procs, &b->cap_procs, sizeof(ProvProc), b->num_procs + 1);
+  ProvProc* p = &b->procs[b->num_procs];
+  memset(p, 0, sizeof(ProvProc));
+  p->pid = pid;
+  p->parent = parent;
+  p->exe = PROVIDX_NONE;
+  p->start_time = time;
+  p->last_event = PROVIDX_NO_EVENT;
+  p->start_record = b->num_records;
+  p->end_record = PROVIDX_NO_EVENT;
+  p->cmd = PROVIDX_NO_EVENT;
+
+  char key[32];
+  snprintf(key, sizeof(key), "%d", (int)pid);
+  strmap_put(b->proc_of_pid, key, (void*)(uintptr_t)(b->num_procs + 1));
+  return b->num_procs++;
+}
+
+// return index of newest proc of pid, adding one if pid was not seen yet
+static uint32_t find_or_add_proc (Builder* b, pid_t pid, int32_t time) {
+  const uint32_t proc = find_proc(b, pid);
+  return (proc != PROVIDX_NONE) ? proc : add_proc(b, pid, PROVIDX_NONE, time);
+}
+
+// return index of path, adding it if not seen yet
+static uint32_t find_or_add_path (Builder* b, const char* path) {
+  const uintptr_t id = (uintptr_t)strmap_get(b->path_ids, path);
+  if (id != 0) {
+    return (uint32_t)(id - 1);
+  }
+  b->paths = (IndexPath*)grow(b->paths, &b->cap_paths, sizeof(IndexPath), b->num_paths + 1);
+  IndexPath* p = &b->paths[b->num_paths];
+  p->name_off = b->names_len;
+  p->last_event = PROVIDX_NO_EVENT;
+  p->num_events = 0;
+  const size_t len = strlen(path) + 1;
+  fwrite(path, 1, len, b->names);
+  b->names_len += len;
+  strmap_put(b->path_ids, path, (void*)(uintptr_t)(b->num_paths + 1));
+  return b->num_paths++;
+}
+
+// keep program, cwd, and args of the first exec rec of proc with the path
+// names, as its cmd
+static void set_cmd (Builder* b, uint32_t proc, const ProvRecord* rec) {
+  if (b->procs[proc].cmd != PROVIDX_NO_EVENT || !rec->cwd || !rec->args) {
+    return;
+  }
+  b->procs[proc].cmd = b->names_len;
+  const char* parts[3] = { rec->path, rec->cwd, rec->args };
+  for (int i = 0; i < 3; i++) {
+    const size_t len = strlen(parts[i]) + 1;
+    fwrite(parts[i], 1, len, b->names);
+    b->names_len += len;
+  }
+}
+
+// write event of rec by proc on path, and chain it to their newest events
+static void add_event (Builder* b, uint32_t proc, uint32_t path, const ProvRecord* rec) {
+  ProvEvent ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.time = rec->time;
+  ev.kind = rec->kind;
+  ev.proc = proc;
+  ev.path = path;
+  ev.count = rec->count;
+  if (rec->kind == PROVIDX_IOBYTES) {
+    ev.bytes_read = rec->vals[0];
+    ev.bytes_written = rec->vals[1];
+  }
+  ev.prev_of_path = b->paths[path].last_event;
+  ev.prev_of_proc = b->procs[proc].last_event;
+  fwrite(&ev, sizeof(ev), 1, b->out);
+
+  b->paths[path].last_event = b->num_events;
+  b->paths[path].num_events++;
+  b->procs[proc].last_event = b->num_events;
+  b->num_events++;
+}
+
+// add one parsed record to the index being built
+static void add_record (Builder* b, const ProvRecord* rec) {
+  uint32_t proc;
+  switch (rec->kind) {
+    case PROVIDX_SPAWN:
+      add_proc(b, rec->pid, find_proc(b, rec->ppid), rec->time);
+      break;
+    case PROVIDX_EXECVE:
+      proc = find_proc(b, rec->pid);
+      if (proc == PROVIDX_NONE) {
+        proc = add_proc(b, rec->pid, find_proc(b, rec->ppid), rec->time);
+      }
+      b->procs[proc].exe = find_or_add_path(b, rec->path);
+      set_cmd(b, proc, rec);
+      add_event(b, proc, b->procs[proc].exe, rec);
+      break;
+    case PROVIDX_EXIT:
+    case PROVIDX_LEXIT:
+      // (a LEXIT may follow the EXIT of its proc)
+      proc = find_proc(b, rec->pid);
+      if (proc != PROVIDX_NONE && b->procs[proc].end_record == PROVIDX_NO_EVENT) {
+        b->procs[proc].end_time = rec->time;
+        b->procs[proc].end_record = b->num_records;
+      }
+      break;
+    case PROVIDX_MEM:
+      proc = find_or_add_proc(b, rec->pid, rec->time);
+      if (rec->vals[0] > b->procs[proc].max_vsize_bytes) {
+        b->procs[proc].max_vsize_bytes = rec->vals[0];
+      }
+      break;
+    case PROVIDX_USAGE:
+      // (the last sample of a proc may follow its EXIT)
+      proc = find_or_add_proc(b, rec->pid, rec->time);
+      b->procs[proc].peak_rss_kb = rec->vals[1];
+      b->procs[proc].utime_ms = rec->vals[2];
+      b->procs[proc].stime_ms = rec->vals[3];
+      b->procs[proc].read_bytes = rec->vals[4];
+      b->procs[proc].write_bytes = rec->vals[5];
+      break;
+    case PROVIDX_OTHER:
+      break;
+    default:
+      proc = find_or_add_proc(b, rec->pid, rec->time);
+      add_event(b, proc, find_or_add_path(b, rec->path), rec);
+      break;
+  }
+}
+
+// collect (name, index) of each path, to be sorted by name
+typedef struct {
+  const char* name;
+  uint32_t path;
+} NamedPath;
+
+typedef struct {
+  NamedPath* named;
+  uint32_t num;
+} NamedPaths;
+
+static void collect_path (const char* key, void* val, void* arg) {
+  NamedPaths* np = (NamedPaths*)arg;
+  np->named[np->num].name = key;
+  np->named[np->num].path = (uint32_t)((uintptr_t)val - 1);
+  np->num++;
+}
+
+static int cmp_named_path (const void* a, const void* b) {
+  return strcmp(((const NamedPath*)a)->name, ((const NamedPath*)b)->name);
+}
+
+// write procs, paths, names, and sorted path ids after the events, then the
+// header; return 0 on success, -1 on error
+static int finish_index (Builder* b) {
+  IndexHeader hdr;
+  memset(&hdr, 0, sizeof(hdr));
+  memcpy(hdr.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+  hdr.version = INDEX_VERSION;
+  hdr.num_procs = b->num_procs;
+  hdr.num_paths = b->num_paths;
+  hdr.num_events = b->num_events;
+  hdr.off_events = sizeof(IndexHeader);
+  hdr.off_procs = hdr.off_events + b->num_events * sizeof(ProvEvent);
+  hdr.off_paths = hdr.off_procs + (uint64_t)b->num_procs * sizeof(ProvProc);
+  hdr.off_names = hdr.off_paths + (uint64_t)b->num_paths * sizeof(IndexPath);
+  // (keep the sorted ids 4-byte aligned)
+  const uint64_t names_size = (b->names_len + 3) & ~(uint64_t)3;
+  hdr.off_sorted = hdr.off_names + names_size;
+  hdr.size = hdr.off_sorted + (uint64_t)b->num_paths * sizeof(uint32_t);
+
+  fwrite(b->procs, sizeof(ProvProc), b->num_procs, b->out);
+  fwrite(b->paths, sizeof(IndexPath), b->num_paths, b->out);
+
+  char buf[65536];
+  size_t n;
+  rewind(b->names);
+  while ((n = fread(buf, 1, sizeof(buf), b->names)) > 0) {
+    fwrite(buf, 1, n, b->out);
+  }
+  memset(buf, 0, 4);
+  fwrite(buf, 1, names_size - b->names_len, b->out);
+
+  NamedPaths np;
+  np.named = (NamedPath*)malloc((b->num_paths + 1) * sizeof(NamedPath));
+  np.num = 0;
+  strmap_foreach(b->path_ids, collect_path, &np);
+  qsort(np.named, np.num, sizeof(NamedPath), cmp_named_path);
+  for (uint32_t i = 0; i < np.num; i++) {
+    fwrite(&np.named[i].path, sizeof(uint32_t), 1, b->out);
+  }
+  free(np.named);
+
+  rewind(b->out);
+  fwrite(&hdr, sizeof(hdr), 1, b->out);
+  return ferror(b->out) ? -1 : 0;
+}
+
+// return true if event/proc/path index i is in range of the index
+#define IN_RANGE(i, num) ((uint64_t)(i) < (uint64_t)(num))
+
+// return true if a string starts at off of the path names, and ends within
+// them
+static bool is_name (const ProvIndex* idx, uint64_t off) {
+  const uint64_t names_size = idx->hdr->off_sorted - idx->hdr->off_names;
+  return IN_RANGE(off, names_size) && memchr(idx->names + off, '\0', names_size - off);
+}
+
+// return true if every index and offset within the sections of idx is in
+// range (so a stale or corrupt index file cannot crash a query), and each
+// chain of events only steps back to older events (so it ends)
+static bool has_valid_links (const ProvIndex* idx) {
+  const IndexHeader* hdr = idx->hdr;
+  for (uint64_t e = 0; e < hdr->num_events; e++) {
+    const ProvEvent* ev = &idx->events[e];
+    if ( (ev->kind > PROVIDX_OTHER) || !IN_RANGE(ev->proc, hdr->num_procs) ||
+         !IN_RANGE(ev->path, hdr->num_paths) ||
+         (ev->prev_of_path != PROVIDX_NO_EVENT && ev->prev_of_path >= e) ||
+         (ev->prev_of_proc != PROVIDX_NO_EVENT && ev->prev_of_proc >= e) ) {
+      return false;
+    }
+  }
+  for (uint32_t i = 0; i < hdr->num_procs; i++) {
+    const ProvProc* p = &idx->procs[i];
+    if ( (p->parent != PROVIDX_NONE && p->parent >= i) ||
+         (p->exe != PROVIDX_NONE && !IN_RANGE(p->exe, hdr->num_paths)) ||
+         (p->last_event != PROVIDX_NO_EVENT && !IN_RANGE(p->last_event, hdr->num_events)) ) {
+      return false;
+    }
+    if (p->cmd != PROVIDX_NO_EVENT) {
+      // (program, cwd, and args follow one another)
+      uint64_t off = p->cmd;
+      for (int part = 0; part < 3; part++) {
+        if (!is_name(idx, off)) {
+          return false;
+        }
+        off += strlen(idx->names + off) + 1;
+      }
+    }
+  }
+  for (uint32_t i = 0; i < hdr->num_paths; i++) {
+    const IndexPath* path = &idx->paths[i];
+    if ( !is_name(idx, path->name_off) || !IN_RANGE(idx->sorted[i], hdr->num_paths) ||
+         (path->last_event != PROVIDX_NO_EVENT && !IN_RANGE(path->last_event, hdr->num_events)) ) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+int provindex_parse_record (char* line, ProvRecord* rec) {
+  memset(rec, 0, sizeof(ProvRecord));
+  rec->count = 1;
+
+  char* end = line + strlen(line);
+  while (end > line && (end[-1] == '\n' || end[-1] == '\r')) {
+    *--end = '\0';
+  }
+  if (line[0] == '#' || line[0] == '\0') {
+    return -1;
+  }
+
+  // <time> <pid> <action> [<args>]
+  char* s = line;
+  long long time, pid, val;
+  if (next_number(&s, &time) != 0 || next_number(&s, &pid) != 0) {
+    return -1;
+  }
+  const char* action = next_token(&s);
+  if (!action) {
+    return -1;
+  }
+  rec->time = (int32_t)time;
+  rec->pid = (pid_t)pid;
+
+  if (strcmp(action, "REPEAT") == 0) {
+    // REPEAT <action> <n> <path>
+    const char* repeated = next_token(&s);
+    rec->kind = repeated ? io_kind(repeated) : PROVIDX_OTHER;
+    if (rec->kind == PROVIDX_OTHER || next_number(&s, &val) != 0 || val < 1) {
+      return -1;
+    }
+    rec->count = (uint64_t)val - 1;
+    rec->path = s;
+  } else if (strcmp(action, "IOBYTES") == 0) {
+    rec->kind = PROVIDX_IOBYTES;
+    for (int i = 0; i < 2; i++) {
+      if (next_number(&s, &val) != 0) {
+        return -1;
+      }
+      rec->vals[i] = (uint64_t)val;
+    }
+    rec->path = s;
+  } else if (strcmp(action, "EXECVE") == 0) {
+    // <ppid> EXECVE <pid> <program path> <cwd> <args>
+    rec->kind = PROVIDX_EXECVE;
+    rec->ppid = rec->pid;
+    if (next_number(&s, &pid) != 0) {
+      return -1;
+    }
+    rec->pid = (pid_t)pid;
+    rec->path = next_token(&s);
+    rec->cwd = next_token(&s);
+    rec->args = (rec->cwd && s[0] != '\0') ? s : NULL;
+  } else if (strcmp(action, "SPAWN") == 0) {
+    rec->kind = PROVIDX_SPAWN;
+    rec->ppid = rec->pid;
+    if (next_number(&s, &pid) != 0) {
+      return -1;
+    }
+    rec->pid = (pid_t)pid;
+    return 0;
+  } else if (strcmp(action, "EXIT") == 0 || strcmp(action, "LEXIT") == 0) {
+    rec->kind = (action[0] == 'L') ? PROVIDX_LEXIT : PROVIDX_EXIT;
+    return 0;
+  } else if (strcmp(action, "MEM") == 0 || strcmp(action, "USAGE") == 0) {
+    rec->kind = (action[0] == 'M') ? PROVIDX_MEM : PROVIDX_USAGE;
+    const int num_vals = (rec->kind == PROVIDX_MEM) ? 1 : 6;
+    for (int i = 0; i < num_vals; i++) {
+      if (next_number(&s, &val) != 0) {
+        return -1;
+      }
+      rec->vals[i] = (uint64_t)val;
+    }
+    return 0;
+  } else {
+    rec->kind = io_kind(action);
+    if (rec->kind == PROVIDX_OTHER) {
+      return 0;
+    }
+    rec->path = s;
+  }
+
+  // records of a path must name one
+  return (rec->path && rec->path[0] != '\0') ? 0 : -1;
+}
+
+int provindex_build (const char* log_path, const char* index_path) {
+  FILE* in = fopen(log_path, "r");
+  if (!in) {
+    fprintf(stderr, "provindex: cannot read %s: %s\n", log_path, strerror(errno));
+    return -1;
+  }
+  Builder b;
+  memset(&b, 0, sizeof(b));
+  b.out = fopen(index_path, "w+");
+  b.names = tmpfile();
+  if (!b.out || !b.names) {
+    fprintf(stderr, "provindex: cannot write %s: %s\n", index_path, strerror(errno));
+    fclose(in);
+    if (b.out) fclose(b.out);
+    if (b.names) fclose(b.names);
+    return -1;
+  }
+  b.path_ids = strmap_new();
+  b.proc_of_pid = strmap_new();
+
+  // events follow the header (written last)
+  IndexHeader placeholder;
+  memset(&placeholder, 0, sizeof(placeholder));
+  fwrite(&placeholder, sizeof(placeholder), 1, b.out);
+
+  char* line = NULL;
+  size_t line_cap = 0;
+  ProvRecord rec;
+  while (getline(&line, &line_cap, in) != -1) {
+    if (provindex_parse_record(line, &rec) == 0) {
+      add_record(&b, &rec);
+      b.num_records++;
+    }
+  }
+  free(line);
+
+  int rc = finish_index(&b);
+  if (fclose(b.out) != 0) {
+    rc = -1;
+  }
+  if (rc != 0) {
+    fprintf(stderr, "provindex: cannot write %s: %s\n", index_path, strerror(errno));
+  }
+  fclose(b.names);
+  fclose(in);
+  strmap_free(b.path_ids, NULL);
+  strmap_free(b.proc_of_pid, NULL);
+  free(b.paths);
+  free(b.procs);
+  return rc;
+}
+
+ProvIndex* provindex_open (const char* index_path) {
+  const int fd = open(index_path, O_RDONLY);
+  if (fd < 0) {
+    return NULL;
+  }
+  struct stat st;
+  void* base = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(IndexHeader)) {
+    base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  close(fd);
+  if (base == MAP_FAILED) {
+    return NULL;
+  }
+
+  // check the header, and that every section is within the file (and below,
+  // that every index within them is)
+  const IndexHeader* hdr = (const IndexHeader*)base;
+  if ( (memcmp(hdr->magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0) ||
+       (hdr->version != INDEX_VERSION) || (hdr->size != (uint64_t)st.st_size) ||
+       (hdr->off_procs != hdr->off_events + hdr->num_events * sizeof(ProvEvent)) ||
+       (hdr->off_paths != hdr->off_procs + (uint64_t)hdr->num_procs * sizeof(ProvProc)) ||
+       (hdr->off_names != hdr->off_paths + (uint64_t)hdr->num_paths * sizeof(IndexPath)) ||
+       (hdr->off_sorted < hdr->off_names) || (hdr->off_sorted % sizeof(uint32_t) != 0) ||
+       (hdr->size != hdr->off_sorted + (uint64_t)hdr->num_paths * sizeof(uint32_t)) ) {
+    munmap(base, st.st_size);
+    return NULL;
+  }
+
+  ProvIndex* idx = (ProvIndex*)malloc(sizeof(ProvIndex));
+  idx->base = (const char*)base;
+  idx->size = st.st_size;
+  idx->hdr = hdr;
+  idx->events = (const ProvEvent*)(idx->base + hdr->off_events);
+  idx->procs = (const ProvProc*)(idx->base + hdr->off_procs);
+  idx->paths = (const IndexPath*)(idx->base + hdr->off_paths);
+  idx->names = idx->base + hdr->off_names;
+  idx->sorted = (const uint32_t*)(idx->base + hdr->off_sorted);
+  if (!has_valid_links(idx)) {
+    munmap(base, st.st_size);
+    free(idx);
+    return NULL;
+  }
+
+  // process tree: push children to the front of their parent's list, in
+  // reverse, so each list is in order of index
+  const uint32_t n = hdr->num_procs;
+  idx->first_child = (uint32_t*)malloc((n + 1) * sizeof(uint32_t));
+  idx->next_sibling = (uint32_t*)malloc((n + 1) * sizeof(uint32_t));
+  for (uint32_t i = 0; i < n; i++) {
+    idx->first_child[i] = PROVIDX_NONE;
+    idx->next_sibling[i] = PROVIDX_NONE;
+  }
+  for (uint32_t i = n; i-- > 0; ) {
+    const uint32_t parent = idx->procs[i].parent;
+    if (IN_RANGE(parent, n)) {
+      idx->next_sibling[i] = idx->first_child[parent];
+      idx->first_child[parent] = i;
+    }
+  }
+  return idx;
+}
+
+void provindex_close (ProvIndex* idx) {
+  if (idx) {
+    munmap((void*)idx->base, idx->size);
+    free(idx->first_child);
+    free(idx->next_sibling);
+    free(idx);
+  }
+}
+
+uint32_t provindex_num_procs (const ProvIndex* idx) {
+  return idx->hdr->num_procs;
+}
+
+uint32_t provindex_num_paths (const ProvIndex* idx) {
+  return idx->hdr->num_paths;
+}
+
+uint64_t provindex_num_events (const ProvIndex* idx) {
+  return idx->hdr->num_events;
+}
+
+const ProvProc* provindex_proc (const ProvIndex* idx, uint32_t proc) {
+  return IN_RANGE(proc, idx->hdr->num_procs) ? &idx->procs[proc] : NULL;
+}
+
+const char* provindex_path (const ProvIndex* idx, uint32_t path) {
+  return IN_RANGE(path, idx->hdr->num_paths) ? idx->names + idx->paths[path].name_off : NULL;
+}
+
+const ProvEvent* provindex_event (const ProvIndex* idx, uint64_t event) {
+  return IN_RANGE(event, idx->hdr->num_events) ? &idx->events[event] : NULL;
+}
+
+bool provindex_proc_cmd (const ProvIndex* idx, uint32_t proc,
+                         const char** program, const char** cwd, const char** args) {
+  const ProvProc* p = provindex_proc(idx, proc);
+  const uint64_t names_size = idx->hdr->off_sorted - idx->hdr->off_names;
+  if (!p || !IN_RANGE(p->cmd, names_size)) {
+    return false;
+  }
+  *program = idx->names + p->cmd;
+  *cwd = *program + strlen(*program) + 1;
+  *args = *cwd + strlen(*cwd) + 1;
+  return true;
+}
+
+uint64_t provindex_last_event_of_path (const ProvIndex* idx, uint32_t path) {
+  return IN_RANGE(path, idx->hdr->num_paths) ? idx->paths[path].last_event : PROVIDX_NO_EVENT;
+}
+
+uint32_t provindex_find_path (const ProvIndex* idx, const char* path) {
+  uint32_t lo = 0;
+  uint32_t hi = idx->hdr->num_paths;
+  while (lo < hi) {
+    const uint32_t mid = lo + (hi - lo) / 2;
+    const int cmp = strcmp(provindex_path(idx, idx->sorted[mid]), path);
+    if (cmp == 0) {
+      return idx->sorted[mid];
+    } else if (cmp < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return PROVIDX_NONE;
+}
+
+uint32_t provindex_first_child (const ProvIndex* idx, uint32_t proc) {
+  return IN_RANGE(proc, idx->hdr->num_procs) ? idx->first_child[proc] : PROVIDX_NONE;
+}
+
+uint32_t provindex_next_sibling (const ProvIndex* idx, uint32_t proc) {
+  return IN_RANGE(proc, idx->hdr->num_procs) ? idx->next_sibling[proc] : PROVIDX_NONE;
+}
+
+bool provindex_event_reads (const ProvEvent* ev) {
+  return (ev->kind == PROVIDX_READ) || (ev->kind == PROVIDX_READWRITE) ||
+         (ev->kind == PROVIDX_EXECVE) ||
+         (ev->kind == PROVIDX_IOBYTES && ev->bytes_read > 0);
+}
+
+bool provindex_event_writes (const ProvEvent* ev) {
+  return (ev->kind == PROVIDX_WRITE) || (ev->kind == PROVIDX_READWRITE) ||
+         (ev->kind == PROVIDX_IOBYTES && ev->bytes_written > 0);
+}
+
+// breadth-first walk from the marked nodes, upstream (ancestors) or downstream
+// (descendants); nodes are procs [0, num_procs) then paths
+static void walk_lineage (const ProvIndex* idx, bool upstream, bool* proc_marks, bool* path_marks) {
+  const uint32_t num_procs = idx->hdr->num_procs;
+  const uint32_t num_paths = idx->hdr->num_paths;
+  const uint64_t num_nodes = (uint64_t)num_procs + num_paths;
+
+  // each node is queued at most twice: as a start node, and when marked
+  uint64_t* queue = (uint64_t*)malloc((2 * num_nodes + 1) * sizeof(uint64_t));
+  uint64_t head = 0;
+  uint64_t tail = 0;
+  for (uint32_t i = 0; i < num_procs; i++) {
+    if (proc_marks[i]) {
+      queue[tail++] = i;
+      proc_marks[i] = false;
+    }
+  }
+  for (uint32_t i = 0; i < num_paths; i++) {
+    if (path_marks[i]) {
+      queue[tail++] = (uint64_t)num_procs + i;
+      path_marks[i] = false;
+    }
+  }
+
+  #define VISIT_PROC(p) \
+    if (IN_RANGE((p), num_procs) && !proc_marks[(p)]) { \
+      proc_marks[(p)] = true; \
+      queue[tail++] = (p); \
+    }
+  #define VISIT_PATH(f) \
+    if (!path_marks[(f)]) { \
+      path_marks[(f)] = true; \
+      queue[tail++] = (uint64_t)num_procs + (f); \
+    }
+
+  while (head < tail) {
+    const uint64_t node = queue[head++];
+    if (node < num_procs) {
+      const uint32_t proc = (uint32_t)node;
+      if (upstream) {
+        VISIT_PROC(idx->procs[proc].parent);
+      } else {
+        for (uint32_t c = idx->first_child[proc]; c != PROVIDX_NONE; c = idx->next_sibling[c]) {
+          VISIT_PROC(c);
+        }
+      }
+      for (uint64_t e = idx->procs[proc].last_event; e != PROVIDX_NO_EVENT; e = idx->events[e].prev_of_proc) {
+        const ProvEvent* ev = &idx->events[e];
+        if (upstream ? provindex_event_reads(ev) : provindex_event_writes(ev)) {
+          VISIT_PATH(ev->path);
+        }
+      }
+    } else {
+      const uint32_t path = (uint32_t)(node - num_procs);
+      for (uint64_t e = idx->paths[path].last_event; e != PROVIDX_NO_EVENT; e = idx->events[e].prev_of_path) {
+        const ProvEvent* ev = &idx->events[e];
+        if (upstream ? provindex_event_writes(ev) : provindex_event_reads(ev)) {
+          VISIT_PROC(ev->proc);
+        }
+      }
+    }
+  }
+
+  #undef VISIT_PROC
+  #undef VISIT_PATH
+  free(queue);
+}
+
+void provindex_ancestors (const ProvIndex* idx, bool* proc_marks, bool* path_marks) {
+  walk_lineage(idx, true, proc_marks, path_marks);
+}
+
+void provindex_descendants (const ProvIndex* idx, bool* proc_marks, bool* path_marks) {
+  walk_lineage(idx, false, proc_marks, path_marks);
+}
+
+void provindex_closure (const ProvIndex* idx, bool* proc_marks, bool* path_marks) {
+  const uint32_t num_procs = idx->hdr->num_procs;
+
+  // mark descendant procs (children always have a larger index than their
+  // parent, so one pass in order of index reaches all of them)
+  for (uint32_t i = 0; i < num_procs; i++) {
+    const uint32_t parent = idx->procs[i].parent;
+    if (IN_RANGE(parent, num_procs) && proc_marks[parent]) {
+      proc_marks[i] = true;
+    }
+  }
+
+  for (uint32_t i = 0; i < num_procs; i++) {
+    if (proc_marks[i]) {
+      for (uint64_t e = idx->procs[i].last_event; e != PROVIDX_NO_EVENT; e = idx->events[e].prev_of_proc) {
+        path_marks[idx->events[e].path] = true;
+      }
+    }
+  }
+}
@@ -0,0 +1,175 @@
+/*******************************************************************************
+module:   provindex
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  stream a provenance log once into an on-disk index (path dictionary,
+          per-path and per-proc event postings, process tree), and answer
+          lineage queries (ancestors, descendants, file closure) from it
+notes:    - building keeps only the paths and procs in memory (never the
+            events), so memory does not grow with the length of the log
+          - the index is one file, mmap-ed by provindex_open(): postings are
+            chains of events (newest first), so queries only touch the events
+            of the paths/procs they visit
+lineage:  - ancestors of a file: the procs that wrote it
+          - ancestors of a proc: the files it read/exec-ed, and its parent
+          - descendants of a file: the procs that read/exec-ed it
+          - descendants of a proc: the files it wrote, and its children
+*******************************************************************************/
+
+#ifndef PROVINDEX_H
+#define PROVINDEX_H 1
+
+// allow this header to be included from c++ source file
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*******************************************************************************
+ * SYSTEM INCLUDES
+ ******************************************************************************/
+
+#include <stdbool.h>    // ISOC: bool
+#include <stdint.h>     // ISOC: uint32_t, uint64_t, int32_t
+#include <sys/types.h>  // P2001: pid_t
+
+/*******************************************************************************
+ * PUBLIC TYPES / CONSTANTS / VARIABLES
+ ******************************************************************************/
+
+// no proc / no path / no event
+#define PROVIDX_NONE 0xFFFFFFFFu
+
+// kinds of provlog records
+typedef enum {
+  PROVIDX_READ,         // READ <path>
+  PROVIDX_WRITE,        // WRITE <path>
+  PROVIDX_READWRITE,    // READ-WRITE <path>
+  PROVIDX_UNKNOWNIO,    // UNKNOWNIO <path>
+  PROVIDX_CLOSE,        // CLOSE <path>
+  PROVIDX_IOBYTES,      // IOBYTES <read> <written> <path>
+  PROVIDX_EXECVE,       // <ppid> EXECVE <pid> <program path> <cwd> <args>
+  PROVIDX_SPAWN,        // <ppid> SPAWN <pid>
+  PROVIDX_EXIT,         // EXIT
+  PROVIDX_LEXIT,        // LEXIT (proc disappeared without a traced exit)
+  PROVIDX_MEM,          // MEM <vsize>
+  PROVIDX_USAGE,        // USAGE <rss> <peak rss> <utime> <stime> <read> <written>
+  PROVIDX_OTHER         // EXECVE2, PTRACE, ... (not indexed)
+} ProvRecordKind;
+
+// one parsed provlog record (REPEAT <action> <n> <path> is parsed as a record
+// of action with count n-1, so counts of a path add up to its num accesses)
+typedef struct {
+  int32_t time;
+  pid_t pid;                // proc the record is about (EXECVE/SPAWN: the child)
+  pid_t ppid;               // EXECVE/SPAWN: the parent, else 0
+  ProvRecordKind kind;
+  uint64_t count;           // num accesses of path the record stands for
+  uint64_t vals[6];         // IOBYTES: read, written.  MEM: vsize.  USAGE: all 6
+  const char* path;         // file path (EXECVE: program), NULL if none
+  const char* cwd;          // EXECVE: cwd of the proc, else NULL
+  const char* args;         // EXECVE: its args (as logged, e.g. ["sh", "-c"]), else NULL
+} ProvRecord;
+
+// one indexed event of a proc on a path
+typedef struct {
+  int32_t time;
+  uint32_t kind;            // ProvRecordKind
+  uint32_t proc;
+  uint32_t path;
+  uint64_t count;
+  uint64_t bytes_read;      // IOBYTES only
+  uint64_t bytes_written;   // IOBYTES only
+  uint64_t prev_of_path;    // previous event of path, or PROVIDX_NO_EVENT
+  uint64_t prev_of_proc;    // previous event of proc, or PROVIDX_NO_EVENT
+} ProvEvent;
+
+// no previous event
+#define PROVIDX_NO_EVENT UINT64_MAX
+
+// one indexed proc (a pid between its SPAWN and the next SPAWN of the pid)
+typedef struct {
+  int32_t pid;
+  uint32_t parent;          // proc that spawned/exec-ed it, or PROVIDX_NONE
+  uint32_t exe;             // path of last program exec-ed, or PROVIDX_NONE
+  int32_t start_time;
+  int32_t end_time;         // time of EXIT/LEXIT, or 0 if none
+  uint32_t pad;
+  uint64_t max_vsize_bytes; // from MEM records
+  uint64_t peak_rss_kb;     // from USAGE records (last sample)
+  uint64_t utime_ms;
+  uint64_t stime_ms;
+  uint64_t read_bytes;
+  uint64_t write_bytes;
+  uint64_t last_event;      // newest event of proc, or PROVIDX_NO_EVENT
+  uint64_t start_record;    // num of its SPAWN (or first) record in the log
+  uint64_t end_record;      // num of its EXIT/LEXIT record, or PROVIDX_NO_EVENT
+  uint64_t cmd;             // its first exec (see provindex_proc_cmd()), or
+                            // PROVIDX_NO_EVENT if it did not exec
+} ProvProc;
+
+// opened index (read-only)
+typedef struct ProvIndex ProvIndex;
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+// parse one provlog line (modified in place: rec->path points into it)
+// return 0 on success, -1 if line is a comment, blank, or malformed
+int provindex_parse_record (char* line, ProvRecord* rec);
+
+// stream provlog at log_path once, and write its index to index_path
+// return 0 on success, -1 on error (reason printed to stderr)
+int provindex_build (const char* log_path, const char* index_path);
+
+// open / close index written by provindex_build() (NULL if unreadable, or if
+// any of its indexes or offsets is out of range)
+ProvIndex* provindex_open (const char* index_path);
+void provindex_close (ProvIndex* idx);
+
+// num of / one of the procs, paths, events of index
+uint32_t provindex_num_procs (const ProvIndex* idx);
+uint32_t provindex_num_paths (const ProvIndex* idx);
+uint64_t provindex_num_events (const ProvIndex* idx);
+const ProvProc* provindex_proc (const ProvIndex* idx, uint32_t proc);
+const char* provindex_path (const ProvIndex* idx, uint32_t path);
+const ProvEvent* provindex_event (const ProvIndex* idx, uint64_t event);
+
+// set program, cwd, and args (as logged) of the first exec of proc (the
+// command its parent ran), return false if it did not exec (e.g., a forked
+// child that exited without one)
+bool provindex_proc_cmd (const ProvIndex* idx, uint32_t proc,
+                         const char** program, const char** cwd, const char** args);
+
+// newest event of path, or PROVIDX_NO_EVENT (follow prev_of_path from there)
+uint64_t provindex_last_event_of_path (const ProvIndex* idx, uint32_t path);
+
+// return path index of path, or PROVIDX_NONE if not in index
+uint32_t provindex_find_path (const ProvIndex* idx, const char* path);
+
+// first child of proc / next child of the parent of proc, or PROVIDX_NONE
+uint32_t provindex_first_child (const ProvIndex* idx, uint32_t proc);
+uint32_t provindex_next_sibling (const ProvIndex* idx, uint32_t proc);
+
+// return true if event kind reads its path into its proc (READ, READ-WRITE,
+// EXECVE, IOBYTES with bytes read) / writes its path (WRITE, READ-WRITE,
+// IOBYTES with bytes written)
+bool provindex_event_reads (const ProvEvent* ev);
+bool provindex_event_writes (const ProvEvent* ev);
+
+// mark (in proc_marks[num_procs], path_marks[num_paths]) the ancestors or
+// descendants of the marked procs/paths; the start nodes stay marked only if
+// they are reachable from another start node
+void provindex_ancestors (const ProvIndex* idx, bool* proc_marks, bool* path_marks);
+void provindex_descendants (const ProvIndex* idx, bool* proc_marks, bool* path_marks);
+
+// mark the marked procs, their descendant procs, and every path any of them
+// accessed (the files needed to re-run the marked procs)
+void provindex_closure (const ProvIndex* idx, bool* proc_marks, bool* path_marks);
+
+// allow this header to be included from c++ source file
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PROVINDEX_H
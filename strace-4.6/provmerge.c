@@ -0,0 +1,423 @@
+/*******************************************************************************
+module:   provmerge
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  k-way merge the provenance logs of nested audits (ptu in ptu, sub-
+          packages of multi_repo_paths) into one log, ordered by time, with
+          the pids of each namespace kept apart
+*******************************************************************************/
+
+/*******************************************************************************
+ * SYSTEM INCLUDES
+ ******************************************************************************/
+
+#include <errno.h>      // ISOC: errno
+#include <inttypes.h>   // ISOC: uintptr_t
+#include <pthread.h>    // P2001: pthread_create(), pthread_join(), pthread_mutex_*(), pthread_cond_*()
+#include <stdbool.h>    // ISOC: bool
+#include <stdlib.h>     // ISOC: malloc(), realloc(), free(), strtol()
+#include <string.h>     // ISOC: strcmp(), strncmp(), strdup(), strerror(), memcpy()
+
+/*******************************************************************************
+ * USER INCLUDES
+ ******************************************************************************/
+
+#include "provmerge.h"
+#include "strmap.h"     // StrMap, strmap_new(), strmap_get(), strmap_put(), strmap_free()
+
+/*******************************************************************************
+ * PRIVATE TYPES / CONSTANTS / VARIABLES
+ ******************************************************************************/
+
+// lines of a log are passed from its reader thread to the merge in chunks of
+// about this many bytes, at most this many chunks ahead
+#define CHUNK_BYTES (256 * 1024)
+#define MAX_READY_CHUNKS 2
+
+// NUL-separated lines (without newlines)
+typedef struct Chunk {
+  char* buf;
+  size_t len;
+  size_t cap;
+  struct Chunk* next;
+} Chunk;
+
+// one log being merged
+typedef struct {
+  const char* path;
+  FILE* f;
+  char* fullns;             // "# @fullns:" header (or path of log)
+  char* parentns;           // "# @parentns:" header (NULL if none)
+  int parent;               // input of parentns, or -1
+  int depth;                // num of ancestor namespaces
+
+  // chunks read ahead by the reader thread (under mut)
+  pthread_t thread;
+  pthread_mutex_t mut;
+  pthread_cond_t cond;
+  Chunk* ready;
+  Chunk* ready_tail;
+  int num_ready;
+  bool read_all;
+  bool read_error;
+
+  // chunk being merged, and its current line
+  Chunk* cur;
+  size_t pos;
+  const char* line;
+  long time;
+
+  StrMap* out_pid_of_pid;   // pid -> pid in merged log, of newest proc of pid
+} Input;
+
+typedef struct {
+  Input* inputs;
+  int num_inputs;
+  FILE* out;
+  StrMap* ns_of_out_pid;    // pid in merged log -> input + 1 it was given to
+  long next_new_pid;
+} Merger;
+
+/*******************************************************************************
+ * PRIVATE MACROS / FUNCTIONS
+ ******************************************************************************/
+
+// return value of header "# @name: value" in line, or NULL if line is not it
+static const char* header_value (const char* line, const char* name) {
+  const size_t len = strlen(name);
+  if (strncmp(line, "# @", 3) != 0 || strncmp(line + 3, name, len) != 0 ||
+      strncmp(line + 3 + len, ": ", 2) != 0) {
+    return NULL;
+  }
+  return line + 3 + len + 2;
+}
+
+static Chunk* new_chunk (void) {
+  Chunk* c = (Chunk*)malloc(sizeof(Chunk));
+  c->cap = CHUNK_BYTES + 4096;
+  c->buf = (char*)malloc(c->cap);
+  c->len = 0;
+  c->next = NULL;
+  return c;
+}
+
+static void free_chunk (Chunk* c) {
+  free(c->buf);
+  free(c);
+}
+
+// add line (of n chars, maybe ending in a newline) to c
+static void chunk_add (Chunk* c, const char* line, size_t n) {
+  if (n > 0 && line[n - 1] == '\n') {
+    n--;
+  }
+  if (c->len + n + 1 > c->cap) {
+    c->cap = c->len + n + 1 + 4096;
+    c->buf = (char*)realloc(c->buf, c->cap);
+  }
+  memcpy(c->buf + c->len, line, n);
+  c->buf[c->len + n] = '\0';
+  c->len += n + 1;
+}
+
+// pass c to the merge, waiting while it is MAX_READY_CHUNKS behind
+static void push_chunk (Input* in, Chunk* c) {
+  pthread_mutex_lock(&in->mut);
+  while (in->num_ready >= MAX_READY_CHUNKS) {
+    pthread_cond_wait(&in->cond, &in->mut);
+  }
+  if (in->ready_tail) in->ready_tail->next = c; else in->ready = c;
+  in->ready_tail = c;
+  in->num_ready++;
+  pthread_cond_broadcast(&in->cond);
+  pthread_mutex_unlock(&in->mut);
+}
+
+// reader thread of a log: parse its headers, then pass its records (not its
+// comments) to the merge in chunks
+static void* read_input (void* arg) {
+  Input* in = (Input*)arg;
+  char* line = NULL;
+  size_t line_cap = 0;
+  ssize_t n;
+  bool in_headers = true;
+  Chunk* c = new_chunk();
+
+  while ((n = getline(&line, &line_cap, in->f)) != -1) {
+    if (line[0] == '#') {
+      const char* val;
+      if (line[n - 1] == '\n') {
+        line[--n] = '\0';
+      }
+      // (headers are only read before the first chunk is passed on)
+      if (in_headers && (val = header_value(line, "fullns"))) {
+        free(in->fullns);
+        in->fullns = strdup(val);
+      } else if (in_headers && (val = header_value(line, "parentns"))) {
+        free(in->parentns);
+        in->parentns = (strcmp(val, "(null)") == 0) ? NULL : strdup(val);
+      }
+      continue;
+    }
+    chunk_add(c, line, n);
+    if (c->len >= CHUNK_BYTES) {
+      in_headers = false;
+      push_chunk(in, c);
+      c = new_chunk();
+    }
+  }
+  free(line);
+  push_chunk(in, c);
+
+  pthread_mutex_lock(&in->mut);
+  in->read_error = ferror(in->f);
+  in->read_all = true;
+  pthread_cond_broadcast(&in->cond);
+  pthread_mutex_unlock(&in->mut);
+  return NULL;
+}
+
+// advance input to its next line (in->line is NULL at the end of the log)
+static void next_line (Input* in) {
+  if (in->cur) {
+    in->pos += strlen(in->cur->buf + in->pos) + 1;
+  }
+  while (!in->cur || in->pos >= in->cur->len) {
+    if (in->cur) {
+      free_chunk(in->cur);
+      in->cur = NULL;
+    }
+    pthread_mutex_lock(&in->mut);
+    while (in->num_ready == 0 && !in->read_all) {
+      pthread_cond_wait(&in->cond, &in->mut);
+    }
+    if (in->num_ready > 0) {
+      in->cur = in->ready;
+      in->ready = in->cur->next;
+      if (!in->ready) in->ready_tail = NULL;
+      in->num_ready--;
+      pthread_cond_broadcast(&in->cond);
+    }
+    pthread_mutex_unlock(&in->mut);
+    if (!in->cur) {
+      in->line = NULL;
+      return;
+    }
+    in->pos = 0;
+  }
+  in->line = in->cur->buf + in->pos;
+  in->time = strtol(in->line, NULL, 10);
+}
+
+// return true if the current line of input a goes before that of input b
+static bool goes_before (const Merger* m, int a, int b) {
+  const Input* ia = &m->inputs[a];
+  const Input* ib = &m->inputs[b];
+  if (ia->time != ib->time) return ia->time < ib->time;
+  if (ia->depth != ib->depth) return ia->depth < ib->depth;
+  return a < b;
+}
+
+// restore heap order of heap[0..n) from position i down
+static void sift_down (const Merger* m, int* heap, int n, int i) {
+  for (;;) {
+    int first = i;
+    const int l = 2 * i + 1;
+    const int r = 2 * i + 2;
+    if (l < n && goes_before(m, heap[l], heap[first])) first = l;
+    if (r < n && goes_before(m, heap[r], heap[first])) first = r;
+    if (first == i) {
+      return;
+    }
+    const int tmp = heap[i];
+    heap[i] = heap[first];
+    heap[first] = tmp;
+    i = first;
+  }
+}
+
+// return merged pid of newest proc of pid in namespace of input, or 0
+static long find_out_pid (const Merger* m, int input, long pid) {
+  char key[32];
+  snprintf(key, sizeof(key), "%ld", pid);
+  return (long)(uintptr_t)strmap_get(m->inputs[input].out_pid_of_pid, key);
+}
+
+// give a new proc of pid (started at time) in namespace of input a merged pid
+static long add_out_pid (Merger* m, int input, long pid, long time) {
+  char key[32];
+  snprintf(key, sizeof(key), "%ld", pid);
+  const uintptr_t owner = (uintptr_t)strmap_get(m->ns_of_out_pid, key);
+  long out_pid = pid;
+  if (owner != 0 && owner != (uintptr_t)(input + 1)) {
+    out_pid = m->next_new_pid++;
+    fprintf(m->out, "# @pid: %ld %s %ld %ld\n", out_pid, m->inputs[input].fullns, pid, time);
+    snprintf(key, sizeof(key), "%ld", out_pid);
+  }
+  strmap_put(m->ns_of_out_pid, key, (void*)(uintptr_t)(input + 1));
+  snprintf(key, sizeof(key), "%ld", pid);
+  strmap_put(m->inputs[input].out_pid_of_pid, key, (void*)(uintptr_t)out_pid);
+  return out_pid;
+}
+
+static long find_or_add_out_pid (Merger* m, int input, long pid, long time) {
+  const long out_pid = find_out_pid(m, input, pid);
+  return out_pid ? out_pid : add_out_pid(m, input, pid, time);
+}
+
+// write line of input to the merged log, with its pids rewritten
+static void merge_line (Merger* m, int input, const char* line) {
+  // <time> <pid> <action> [<args>]  (SPAWN/EXECVE args start with child pid)
+  char* end;
+  const long time = strtol(line, &end, 10);
+  const long pid = strtol(end, &end, 10);
+  if (*end != ' ') {
+    return;
+  }
+  const char* action = end + 1;
+  const char* args = strchr(action, ' ');
+  const size_t action_len = args ? (size_t)(args - action) : strlen(action);
+  args = args ? args + 1 : "";
+
+  const bool is_spawn = (action_len == 5 && strncmp(action, "SPAWN", 5) == 0);
+  const bool is_execve = (action_len == 6 && strncmp(action, "EXECVE", 6) == 0);
+  if (!is_spawn && !is_execve) {
+    fprintf(m->out, "%ld %ld %.*s%s%s\n", time, find_or_add_out_pid(m, input, pid, time),
+            (int)action_len, action, *args ? " " : "", args);
+    return;
+  }
+
+  const long child = strtol(args, &end, 10);
+  long out_child;
+  long out_parent = find_out_pid(m, input, pid);
+  if (is_spawn) {
+    out_parent = out_parent ? out_parent : add_out_pid(m, input, pid, time);
+    out_child = add_out_pid(m, input, child, time);
+  } else {
+    // the root proc of a namespace is exec-ed by its tracer: a proc of the
+    // parent namespace
+    out_child = find_or_add_out_pid(m, input, child, time);
+    const int parent_ns = m->inputs[input].parent;
+    if (!out_parent && parent_ns >= 0) {
+      out_parent = find_out_pid(m, parent_ns, pid);
+    }
+    out_parent = out_parent ? out_parent : add_out_pid(m, input, pid, time);
+  }
+  fprintf(m->out, "%ld %ld %.*s %ld%s\n", time, out_parent, (int)action_len, action,
+          out_child, end);
+}
+
+// link each input to the input of its parent namespace, and set its depth
+static void link_namespaces (Merger* m) {
+  for (int i = 0; i < m->num_inputs; i++) {
+    Input* in = &m->inputs[i];
+    in->parent = -1;
+    for (int j = 0; j < m->num_inputs && in->parentns; j++) {
+      if (j != i && strcmp(m->inputs[j].fullns, in->parentns) == 0) {
+        in->parent = j;
+        break;
+      }
+    }
+  }
+  for (int i = 0; i < m->num_inputs; i++) {
+    int depth = 0;
+    for (int p = m->inputs[i].parent; p >= 0 && depth < m->num_inputs; p = m->inputs[p].parent) {
+      depth++;
+    }
+    m->inputs[i].depth = depth;
+  }
+}
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+int provmerge_logs (const char* const* log_paths, int num_logs, FILE* out) {
+  Merger m;
+  m.inputs = (Input*)calloc(num_logs + 1, sizeof(Input));
+  m.num_inputs = 0;
+  m.out = out;
+  m.ns_of_out_pid = strmap_new();
+  m.next_new_pid = PROVMERGE_FIRST_NEW_PID;
+  int rc = 0;
+
+  // start a reader thread per log
+  for (int i = 0; i < num_logs; i++) {
+    Input* in = &m.inputs[m.num_inputs];
+    in->path = log_paths[i];
+    in->f = fopen(log_paths[i], "r");
+    if (!in->f) {
+      fprintf(stderr, "provmerge: cannot read %s: %s\n", log_paths[i], strerror(errno));
+      rc = -1;
+      break;
+    }
+    in->fullns = strdup(log_paths[i]);
+    in->out_pid_of_pid = strmap_new();
+    pthread_mutex_init(&in->mut, NULL);
+    pthread_cond_init(&in->cond, NULL);
+    if (pthread_create(&in->thread, NULL, read_input, in) != 0) {
+      fprintf(stderr, "provmerge: cannot start reader of %s\n", log_paths[i]);
+      fclose(in->f);
+      rc = -1;
+      break;
+    }
+    m.num_inputs++;
+  }
+
+  // first line of each log (its headers are read by then)
+  int* heap = (int*)malloc((m.num_inputs + 1) * sizeof(int));
+  int heap_len = 0;
+  for (int i = 0; i < m.num_inputs; i++) {
+    next_line(&m.inputs[i]);
+  }
+  link_namespaces(&m);
+
+  if (rc == 0) {
+    fprintf(out, "# @merged: %d\n", m.num_inputs);
+    for (int i = 0; i < m.num_inputs; i++) {
+      fprintf(out, "# @ns: %s %s %s\n", m.inputs[i].fullns,
+              m.inputs[i].parentns ? m.inputs[i].parentns : "(null)", m.inputs[i].path);
+    }
+
+    for (int i = 0; i < m.num_inputs; i++) {
+      if (m.inputs[i].line) {
+        heap[heap_len++] = i;
+      }
+    }
+    for (int i = heap_len / 2 - 1; i >= 0; i--) {
+      sift_down(&m, heap, heap_len, i);
+    }
+    while (heap_len > 0) {
+      Input* in = &m.inputs[heap[0]];
+      merge_line(&m, heap[0], in->line);
+      next_line(in);
+      if (!in->line) {
+        heap[0] = heap[--heap_len];
+      }
+      sift_down(&m, heap, heap_len, 0);
+    }
+  }
+
+  // (on error, drain the logs so their readers can finish)
+  for (int i = 0; i < m.num_inputs; i++) {
+    Input* in = &m.inputs[i];
+    while (in->line) {
+      next_line(in);
+    }
+    pthread_join(in->thread, NULL);
+    if (in->read_error) {
+      fprintf(stderr, "provmerge: cannot read %s\n", in->path);
+      rc = -1;
+    }
+    fclose(in->f);
+    free(in->fullns);
+    free(in->parentns);
+    strmap_free(in->out_pid_of_pid, NULL);
+    pthread_mutex_destroy(&in->mut);
+    pthread_cond_destroy(&in->cond);
+  }
+  free(heap);
+  free(m.inputs);
+  strmap_free(m.ns_of_out_pid, NULL);
+  return rc;
+}
@@ -0,0 +1,58 @@
+/*******************************************************************************
+module:   provmerge
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  k-way merge the provenance logs of nested audits (ptu in ptu, sub-
+          packages of multi_repo_paths) into one log, ordered by time, with
+          the pids of each namespace kept apart
+notes:    - each log is read by its own thread, a few chunks ahead of the merge,
+            so memory is bounded by the num of logs (and of procs), not by
+            their length
+          - records of one log keep their order (a log is merged in order even
+            where its times step back, i.e. at the REPEAT records of
+            coalesced records, see provcoalesce.h)
+          - on equal times, a parent namespace (# @parentns) goes first
+pids:     each proc is keyed by (namespace, pid, start time): it keeps its pid
+          in the merged log, unless a proc of another namespace already used
+          the pid, in which case it gets a new pid above any real pid (listed
+          in a "# @pid: <new pid> <namespace> <pid> <start time>" comment).
+          a namespace's root proc is linked to its tracer in the parent
+          namespace
+*******************************************************************************/
+
+#ifndef PROVMERGE_H
+#define PROVMERGE_H 1
+
+// allow this header to be included from c++ source file
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*******************************************************************************
+ * SYSTEM INCLUDES
+ ******************************************************************************/
+
+#include <stdio.h>      // ISOC: FILE
+
+/*******************************************************************************
+ * PUBLIC TYPES / CONSTANTS / VARIABLES
+ ******************************************************************************/
+
+// first pid given to procs whose pid was used by another namespace (above
+// the max pid of linux, PID_MAX_LIMIT)
+#define PROVMERGE_FIRST_NEW_PID 4194304
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+// merge the num_logs provlogs at log_paths into one provlog written to out
+// return 0 on success, -1 if a log could not be read (reason printed to stderr)
+int provmerge_logs (const char* const* log_paths, int num_logs, FILE* out);
+
+// allow this header to be included from c++ source file
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PROVMERGE_H
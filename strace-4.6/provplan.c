@@ -0,0 +1,1012 @@
+/*******************************************************************************
+module:   provplan
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  plan and run an incremental re-execution of a captured app: from a
+          provenance index and the fingerprints of the files its procs read,
+          re-run (inside the cde-package) only the procs whose inputs changed,
+          and the procs downstream of them, in dependency order; or replay
+          the whole app as independent subtrees, run at once on many cores
+*******************************************************************************/
+
+/*******************************************************************************
+ * SYSTEM INCLUDES
+ ******************************************************************************/
+
+#include <ctype.h>      // ISOC: isdigit(), isxdigit()
+#include <errno.h>      // ISOC: errno
+#include <fcntl.h>      // P2001: open(), O_RDONLY
+#include <limits.h>     // ISOC: PATH_MAX
+#include <pthread.h>    // P2001: pthread_t, pthread_mutex_t, pthread_cond_t
+#include <stdio.h>      // ISOC: fprintf(), snprintf(), perror()
+#include <stdlib.h>     // ISOC: malloc(), realloc(), calloc(), free(), qsort(), realpath()
+#include <string.h>     // ISOC: strlen(), strcmp(), strncmp(), strerror()
+#include <sys/stat.h>   // P2001: stat(), S_ISREG()
+#include <sys/wait.h>   // P2001: waitpid(), WIFEXITED(), WEXITSTATUS()
+#include <unistd.h>     // P2001: fork(), chdir(), dup2(), close(), execv(), write(), _exit()
+
+/*******************************************************************************
+ * USER INCLUDES
+ ******************************************************************************/
+
+#include "provplan.h"
+#include "manifest.h"   // ManifestEntry, manifest_load(), manifest_save(), hash_file_contents()
+#include "strmap.h"     // StrMap, strmap_new(), strmap_get(), strmap_put()
+
+/*******************************************************************************
+ * PRIVATE TYPES / CONSTANTS / VARIABLES
+ ******************************************************************************/
+
+// a step's first and last write (or read) of the current path, by event index
+typedef struct {
+  uint32_t step;
+  uint64_t first;
+  uint64_t last;
+} StepEvent;
+
+// distinct steps that wrote / read one path, while collecting dependencies
+typedef struct {
+  StepEvent* list;
+  uint32_t num;
+  uint32_t cap;
+  uint32_t* slot_of_step;   // slot in list + 1 of step, if stamp_of_step matches
+  uint32_t* stamp_of_step;
+} StepEvents;
+
+// how the subtree of a proc is replayed
+typedef enum {
+  REPLAY_NONE,              // it cannot be
+  REPLAY_EMPTY,             // it wrote no files, so it need not be
+  REPLAY_RERUN,             // by re-running the proc
+  REPLAY_SPLIT              // by replaying the subtree of each of its children
+} ReplayHow;
+
+// a worker's deque of ready steps: the worker pushes and pops at the bottom,
+// idle workers steal from the top
+typedef struct {
+  pthread_mutex_t lock;
+  uint32_t* steps;          // ring of num_steps slots (each step is pushed once)
+  uint32_t top;
+  uint32_t bottom;
+} StepDeque;
+
+// state of a parallel run of a plan
+typedef struct {
+  const ProvIndex* idx;
+  const ProvPlan* plan;
+  const char* package_dir;
+  uint32_t num_workers;
+  StepDeque* deques;
+  uint32_t* num_blocking;   // deps of each step not yet finished
+  uint32_t* first_dependent;// dependents of step s: dependents[first_dependent[s]
+  uint32_t* dependents;     //   .. first_dependent[s + 1])
+  pthread_mutex_t lock;     // guards the counts below, and pushes to deques
+  pthread_cond_t cond;      // signaled when steps get ready, or one fails/ends
+  uint32_t num_ready;       // steps in deques not yet claimed by a worker
+  uint32_t num_running;
+  uint32_t num_started;
+  bool failed;
+} Scheduler;
+
+typedef struct {
+  Scheduler* sched;
+  uint32_t id;
+} Worker;
+
+/*******************************************************************************
+ * PRIVATE MACROS / FUNCTIONS
+ ******************************************************************************/
+
+// return malloc-ed "<package_dir>/<name><path>"
+static char* package_path (const char* package_dir, const char* name, const char* path) {
+  const size_t len = strlen(package_dir) + strlen(name) + strlen(path) + 2;
+  char* s = (char*)malloc(len);
+  snprintf(s, len, "%s/%s%s", package_dir, name, path);
+  return s;
+}
+
+// return true if some proc read path (its data, or exec-ed it)
+static bool is_input (const ProvIndex* idx, uint32_t path) {
+  for (uint64_t e = provindex_last_event_of_path(idx, path); e != PROVIDX_NO_EVENT; ) {
+    const ProvEvent* ev = provindex_event(idx, e);
+    if (provindex_event_reads(ev)) {
+      return true;
+    }
+    e = ev->prev_of_path;
+  }
+  return false;
+}
+
+// return true if path is a device or kernel interface rather than a file
+// steps may pass data through (e.g., /dev/null, written by many procs)
+static bool is_special_path (const char* name) {
+  return strncmp(name, "/dev/", 5) == 0 || strncmp(name, "/proc/", 6) == 0 ||
+         strncmp(name, "/sys/", 5) == 0;
+}
+
+// return value of escape at *s (after its '\'), advance *s past it
+static char unescape (const char** s) {
+  const char c = *(*s)++;
+  switch (c) {
+    case 'f': return '\f';
+    case 'n': return '\n';
+    case 'r': return '\r';
+    case 't': return '\t';
+    case 'v': return '\v';
+    case 'x': {
+      int val = 0;
+      for (int i = 0; i < 2 && isxdigit((unsigned char)**s); i++) {
+        const char d = *(*s)++;
+        val = val * 16 + (isdigit((unsigned char)d) ? d - '0' : (d | 0x20) - 'a' + 10);
+      }
+      return (char)val;
+    }
+    default:
+      if (c >= '0' && c <= '7') {
+        int val = c - '0';
+        for (int i = 0; i < 2 && **s >= '0' && **s <= '7'; i++) {
+          val = val * 8 + (*(*s)++ - '0');
+        }
+        return (char)val;
+      }
+      return c;   // '"' or '\'
+  }
+}
+
+// return true if the lifetime of another child of the parent of proc
+// overlapped its own (as in a pipeline, whose pipes are not in the log)
+static bool overlaps_sibling (const ProvIndex* idx, uint32_t proc) {
+  const ProvProc* p = provindex_proc(idx, proc);
+  for (uint32_t c = provindex_first_child(idx, p->parent); c != PROVIDX_NONE;
+       c = provindex_next_sibling(idx, c)) {
+    const ProvProc* sibling = provindex_proc(idx, c);
+    if (c != proc && sibling->start_record < p->end_record && p->start_record < sibling->end_record) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// return true if proc accessed files before its first exec (e.g., a shell
+// redirecting the stdin/stdout of the command it is about to run), other
+// than opening /dev/null to read (the stdin of a shell's background job, and of
+// every re-run proc)
+static bool has_io_before_exec (const ProvIndex* idx, uint32_t proc) {
+  uint64_t first_exec = PROVIDX_NO_EVENT;
+  uint64_t first_other = PROVIDX_NO_EVENT;
+  for (uint64_t e = provindex_proc(idx, proc)->last_event; e != PROVIDX_NO_EVENT; ) {
+    const ProvEvent* ev = provindex_event(idx, e);
+    if (ev->kind == PROVIDX_EXECVE) {
+      first_exec = e;
+    } else if (provindex_event_writes(ev) || strcmp(provindex_path(idx, ev->path), "/dev/null") != 0) {
+      first_other = e;
+    }
+    e = ev->prev_of_proc;
+  }
+  return first_other < first_exec;
+}
+
+// return true if proc itself (not its children) wrote files
+static bool writes_files (const ProvIndex* idx, uint32_t proc) {
+  for (uint64_t e = provindex_proc(idx, proc)->last_event; e != PROVIDX_NO_EVENT; ) {
+    const ProvEvent* ev = provindex_event(idx, e);
+    if (provindex_event_writes(ev) && !is_special_path(provindex_path(idx, ev->path))) {
+      return true;
+    }
+    e = ev->prev_of_proc;
+  }
+  return false;
+}
+
+// return true if proc can be re-run by itself: it has a complete command,
+// and it got its stdin/stdout/stderr unchanged from the nearest ancestor
+// that exec-ed (as far as the log tells, and unless flags say otherwise)
+static bool can_rerun (const ProvIndex* idx, uint32_t proc, unsigned flags) {
+  const char* program;
+  const char* cwd;
+  const char* args;
+  char** argv;
+  if (!provindex_proc_cmd(idx, proc, &program, &cwd, &args) ||
+      provplan_parse_args(args, &argv) < 0) {
+    return false;
+  }
+  for (int i = 0; argv[i]; i++) {
+    free(argv[i]);
+  }
+  free(argv);
+
+  const bool piped = !(flags & PROVPLAN_NO_PIPES);
+  if (has_io_before_exec(idx, proc) || (piped && overlaps_sibling(idx, proc))) {
+    return false;
+  }
+  // (a forked subshell may have redirected what its children inherit)
+  for (uint32_t q = provindex_proc(idx, proc)->parent; q != PROVIDX_NONE;
+       q = provindex_proc(idx, q)->parent) {
+    if (provindex_proc_cmd(idx, q, &program, &cwd, &args)) {
+      break;
+    }
+    if (provindex_proc(idx, q)->last_event != PROVIDX_NO_EVENT || (piped && overlaps_sibling(idx, q))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// note that step wrote (or read) the current path (stamp) at event e
+static void add_step_event (StepEvents* se, uint32_t stamp, uint32_t step, uint64_t e) {
+  if (se->stamp_of_step[step] == stamp) {
+    StepEvent* prev = &se->list[se->slot_of_step[step] - 1];
+    if (e < prev->first) {
+      prev->first = e;
+    }
+    if (e > prev->last) {
+      prev->last = e;
+    }
+    return;
+  }
+  if (se->num == se->cap) {
+    se->cap = (se->cap == 0) ? 64 : (se->cap * 2);
+    se->list = (StepEvent*)realloc(se->list, se->cap * sizeof(StepEvent));
+  }
+  se->list[se->num].step = step;
+  se->list[se->num].first = e;
+  se->list[se->num].last = e;
+  se->stamp_of_step[step] = stamp;
+  se->slot_of_step[step] = ++se->num;
+}
+
+static int cmp_u64 (const void* a, const void* b) {
+  const uint64_t x = *(const uint64_t*)a;
+  const uint64_t y = *(const uint64_t*)b;
+  return (x < y) ? -1 : (x > y);
+}
+
+// add dependency (later step << 32 | earlier step) to deps
+static void add_dep (uint64_t** deps, uint64_t* num, uint64_t* cap, uint32_t later, uint32_t earlier) {
+  if (*num == *cap) {
+    *cap = (*cap == 0) ? 256 : (*cap * 2);
+    *deps = (uint64_t*)realloc(*deps, *cap * sizeof(uint64_t));
+  }
+  (*deps)[(*num)++] = ((uint64_t)later << 32) | earlier;
+}
+
+// return (later step << 32 | earlier step) of each distinct dependency of a
+// step on another: a file it read after the other wrote it, or wrote after
+// the other read or wrote it (so running them in another order, or at once,
+// would change what is read or left); sorted
+static uint64_t* collect_deps (const ProvIndex* idx, const uint32_t* unit_of,
+                               const uint32_t* step_of, uint32_t num_steps, uint64_t* num_deps) {
+  StepEvents writers, readers;
+  memset(&writers, 0, sizeof(writers));
+  memset(&readers, 0, sizeof(readers));
+  writers.slot_of_step = (uint32_t*)calloc(num_steps + 1, sizeof(uint32_t));
+  writers.stamp_of_step = (uint32_t*)calloc(num_steps + 1, sizeof(uint32_t));
+  readers.slot_of_step = (uint32_t*)calloc(num_steps + 1, sizeof(uint32_t));
+  readers.stamp_of_step = (uint32_t*)calloc(num_steps + 1, sizeof(uint32_t));
+
+  uint64_t* deps = NULL;
+  uint64_t num = 0;
+  uint64_t cap = 0;
+  for (uint32_t path = 0; path < provindex_num_paths(idx); path++) {
+    if (is_special_path(provindex_path(idx, path))) {
+      continue;
+    }
+    writers.num = 0;
+    readers.num = 0;
+    for (uint64_t e = provindex_last_event_of_path(idx, path); e != PROVIDX_NO_EVENT; ) {
+      const ProvEvent* ev = provindex_event(idx, e);
+      const uint32_t unit = unit_of[ev->proc];
+      if (unit != PROVIDX_NONE) {
+        if (provindex_event_writes(ev)) {
+          add_step_event(&writers, path + 1, step_of[unit], e);
+        }
+        if (provindex_event_reads(ev)) {
+          add_step_event(&readers, path + 1, step_of[unit], e);
+        }
+      }
+      e = ev->prev_of_path;
+    }
+
+    for (uint32_t w = 0; w < writers.num; w++) {
+      const StepEvent* writer = &writers.list[w];
+      for (uint32_t r = 0; r < readers.num; r++) {
+        const StepEvent* reader = &readers.list[r];
+        if (writer->step != reader->step) {
+          if (writer->first < reader->last) {
+            add_dep(&deps, &num, &cap, reader->step, writer->step);
+          }
+          if (reader->first < writer->last) {
+            add_dep(&deps, &num, &cap, writer->step, reader->step);
+          }
+        }
+      }
+      for (uint32_t o = 0; o < writers.num; o++) {
+        if (o != w && writer->first < writers.list[o].last) {
+          add_dep(&deps, &num, &cap, writers.list[o].step, writer->step);
+        }
+      }
+    }
+  }
+
+  free(writers.list);
+  free(writers.slot_of_step);
+  free(writers.stamp_of_step);
+  free(readers.list);
+  free(readers.slot_of_step);
+  free(readers.stamp_of_step);
+
+  qsort(deps, num, sizeof(uint64_t), cmp_u64);
+  uint64_t num_distinct = 0;
+  for (uint64_t i = 0; i < num; i++) {
+    if (num_distinct == 0 || deps[i] != deps[num_distinct - 1]) {
+      deps[num_distinct++] = deps[i];
+    }
+  }
+  *num_deps = num_distinct;
+  return deps;
+}
+
+// push step onto min-heap of steps
+static void heap_push (uint32_t* heap, uint32_t* num, uint32_t step) {
+  uint32_t i = (*num)++;
+  while (i > 0 && heap[(i - 1) / 2] > step) {
+    heap[i] = heap[(i - 1) / 2];
+    i = (i - 1) / 2;
+  }
+  heap[i] = step;
+}
+
+// pop smallest step off min-heap of steps
+static uint32_t heap_pop (uint32_t* heap, uint32_t* num) {
+  const uint32_t top = heap[0];
+  const uint32_t last = heap[--(*num)];
+  uint32_t i = 0;
+  for (;;) {
+    uint32_t child = 2 * i + 1;
+    if (child >= *num) {
+      break;
+    }
+    if (child + 1 < *num && heap[child + 1] < heap[child]) {
+      child++;
+    }
+    if (last <= heap[child]) {
+      break;
+    }
+    heap[i] = heap[child];
+    i = child;
+  }
+  heap[i] = last;
+  return top;
+}
+
+// return order[num_steps] of steps such that each comes after the steps it
+// depends on (deps sorted by later step), preferring the original order; a cycle
+// of deps (e.g., two procs appending to each other's inputs) is broken at
+// its earliest step
+static uint32_t* order_steps (uint32_t num_steps, const uint64_t* deps, uint64_t num_deps) {
+  uint32_t* num_blocking = (uint32_t*)calloc(num_steps + 1, sizeof(uint32_t));
+  uint64_t* first_out = (uint64_t*)calloc(num_steps + 2, sizeof(uint64_t));
+  uint32_t* out = (uint32_t*)malloc((num_deps + 1) * sizeof(uint32_t));
+  for (uint64_t i = 0; i < num_deps; i++) {
+    num_blocking[deps[i] >> 32]++;
+    first_out[(uint32_t)deps[i] + 1]++;
+  }
+  for (uint32_t s = 0; s < num_steps; s++) {
+    first_out[s + 1] += first_out[s];
+  }
+  uint64_t* fill = (uint64_t*)malloc((num_steps + 1) * sizeof(uint64_t));
+  memcpy(fill, first_out, num_steps * sizeof(uint64_t));
+  for (uint64_t i = 0; i < num_deps; i++) {
+    out[fill[(uint32_t)deps[i]]++] = (uint32_t)(deps[i] >> 32);
+  }
+  free(fill);
+
+  uint32_t* order = (uint32_t*)malloc((num_steps + 1) * sizeof(uint32_t));
+  bool* placed = (bool*)calloc(num_steps + 1, sizeof(bool));
+  uint32_t* heap = (uint32_t*)malloc((num_steps + 1) * sizeof(uint32_t));
+  uint32_t num_heap = 0;
+  uint32_t num_placed = 0;
+  uint32_t next_unplaced = 0;
+  for (uint32_t s = 0; s < num_steps; s++) {
+    if (num_blocking[s] == 0) {
+      heap_push(heap, &num_heap, s);
+    }
+  }
+  while (num_placed < num_steps) {
+    uint32_t s;
+    if (num_heap > 0) {
+      s = heap_pop(heap, &num_heap);
+    } else {
+      while (placed[next_unplaced]) {
+        next_unplaced++;
+      }
+      s = next_unplaced;
+    }
+    if (placed[s]) {
+      continue;
+    }
+    placed[s] = true;
+    order[num_placed++] = s;
+    for (uint64_t i = first_out[s]; i < first_out[s + 1]; i++) {
+      if (!placed[out[i]] && --num_blocking[out[i]] == 0) {
+        heap_push(heap, &num_heap, out[i]);
+      }
+    }
+  }
+
+  free(heap);
+  free(placed);
+  free(out);
+  free(first_out);
+  free(num_blocking);
+  return order;
+}
+
+// return plan to re-run the procs marked in is_unit[num_procs] (a unit
+// within another is re-run by it)
+static ProvPlan* plan_of_units (const ProvIndex* idx, const bool* is_unit) {
+  // (children always have a larger index than their parent, so one pass in
+  // order of index finds the units within others)
+  const uint32_t num_procs = provindex_num_procs(idx);
+  uint32_t* unit_of = (uint32_t*)malloc((num_procs + 1) * sizeof(uint32_t));
+  uint32_t* step_of = (uint32_t*)malloc((num_procs + 1) * sizeof(uint32_t));
+  uint32_t* proc_of_step = (uint32_t*)malloc((num_procs + 1) * sizeof(uint32_t));
+  uint32_t num_steps = 0;
+  for (uint32_t i = 0; i < num_procs; i++) {
+    const uint32_t parent = provindex_proc(idx, i)->parent;
+    unit_of[i] = PROVIDX_NONE;
+    if (parent != PROVIDX_NONE && unit_of[parent] != PROVIDX_NONE) {
+      unit_of[i] = unit_of[parent];
+    } else if (is_unit[i]) {
+      unit_of[i] = i;
+      step_of[i] = num_steps;
+      proc_of_step[num_steps++] = i;
+    }
+  }
+
+  uint64_t num_deps;
+  uint64_t* deps = collect_deps(idx, unit_of, step_of, num_steps, &num_deps);
+  uint32_t* order = order_steps(num_steps, deps, num_deps);
+  uint32_t* pos = (uint32_t*)malloc((num_steps + 1) * sizeof(uint32_t));
+  for (uint32_t i = 0; i < num_steps; i++) {
+    pos[order[i]] = i;
+  }
+
+  // steps in order, each with the deps placed before it (deps broken off a
+  // cycle are dropped)
+  ProvPlan* plan = (ProvPlan*)calloc(1, sizeof(ProvPlan));
+  plan->num_steps = num_steps;
+  plan->steps = (ProvPlanStep*)calloc(num_steps + 1, sizeof(ProvPlanStep));
+  for (uint32_t i = 0; i < num_steps; i++) {
+    plan->steps[i].proc = proc_of_step[order[i]];
+  }
+  for (uint64_t first = 0, last; first < num_deps; first = last) {
+    const uint32_t later = (uint32_t)(deps[first] >> 32);
+    ProvPlanStep* step = &plan->steps[pos[later]];
+    for (last = first; last < num_deps && (uint32_t)(deps[last] >> 32) == later; last++) {
+    }
+    step->deps = (uint32_t*)malloc((last - first) * sizeof(uint32_t));
+    for (uint64_t d = first; d < last; d++) {
+      const uint32_t earlier_pos = pos[(uint32_t)deps[d]];
+      if (earlier_pos < pos[later]) {
+        step->deps[step->num_deps++] = earlier_pos;
+      }
+    }
+  }
+
+  free(pos);
+  free(order);
+  free(deps);
+  free(proc_of_step);
+  free(step_of);
+  free(unit_of);
+  return plan;
+}
+
+// print what step of plan is re-run ([num/of])
+static void print_step (const ProvIndex* idx, const ProvPlan* plan, uint32_t step, uint32_t num) {
+  const char* program;
+  const char* cwd;
+  const char* args;
+  provindex_proc_cmd(idx, plan->steps[step].proc, &program, &cwd, &args);
+  fprintf(stderr, "ptu-prov: [%u/%u] re-running proc %d: %s\n", num, plan->num_steps,
+          (int)provindex_proc(idx, plan->steps[step].proc)->pid, args);
+}
+
+// take a ready step for worker id (one is claimed, so some deque holds one):
+// the newest of its own deque, else steal the oldest of another's
+static uint32_t take_step (Scheduler* s, uint32_t id) {
+  const uint32_t cap = s->plan->num_steps;
+  for (;;) {
+    for (uint32_t i = 0; i < s->num_workers; i++) {
+      StepDeque* d = &s->deques[(id + i) % s->num_workers];
+      pthread_mutex_lock(&d->lock);
+      if (d->top != d->bottom) {
+        const uint32_t step = (i == 0) ? d->steps[--d->bottom % cap] : d->steps[d->top++ % cap];
+        pthread_mutex_unlock(&d->lock);
+        return step;
+      }
+      pthread_mutex_unlock(&d->lock);
+    }
+  }
+}
+
+// push ready step onto the bottom of deque d
+static void push_step (Scheduler* s, StepDeque* d, uint32_t step) {
+  pthread_mutex_lock(&d->lock);
+  d->steps[d->bottom++ % s->plan->num_steps] = step;
+  pthread_mutex_unlock(&d->lock);
+}
+
+// run ready steps until none are left, or one failed
+static void* run_worker (void* arg) {
+  Scheduler* s = ((Worker*)arg)->sched;
+  const uint32_t id = ((Worker*)arg)->id;
+  for (;;) {
+    pthread_mutex_lock(&s->lock);
+    while (s->num_ready == 0 && s->num_running > 0 && !s->failed) {
+      pthread_cond_wait(&s->cond, &s->lock);
+    }
+    if (s->num_ready == 0 || s->failed) {
+      pthread_mutex_unlock(&s->lock);
+      return NULL;
+    }
+    s->num_ready--;
+    s->num_running++;
+    const uint32_t num = ++s->num_started;
+    pthread_mutex_unlock(&s->lock);
+
+    const uint32_t step = take_step(s, id);
+    print_step(s->idx, s->plan, step, num);
+    const pid_t pid = provplan_start_step(s->idx, s->plan, step, s->package_dir);
+    int status;
+    const bool ok = (pid >= 0 && waitpid(pid, &status, 0) == pid &&
+                     WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    // (its dependents that got ready are kept by this worker)
+    pthread_mutex_lock(&s->lock);
+    s->num_running--;
+    if (!ok) {
+      fprintf(stderr, "ptu-prov: re-run of proc %d failed, later steps not run\n",
+              (int)provindex_proc(s->idx, s->plan->steps[step].proc)->pid);
+      s->failed = true;
+    } else {
+      for (uint32_t i = s->first_dependent[step]; i < s->first_dependent[step + 1]; i++) {
+        if (--s->num_blocking[s->dependents[i]] == 0) {
+          push_step(s, &s->deques[id], s->dependents[i]);
+          s->num_ready++;
+        }
+      }
+    }
+    pthread_cond_broadcast(&s->cond);
+    pthread_mutex_unlock(&s->lock);
+  }
+}
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+int provplan_parse_args (const char* args, char*** argv) {
+  const char* s = args;
+  if (*s++ != '[') {
+    return -1;
+  }
+  int argc = 0;
+  int cap = 8;
+  char** v = (char**)malloc(cap * sizeof(char*));
+
+  while (*s != ']') {
+    // (an abbreviated list ends in "...", an unreadable arg is an address)
+    if (argc > 0) {
+      if (s[0] != ',' || s[1] != ' ') {
+        goto bad;
+      }
+      s += 2;
+    }
+    if (*s++ != '"') {
+      goto bad;
+    }
+    char* arg = (char*)malloc(strlen(s) + 1);
+    size_t len = 0;
+    while (*s != '"') {
+      if (*s == '\0') {
+        free(arg);
+        goto bad;
+      }
+      if (*s == '\\' && s[1] != '\0') {
+        s++;
+        arg[len++] = unescape(&s);
+      } else {
+        arg[len++] = *s++;
+      }
+    }
+    s++;
+    arg[len] = '\0';
+    if (argc + 1 >= cap) {
+      cap *= 2;
+      v = (char**)realloc(v, cap * sizeof(char*));
+    }
+    v[argc++] = arg;
+    // (an abbreviated arg is followed by "...")
+    if (strncmp(s, "...", 3) == 0) {
+      goto bad;
+    }
+  }
+  if (s[1] != '\0') {
+    goto bad;
+  }
+  v[argc] = NULL;
+  *argv = v;
+  return argc;
+
+bad:
+  for (int i = 0; i < argc; i++) {
+    free(v[i]);
+  }
+  free(v);
+  return -1;
+}
+
+int provplan_save_fingerprints (const ProvIndex* idx, const char* package_dir) {
+  char* root = package_path(package_dir, "cde-root", "");
+  char* fn = package_path(package_dir, PROVPLAN_FINGERPRINTS, "");
+  struct stat root_stat;
+  if (stat(root, &root_stat) != 0) {
+    fprintf(stderr, "ptu-prov: no cde-root in %s\n", package_dir);
+    free(root);
+    free(fn);
+    return -1;
+  }
+
+  // (files whose stat did not change keep their saved hash)
+  StrMap* saved = manifest_load(fn, &root_stat);
+  StrMap* fingerprints = strmap_new();
+  for (uint32_t path = 0; path < provindex_num_paths(idx); path++) {
+    const char* name = provindex_path(idx, path);
+    if (name[0] != '/' || !is_input(idx, path)) {
+      continue;
+    }
+    char* file = package_path(package_dir, "cde-root", name);
+    struct stat st;
+    if (stat(file, &st) == 0 && S_ISREG(st.st_mode)) {
+      const ManifestEntry* prev = (const ManifestEntry*)strmap_get(saved, name);
+      ManifestEntry* entry = (ManifestEntry*)malloc(sizeof(ManifestEntry));
+      manifest_entry_set_stat(entry, &st);
+      if (prev && prev->has_hash && manifest_entry_matches(prev, &st)) {
+        entry->hash = prev->hash;
+        entry->has_hash = true;
+      } else {
+        entry->has_hash = (hash_file_contents(file, &entry->hash) == 0);
+      }
+      strmap_put(fingerprints, name, entry);
+    }
+    free(file);
+  }
+
+  const int rc = manifest_save(fingerprints, fn, &root_stat);
+  if (rc != 0) {
+    fprintf(stderr, "ptu-prov: cannot write %s: %s\n", fn, strerror(errno));
+  }
+  manifest_free(saved);
+  manifest_free(fingerprints);
+  free(root);
+  free(fn);
+  return rc;
+}
+
+long provplan_mark_changed (const ProvIndex* idx, const char* package_dir, bool* path_marks) {
+  char* root = package_path(package_dir, "cde-root", "");
+  char* fn = package_path(package_dir, PROVPLAN_FINGERPRINTS, "");
+  struct stat root_stat;
+  struct stat fn_stat;
+  const bool have = (stat(root, &root_stat) == 0 && stat(fn, &fn_stat) == 0);
+  free(root);
+  if (!have) {
+    free(fn);
+    return -1;
+  }
+
+  // (fingerprints of another cde-root load as none, so every file changed)
+  StrMap* saved = manifest_load(fn, &root_stat);
+  long num_changed = 0;
+  for (uint32_t path = 0; path < provindex_num_paths(idx); path++) {
+    const char* name = provindex_path(idx, path);
+    if (name[0] != '/' || !is_input(idx, path)) {
+      continue;
+    }
+    char* file = package_path(package_dir, "cde-root", name);
+    struct stat st;
+    const bool exists = (stat(file, &st) == 0 && S_ISREG(st.st_mode));
+    const ManifestEntry* entry = (const ManifestEntry*)strmap_get(saved, name);
+    bool changed;
+    if (!entry || !exists) {
+      changed = (entry != NULL) || exists;
+    } else if (manifest_entry_matches(entry, &st)) {
+      changed = false;
+    } else {
+      uint64_t hash;
+      changed = !entry->has_hash || hash_file_contents(file, &hash) != 0 || hash != entry->hash;
+    }
+    if (changed) {
+      path_marks[path] = true;
+      num_changed++;
+    }
+    free(file);
+  }
+
+  manifest_free(saved);
+  free(fn);
+  return num_changed;
+}
+
+ProvPlan* provplan_new (const ProvIndex* idx, const bool* changed_paths, unsigned flags) {
+  const uint32_t num_procs = provindex_num_procs(idx);
+  const uint32_t num_paths = provindex_num_paths(idx);
+  bool* proc_marks = (bool*)calloc(num_procs + 1, sizeof(bool));
+  bool* path_marks = (bool*)malloc((num_paths + 1) * sizeof(bool));
+  memcpy(path_marks, changed_paths, num_paths * sizeof(bool));
+  provindex_descendants(idx, proc_marks, path_marks);
+
+  // each affected proc is re-run by itself or its nearest ancestor that can be
+  bool* is_unit = (bool*)calloc(num_procs + 1, sizeof(bool));
+  bool ok = true;
+  for (uint32_t i = 0; i < num_procs && ok; i++) {
+    if (proc_marks[i]) {
+      uint32_t u = i;
+      while (u != PROVIDX_NONE && !is_unit[u] && !can_rerun(idx, u, flags)) {
+        u = provindex_proc(idx, u)->parent;
+      }
+      if (u == PROVIDX_NONE) {
+        fprintf(stderr, "ptu-prov: cannot re-run proc %d (no complete command of it or its "
+                        "parents in the provenance log)\n", (int)provindex_proc(idx, i)->pid);
+        ok = false;
+      } else {
+        is_unit[u] = true;
+      }
+    }
+  }
+  free(proc_marks);
+  free(path_marks);
+  ProvPlan* plan = ok ? plan_of_units(idx, is_unit) : NULL;
+  free(is_unit);
+  return plan;
+}
+
+ProvPlan* provplan_new_replay (const ProvIndex* idx, unsigned flags) {
+  const uint32_t num_procs = provindex_num_procs(idx);
+  uint8_t* how = (uint8_t*)malloc(num_procs + 1);
+  uint32_t* num_units = (uint32_t*)calloc(num_procs + 1, sizeof(uint32_t));
+
+  // bottom-up (children have a larger index than their parent): split a proc
+  // that wrote no files itself (and did not redirect what its children
+  // inherit) into its children if that gives more than one unit to run at
+  // once, or if it cannot be re-run
+  for (uint32_t i = num_procs; i-- > 0; ) {
+    bool kids_ok = true;
+    bool kids_empty = true;
+    uint32_t kid_units = 0;
+    for (uint32_t c = provindex_first_child(idx, i); c != PROVIDX_NONE;
+         c = provindex_next_sibling(idx, c)) {
+      kids_ok = kids_ok && (how[c] != REPLAY_NONE);
+      kids_empty = kids_empty && (how[c] == REPLAY_EMPTY);
+      kid_units += num_units[c];
+    }
+    const bool writes = writes_files(idx, i);
+    const bool rerun = can_rerun(idx, i, flags);
+    const bool split = !writes && kids_ok && !has_io_before_exec(idx, i);
+    if (!writes && kids_empty && (provindex_proc(idx, i)->parent != PROVIDX_NONE || !rerun)) {
+      how[i] = REPLAY_EMPTY;
+    } else if (split && !kids_empty && (kid_units > 1 || !rerun)) {
+      how[i] = REPLAY_SPLIT;
+      num_units[i] = kid_units;
+    } else if (rerun) {
+      how[i] = REPLAY_RERUN;
+      num_units[i] = 1;
+    } else {
+      how[i] = REPLAY_NONE;
+    }
+  }
+
+  // top-down: the units are the procs re-run within (split) roots
+  bool* is_unit = (bool*)calloc(num_procs + 1, sizeof(bool));
+  bool ok = true;
+  for (uint32_t i = 0; i < num_procs && ok; i++) {
+    const uint32_t parent = provindex_proc(idx, i)->parent;
+    if (parent == PROVIDX_NONE && how[i] == REPLAY_NONE) {
+      fprintf(stderr, "ptu-prov: cannot replay proc %d (no complete command of it, or of "
+                      "each of its children, in the provenance log)\n", (int)provindex_proc(idx, i)->pid);
+      ok = false;
+    }
+    if (parent != PROVIDX_NONE && how[parent] != REPLAY_SPLIT) {
+      how[i] = REPLAY_EMPTY;
+    }
+    is_unit[i] = (how[i] == REPLAY_RERUN);
+  }
+  free(num_units);
+  free(how);
+  ProvPlan* plan = ok ? plan_of_units(idx, is_unit) : NULL;
+  free(is_unit);
+  return plan;
+}
+
+void provplan_free (ProvPlan* plan) {
+  if (plan) {
+    for (uint32_t i = 0; i < plan->num_steps; i++) {
+      free(plan->steps[i].deps);
+    }
+    free(plan->steps);
+    free(plan);
+  }
+}
+
+pid_t provplan_start_step (const ProvIndex* idx, const ProvPlan* plan, uint32_t step,
+                           const char* package_dir) {
+  const uint32_t proc = plan->steps[step].proc;
+  const char* exe;
+  const char* cwd;
+  const char* cmd_args;
+  char** args;
+  const int argc = provindex_proc_cmd(idx, proc, &exe, &cwd, &cmd_args) ?
+                   provplan_parse_args(cmd_args, &args) : -1;
+  char* package = realpath(package_dir, NULL);
+  if (argc < 0 || !package) {
+    fprintf(stderr, "ptu-prov: cannot re-run proc %d\n", (int)provindex_proc(idx, proc)->pid);
+    if (argc >= 0) {
+      for (int i = 0; i < argc; i++) {
+        free(args[i]);
+      }
+      free(args);
+    }
+    free(package);
+    return -1;
+  }
+
+  // cde-exec <program> <args after argv[0]>, from cwd within cde-root
+  char** argv = (char**)malloc((argc + 3) * sizeof(char*));
+  argv[0] = package_path(package, "cde-exec", "");
+  argv[1] = (char*)exe;
+  for (int i = 1; i < argc; i++) {
+    argv[i + 1] = args[i];
+  }
+  argv[(argc > 0) ? (argc + 1) : 2] = NULL;
+  char* dir = package_path(package, "cde-root", cwd);
+
+  // (the child does not use stdio: in a parallel run, another thread may
+  // hold its lock)
+  const pid_t pid = fork();
+  if (pid == 0) {
+    const int null_fd = open("/dev/null", O_RDONLY);
+    if (null_fd > 0) {
+      dup2(null_fd, STDIN_FILENO);
+      close(null_fd);
+    }
+    const bool entered = (chdir(dir) == 0);
+    if (entered) {
+      execv(argv[0], argv);
+    }
+    char msg[PATH_MAX + 64];
+    snprintf(msg, sizeof(msg), "ptu-prov: cannot %s %s: %s\n", entered ? "run" : "enter",
+             entered ? argv[0] : dir, strerror(errno));
+    if (write(STDERR_FILENO, msg, strlen(msg)) < 0) {
+      _exit(127);
+    }
+    _exit(127);
+  } else if (pid < 0) {
+    perror("ptu-prov: fork");
+  }
+
+  for (int i = 0; i < argc; i++) {
+    free(args[i]);
+  }
+  free(args);
+  free(argv[0]);
+  free(argv);
+  free(dir);
+  free(package);
+  return pid;
+}
+
+int provplan_run (const ProvIndex* idx, const ProvPlan* plan, const char* package_dir) {
+  for (uint32_t i = 0; i < plan->num_steps; i++) {
+    const ProvProc* p = provindex_proc(idx, plan->steps[i].proc);
+    print_step(idx, plan, i, i + 1);
+    const pid_t pid = provplan_start_step(idx, plan, i, package_dir);
+    int status;
+    if (pid < 0 || waitpid(pid, &status, 0) != pid ||
+        !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      fprintf(stderr, "ptu-prov: re-run of proc %d failed, later steps not run\n", (int)p->pid);
+      return -1;
+    }
+  }
+  return 0;
+}
+
+int provplan_run_parallel (const ProvIndex* idx, const ProvPlan* plan, const char* package_dir,
+                           uint32_t num_workers) {
+  const uint32_t num_steps = plan->num_steps;
+  if (num_workers > num_steps) {
+    num_workers = num_steps;
+  }
+  if (num_workers == 0) {
+    return 0;
+  }
+  Scheduler s;
+  memset(&s, 0, sizeof(s));
+  s.idx = idx;
+  s.plan = plan;
+  s.package_dir = package_dir;
+  s.num_workers = num_workers;
+  pthread_mutex_init(&s.lock, NULL);
+  pthread_cond_init(&s.cond, NULL);
+
+  // dependents of each step (deps are by position in plan, all before it)
+  s.num_blocking = (uint32_t*)calloc(num_steps + 1, sizeof(uint32_t));
+  s.first_dependent = (uint32_t*)calloc(num_steps + 2, sizeof(uint32_t));
+  uint32_t num_deps = 0;
+  for (uint32_t i = 0; i < num_steps; i++) {
+    s.num_blocking[i] = plan->steps[i].num_deps;
+    num_deps += plan->steps[i].num_deps;
+    for (uint32_t d = 0; d < plan->steps[i].num_deps; d++) {
+      s.first_dependent[plan->steps[i].deps[d] + 1]++;
+    }
+  }
+  for (uint32_t i = 0; i < num_steps; i++) {
+    s.first_dependent[i + 1] += s.first_dependent[i];
+  }
+  s.dependents = (uint32_t*)malloc((num_deps + 1) * sizeof(uint32_t));
+  uint32_t* fill = (uint32_t*)malloc((num_steps + 1) * sizeof(uint32_t));
+  memcpy(fill, s.first_dependent, num_steps * sizeof(uint32_t));
+  for (uint32_t i = 0; i < num_steps; i++) {
+    for (uint32_t d = 0; d < plan->steps[i].num_deps; d++) {
+      s.dependents[fill[plan->steps[i].deps[d]]++] = i;
+    }
+  }
+  free(fill);
+
+  // steps ready at the start are dealt out to the workers' deques
+  s.deques = (StepDeque*)calloc(num_workers, sizeof(StepDeque));
+  for (uint32_t w = 0; w < num_workers; w++) {
+    pthread_mutex_init(&s.deques[w].lock, NULL);
+    s.deques[w].steps = (uint32_t*)malloc(num_steps * sizeof(uint32_t));
+  }
+  for (uint32_t i = 0; i < num_steps; i++) {
+    if (s.num_blocking[i] == 0) {
+      push_step(&s, &s.deques[s.num_ready++ % num_workers], i);
+    }
+  }
+
+  Worker* workers = (Worker*)malloc(num_workers * sizeof(Worker));
+  pthread_t* threads = (pthread_t*)malloc(num_workers * sizeof(pthread_t));
+  uint32_t num_threads = 0;
+  for (uint32_t w = 0; w < num_workers; w++) {
+    workers[w].sched = &s;
+    workers[w].id = w;
+    if (pthread_create(&threads[w], NULL, run_worker, &workers[w]) != 0) {
+      break;
+    }
+    num_threads++;
+  }
+  if (num_threads == 0) {
+    fprintf(stderr, "ptu-prov: cannot start workers\n");
+    s.failed = true;
+  }
+  for (uint32_t w = 0; w < num_threads; w++) {
+    pthread_join(threads[w], NULL);
+  }
+  const bool ok = !s.failed && s.num_started == num_steps;
+
+  for (uint32_t w = 0; w < num_workers; w++) {
+    pthread_mutex_destroy(&s.deques[w].lock);
+    free(s.deques[w].steps);
+  }
+  free(s.deques);
+  free(threads);
+  free(workers);
+  free(s.dependents);
+  free(s.first_dependent);
+  free(s.num_blocking);
+  pthread_cond_destroy(&s.cond);
+  pthread_mutex_destroy(&s.lock);
+  return ok ? 0 : -1;
+}
@@ -0,0 +1,136 @@
+/*******************************************************************************
+module:   provplan
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  plan and run an incremental re-execution of a captured app: from a
+          provenance index and the fingerprints of the files its procs read,
+          re-run (inside the cde-package) only the procs whose inputs changed,
+          and the procs downstream of them, in dependency order; or replay
+          the whole app as independent subtrees, run at once on many cores
+notes:    - a proc is re-run by the command of its first exec (its cwd, program
+            and args, as logged), which also re-runs its children
+          - a proc is re-run by its nearest ancestor that can be if it did not
+            exec, if its args were abbreviated in the log, or if its stdin/
+            stdout may not be what its parent had: it accessed files before
+            its exec (a shell's "<" or ">"), or ran alongside a sibling (a
+            pipeline).  pipes are not in the log, so the output of a proc
+            read by its parent (a shell's "$(...)") is not known to be needed
+          - outputs of procs that are not re-run are reused as they are in
+            cde-root
+          - a replay re-runs the subtree of a proc that wrote no files itself
+            by replaying the subtrees of its children (as logged: args a
+            shell got from a pipe are not re-computed), so that independent
+            ones (e.g., the compiles a make runs) can run at once; subtrees
+            that wrote no files are not replayed
+          - steps are ordered by the files they share (a step runs after
+            those that wrote files it reads, and those that read or wrote
+            files it writes, in the original run); effects not in the log
+            (e.g., dirs made, files deleted) do not order steps.  each step
+            runs under its own cde-exec
+          - fingerprints are kept in a capture manifest (see manifest.h) of
+            the files read by any proc, so unchanged files are not re-hashed
+*******************************************************************************/
+
+#ifndef PROVPLAN_H
+#define PROVPLAN_H 1
+
+// allow this header to be included from c++ source file
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*******************************************************************************
+ * SYSTEM INCLUDES
+ ******************************************************************************/
+
+#include <stdbool.h>    // ISOC: bool
+#include <stdint.h>     // ISOC: uint32_t
+#include <sys/types.h>  // P2001: pid_t
+
+/*******************************************************************************
+ * USER INCLUDES
+ ******************************************************************************/
+
+#include "provindex.h"  // ProvIndex
+
+/*******************************************************************************
+ * PUBLIC TYPES / CONSTANTS / VARIABLES
+ ******************************************************************************/
+
+// name of the fingerprints file in a cde-package
+#define PROVPLAN_FINGERPRINTS "cde.fingerprints"
+
+// flags of a plan
+enum {
+  PROVPLAN_NO_PIPES = 1     // procs that ran alongside each other were not
+                            // connected by pipes (as under make -j or
+                            // xargs -P), so each can be re-run by itself
+};
+
+// one step of a plan: re-run the command of proc (and so its children)
+typedef struct {
+  uint32_t proc;
+  uint32_t num_deps;
+  uint32_t* deps;           // steps (all before this one) it must run after
+} ProvPlanStep;
+
+// steps to re-run, in dependency order (the order of the original run)
+typedef struct {
+  ProvPlanStep* steps;
+  uint32_t num_steps;
+} ProvPlan;
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+// parse args as logged (e.g. ["sh", "-c", "a \"b\""]) into a NULL-terminated
+// argv (caller frees each arg and argv), return argc, or -1 if args are
+// malformed or were abbreviated in the log (so the command cannot be re-run)
+int provplan_parse_args (const char* args, char*** argv);
+
+// save fingerprints of the files read by the procs of idx (as found under
+// package_dir/cde-root) to package_dir/PROVPLAN_FINGERPRINTS
+// return 0 on success, -1 on error (reason printed to stderr)
+int provplan_save_fingerprints (const ProvIndex* idx, const char* package_dir);
+
+// mark (in path_marks[num_paths]) the files read by procs of idx whose
+// contents under package_dir/cde-root changed since their fingerprints were
+// saved (or that were created or deleted since)
+// return num of files marked, or -1 if there are no saved fingerprints
+long provplan_mark_changed (const ProvIndex* idx, const char* package_dir, bool* path_marks);
+
+// return the plan to bring the outputs of idx up to date with the changed
+// files marked in changed_paths[num_paths] (an empty plan if nothing is
+// affected), or NULL if an affected proc cannot be re-run
+ProvPlan* provplan_new (const ProvIndex* idx, const bool* changed_paths, unsigned flags);
+
+// return the plan to replay all of idx, split into independent subtrees, or
+// NULL if some root proc cannot be replayed
+ProvPlan* provplan_new_replay (const ProvIndex* idx, unsigned flags);
+void provplan_free (ProvPlan* plan);
+
+// start step of plan inside the cde-package at package_dir (its command run
+// by package_dir/cde-exec from its cwd in cde-root, with stdin from
+// /dev/null), return pid of the started proc, or -1 on error
+pid_t provplan_start_step (const ProvIndex* idx, const ProvPlan* plan, uint32_t step,
+                           const char* package_dir);
+
+// run the steps of plan one by one, stop at the first that fails
+// return 0 if all steps exited with status 0, else -1
+int provplan_run (const ProvIndex* idx, const ProvPlan* plan, const char* package_dir);
+
+// run the steps of plan on num_workers threads (each waiting for one step at
+// a time), a step once the steps it depends on exited with status 0: each
+// worker takes the newest step it made ready, or steals the oldest from
+// another; stop starting steps at the first that fails
+// return 0 if all steps exited with status 0, else -1
+int provplan_run_parallel (const ProvIndex* idx, const ProvPlan* plan, const char* package_dir,
+                           uint32_t num_workers);
+
+// allow this header to be included from c++ source file
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PROVPLAN_H
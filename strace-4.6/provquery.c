@@ -0,0 +1,581 @@
+/*******************************************************************************
+module:   provquery
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  command-line front end of provindex (run when ptu is invoked as
+          "ptu-prov"): index a provenance log, query the lineage of files and
+          procs, export the provenance graph as DOT or PROV-JSON, merge the
+          logs of nested audits, re-run only the procs whose inputs
+          changed, replay the app on many cores, trim a package down to
+          the files the app accessed, and ship a re-captured package as a
+          delta against the old one
+*******************************************************************************/
+
+/*******************************************************************************
+ * SYSTEM INCLUDES
+ ******************************************************************************/
+
+#include <errno.h>      // ISOC: errno
+#include <inttypes.h>   // ISOC: PRIu64
+#include <stdbool.h>    // ISOC: bool
+#include <stdlib.h>     // ISOC: calloc(), free(), strtol()
+#include <string.h>     // ISOC: strcmp(), strlen()
+#include <time.h>       // ISOC: time_t, gmtime_r(), strftime()
+#include <unistd.h>     // P2001: sysconf()
+
+/*******************************************************************************
+ * USER INCLUDES
+ ******************************************************************************/
+
+#include "provquery.h"
+#include "provindex.h"  // ProvIndex, provindex_open(), provindex_ancestors(), ...
+#include "provmerge.h"  // provmerge_logs()
+#include "provplan.h"   // ProvPlan, provplan_new(), provplan_run(), ...
+#include "pkgtrim.h"    // PkgTrimOptions, PkgTrimReport, pkgtrim_package(), ...
+#include "pkgdelta.h"   // PkgDeltaReport, pkgdelta_export(), pkgdelta_apply()
+#include "strutils.h"   // str_print_json()
+
+/*******************************************************************************
+ * PRIVATE TYPES / CONSTANTS / VARIABLES
+ ******************************************************************************/
+
+// max -j jobs (more threads or workers than this only thrash)
+#define MAX_JOBS 1024
+
+// called once per (proc, path) edge of a kind, with the num of the edge
+typedef void (*EdgeFunc) (const ProvIndex* idx, FILE* f, uint32_t proc, uint32_t path, uint64_t num);
+
+/*******************************************************************************
+ * PRIVATE MACROS / FUNCTIONS
+ ******************************************************************************/
+
+static int usage (void) {
+  fprintf(stderr,
+          "usage: ptu-prov index <provlog> [<index>]    (default index: <provlog>.idx)\n"
+          "       ptu-prov merge <merged provlog> <provlog>...    (\"-\" writes to stdout)\n"
+          "       ptu-prov ancestors <index> <path|pid>...\n"
+          "       ptu-prov descendants <index> <path|pid>...\n"
+          "       ptu-prov closure <index> <pid>...\n"
+          "       ptu-prov dot <index>\n"
+          "       ptu-prov provjson <index>\n"
+          "       ptu-prov fingerprint <index> <cde-package>\n"
+          "       ptu-prov plan [-a] [-c] <index> <cde-package> [<changed path>...]\n"
+          "       ptu-prov rerun [-a] [-c] [-j <jobs>] <index> <cde-package> [<changed path>...]\n"
+          "         -a  replay all of the app (as independent subtrees), not what changed\n"
+          "         -c  procs that ran at once were not connected by pipes (make -j)\n"
+          "         -j  re-run up to <jobs> procs at once (0: one per core; default 1; max 1024)\n"
+          "       ptu-prov trim [-n] [-m <policy>] [-u <policy>] <index> <cde-package>\n"
+          "         -n  only list what would be trimmed\n"
+          "         -m  keep|stub|prune files only stat-ed, not opened (default stub)\n"
+          "         -u  keep|stub|prune files not touched by the audit (default prune)\n"
+          "       ptu-prov delta [-j <jobs>] <old cde-package> <new cde-package> <patch>\n"
+          "         -j  hash files on <jobs> threads (0: one per core, the default; max 1024)\n"
+          "       ptu-prov apply <old cde-package> <patch> <new cde-package>\n"
+          "         (\"-\" patch writes to stdout / reads from stdin)\n");
+  return 2;
+}
+
+// return the num of cores online (1 to MAX_JOBS)
+static uint32_t num_cores (void) {
+  const long n = sysconf(_SC_NPROCESSORS_ONLN);
+  return (n < 1) ? 1 : (n > MAX_JOBS) ? MAX_JOBS : (uint32_t)n;
+}
+
+// parse the <jobs> of -j (0: one per core), return false if it is not 0 to
+// MAX_JOBS
+static bool parse_jobs (const char* s, uint32_t* num_jobs) {
+  char* end;
+  errno = 0;
+  const long n = strtol(s, &end, 10);
+  if (errno != 0 || end == s || *end != '\0' || n < 0 || n > MAX_JOBS) {
+    return false;
+  }
+  *num_jobs = (n == 0) ? num_cores() : (uint32_t)n;
+  return true;
+}
+
+static ProvIndex* open_index (const char* index_path) {
+  ProvIndex* idx = provindex_open(index_path);
+  if (!idx) {
+    fprintf(stderr, "ptu-prov: %s is not a provenance index (see 'ptu-prov index')\n", index_path);
+  }
+  return idx;
+}
+
+// mark the node named by arg: a path if it starts with '/', else a pid (all
+// procs of it); return 0 on success, -1 if no such node
+static int mark_node (const ProvIndex* idx, const char* arg, bool paths_ok,
+                      bool* proc_marks, bool* path_marks) {
+  if (arg[0] == '/' && paths_ok) {
+    const uint32_t path = provindex_find_path(idx, arg);
+    if (path == PROVIDX_NONE) {
+      fprintf(stderr, "ptu-prov: no file %s in index\n", arg);
+      return -1;
+    }
+    path_marks[path] = true;
+    return 0;
+  }
+
+  char* end;
+  const long pid = strtol(arg, &end, 10);
+  bool found = false;
+  if (end != arg && *end == '\0') {
+    for (uint32_t i = 0; i < provindex_num_procs(idx); i++) {
+      if (provindex_proc(idx, i)->pid == pid) {
+        proc_marks[i] = true;
+        found = true;
+      }
+    }
+  }
+  if (!found) {
+    fprintf(stderr, "ptu-prov: no %s %s in index\n", paths_ok ? "file or pid" : "pid", arg);
+    return -1;
+  }
+  return 0;
+}
+
+// print marked procs ("proc <pid> <program>") then marked files ("file <path>")
+static void print_marked (const ProvIndex* idx, const bool* proc_marks, const bool* path_marks) {
+  for (uint32_t i = 0; i < provindex_num_procs(idx); i++) {
+    if (proc_marks[i]) {
+      const ProvProc* p = provindex_proc(idx, i);
+      const char* exe = provindex_path(idx, p->exe);
+      printf("proc %d %s\n", (int)p->pid, exe ? exe : "-");
+    }
+  }
+  for (uint32_t i = 0; i < provindex_num_paths(idx); i++) {
+    if (path_marks[i]) {
+      printf("file %s\n", provindex_path(idx, i));
+    }
+  }
+}
+
+// run ancestors/descendants/closure query of args on index
+static int run_query (const char* query, const char* index_path, int num_args, char** args) {
+  ProvIndex* idx = open_index(index_path);
+  if (!idx) {
+    return 1;
+  }
+  bool* proc_marks = (bool*)calloc(provindex_num_procs(idx) + 1, sizeof(bool));
+  bool* path_marks = (bool*)calloc(provindex_num_paths(idx) + 1, sizeof(bool));
+  const bool is_closure = (strcmp(query, "closure") == 0);
+
+  int rc = 0;
+  for (int i = 0; i < num_args && rc == 0; i++) {
+    rc = mark_node(idx, args[i], !is_closure, proc_marks, path_marks);
+  }
+  if (rc == 0) {
+    if (is_closure) {
+      provindex_closure(idx, proc_marks, path_marks);
+    } else if (strcmp(query, "ancestors") == 0) {
+      provindex_ancestors(idx, proc_marks, path_marks);
+    } else {
+      provindex_descendants(idx, proc_marks, path_marks);
+    }
+    print_marked(idx, proc_marks, path_marks);
+  }
+
+  free(proc_marks);
+  free(path_marks);
+  provindex_close(idx);
+  return (rc == 0) ? 0 : 1;
+}
+
+// trim package as opts says by the accesses of index, list each captured file
+// to stdout, and summarize what was trimmed to stderr
+static int run_trim (const PkgTrimOptions* opts, const char* index_path, const char* package_dir) {
+  ProvIndex* idx = open_index(index_path);
+  if (!idx) {
+    return 1;
+  }
+  PkgTrimReport report;
+  const int rc = (pkgtrim_package(idx, package_dir, opts, stdout, &report) == 0) ? 0 : 1;
+  if (rc == 0) {
+    for (int c = 0; c < PKGTRIM_NUM_CLASSES; c++) {
+      fprintf(stderr, "ptu-prov: %-8s %6" PRIu64 " files %12" PRIu64 " bytes\n",
+              pkgtrim_class_name((PkgTrimClass)c), report.num_files[c], report.bytes[c]);
+    }
+    fprintf(stderr, "ptu-prov: %s %" PRIu64 " files, pruned %" PRIu64 " files and %" PRIu64
+                    " dirs, saving %" PRIu64 " bytes\n", opts->dry_run ? "would stub" : "stubbed",
+            report.num_stubbed, report.num_pruned, report.num_dirs_pruned, report.bytes_saved);
+  }
+  provindex_close(idx);
+  return rc;
+}
+
+// write patch of package new_dir against package old_dir (hashing on
+// num_jobs threads), and summarize it to stderr
+static int run_delta (uint32_t num_jobs, const char* old_dir, const char* new_dir,
+                      const char* patch_path) {
+  FILE* patch = (strcmp(patch_path, "-") == 0) ? stdout : fopen(patch_path, "w");
+  if (!patch) {
+    fprintf(stderr, "ptu-prov: cannot write %s\n", patch_path);
+    return 1;
+  }
+  PkgDeltaReport report;
+  int rc = (pkgdelta_export(old_dir, new_dir, num_jobs, patch, &report) == 0) ? 0 : 1;
+  if (patch != stdout && fclose(patch) != 0) {
+    fprintf(stderr, "ptu-prov: cannot write %s\n", patch_path);
+    rc = 1;
+  }
+  if (rc == 0) {
+    fprintf(stderr, "ptu-prov: %" PRIu64 " files same, %" PRIu64 " moved, %" PRIu64 " patched, %"
+                    PRIu64 " sent whole\n", report.num_same, report.num_moved, report.num_patched,
+            report.num_literal);
+    fprintf(stderr, "ptu-prov: %" PRIu64 " of %" PRIu64 " bytes copied from %s, patch is %" PRIu64
+                    " bytes\n", report.bytes_copied, report.bytes_new, old_dir, report.bytes_patch);
+  }
+  return rc;
+}
+
+// plan (and if rerun, run on num_jobs workers) re-execution of the procs of
+// index affected by the changed paths, and by the files of package whose
+// fingerprints changed (or if all, replay of all of index)
+static int run_plan (bool rerun, bool all, unsigned flags, uint32_t num_jobs,
+                     const char* index_path, const char* package_dir, int num_args, char** args) {
+  ProvIndex* idx = open_index(index_path);
+  if (!idx) {
+    return 1;
+  }
+  bool* path_marks = (bool*)calloc(provindex_num_paths(idx) + 1, sizeof(bool));
+  int rc = 0;
+  for (int i = 0; i < num_args && rc == 0; i++) {
+    const uint32_t path = (args[i][0] == '/') ? provindex_find_path(idx, args[i]) : PROVIDX_NONE;
+    if (path == PROVIDX_NONE) {
+      fprintf(stderr, "ptu-prov: no file %s in index\n", args[i]);
+      rc = 1;
+    } else {
+      path_marks[path] = true;
+    }
+  }
+  const long num_changed = (rc == 0 && !all) ? provplan_mark_changed(idx, package_dir, path_marks) : 0;
+  if (num_changed < 0 && num_args == 0) {
+    fprintf(stderr, "ptu-prov: no fingerprints in %s (see 'ptu-prov fingerprint'), "
+                    "and no changed paths given\n", package_dir);
+    rc = 1;
+  }
+
+  ProvPlan* plan = NULL;
+  if (rc == 0) {
+    plan = all ? provplan_new_replay(idx, flags) : provplan_new(idx, path_marks, flags);
+  }
+  if (!plan) {
+    rc = 1;
+  } else if (!rerun) {
+    for (uint32_t i = 0; i < plan->num_steps; i++) {
+      const ProvProc* p = provindex_proc(idx, plan->steps[i].proc);
+      const char* program;
+      const char* cwd;
+      const char* cmd_args;
+      provindex_proc_cmd(idx, plan->steps[i].proc, &program, &cwd, &cmd_args);
+      printf("%u %d %s %s %s", i + 1, (int)p->pid, cwd, program, cmd_args);
+      for (uint32_t d = 0; d < plan->steps[i].num_deps; d++) {
+        printf("%s%u", (d == 0) ? " after " : ",", plan->steps[i].deps[d] + 1);
+      }
+      printf("\n");
+    }
+  } else {
+    if (all) {
+      fprintf(stderr, "ptu-prov: replaying %u procs on %u workers\n", plan->num_steps, num_jobs);
+    } else {
+      fprintf(stderr, "ptu-prov: %ld changed files, re-running %u procs\n",
+              (num_changed > 0) ? num_changed : 0, plan->num_steps);
+    }
+    if (num_jobs > 1) {
+      rc = (provplan_run_parallel(idx, plan, package_dir, num_jobs) == 0) ? 0 : 1;
+    } else {
+      rc = (provplan_run(idx, plan, package_dir) == 0) ? 0 : 1;
+    }
+    if (rc == 0) {
+      rc = (provplan_save_fingerprints(idx, package_dir) == 0) ? 0 : 1;
+    }
+  }
+
+  provplan_free(plan);
+  free(path_marks);
+  provindex_close(idx);
+  return rc;
+}
+
+// call edge_func once per distinct (proc, path) of events that write (or
+// read) path; return num of edges
+static uint64_t for_each_edge (const ProvIndex* idx, FILE* f, bool writes, EdgeFunc edge_func) {
+  // seen[path] == proc + 1 if the edge of proc to path was already passed on
+  uint32_t* seen = (uint32_t*)calloc(provindex_num_paths(idx) + 1, sizeof(uint32_t));
+  uint64_t num = 0;
+  for (uint32_t i = 0; i < provindex_num_procs(idx); i++) {
+    for (uint64_t e = provindex_proc(idx, i)->last_event; e != PROVIDX_NO_EVENT; ) {
+      const ProvEvent* ev = provindex_event(idx, e);
+      const bool matches = writes ? provindex_event_writes(ev) : provindex_event_reads(ev);
+      if (matches && seen[ev->path] != i + 1) {
+        seen[ev->path] = i + 1;
+        edge_func(idx, f, i, ev->path, num++);
+      }
+      e = ev->prev_of_proc;
+    }
+  }
+  free(seen);
+  return num;
+}
+
+// print s escaped for a quoted DOT string
+static void print_dot_chars (FILE* f, const char* s) {
+  for (; *s; s++) {
+    if (*s == '"' || *s == '\\') {
+      fputc('\\', f);
+    }
+    fputc(*s, f);
+  }
+}
+
+static void print_dot_read (const ProvIndex* idx, FILE* f, uint32_t proc, uint32_t path, uint64_t num) {
+  fprintf(f, "  f%u -> p%u;\n", path, proc);
+}
+
+static void print_dot_write (const ProvIndex* idx, FILE* f, uint32_t proc, uint32_t path, uint64_t num) {
+  fprintf(f, "  p%u -> f%u;\n", proc, path);
+}
+
+// print time t as a quoted xsd:dateTime (UTC)
+static void print_json_time (FILE* f, int32_t t) {
+  char buf[32];
+  struct tm tm;
+  const time_t tt = t;
+  gmtime_r(&tt, &tm);
+  strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", &tm);
+  fprintf(f, "\"%s\"", buf);
+}
+
+static void print_json_used (const ProvIndex* idx, FILE* f, uint32_t proc, uint32_t path, uint64_t num) {
+  fprintf(f, "%s\n    \"ptu:u%" PRIu64 "\": {\"prov:activity\": \"ptu:p%u\", \"prov:entity\": \"ptu:f%u\"}",
+          (num == 0) ? "" : ",", num, proc, path);
+}
+
+static void print_json_generated (const ProvIndex* idx, FILE* f, uint32_t proc, uint32_t path, uint64_t num) {
+  fprintf(f, "%s\n    \"ptu:g%" PRIu64 "\": {\"prov:entity\": \"ptu:f%u\", \"prov:activity\": \"ptu:p%u\"}",
+          (num == 0) ? "" : ",", num, path, proc);
+}
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+void provquery_export_dot (const ProvIndex* idx, FILE* f) {
+  fprintf(f, "digraph provenance {\n");
+  for (uint32_t i = 0; i < provindex_num_procs(idx); i++) {
+    const ProvProc* p = provindex_proc(idx, i);
+    const char* exe = provindex_path(idx, p->exe);
+    fprintf(f, "  p%u [shape=box, label=\"%d ", i, (int)p->pid);
+    print_dot_chars(f, exe ? exe : "-");
+    fprintf(f, "\"];\n");
+  }
+  for (uint32_t i = 0; i < provindex_num_paths(idx); i++) {
+    fprintf(f, "  f%u [shape=ellipse, label=\"", i);
+    print_dot_chars(f, provindex_path(idx, i));
+    fprintf(f, "\"];\n");
+  }
+  for (uint32_t i = 0; i < provindex_num_procs(idx); i++) {
+    const uint32_t parent = provindex_proc(idx, i)->parent;
+    if (parent != PROVIDX_NONE) {
+      fprintf(f, "  p%u -> p%u [style=dashed];\n", parent, i);
+    }
+  }
+  for_each_edge(idx, f, false, print_dot_read);
+  for_each_edge(idx, f, true, print_dot_write);
+  fprintf(f, "}\n");
+}
+
+void provquery_export_provjson (const ProvIndex* idx, FILE* f) {
+  fprintf(f, "{\n  \"prefix\": {\"ptu\": \"urn:ptu:\"},\n  \"entity\": {");
+  for (uint32_t i = 0; i < provindex_num_paths(idx); i++) {
+    fprintf(f, "%s\n    \"ptu:f%u\": {\"prov:label\": ", (i == 0) ? "" : ",", i);
+    str_print_json(f, provindex_path(idx, i));
+    fprintf(f, "}");
+  }
+
+  fprintf(f, "\n  },\n  \"activity\": {");
+  for (uint32_t i = 0; i < provindex_num_procs(idx); i++) {
+    const ProvProc* p = provindex_proc(idx, i);
+    const char* exe = provindex_path(idx, p->exe);
+    fprintf(f, "%s\n    \"ptu:p%u\": {\"prov:label\": ", (i == 0) ? "" : ",", i);
+    str_print_json(f, exe ? exe : "-");
+    fprintf(f, ", \"ptu:pid\": %d, \"prov:startTime\": ", (int)p->pid);
+    print_json_time(f, p->start_time);
+    if (p->end_time != 0) {
+      fprintf(f, ", \"prov:endTime\": ");
+      print_json_time(f, p->end_time);
+    }
+    fprintf(f, ", \"ptu:peakRssKb\": %" PRIu64 ", \"ptu:utimeMs\": %" PRIu64
+               ", \"ptu:stimeMs\": %" PRIu64 "}",
+            p->peak_rss_kb, p->utime_ms, p->stime_ms);
+  }
+
+  fprintf(f, "\n  },\n  \"used\": {");
+  for_each_edge(idx, f, false, print_json_used);
+  fprintf(f, "\n  },\n  \"wasGeneratedBy\": {");
+  for_each_edge(idx, f, true, print_json_generated);
+
+  fprintf(f, "\n  },\n  \"wasInformedBy\": {");
+  uint64_t num = 0;
+  for (uint32_t i = 0; i < provindex_num_procs(idx); i++) {
+    const uint32_t parent = provindex_proc(idx, i)->parent;
+    if (parent != PROVIDX_NONE) {
+      fprintf(f, "%s\n    \"ptu:i%" PRIu64 "\": {\"prov:informed\": \"ptu:p%u\", \"prov:informant\": \"ptu:p%u\"}",
+              (num == 0) ? "" : ",", num, i, parent);
+      num++;
+    }
+  }
+  fprintf(f, "\n  }\n}\n");
+}
+
+int provquery_main (int argc, char** argv) {
+  if (argc < 3) {
+    return usage();
+  }
+  const char* cmd = argv[1];
+
+  if (strcmp(cmd, "index") == 0) {
+    if (argc > 4) {
+      return usage();
+    }
+    char* index_path = NULL;
+    if (argc == 4) {
+      index_path = strdup(argv[3]);
+    } else {
+      index_path = (char*)malloc(strlen(argv[2]) + sizeof(".idx"));
+      sprintf(index_path, "%s.idx", argv[2]);
+    }
+    int rc = provindex_build(argv[2], index_path) == 0 ? 0 : 1;
+    ProvIndex* idx = (rc == 0) ? open_index(index_path) : NULL;
+    if (idx) {
+      fprintf(stderr, "ptu-prov: indexed %" PRIu64 " events of %u procs on %u files into %s\n",
+              provindex_num_events(idx), provindex_num_procs(idx), provindex_num_paths(idx), index_path);
+      provindex_close(idx);
+    } else {
+      rc = 1;
+    }
+    free(index_path);
+    return rc;
+  } else if (strcmp(cmd, "merge") == 0) {
+    if (argc < 4) {
+      return usage();
+    }
+    FILE* out = (strcmp(argv[2], "-") == 0) ? stdout : fopen(argv[2], "w");
+    if (!out) {
+      fprintf(stderr, "ptu-prov: cannot write %s\n", argv[2]);
+      return 1;
+    }
+    int rc = provmerge_logs((const char* const*)(argv + 3), argc - 3, out) == 0 ? 0 : 1;
+    if (out != stdout && fclose(out) != 0) {
+      fprintf(stderr, "ptu-prov: cannot write %s\n", argv[2]);
+      rc = 1;
+    }
+    return rc;
+  } else if (strcmp(cmd, "ancestors") == 0 || strcmp(cmd, "descendants") == 0 ||
+             strcmp(cmd, "closure") == 0) {
+    if (argc < 4) {
+      return usage();
+    }
+    return run_query(cmd, argv[2], argc - 3, argv + 3);
+  } else if (strcmp(cmd, "dot") == 0 || strcmp(cmd, "provjson") == 0) {
+    if (argc != 3) {
+      return usage();
+    }
+    ProvIndex* idx = open_index(argv[2]);
+    if (!idx) {
+      return 1;
+    }
+    if (cmd[0] == 'd') {
+      provquery_export_dot(idx, stdout);
+    } else {
+      provquery_export_provjson(idx, stdout);
+    }
+    provindex_close(idx);
+    return 0;
+  } else if (strcmp(cmd, "fingerprint") == 0) {
+    if (argc != 4) {
+      return usage();
+    }
+    ProvIndex* idx = open_index(argv[2]);
+    if (!idx) {
+      return 1;
+    }
+    const int rc = (provplan_save_fingerprints(idx, argv[3]) == 0) ? 0 : 1;
+    provindex_close(idx);
+    return rc;
+  } else if (strcmp(cmd, "plan") == 0 || strcmp(cmd, "rerun") == 0) {
+    const bool rerun = (cmd[0] == 'r');
+    bool all = false;
+    unsigned flags = 0;
+    uint32_t num_jobs = 1;
+    int a = 2;
+    for (; a < argc && argv[a][0] == '-'; a++) {
+      if (strcmp(argv[a], "-a") == 0) {
+        all = true;
+      } else if (strcmp(argv[a], "-c") == 0) {
+        flags |= PROVPLAN_NO_PIPES;
+      } else if (strcmp(argv[a], "-j") == 0 && rerun && a + 1 < argc) {
+        if (!parse_jobs(argv[++a], &num_jobs)) {
+          return usage();
+        }
+      } else {
+        return usage();
+      }
+    }
+    if (argc - a < 2 || (all && argc - a > 2)) {
+      return usage();
+    }
+    return run_plan(rerun, all, flags, num_jobs,
+                    argv[a], argv[a + 1], argc - a - 2, argv + a + 2);
+  } else if (strcmp(cmd, "trim") == 0) {
+    PkgTrimOptions opts = { PKGTRIM_STUB, PKGTRIM_PRUNE, false };
+    int a = 2;
+    for (; a < argc && argv[a][0] == '-'; a++) {
+      if (strcmp(argv[a], "-n") == 0) {
+        opts.dry_run = true;
+      } else if (strcmp(argv[a], "-m") == 0 && a + 1 < argc) {
+        if (pkgtrim_parse_policy(argv[++a], &opts.metadata) != 0) {
+          return usage();
+        }
+      } else if (strcmp(argv[a], "-u") == 0 && a + 1 < argc) {
+        if (pkgtrim_parse_policy(argv[++a], &opts.unused) != 0) {
+          return usage();
+        }
+      } else {
+        return usage();
+      }
+    }
+    if (argc - a != 2) {
+      return usage();
+    }
+    return run_trim(&opts, argv[a], argv[a + 1]);
+  } else if (strcmp(cmd, "delta") == 0) {
+    uint32_t num_jobs = num_cores();
+    int a = 2;
+    if (a + 1 < argc && strcmp(argv[a], "-j") == 0) {
+      if (!parse_jobs(argv[a + 1], &num_jobs)) {
+        return usage();
+      }
+      a += 2;
+    }
+    if (argc - a != 3) {
+      return usage();
+    }
+    return run_delta(num_jobs, argv[a], argv[a + 1], argv[a + 2]);
+  } else if (strcmp(cmd, "apply") == 0) {
+    if (argc != 5) {
+      return usage();
+    }
+    FILE* patch = (strcmp(argv[3], "-") == 0) ? stdin : fopen(argv[3], "r");
+    if (!patch) {
+      fprintf(stderr, "ptu-prov: cannot read %s\n", argv[3]);
+      return 1;
+    }
+    const int rc = (pkgdelta_apply(argv[2], patch, argv[4]) == 0) ? 0 : 1;
+    if (patch != stdin) {
+      fclose(patch);
+    }
+    return rc;
+  }
+  return usage();
+}
@@ -0,0 +1,62 @@
+/*******************************************************************************
+module:   provquery
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  command-line front end of provindex (run when ptu is invoked as
+          "ptu-prov"): index a provenance log, query the lineage of files and
+          procs, export the provenance graph as DOT or PROV-JSON, merge the
+          logs of nested audits, re-run only the procs whose inputs
+          changed, replay the app on many cores, trim a package down to
+          the files the app accessed, and ship a re-captured package as a
+          delta against the old one
+usage:    ptu-prov index <provlog> [<index>]
+          ptu-prov merge <merged provlog> <provlog>...
+          ptu-prov ancestors|descendants <index> <path|pid>...
+          ptu-prov closure <index> <pid>...
+          ptu-prov dot|provjson <index>
+          ptu-prov fingerprint <index> <cde-package>
+          ptu-prov plan [-a] [-c] <index> <cde-package> [<changed path>...]
+          ptu-prov rerun [-a] [-c] [-j <jobs>] <index> <cde-package> [<changed path>...]
+          ptu-prov trim [-n] [-m keep|stub|prune] [-u keep|stub|prune] <index> <cde-package>
+          ptu-prov delta [-j <jobs>] <old cde-package> <new cde-package> <patch>
+          ptu-prov apply <old cde-package> <patch> <new cde-package>
+*******************************************************************************/
+
+#ifndef PROVQUERY_H
+#define PROVQUERY_H 1
+
+// allow this header to be included from c++ source file
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*******************************************************************************
+ * SYSTEM INCLUDES
+ ******************************************************************************/
+
+#include <stdio.h>      // ISOC: FILE
+
+/*******************************************************************************
+ * PUBLIC TYPES / CONSTANTS / VARIABLES
+ ******************************************************************************/
+
+struct ProvIndex;       // provindex.h
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+// run ptu-prov with argv (argv[1] is the subcommand), return exit status
+int provquery_main (int argc, char** argv);
+
+// stream the provenance graph of idx to f (procs/files as nodes, spawns,
+// reads/execs, and writes as edges, each edge once)
+void provquery_export_dot (const struct ProvIndex* idx, FILE* f);
+void provquery_export_provjson (const struct ProvIndex* idx, FILE* f);
+
+// allow this header to be included from c++ source file
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PROVQUERY_H
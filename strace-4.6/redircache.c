@@ -0,0 +1,185 @@
+/*******************************************************************************
+module:   redircache
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  bounded LRU cache of the path redirections cde-exec makes: maps a
+          path a traced proc passed to a syscall (with the cwd it resolves
+          against) to the path redirected into cde-root, or to a verdict that
+          it is not redirected
+*******************************************************************************/
+
+/*******************************************************************************
+ * SYSTEM INCLUDES
+ ******************************************************************************/
+
+#include <stdint.h>     // ISOC: uintptr_t
+#include <stdio.h>      // ISOC: snprintf()
+#include <stdlib.h>     // ISOC: malloc(), calloc(), realloc(), free()
+#include <string.h>     // ISOC: strdup(), strlen(), memcpy()
+
+/*******************************************************************************
+ * USER INCLUDES
+ ******************************************************************************/
+
+#include "redircache.h"
+#include "strmap.h"     // StrMap, strmap_new(), strmap_get(), strmap_put(), ...
+
+/*******************************************************************************
+ * PRIVATE TYPES / CONSTANTS / VARIABLES
+ ******************************************************************************/
+
+// one cached path, in the recency list (most recently used first)
+typedef struct RedirEntry {
+  char* key;
+  char* redirected;         // NULL if not redirected
+  struct RedirEntry* prev;
+  struct RedirEntry* next;
+} RedirEntry;
+
+struct RedirCache {
+  size_t capacity;
+  StrMap* entries;          // key -> RedirEntry
+  StrMap* cwd_ids;          // cwd -> its id (from 1)
+  size_t num_cwds;
+  RedirEntry* newest;
+  RedirEntry* oldest;
+  char* key_buf;            // key of the relative path being looked up
+  size_t key_buf_len;
+};
+
+/*******************************************************************************
+ * PRIVATE MACROS / FUNCTIONS
+ ******************************************************************************/
+
+// return key of path resolved against cwd (valid until the next call), or
+// NULL if path is relative and cwd has no id (unless add_cwd)
+static const char* make_key (RedirCache* cache, const char* cwd, const char* path, bool add_cwd) {
+  if (path[0] == '/') {
+    return path;
+  }
+  uintptr_t id = (uintptr_t)strmap_get(cache->cwd_ids, cwd);
+  if (id == 0) {
+    if (!add_cwd) {
+      return NULL;
+    }
+    // (cwd ids are only reset with the entries keyed by them)
+    if (cache->num_cwds >= cache->capacity) {
+      redircache_clear(cache);
+    }
+    id = ++cache->num_cwds;
+    strmap_put(cache->cwd_ids, cwd, (void*)id);
+  }
+
+  // "<cwd id>:<path>" (never starts with '/', as absolute paths do)
+  const size_t len = strlen(path) + 24;
+  if (len > cache->key_buf_len) {
+    cache->key_buf = (char*)realloc(cache->key_buf, len);
+    cache->key_buf_len = len;
+  }
+  snprintf(cache->key_buf, len, "%lu:%s", (unsigned long)id, path);
+  return cache->key_buf;
+}
+
+static void unlink_entry (RedirCache* cache, RedirEntry* e) {
+  if (e->prev) {
+    e->prev->next = e->next;
+  } else {
+    cache->newest = e->next;
+  }
+  if (e->next) {
+    e->next->prev = e->prev;
+  } else {
+    cache->oldest = e->prev;
+  }
+}
+
+static void push_newest (RedirCache* cache, RedirEntry* e) {
+  e->prev = NULL;
+  e->next = cache->newest;
+  if (cache->newest) {
+    cache->newest->prev = e;
+  } else {
+    cache->oldest = e;
+  }
+  cache->newest = e;
+}
+
+static void free_entry (RedirEntry* e) {
+  free(e->key);
+  free(e->redirected);
+  free(e);
+}
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+RedirCache* redircache_new (size_t capacity) {
+  RedirCache* cache = (RedirCache*)calloc(1, sizeof(RedirCache));
+  cache->capacity = (capacity > 0) ? capacity : 1;
+  cache->entries = strmap_new();
+  cache->cwd_ids = strmap_new();
+  return cache;
+}
+
+void redircache_free (RedirCache* cache) {
+  if (cache) {
+    redircache_clear(cache);
+    strmap_free(cache->entries, NULL);
+    strmap_free(cache->cwd_ids, NULL);
+    free(cache->key_buf);
+    free(cache);
+  }
+}
+
+bool redircache_get (RedirCache* cache, const char* cwd, const char* path, const char** redirected) {
+  const char* key = make_key(cache, cwd, path, false);
+  RedirEntry* e = key ? (RedirEntry*)strmap_get(cache->entries, key) : NULL;
+  if (!e) {
+    return false;
+  }
+  if (e != cache->newest) {
+    unlink_entry(cache, e);
+    push_newest(cache, e);
+  }
+  *redirected = e->redirected;
+  return true;
+}
+
+void redircache_put (RedirCache* cache, const char* cwd, const char* path, const char* redirected) {
+  const char* key = make_key(cache, cwd, path, true);
+  RedirEntry* e = (RedirEntry*)strmap_get(cache->entries, key);
+  if (e) {
+    free(e->redirected);
+    unlink_entry(cache, e);
+  } else {
+    if (strmap_size(cache->entries) >= cache->capacity) {
+      RedirEntry* oldest = cache->oldest;
+      unlink_entry(cache, oldest);
+      strmap_remove(cache->entries, oldest->key);
+      free_entry(oldest);
+    }
+    e = (RedirEntry*)malloc(sizeof(RedirEntry));
+    e->key = strdup(key);
+    strmap_put(cache->entries, e->key, e);
+  }
+  e->redirected = redirected ? strdup(redirected) : NULL;
+  push_newest(cache, e);
+}
+
+void redircache_clear (RedirCache* cache) {
+  while (cache->newest) {
+    RedirEntry* e = cache->newest;
+    cache->newest = e->next;
+    strmap_remove(cache->entries, e->key);
+    free_entry(e);
+  }
+  cache->oldest = NULL;
+  strmap_free(cache->cwd_ids, NULL);
+  cache->cwd_ids = strmap_new();
+  cache->num_cwds = 0;
+}
+
+size_t redircache_size (const RedirCache* cache) {
+  return strmap_size(cache->entries);
+}
@@ -0,0 +1,65 @@
+/*******************************************************************************
+module:   redircache
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  bounded LRU cache of the path redirections cde-exec makes: maps a
+          path a traced proc passed to a syscall (with the cwd it resolves
+          against) to the path redirected into cde-root, or to a verdict that
+          it is not redirected
+notes:    - an absolute path is keyed by itself (whatever the cwd), a relative
+            path by the id of its cwd (cwds are interned) and itself
+          - NOT threadsafe
+*******************************************************************************/
+
+#ifndef REDIRCACHE_H
+#define REDIRCACHE_H 1
+
+// allow this header to be included from c++ source file
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*******************************************************************************
+ * SYSTEM INCLUDES
+ ******************************************************************************/
+
+#include <stdbool.h>    // ISOC: bool
+#include <stddef.h>     // ISOC: size_t
+
+/*******************************************************************************
+ * PUBLIC TYPES / CONSTANTS / VARIABLES
+ ******************************************************************************/
+
+// opaque cache type
+typedef struct RedirCache RedirCache;
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+// return a new empty cache of up to capacity (> 0) paths
+RedirCache* redircache_new (size_t capacity);
+void redircache_free (RedirCache* cache);
+
+// return true if the redirection of path (resolved against cwd) is cached,
+// and set *redirected to it, or to NULL if path is not redirected (owned by
+// cache, valid until the next put or clear)
+bool redircache_get (RedirCache* cache, const char* cwd, const char* path, const char** redirected);
+
+// cache redirected (copied), or NULL if not redirected, as the redirection
+// of path (resolved against cwd), evicting the least recently used path if
+// the cache is full
+void redircache_put (RedirCache* cache, const char* cwd, const char* path, const char* redirected);
+
+// forget all cached redirections (e.g., after files they depend on changed)
+void redircache_clear (RedirCache* cache);
+
+// return num paths in cache
+size_t redircache_size (const RedirCache* cache);
+
+// allow this header to be included from c++ source file
+#ifdef __cplusplus
+}
+#endif
+
+#endif // REDIRCACHE_H
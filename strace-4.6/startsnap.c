@@ -0,0 +1,271 @@
+/*******************************************************************************
+module:   startsnap
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  startup snapshot: a file of named sections (e.g., parsed cde.options)
+          that cde-exec saves on its first run in a package, and mmaps on
+          later runs instead of redoing the work that made them
+notes:    - file layout: a header (magic, key, num sections), a table of
+            sections (name, offset, size), then the sections, each aligned
+            to 8 bytes
+*******************************************************************************/
+
+/*******************************************************************************
+ * SYSTEM INCLUDES
+ ******************************************************************************/
+
+#include <errno.h>      // ISOC: errno
+#include <fcntl.h>      // P2001: open(), O_RDONLY, O_WRONLY, O_CREAT, O_TRUNC
+#include <stdbool.h>    // ISOC: bool
+#include <stdio.h>      // ISOC: snprintf(), rename()
+#include <stdlib.h>     // ISOC: malloc(), calloc(), realloc(), free()
+#include <string.h>     // ISOC: memcpy(), memcmp(), memset(), strncpy(), strncmp(), strlen()
+#include <sys/mman.h>   // P2001: mmap(), munmap()
+#include <sys/stat.h>   // P2001: stat(), fstat()
+#include <unistd.h>     // P2001: write(), close(), unlink(), getpid()
+
+/*******************************************************************************
+ * USER INCLUDES
+ ******************************************************************************/
+
+#include "startsnap.h"
+
+/*******************************************************************************
+ * PRIVATE TYPES / CONSTANTS / VARIABLES
+ ******************************************************************************/
+
+// first bytes of a snapshot (bump the digit if the layout changes)
+static const char SNAP_MAGIC[8] = { 'P', 'T', 'U', 'S', 'N', 'A', 'P', '1' };
+
+#define SECTION_NAME_LEN 24
+
+typedef struct {
+  char magic[8];
+  uint64_t key;
+  uint64_t num_sections;
+} SnapHeader;
+
+typedef struct {
+  char name[SECTION_NAME_LEN];   // NUL-padded
+  uint64_t offset;               // from start of file
+  uint64_t size;
+} SnapSection;
+
+struct StartSnap {
+  void* map;
+  size_t map_size;
+  const SnapSection* sections;
+  uint64_t num_sections;
+};
+
+typedef struct {
+  char name[SECTION_NAME_LEN];
+  char* data;
+  size_t size;
+} WriterSection;
+
+struct StartSnapWriter {
+  WriterSection* sections;
+  size_t num_sections;
+};
+
+/*******************************************************************************
+ * PRIVATE MACROS / FUNCTIONS
+ ******************************************************************************/
+
+#define ALIGN8(n) (((n) + 7) & ~(uint64_t)7)
+
+// write all size bytes of data to fd, return 0 on success, -1 on error
+static int write_all (int fd, const void* data, size_t size) {
+  const char* p = (const char*)data;
+  while (size > 0) {
+    ssize_t n = write(fd, p, size);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return -1;
+    }
+    p += n;
+    size -= n;
+  }
+  return 0;
+}
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+uint64_t startsnap_hash (uint64_t hash, const void* data, size_t size) {
+  // FNV-1a
+  const unsigned char* p = (const unsigned char*)data;
+  for (size_t i = 0; i < size; i++) {
+    hash ^= p[i];
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+uint64_t startsnap_hash_file (uint64_t hash, const char* path) {
+  struct stat st;
+  uint64_t stamp[6] = { 0 };
+  if (stat(path, &st) == 0) {
+    stamp[0] = (uint64_t)st.st_dev;
+    stamp[1] = (uint64_t)st.st_ino;
+    stamp[2] = (uint64_t)st.st_size;
+    stamp[3] = (uint64_t)st.st_mtim.tv_sec;
+    stamp[4] = (uint64_t)st.st_mtim.tv_nsec;
+    stamp[5] = 1;
+  }
+  return startsnap_hash(hash, stamp, sizeof(stamp));
+}
+
+StartSnap* startsnap_open (const char* path, uint64_t key) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return NULL;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(SnapHeader)) {
+    close(fd);
+    return NULL;
+  }
+  const size_t map_size = (size_t)st.st_size;
+  void* map = mmap(NULL, map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    return NULL;
+  }
+
+  // check header, and that all sections are within the file
+  const SnapHeader* h = (const SnapHeader*)map;
+  const SnapSection* sections = (const SnapSection*)((const char*)map + sizeof(SnapHeader));
+  bool ok = memcmp(h->magic, SNAP_MAGIC, sizeof(SNAP_MAGIC)) == 0 && h->key == key &&
+            h->num_sections <= (map_size - sizeof(SnapHeader)) / sizeof(SnapSection);
+  for (uint64_t i = 0; ok && i < h->num_sections; i++) {
+    ok = sections[i].offset <= map_size && sections[i].size <= map_size - sections[i].offset &&
+         sections[i].name[SECTION_NAME_LEN - 1] == '\0';
+  }
+  if (!ok) {
+    munmap(map, map_size);
+    return NULL;
+  }
+
+  StartSnap* snap = (StartSnap*)calloc(1, sizeof(StartSnap));
+  snap->map = map;
+  snap->map_size = map_size;
+  snap->sections = sections;
+  snap->num_sections = h->num_sections;
+  return snap;
+}
+
+void startsnap_close (StartSnap* snap) {
+  if (snap) {
+    munmap(snap->map, snap->map_size);
+    free(snap);
+  }
+}
+
+const void* startsnap_section (const StartSnap* snap, const char* name, size_t* size) {
+  for (uint64_t i = 0; i < snap->num_sections; i++) {
+    if (strncmp(snap->sections[i].name, name, SECTION_NAME_LEN) == 0) {
+      *size = (size_t)snap->sections[i].size;
+      return (const char*)snap->map + snap->sections[i].offset;
+    }
+  }
+  return NULL;
+}
+
+StartSnapWriter* startsnap_writer_new (void) {
+  return (StartSnapWriter*)calloc(1, sizeof(StartSnapWriter));
+}
+
+void startsnap_writer_free (StartSnapWriter* w) {
+  if (w) {
+    for (size_t i = 0; i < w->num_sections; i++) {
+      free(w->sections[i].data);
+    }
+    free(w->sections);
+    free(w);
+  }
+}
+
+void startsnap_add (StartSnapWriter* w, const char* name, const void* data, size_t size) {
+  w->sections = (WriterSection*)realloc(w->sections, (w->num_sections + 1) * sizeof(WriterSection));
+  WriterSection* s = &w->sections[w->num_sections++];
+  memset(s->name, 0, SECTION_NAME_LEN);
+  strncpy(s->name, name, SECTION_NAME_LEN - 1);
+  s->data = NULL;
+  s->size = 0;
+  startsnap_append(w, data, size);
+}
+
+void startsnap_append (StartSnapWriter* w, const void* data, size_t size) {
+  WriterSection* s = &w->sections[w->num_sections - 1];
+  if (size > 0) {
+    s->data = (char*)realloc(s->data, s->size + size);
+    memcpy(s->data + s->size, data, size);
+    s->size += size;
+  }
+}
+
+int startsnap_save (const StartSnapWriter* w, const char* path, uint64_t key) {
+  SnapHeader h;
+  memcpy(h.magic, SNAP_MAGIC, sizeof(SNAP_MAGIC));
+  h.key = key;
+  h.num_sections = w->num_sections;
+
+  SnapSection* table = (SnapSection*)calloc(w->num_sections + 1, sizeof(SnapSection));
+  uint64_t offset = ALIGN8(sizeof(SnapHeader) + w->num_sections * sizeof(SnapSection));
+  for (size_t i = 0; i < w->num_sections; i++) {
+    memcpy(table[i].name, w->sections[i].name, SECTION_NAME_LEN);
+    table[i].offset = offset;
+    table[i].size = w->sections[i].size;
+    offset = ALIGN8(offset + w->sections[i].size);
+  }
+
+  // (a temp file of our own, so runs saving at once do not mix their writes)
+  const size_t tmp_path_len = strlen(path) + 32;
+  char* tmp_path = (char*)malloc(tmp_path_len);
+  snprintf(tmp_path, tmp_path_len, "%s.%d.tmp", path, (int)getpid());
+  int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  int ret = (fd < 0) ? -1 : 0;
+
+  static const char zeros[8] = { 0 };
+  uint64_t written = sizeof(SnapHeader) + w->num_sections * sizeof(SnapSection);
+  if (ret == 0) {
+    ret = write_all(fd, &h, sizeof(h));
+  }
+  if (ret == 0) {
+    ret = write_all(fd, table, w->num_sections * sizeof(SnapSection));
+  }
+  for (size_t i = 0; ret == 0 && i < w->num_sections; i++) {
+    ret = write_all(fd, zeros, table[i].offset - written);
+    if (ret == 0) {
+      ret = write_all(fd, w->sections[i].data, w->sections[i].size);
+    }
+    written = table[i].offset + w->sections[i].size;
+  }
+
+  if (fd >= 0) {
+    if (ret != 0) {
+      const int err = errno;
+      close(fd);
+      errno = err;
+    } else if (close(fd) != 0) {
+      ret = -1;
+    }
+  }
+  if (ret == 0 && rename(tmp_path, path) != 0) {
+    ret = -1;
+  }
+  if (ret != 0) {
+    const int err = errno;
+    unlink(tmp_path);
+    errno = err;
+  }
+
+  free(tmp_path);
+  free(table);
+  return ret;
+}
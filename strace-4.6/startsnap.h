@@ -0,0 +1,81 @@
+/*******************************************************************************
+module:   startsnap
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  startup snapshot: a file of named sections (e.g., parsed cde.options)
+          that cde-exec saves on its first run in a package, and mmaps on
+          later runs instead of redoing the work that made them
+notes:    - a snapshot is only used if its key (a hash of the stamps of the
+            files and settings its sections were made from) is the key the
+            caller computes now, so a stale or corrupt one is ignored
+          - saved to a temp file renamed over the snapshot, so concurrent runs
+            each see a whole snapshot or none
+*******************************************************************************/
+
+#ifndef STARTSNAP_H
+#define STARTSNAP_H 1
+
+// allow this header to be included from c++ source file
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*******************************************************************************
+ * SYSTEM INCLUDES
+ ******************************************************************************/
+
+#include <stddef.h>     // ISOC: size_t
+#include <stdint.h>     // ISOC: uint64_t
+
+/*******************************************************************************
+ * PUBLIC TYPES / CONSTANTS / VARIABLES
+ ******************************************************************************/
+
+// initial hash, to pass to the first of startsnap_hash() or startsnap_hash_file()
+#define STARTSNAP_HASH_INIT 0xcbf29ce484222325ULL
+
+// opaque opened (mmapped) snapshot type
+typedef struct StartSnap StartSnap;
+
+// opaque snapshot (being built) type
+typedef struct StartSnapWriter StartSnapWriter;
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+// return hash extended with size bytes of data
+uint64_t startsnap_hash (uint64_t hash, const void* data, size_t size);
+
+// return hash extended with the stamp (device, inode, size, mtime) of the file
+// at path, or with its absence
+uint64_t startsnap_hash_file (uint64_t hash, const char* path);
+
+// return the snapshot at path (mmapped) if it was saved with key, else NULL
+StartSnap* startsnap_open (const char* path, uint64_t key);
+void startsnap_close (StartSnap* snap);
+
+// return section name of snap (valid until snap is closed) and set *size to
+// its size, or return NULL if snap has no such section
+const void* startsnap_section (const StartSnap* snap, const char* name, size_t* size);
+
+// return new snapshot with no sections
+StartSnapWriter* startsnap_writer_new (void);
+void startsnap_writer_free (StartSnapWriter* w);
+
+// add section name (up to 23 chars) holding a copy of size bytes of data
+void startsnap_add (StartSnapWriter* w, const char* name, const void* data, size_t size);
+
+// append size bytes of data to the last section added
+void startsnap_append (StartSnapWriter* w, const void* data, size_t size);
+
+// save snapshot w, with key, to path
+// return 0 on success, -1 on error (errno set)
+int startsnap_save (const StartSnapWriter* w, const char* path, uint64_t key);
+
+// allow this header to be included from c++ source file
+#ifdef __cplusplus
+}
+#endif
+
+#endif // STARTSNAP_H
@@ -56,6 +56,8 @@
 #include <string.h>
 #include <limits.h>
 #include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
 
 extern int getopt (int argc, char * const argv[], const char *optstring);
 
@@ -99,6 +101,10 @@ extern int getopt (int argc, char * const argv[], const char *optstring);
 #include "okapi.h"        // pgbovine
 #include "provenance.h"
 #include "perftimers.h"   // set_perf_timer(), get_total_perf_time()
+#include "sysprofile.h"   // sysprofile_record_stop(), print_sysprofile()
+#include "ctlsock.h"      // ctlsock_start(), ctlsock_record_stop()
+#include "strutils.h"     // str_print_json()
+#include "provquery.h"    // provquery_main()
 
 /*******************************************************************************
  * EXTERNALLY-DEFINED VARIABLES
@@ -113,8 +119,9 @@ extern char CDE_exec_streaming_mode; // -s option
 extern char CDE_block_net_access; // -n option
 extern char CDE_use_linker_from_package; // ON by default, -l option to turn OFF
 extern void strcpy_redirected_cderoot(char* dst, char* src);
-extern void CDE_init_tcb_dir_fields(struct tcb* tcp);
+extern void CDE_init_tcb_dir_fields(struct tcb* tcp, unsigned long clone_flags);
 extern FILE* CDE_copied_files_logfile;
+extern int CDE_lib_prefetch_workers; // -J option
 extern char* CDE_PACKAGE_DIR;
 extern char* CDE_ROOT_NAME;
 extern void CDE_add_ignore_exact_path(char* p);
@@ -167,6 +174,9 @@ FILE *outf;
 static int curcol;
 struct tcb **tcbtab;
 unsigned int nprocs, tcbtabsize;
+// digimokan: guards tcbtab against the control socket thread (-k), which
+// reads it; recursive since droptcb() may drop the parent too
+static pthread_mutex_t tcbtab_mut = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
 const char *progname;
 extern char **environ;
 
@@ -497,7 +507,7 @@ startup_attach(void)
 						tcbtab[tcbi]->nchildren++;
 						tcbtab[tcbi]->nclone_threads++;
 						tcp->parent = tcbtab[tcbi];
-            CDE_init_tcb_dir_fields(tcp); // pgbovine - do it AFTER you init parent
+            CDE_init_tcb_dir_fields(tcp, CLONE_FS|CLONE_FILES); // pgbovine - do it AFTER you init parent
 					}
 					if (interactive) {
 						sigprocmask(SIG_SETMASK, &empty_set, NULL);
@@ -797,7 +807,7 @@ fprintf(stderr, "%s %d\n", pathname, cde_exec_from_outside_cderoot);
 				kill(pid, SIGCONT);
 		}
 		tcp = alloctcb(pid);
-		CDE_init_tcb_dir_fields(tcp); // pgbovine
+		CDE_init_tcb_dir_fields(tcp, 0); // pgbovine
 		tcp->flags |= TCB_ATTACHED | TCB_STARTUP;
 		newoutf(tcp);
 	}
@@ -805,6 +815,7 @@ fprintf(stderr, "%s %d\n", pathname, cde_exec_from_outside_cderoot);
 		/* The tracee is our parent: */
 		pid = getppid();
 		tcp = alloctcb(pid);
+		CDE_init_tcb_dir_fields(tcp, 0); // digimokan
 		/* We want subsequent startup_attach() to attach to it.  */
 		tcp->flags |= TCB_ATTACHED;
 	}
@@ -907,10 +918,12 @@ expand_tcbtab(void)
 		cleanup();
 		exit(1);
 	}
+	pthread_mutex_lock(&tcbtab_mut);
 	for (i = tcbtabsize; i < 2 * tcbtabsize; ++i)
 		newtab[i] = &newtcbs[i - tcbtabsize];
 	tcbtabsize *= 2;
 	tcbtab = newtab;
+	pthread_mutex_unlock(&tcbtab_mut);
 }
 
 struct tcb *
@@ -925,6 +938,7 @@ alloc_tcb(int pid, int command_options_parsed)
 	for (i = 0; i < tcbtabsize; i++) {
 		tcp = tcbtab[i];
 		if ((tcp->flags & TCB_INUSE) == 0) {
+			pthread_mutex_lock(&tcbtab_mut);
 			tcp->pid = pid;
 			tcp->parent = NULL;
 			tcp->nchildren = 0;
@@ -939,10 +953,13 @@ alloc_tcb(int pid, int command_options_parsed)
 			tcp->stime.tv_sec = 0;
 			tcp->stime.tv_usec = 0;
 			tcp->pfd = -1;
+			tcp->sysprofile_entered_ns = 0;
+			tcp->ctl_verbose = 0;
 
       alloc_tcb_cde_fields(tcp); // pgbovine
 
 			nprocs++;
+			pthread_mutex_unlock(&tcbtab_mut);
 			if (command_options_parsed)
 				newoutf(tcp);
 			return tcp;
@@ -1308,6 +1325,7 @@ struct tcb *tcp;
 		return;
 	}
 #endif
+	pthread_mutex_lock(&tcbtab_mut);
 	nprocs--;
 	tcp->pid = 0;
 
@@ -1356,6 +1374,7 @@ struct tcb *tcp;
 	tcp->outf = 0;
 
   free_tcb_cde_fields(tcp); // pgbovine
+	pthread_mutex_unlock(&tcbtab_mut);
 }
 
 #ifndef USE_PROCFS
@@ -1377,7 +1396,7 @@ struct tcb *tcp;
 		tcp->parent->nclone_waiting--;
 #endif
 
-	if (ptrace_restart(PTRACE_SYSCALL, tcp, 0) < 0)
+	if (ptrace_resume(tcp, 0) < 0)
 		return -1;
 
 	if (!qflag)
@@ -2215,6 +2234,101 @@ handle_ptrace_event(int status, struct tcb *tcp)
 }
 #endif
 
+// digimokan: add a stop handled by trace_syscall() to the -R syscall profile
+static void
+profile_syscall_stop(struct tcb *tcp, int trace_syscall_ret, unsigned long long begin_ns)
+{
+	unsigned long long end_ns = sysprofile_now();
+
+	if (trace_syscall_ret < 0 || tcp->scno < 0 || tcp->scno >= nsyscalls) {
+		sysprofile_discard_stop();
+		return;
+	}
+
+	// trace_syscall() sets TCB_INSYSCALL when it handled a syscall entry
+	if (tcp->flags & TCB_INSYSCALL) {
+		sysprofile_record_stop(tcp->scno, sysent[tcp->scno].sys_name, true,
+				       end_ns - begin_ns, 0);
+		tcp->sysprofile_entered_ns = end_ns;
+	}
+	else {
+		unsigned long long blocked_ns = tcp->sysprofile_entered_ns ?
+			begin_ns - tcp->sysprofile_entered_ns : 0;
+		sysprofile_record_stop(tcp->scno, sysent[tcp->scno].sys_name, false,
+				       end_ns - begin_ns, blocked_ns);
+		tcp->sysprofile_entered_ns = 0;
+	}
+}
+
+// digimokan: print -R syscall profile: table to stderr, json to a file in cwd
+static void
+report_syscall_profile(void)
+{
+	if (sysprofile_format() == SYSPROFILE_JSON) {
+		FILE *f = fopen("ptu-syscall-profile.json", "w");
+		if (!f) {
+			fprintf(stderr, "%s: cannot write ptu-syscall-profile.json\n", progname);
+			return;
+		}
+		print_sysprofile(f, SYSPROFILE_JSON);
+		fclose(f);
+	}
+	else {
+		print_sysprofile(stderr, SYSPROFILE_TABLE);
+	}
+}
+
+// digimokan: write json array of traced processes (control socket "tcbs")
+static void
+ctl_dump_tcbs(FILE *f)
+{
+	char cwd[MAXPATHLEN];
+	int first = 1;
+	unsigned int i;
+
+	pthread_mutex_lock(&tcbtab_mut);
+	fprintf(f, "[");
+	for (i = 0; i < tcbtabsize; i++) {
+		struct tcb *tcp = tcbtab[i];
+		if (!(tcp->flags & TCB_INUSE) || tcp->pid == 0)
+			continue;
+		// the tracing thread may be changing (or freeing) the cwd, so copy it under its lock
+		CDE_copy_current_dir(tcp, cwd, sizeof(cwd));
+		fprintf(f, "%s{\"pid\":%d,\"ppid\":%d,\"in_syscall\":%s,\"syscall\":",
+			first ? "" : ",", tcp->pid, tcp->parent ? tcp->parent->pid : 0,
+			(tcp->flags & TCB_INSYSCALL) ? "true" : "false");
+		str_print_json(f, (tcp->scno >= 0 && tcp->scno < nsyscalls) ?
+				       sysent[tcp->scno].sys_name : "");
+		fprintf(f, ",\"cwd\":");
+		str_print_json(f, cwd);
+		fprintf(f, ",\"verbose\":%s}",
+			__atomic_load_n(&tcp->ctl_verbose, __ATOMIC_RELAXED) ? "true" : "false");
+		first = 0;
+	}
+	fprintf(f, "]");
+	pthread_mutex_unlock(&tcbtab_mut);
+}
+
+// digimokan: toggle verbose tracing of one pid (control socket "verbose")
+static int
+ctl_set_verbose(int pid, bool on)
+{
+	int ret = -1;
+	unsigned int i;
+
+	pthread_mutex_lock(&tcbtab_mut);
+	for (i = 0; i < tcbtabsize; i++) {
+		struct tcb *tcp = tcbtab[i];
+		if ((tcp->flags & TCB_INUSE) && tcp->pid == pid) {
+			__atomic_store_n(&tcp->ctl_verbose, on ? 1 : 0, __ATOMIC_RELAXED);
+			ret = 0;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&tcbtab_mut);
+	return ret;
+}
+
 static int
 trace()
 {
@@ -2343,6 +2457,9 @@ Process %d attached (waiting for parent)\n",
 			 */
 			continue;
 		}
+		/* digimokan: an untraced proc's exit syscall was not seen */
+		if (tcp->untraced && (WIFSIGNALED(status) || WIFEXITED(status)))
+			print_exit_prov(tcp);
 		if (WIFSIGNALED(status)) {
 			if (pid == strace_child)
 				exit_code = 0x100 | WTERMSIG(status);
@@ -2370,6 +2487,7 @@ Process %d attached (waiting for parent)\n",
 			if (debug)
 				fprintf(stderr, "pid %u exited with %d\n", pid, WEXITSTATUS(status));
 			if ((tcp->flags & (TCB_ATTACHED|TCB_STARTUP)) == TCB_ATTACHED
+			    && !tcp->untraced
 #ifdef TCB_GROUP_EXITING
 			    && !(tcp->parent && (tcp->parent->flags & TCB_GROUP_EXITING))
 			    && !(tcp->flags & TCB_GROUP_EXITING)
@@ -2443,6 +2561,14 @@ Process %d attached (waiting for parent)\n",
 			goto tracing;
 		}
 
+		/* digimokan: an untraced proc makes no syscall stops, so its
+		   SIGTRAP was sent by an execve it did (or, rarely, by another
+		   proc, and is lost) */
+		if (tcp->untraced && WSTOPSIG(status) == SIGTRAP) {
+			tcp->flags &= ~TCB_INSYSCALL;
+			goto tracing;
+		}
+
 		if (WSTOPSIG(status) != SIGTRAP) {
 			if (WSTOPSIG(status) == SIGSTOP &&
 					(tcp->flags & TCB_SIGTRAPPED)) {
@@ -2451,7 +2577,7 @@ Process %d attached (waiting for parent)\n",
 				 * Hope we are back in control now.
 				 */
 				tcp->flags &= ~(TCB_INSYSCALL | TCB_SIGTRAPPED);
-				if (ptrace_restart(PTRACE_SYSCALL, tcp, 0) < 0) {
+				if (ptrace_resume(tcp, 0) < 0) {
 					cleanup();
 					return -1;
 				}
@@ -2502,7 +2628,7 @@ Process %d attached (waiting for parent)\n",
 #endif
 				continue;
 			}
-			if (ptrace_restart(PTRACE_SYSCALL, tcp, WSTOPSIG(status)) < 0) {
+			if (ptrace_resume(tcp, WSTOPSIG(status)) < 0) {
 				cleanup();
 				return -1;
 			}
@@ -2512,7 +2638,24 @@ Process %d attached (waiting for parent)\n",
 		/* we handled the STATUS, we are permitted to interrupt now. */
 		if (interrupted)
 			return 0;
-		if (trace_syscall(tcp) < 0 && !tcp->ptrace_errno) {
+		count_perf_event(TRACE_STOPS, 1);
+		start_perf_timer(TRACE_STOP_HANDLING);
+		bool ctl_mode = ctlsock_enabled();
+		unsigned long long stop_begin_ns = (Sysprofile_mode || ctl_mode) ? sysprofile_now() : 0;
+		// digimokan: verbose tracing toggled on for this pid via the control socket
+		int saved_verbose_mode = Cde_verbose_mode;
+		if (ctl_mode && __atomic_load_n(&tcp->ctl_verbose, __ATOMIC_RELAXED) && !Cde_verbose_mode)
+			Cde_verbose_mode = 1;
+		int trace_syscall_ret = trace_syscall(tcp);
+		Cde_verbose_mode = saved_verbose_mode;
+		if (ctl_mode)
+			ctlsock_record_stop(tcp->pid,
+					    (tcp->scno >= 0 && tcp->scno < nsyscalls) ? sysent[tcp->scno].sys_name : NULL,
+					    sysprofile_now() - stop_begin_ns, nprocs);
+		if (Sysprofile_mode)
+			profile_syscall_stop(tcp, trace_syscall_ret, stop_begin_ns);
+		stop_perf_timer(TRACE_STOP_HANDLING);
+		if (trace_syscall_ret < 0 && !tcp->ptrace_errno) {
 			/* ptrace() failed in trace_syscall() with ESRCH.
 			 * Likely a result of process disappearing mid-flight.
 			 * Observed case: exit_group() terminating
@@ -2561,7 +2704,7 @@ Process %d attached (waiting for parent)\n",
 	tracing:
 		/* Remember current print column before continuing. */
 		tcp->curcol = curcol;
-		if (ptrace_restart(PTRACE_SYSCALL, tcp, 0) < 0) {
+		if (ptrace_resume(tcp, 0) < 0) {
 			cleanup();
 			return -1;
 		}
@@ -2690,12 +2833,13 @@ int main (int argc, char *argv[]) {
   struct tcb *tcp;
   int c;
   int optF = 0;
+  int ctl_socket_mode = 0;
   struct sigaction sa;
 
   static char buf[BUFSIZ];
 
-  // digimokan: set performance timer for okapi file copying during audit
-  set_perf_timer(AUDIT_FILE_COPYING, DISABLED);
+  // digimokan: perf timers start out disabled (-M enables all of them)
+  set_all_perf_timers(DISABLED);
 
   // pgbovine - make sure this constant is a reasonable number and not something KRAZY
   if (MAXPATHLEN > (1024 * 4096)) {
@@ -2709,6 +2853,11 @@ int main (int argc, char *argv[]) {
   }
 	progname = argv[0];
 
+  // digimokan - if program name is 'ptu-prov', index/query a provenance log (no tracing)
+  if (strcmp(basename(progname), "ptu-prov") == 0) {
+    exit(provquery_main(argc, argv));
+  }
+
   // pgbovine - if program name is 'cde-exec', then activate Cde_exec_mode
   Cde_exec_mode = (strcmp(basename(progname), "cde-exec") == 0 || strcmp(basename(progname), "ptu-exec") == 0);
   Cde_restore_mode = (strcmp(basename(progname), "ptu-restore") == 0);
@@ -2739,11 +2888,11 @@ int main (int argc, char *argv[]) {
     // MOVE qualify to after getopt
 
 	while ((c = getopt(argc, argv,
-		"+cCdfFhqrtTvVxzlsSnNbw"
+		"+cCdfFhkqrtTvVxzlsSnNbwB"
 #ifndef USE_PROCFS
 		"D"
 #endif
-		"a:e:o:O:u:E:i:p:P:I:")) != EOF) {
+		"a:e:o:O:u:E:i:p:P:I:J:MR:m:")) != EOF) {
 		switch (c) {
 		case 'c':
       // pgbovine - hijack for -c option
@@ -2818,6 +2967,46 @@ int main (int argc, char *argv[]) {
 			// quanpt - id of the new db in SSH replacement mode
 			/*Prov_db_id = strdup(optarg);*/
 			break;
+		case 'J':
+			// number of threads prefetching shared libs during audit (0 = OFF)
+			CDE_lib_prefetch_workers = atoi(optarg);
+			break;
+		case 'm': {
+			// millisecs between MEM/USAGE provenance samples of each process (0 = OFF)
+			char *end;
+			long ms;
+			errno = 0;
+			ms = strtol(optarg, &end, 10);
+			if (errno || end == optarg || *end != '\0' || ms < 0 || ms > INT_MAX) {
+				fprintf(stderr, "%s: -m expects millisecs (0 to %d), got '%s'\n",
+					progname, INT_MAX, optarg);
+				usage(stderr, 1);
+			}
+			Prov_sample_interval_ms = (unsigned int) ms;
+			break;
+		}
+		case 'B':
+			// log bytes read/written via each opened file at its close (IOBYTES records)
+			Prov_fd_byte_accounting = 1;
+			break;
+		case 'R': {
+			// profile tracer overhead per syscall, report as table or json at exit
+			SysProfileFormat fmt;
+			if (sysprofile_parse_format(optarg, &fmt) != 0) {
+				fprintf(stderr, "%s: -R expects 'table' or 'json', got '%s'\n", progname, optarg);
+				exit(1);
+			}
+			sysprofile_enable(fmt);
+			break;
+		}
+		case 'M':
+			// time where tracer time goes, and print a report at exit
+			set_all_perf_timers(ENABLED);
+			break;
+		case 'k':
+			// serve live stats on a control socket in the package dir
+			ctl_socket_mode = 1;
+			break;
 		case 'T':
 			dtime++;
 			break;
@@ -2939,9 +3128,19 @@ int main (int argc, char *argv[]) {
 			",mkdirat,unlinkat,setxattr,lsetxattr,getxattr,lgetxattr,listxattr,llistxattr,removexattr,lremovexattr" \
 			",connect,accept,listen,close" \
 			",exit_group"
-	char* tmp = strdup(SYSCALL_1ST);
-	qualify(tmp);
-  	free(tmp);
+	qualify(SYSCALL_1ST);
+
+	// digimokan: with -B, also stop at exit of the read/write family, to count bytes per opened file
+	// (names differ by arch, e.g. pread vs. pread64, so skip those this arch lacks)
+	if (Prov_fd_byte_accounting) {
+		int sc;
+		static const char *const io_bytes_syscalls[] = {
+			"read", "write", "readv", "writev", "pread", "pwrite",
+			"pread64", "pwrite64", "preadv", "pwritev", NULL
+		};
+		for (sc = 0; io_bytes_syscalls[sc]; sc++)
+			qualify_syscall_if_known(io_bytes_syscalls[sc]);
+	}
 
 	qualify("abbrev=all");
 	qualify("verbose=all");
@@ -2990,20 +3189,6 @@ int main (int argc, char *argv[]) {
 		run_gid = getgid();
 	}
 
-#ifdef LINUX
-	if (followfork) {
-		if (test_ptrace_setoptions() < 0) {
-			fprintf(stderr,
-				"Test for options supported by PTRACE_SETOPTIONS "
-				"failed, giving up using this feature.\n");
-			ptrace_setoptions = 0;
-		}
-		if (debug)
-			fprintf(stderr, "ptrace_setoptions = %#x\n",
-				ptrace_setoptions);
-	}
-#endif
-
 	/* Check if they want to redirect the output. */
 	if (outfname) {
 		/* See if they want to pipe the output. */
@@ -3048,12 +3233,43 @@ int main (int argc, char *argv[]) {
 	extern void CDE_init(char** argv, int optind);
 	CDE_init(argv, optind);
 
+#ifdef LINUX
+	/* digimokan: cde-exec probes the kernel once per package, and
+	   takes the result from its startup snapshot after that */
+	if (followfork) {
+		extern int CDE_get_snapshot_ptrace_setoptions(void);
+		int snap_ptrace_setoptions = CDE_get_snapshot_ptrace_setoptions();
+		if (snap_ptrace_setoptions >= 0)
+			ptrace_setoptions = snap_ptrace_setoptions;
+		else if (test_ptrace_setoptions() < 0) {
+			fprintf(stderr,
+				"Test for options supported by PTRACE_SETOPTIONS "
+				"failed, giving up using this feature.\n");
+			ptrace_setoptions = 0;
+		}
+		if (debug)
+			fprintf(stderr, "ptrace_setoptions = %#x\n",
+				ptrace_setoptions);
+	}
+#endif
+
     init_prov(); // quanpt: initialize provlog file
+
+	// digimokan: live stats over a control socket (only for -k)
+	if (ctl_socket_mode) {
+		char *ctl_path = format("%s/%s", Cde_app_dir, CTLSOCK_NAME);
+		if (ctlsock_start(ctl_path, ctl_dump_tcbs, ctl_set_verbose) != 0)
+			fprintf(stderr, "%s: cannot serve control socket %s: %s\n",
+				progname, ctl_path, strerror(errno));
+		free(ctl_path);
+	}
 		
 	extern void CDE_load_environment_vars(char* repo_name);
 	extern void CDE_load_environment_vars_for_pid(char* pidkey);
+	extern void CDE_finish_startup_snapshot(int ptrace_setoptions);
 	if (Cde_exec_mode) {
 		CDE_load_environment_vars(CDE_ROOT_NAME);
+		CDE_finish_startup_snapshot(followfork ? (int)ptrace_setoptions : -1);
 	}
 
 
@@ -3070,7 +3286,7 @@ int main (int argc, char *argv[]) {
 		char *envp[] = {NULL};
 		int pid = criu_main(8, criu_argv, envp);
 		tcp = alloctcb(pid);
-		CDE_init_tcb_dir_fields(tcp); // pgbovine
+		CDE_init_tcb_dir_fields(tcp, 0); // pgbovine
 		tcp->flags |= TCB_ATTACHED | TCB_STARTUP;
 		newoutf(tcp);
 		// ptrace(PTRACE_CONT, pid, 0, 0);
@@ -3120,6 +3336,11 @@ int main (int argc, char *argv[]) {
 	if (trace() < 0)
 		exit(1);
 	cleanup();
+
+	extern void CDE_finish(void);
+	CDE_finish();
+	finish_prov();
+
 	fflush(NULL);
 	if (exit_code > 0xff) {
 		/* Child was killed by a signal, mimic that.  */
@@ -3131,11 +3352,15 @@ int main (int argc, char *argv[]) {
 		exit_code += 128;
 	}
 
-	// print audit file copying total time (only if timer was ENABLED)
-    double audit_time;
-    if (get_total_perf_time(AUDIT_FILE_COPYING, &audit_time) == SUCCESS_TIMER_TOTAL_RETURNED) {
-      printf("total time doing file copying during audit: %.3f\n", audit_time);
-    }
+	// print perf timer/counter totals (only if timers were ENABLED with -M;
+	// -k enables the counters alone, for its live stats)
+	ctlsock_stop();
+	if (any_perf_timer_enabled())
+		print_perf_report(stderr);
+
+	// print syscall profile (only if enabled with -R)
+	if (Sysprofile_mode)
+		report_syscall_profile();
 
 	exit(exit_code);
 }
@@ -0,0 +1,173 @@
+/*******************************************************************************
+module:   strmap
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  hash map from c-string keys (e.g., file paths) to arbitrary values
+*******************************************************************************/
+
+/*******************************************************************************
+ * SYSTEM INCLUDES
+ ******************************************************************************/
+
+#include <stdbool.h>    // ISOC: bool, true, false
+#include <stdlib.h>     // ISOC: malloc(), calloc(), free()
+#include <string.h>     // ISOC: strdup(), strcmp()
+
+/*******************************************************************************
+ * USER INCLUDES
+ ******************************************************************************/
+
+#include "strmap.h"
+
+/*******************************************************************************
+ * PRIVATE TYPES / CONSTANTS / VARIABLES
+ ******************************************************************************/
+
+#define INITIAL_BUCKETS 64      // num buckets in a new map (power of 2)
+
+typedef struct StrMapNode {
+  char* key;
+  void* val;
+  unsigned long hash;
+  struct StrMapNode* next;
+} StrMapNode;
+
+struct StrMap {
+  StrMapNode** buckets;
+  size_t num_buckets;   // always a power of 2
+  size_t num_keys;
+};
+
+/*******************************************************************************
+ * PRIVATE MACROS / FUNCTIONS
+ ******************************************************************************/
+
+// djb2 string hash
+static unsigned long hash_key (const char* key) {
+  unsigned long h = 5381;
+  while (*key)
+    h = ((h << 5) + h) + (unsigned char)*key++;
+  return h;
+}
+
+static StrMapNode** find_node (const StrMap* map, const char* key, unsigned long hash) {
+  StrMapNode** n = &map->buckets[hash & (map->num_buckets - 1)];
+  while (*n && ((*n)->hash != hash || strcmp((*n)->key, key) != 0))
+    n = &(*n)->next;
+  return n;
+}
+
+// double num buckets once load factor exceeds 1
+static void grow_if_needed (StrMap* map) {
+  if (map->num_keys < map->num_buckets)
+    return;
+
+  size_t new_num_buckets = map->num_buckets * 2;
+  StrMapNode** new_buckets = (StrMapNode**)calloc(new_num_buckets, sizeof(StrMapNode*));
+  if (!new_buckets)
+    return; // keep working, just with longer chains
+
+  for (size_t b = 0; b < map->num_buckets; b++) {
+    StrMapNode* n = map->buckets[b];
+    while (n) {
+      StrMapNode* next = n->next;
+      size_t nb = n->hash & (new_num_buckets - 1);
+      n->next = new_buckets[nb];
+      new_buckets[nb] = n;
+      n = next;
+    }
+  }
+
+  free(map->buckets);
+  map->buckets = new_buckets;
+  map->num_buckets = new_num_buckets;
+}
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+StrMap* strmap_new (void) {
+  StrMap* map = (StrMap*)malloc(sizeof(StrMap));
+  map->buckets = (StrMapNode**)calloc(INITIAL_BUCKETS, sizeof(StrMapNode*));
+  map->num_buckets = INITIAL_BUCKETS;
+  map->num_keys = 0;
+  return map;
+}
+
+void strmap_free (StrMap* map, StrMapValFunc free_val) {
+  if (!map)
+    return;
+
+  for (size_t b = 0; b < map->num_buckets; b++) {
+    StrMapNode* n = map->buckets[b];
+    while (n) {
+      StrMapNode* next = n->next;
+      if (free_val)
+        free_val(n->val);
+      free(n->key);
+      free(n);
+      n = next;
+    }
+  }
+
+  free(map->buckets);
+  free(map);
+}
+
+void* strmap_put (StrMap* map, const char* key, void* val) {
+  unsigned long hash = hash_key(key);
+  StrMapNode** n = find_node(map, key, hash);
+
+  if (*n) {
+    void* old_val = (*n)->val;
+    (*n)->val = val;
+    return old_val;
+  }
+
+  StrMapNode* node = (StrMapNode*)malloc(sizeof(StrMapNode));
+  node->key = strdup(key);
+  node->val = val;
+  node->hash = hash;
+  node->next = NULL;
+  *n = node;
+  map->num_keys++;
+
+  grow_if_needed(map);
+  return NULL;
+}
+
+void* strmap_get (const StrMap* map, const char* key) {
+  StrMapNode** n = find_node(map, key, hash_key(key));
+  return *n ? (*n)->val : NULL;
+}
+
+bool strmap_contains (const StrMap* map, const char* key) {
+  return *find_node(map, key, hash_key(key)) != NULL;
+}
+
+void* strmap_remove (StrMap* map, const char* key) {
+  StrMapNode** n = find_node(map, key, hash_key(key));
+  if (!*n)
+    return NULL;
+
+  StrMapNode* node = *n;
+  void* val = node->val;
+  *n = node->next;
+  free(node->key);
+  free(node);
+  map->num_keys--;
+  return val;
+}
+
+size_t strmap_size (const StrMap* map) {
+  return map->num_keys;
+}
+
+void strmap_foreach (const StrMap* map, StrMapIterFunc iter_func, void* arg) {
+  for (size_t b = 0; b < map->num_buckets; b++) {
+    for (StrMapNode* n = map->buckets[b]; n; n = n->next)
+      iter_func(n->key, n->val, arg);
+  }
+}
+
@@ -0,0 +1,69 @@
+/*******************************************************************************
+module:   strmap
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  hash map from c-string keys (e.g., file paths) to arbitrary values
+*******************************************************************************/
+
+#ifndef STRMAP_H
+#define STRMAP_H 1
+
+// allow this header to be included from c++ source file
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*******************************************************************************
+ * SYSTEM INCLUDES
+ ******************************************************************************/
+
+#include <stdbool.h>    // ISOC: bool
+#include <stddef.h>     // ISOC: size_t
+
+/*******************************************************************************
+ * PUBLIC TYPES / CONSTANTS / VARIABLES
+ ******************************************************************************/
+
+// opaque map type (NOT threadsafe: callers must lock around shared maps)
+typedef struct StrMap StrMap;
+
+// called on each value in strmap_free() and strmap_foreach()
+typedef void (*StrMapValFunc) (void* val);
+typedef void (*StrMapIterFunc) (const char* key, void* val, void* arg);
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+// return a new empty map
+StrMap* strmap_new (void);
+
+// free map and its (copied) keys, calling free_val on each value if non-NULL
+void strmap_free (StrMap* map, StrMapValFunc free_val);
+
+// map key (copied) to val, return previous val of key (or NULL if none)
+void* strmap_put (StrMap* map, const char* key, void* val);
+
+// return val of key, or NULL if key is not in map
+void* strmap_get (const StrMap* map, const char* key);
+
+// return true if key is in map (even if its val is NULL)
+bool strmap_contains (const StrMap* map, const char* key);
+
+// remove key from map, and return its val (or NULL if key not in map)
+void* strmap_remove (StrMap* map, const char* key);
+
+// return num keys in map
+size_t strmap_size (const StrMap* map);
+
+// call iter_func on every key/val in map (in no particular order)
+// NOTE iter_func must not add/remove keys
+void strmap_foreach (const StrMap* map, StrMapIterFunc iter_func, void* arg);
+
+// allow this header to be included from c++ source file
+#ifdef __cplusplus
+}
+#endif
+
+#endif // STRMAP_H
+
@@ -12,7 +12,10 @@ purpose:  various c-string utility functions
 #include <stddef.h>     // ISOC: NULL
 #include <stdbool.h>    // ISOC: bool, true, false
 #include <string.h>     // ISOC: strlen()
-#include <ctype.h>      // ISOC: isspace()
+#include <ctype.h>      // ISOC: isspace(), isdigit(), toupper()
+#include <stdlib.h>     // ISOC: strtoll()
+#include <limits.h>     // ISOC: LLONG_MAX
+#include <stdio.h>      // ISOC: FILE, fputc(), fprintf()
 
 /*******************************************************************************
  * USER INCLUDES
@@ -65,3 +68,55 @@ bool str_endswith (const char* str, const char* ending_substr) {
   return ( strncmp(str + (len_str - len_es), ending_substr, len_es) == 0 );
 }
 
+// parse a size like "512", "64K", "10M", "2G" (1024-based) into num bytes,
+// return -1 if str is not a valid size
+long long str_to_bytes (const char* str) {
+  char* end = NULL;
+
+  if (!isdigit((unsigned char)*str)) {
+    return -1;
+  }
+
+  long long num = strtoll(str, &end, 10);
+  if (end == str) {
+    return -1;
+  }
+
+  int shift = 0;
+  switch (toupper((unsigned char)*end)) {
+    case 'T': shift = 40; end++; break;
+    case 'G': shift = 30; end++; break;
+    case 'M': shift = 20; end++; break;
+    case 'K': shift = 10; end++; break;
+  }
+
+  // allow "10MB", "10M", "10 " but nothing else trailing
+  if (shift && toupper((unsigned char)*end) == 'B') {
+    end++;
+  }
+  if (str_find_stripped_end(end) != end) {
+    return -1;
+  }
+
+  if (num > (LLONG_MAX >> shift)) {
+    return -1;
+  }
+
+  return num << shift;
+}
+
+// print str as an escaped json string (with quotes) to f ("" if str is NULL)
+void str_print_json (FILE* f, const char* str) {
+  fputc('"', f);
+  for (; str && *str; str++) {
+    const unsigned char c = (unsigned char)*str;
+    if (c == '"' || c == '\\') {
+      fprintf(f, "\\%c", c);
+    } else if (c < 0x20) {
+      fprintf(f, "\\u%04x", c);
+    } else {
+      fputc(c, f);
+    }
+  }
+  fputc('"', f);
+}
@@ -18,6 +18,7 @@ extern "C" {
  ******************************************************************************/
 
 #include <stdbool.h>    // ISOC: bool
+#include <stdio.h>      // ISOC: FILE
 
 /*******************************************************************************
  * PUBLIC FUNCTIONS
@@ -35,6 +36,13 @@ bool str_startswith (const char* str, const char* starting_substr);
 // return true if str ends with ending_substr
 bool str_endswith (const char* str, const char* ending_substr);
 
+// parse a size like "512", "64K", "10M", "2G" (1024-based) into num bytes,
+// return -1 if str is not a valid size
+long long str_to_bytes (const char* str);
+
+// print str as an escaped json string (with quotes) to f ("" if str is NULL)
+void str_print_json (FILE* f, const char* str);
+
 // allow this header to be included from c++ source file
 #ifdef __cplusplus
 }
@@ -346,6 +346,14 @@ qual_syscall(const char *s, int bitflag, int not)
 	return rc;
 }
 
+/* digimokan: also trace syscall s (qualify("trace=s") would replace the
+   traced set), return -1 (tracing nothing more) if this arch has no s */
+int
+qualify_syscall_if_known(const char *s)
+{
+	return qual_syscall(s, QUAL_TRACE, 0);
+}
+
 static int
 qual_signal(const char *s, int bitflag, int not)
 {
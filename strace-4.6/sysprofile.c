@@ -0,0 +1,240 @@
+/*******************************************************************************
+module:   sysprofile
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  per-syscall profile of tracer overhead: num stops, time the tracee
+          spent in each syscall, time spent in our entry/exit hooks, and num
+          bytes read from / written to child memory while handling it
+*******************************************************************************/
+
+/*******************************************************************************
+ * SYSTEM INCLUDES
+ ******************************************************************************/
+
+#include <stdlib.h>     // ISOC: realloc(), free(), qsort()
+#include <string.h>     // ISOC: memset(), strcmp()
+#include <time.h>       // P2001: clock_gettime()
+
+/*******************************************************************************
+ * USER INCLUDES
+ ******************************************************************************/
+
+#include "sysprofile.h"
+
+/*******************************************************************************
+ * PUBLIC VARIABLES
+ ******************************************************************************/
+
+bool Sysprofile_mode = false;
+
+/*******************************************************************************
+ * PRIVATE TYPES / CONSTANTS / VARIABLES
+ ******************************************************************************/
+
+#define NSEC_PER_SEC 1000000000.0
+
+// use the raw hw clock if available: it is not slewed by ntp adjustments
+#ifdef CLOCK_MONOTONIC_RAW
+#  define SYSPROFILE_CLOCK CLOCK_MONOTONIC_RAW
+#else
+#  define SYSPROFILE_CLOCK CLOCK_MONOTONIC
+#endif
+
+// counted during the stop currently handled by a thread (only the tracing
+// thread records stops, other threads' counts are simply never recorded)
+typedef struct {
+  uint64_t prov_write_ns;
+  long long child_bytes_read;
+  long long child_bytes_written;
+} PendingCounts;
+
+static SysProfileFormat report_format = SYSPROFILE_TABLE;
+static __thread PendingCounts pending;
+
+static SysProfileRow* rows = NULL;    // indexed by syscall number
+static long num_rows = 0;
+
+/*******************************************************************************
+ * PRIVATE MACROS / FUNCTIONS
+ ******************************************************************************/
+
+static inline uint64_t handler_ns (const SysProfileRow* row) {
+  return row->entry_handler_ns + row->exit_handler_ns;
+}
+
+// most time in our hooks first, then most stops, then by name
+static int compare_rows (const void* a, const void* b) {
+  const SysProfileRow* ra = *(const SysProfileRow* const*)a;
+  const SysProfileRow* rb = *(const SysProfileRow* const*)b;
+  const uint64_t ha = handler_ns(ra);
+  const uint64_t hb = handler_ns(rb);
+  const long long sa = ra->entry_stops + ra->exit_stops;
+  const long long sb = rb->entry_stops + rb->exit_stops;
+
+  if (ha != hb) {
+    return (ha > hb) ? -1 : 1;
+  }
+  if (sa != sb) {
+    return (sa > sb) ? -1 : 1;
+  }
+  return strcmp(ra->name, rb->name);
+}
+
+// return recorded rows, sorted by compare_rows (caller frees list)
+static const SysProfileRow** sorted_rows (int* num_sorted) {
+  const SysProfileRow** list = (const SysProfileRow**)malloc((num_rows + 1) * sizeof(SysProfileRow*));
+  int n = 0;
+  for (long i = 0; i < num_rows; i++) {
+    if (rows[i].name) {
+      list[n++] = &rows[i];
+    }
+  }
+  qsort(list, n, sizeof(SysProfileRow*), compare_rows);
+  *num_sorted = n;
+  return list;
+}
+
+static void print_table (FILE* f, const SysProfileRow** list, int n) {
+  fprintf(f, "ptu syscall profile (seconds; blocked = tracee time between entry and exit stops):\n");
+  fprintf(f, "%-20s %10s %12s %12s %12s %12s %14s %14s\n",
+          "syscall", "stops", "blocked", "entry hooks", "exit hooks",
+          "prov writes", "child read", "child written");
+  for (int i = 0; i < n; i++) {
+    const SysProfileRow* r = list[i];
+    fprintf(f, "%-20s %10lld %12.6f %12.6f %12.6f %12.6f %14lld %14lld\n",
+            r->name, r->entry_stops + r->exit_stops,
+            r->blocked_ns / NSEC_PER_SEC, r->entry_handler_ns / NSEC_PER_SEC,
+            r->exit_handler_ns / NSEC_PER_SEC, r->prov_write_ns / NSEC_PER_SEC,
+            r->child_bytes_read, r->child_bytes_written);
+  }
+}
+
+static void print_json (FILE* f, const SysProfileRow** list, int n) {
+  fprintf(f, "{\"syscalls\": [");
+  for (int i = 0; i < n; i++) {
+    const SysProfileRow* r = list[i];
+    fprintf(f, "%s\n  {\"name\": \"%s\", \"scno\": %ld, "
+               "\"entry_stops\": %lld, \"exit_stops\": %lld, "
+               "\"blocked_sec\": %.9f, \"entry_handler_sec\": %.9f, "
+               "\"exit_handler_sec\": %.9f, \"prov_write_sec\": %.9f, "
+               "\"child_bytes_read\": %lld, \"child_bytes_written\": %lld}",
+            (i == 0) ? "" : ",", r->name, (long)(r - rows),
+            r->entry_stops, r->exit_stops,
+            r->blocked_ns / NSEC_PER_SEC, r->entry_handler_ns / NSEC_PER_SEC,
+            r->exit_handler_ns / NSEC_PER_SEC, r->prov_write_ns / NSEC_PER_SEC,
+            r->child_bytes_read, r->child_bytes_written);
+  }
+  fprintf(f, "\n]}\n");
+}
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+void sysprofile_enable (SysProfileFormat fmt) {
+  report_format = fmt;
+  Sysprofile_mode = true;
+}
+
+SysProfileFormat sysprofile_format (void) {
+  return report_format;
+}
+
+int sysprofile_parse_format (const char* name, SysProfileFormat* fmt) {
+  if (strcmp(name, "table") == 0) {
+    *fmt = SYSPROFILE_TABLE;
+  }
+  else if (strcmp(name, "json") == 0) {
+    *fmt = SYSPROFILE_JSON;
+  }
+  else {
+    return -1;
+  }
+  return 0;
+}
+
+uint64_t sysprofile_now (void) {
+  struct timespec ts;
+  clock_gettime(SYSPROFILE_CLOCK, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+void sysprofile_count_child_read (long nbytes) {
+  pending.child_bytes_read += nbytes;
+}
+
+void sysprofile_count_child_write (long nbytes) {
+  pending.child_bytes_written += nbytes;
+}
+
+void sysprofile_add_prov_time (uint64_t ns) {
+  pending.prov_write_ns += ns;
+}
+
+void sysprofile_record_stop (long scno, const char* name, bool entering,
+                             uint64_t handler_ns, uint64_t blocked_ns) {
+  if (scno < 0) {
+    sysprofile_discard_stop();
+    return;
+  }
+
+  // grow rows to fit scno (syscall numbers are small and dense)
+  if (scno >= num_rows) {
+    long new_num_rows = (num_rows == 0) ? 512 : num_rows;
+    while (new_num_rows <= scno) {
+      new_num_rows *= 2;
+    }
+    rows = (SysProfileRow*)realloc(rows, new_num_rows * sizeof(SysProfileRow));
+    memset(rows + num_rows, 0, (new_num_rows - num_rows) * sizeof(SysProfileRow));
+    num_rows = new_num_rows;
+  }
+
+  SysProfileRow* r = &rows[scno];
+  r->name = name;
+  if (entering) {
+    r->entry_stops++;
+    r->entry_handler_ns += handler_ns;
+  }
+  else {
+    r->exit_stops++;
+    r->exit_handler_ns += handler_ns;
+  }
+  r->blocked_ns += blocked_ns;
+  r->prov_write_ns += pending.prov_write_ns;
+  r->child_bytes_read += pending.child_bytes_read;
+  r->child_bytes_written += pending.child_bytes_written;
+
+  sysprofile_discard_stop();
+}
+
+void sysprofile_discard_stop (void) {
+  memset(&pending, 0, sizeof(pending));
+}
+
+const SysProfileRow* sysprofile_row (long scno) {
+  if (scno < 0 || scno >= num_rows || !rows[scno].name) {
+    return NULL;
+  }
+  return &rows[scno];
+}
+
+void print_sysprofile (FILE* f, SysProfileFormat fmt) {
+  int n = 0;
+  const SysProfileRow** list = sorted_rows(&n);
+
+  if (fmt == SYSPROFILE_JSON) {
+    print_json(f, list, n);
+  }
+  else {
+    print_table(f, list, n);
+  }
+
+  free(list);
+}
+
+void sysprofile_reset (void) {
+  free(rows);
+  rows = NULL;
+  num_rows = 0;
+  sysprofile_discard_stop();
+}
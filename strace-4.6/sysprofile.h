@@ -0,0 +1,96 @@
+/*******************************************************************************
+module:   sysprofile
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  per-syscall profile of tracer overhead: num stops, time the tracee
+          spent in each syscall, time spent in our entry/exit hooks, and num
+          bytes read from / written to child memory while handling it
+*******************************************************************************/
+
+#ifndef SYSPROFILE_H
+#define SYSPROFILE_H 1
+
+// allow this header to be included from c++ source file
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*******************************************************************************
+ * SYSTEM INCLUDES
+ ******************************************************************************/
+
+#include <stdbool.h>    // ISOC: bool
+#include <stdint.h>     // ISOC: uint64_t
+#include <stdio.h>      // ISOC: FILE
+
+/*******************************************************************************
+ * PUBLIC TYPES / CONSTANTS / VARIABLES
+ ******************************************************************************/
+
+// output formats of the profile report
+typedef enum {
+  SYSPROFILE_TABLE,
+  SYSPROFILE_JSON
+} SysProfileFormat;
+
+// accumulated profile of one syscall number
+typedef struct {
+  const char* name;               // syscall name (NULL if never recorded)
+  long long entry_stops;          // num syscall-entry stops handled
+  long long exit_stops;           // num syscall-exit stops handled
+  uint64_t blocked_ns;            // time tracee spent between entry and exit stops
+  uint64_t entry_handler_ns;      // time in our syscall-entry hooks (e.g., CDE_begin_*)
+  uint64_t exit_handler_ns;       // time in our syscall-exit hooks (e.g., CDE_end_*, provenance)
+  uint64_t prov_write_ns;         // part of handler time spent writing provenance records
+  long long child_bytes_read;     // num bytes read from child memory
+  long long child_bytes_written;  // num bytes written to child memory
+} SysProfileRow;
+
+// true if syscall profiling is enabled (set by sysprofile_enable())
+extern bool Sysprofile_mode;
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+// enable syscall profiling, and (at exit) reporting in fmt
+void sysprofile_enable (SysProfileFormat fmt);
+
+// return format set by sysprofile_enable()
+SysProfileFormat sysprofile_format (void);
+
+// parse format name ("table" or "json") into fmt, return 0 on success
+int sysprofile_parse_format (const char* name, SysProfileFormat* fmt);
+
+// return current time of the profile clock in nanosec
+uint64_t sysprofile_now (void);
+
+// count bytes read from / written to child memory, and time spent writing
+// provenance, during the stop being handled by the calling thread
+void sysprofile_count_child_read (long nbytes);
+void sysprofile_count_child_write (long nbytes);
+void sysprofile_add_prov_time (uint64_t ns);
+
+// add one handled stop of syscall scno (named name) to its row, along with
+// the bytes and provenance time counted during it
+void sysprofile_record_stop (long scno, const char* name, bool entering,
+                             uint64_t handler_ns, uint64_t blocked_ns);
+
+// forget bytes and provenance time counted during a stop that failed
+void sysprofile_discard_stop (void);
+
+// return recorded row of syscall scno, or NULL if none
+const SysProfileRow* sysprofile_row (long scno);
+
+// print rows of all recorded syscalls (most expensive first) to f
+void print_sysprofile (FILE* f, SysProfileFormat fmt);
+
+// forget all recorded rows
+void sysprofile_reset (void);
+
+// allow this header to be included from c++ source file
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SYSPROFILE_H
@@ -0,0 +1,93 @@
+/*******************************************************************************
+module:   trie
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  super-simple trie for fast (ASCII) string matching, moved out of
+          cde.c (adapted by pgbovine from his earlier IncPy project)
+*******************************************************************************/
+
+/*******************************************************************************
+ * SYSTEM INCLUDES
+ ******************************************************************************/
+
+#include <assert.h>     // ISOC: assert()
+#include <stdlib.h>     // ISOC: calloc(), free()
+
+/*******************************************************************************
+ * USER INCLUDES
+ ******************************************************************************/
+
+#include "trie.h"
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+Trie* TrieNew (void) {
+  // VERY important to blank out the contents with a calloc()
+  return (Trie*)calloc(1, sizeof(Trie));
+}
+
+void TrieInsert (Trie* t, char* ascii_string) {
+  TrieInsertValue(t, ascii_string, 0);
+}
+
+void TrieInsertValue (Trie* t, char* ascii_string, int value) {
+  while (*ascii_string != '\0') {
+    unsigned char idx = (unsigned char)*ascii_string;
+    assert(idx < 128); // we don't support extended ASCII characters
+    if (!t->children[idx]) {
+      t->children[idx] = TrieNew();
+    }
+    t = t->children[idx];
+    ascii_string++;
+  }
+
+  t->elt_is_present = 1;
+  t->value = value;
+}
+
+int TrieContains (Trie* t, char* ascii_string) {
+  while (*ascii_string != '\0') {
+    unsigned char idx = (unsigned char)*ascii_string;
+    // extended ASCII characters are never inserted, so can't match
+    if (idx >= 128) {
+      return 0;
+    }
+    t = t->children[idx];
+    if (!t) {
+      return 0; // early termination, no match!
+    }
+    ascii_string++;
+  }
+
+  return t->elt_is_present;
+}
+
+int TrieLongestPrefix (Trie* t, const char* ascii_string, int* value) {
+  int longest = -1;
+  for (int len = 0; t; len++) {
+    if (t->elt_is_present) {
+      longest = len;
+      *value = t->value;
+    }
+    unsigned char idx = (unsigned char)ascii_string[len];
+    // extended ASCII characters are never inserted, so can't match
+    if (idx == '\0' || idx >= 128) {
+      break;
+    }
+    t = t->children[idx];
+  }
+
+  return longest;
+}
+
+void TrieDelete (Trie* t) {
+  if (!t) {
+    return;
+  }
+  for (int i = 0; i < 128; i++) {
+    TrieDelete(t->children[i]);
+  }
+  free(t);
+}
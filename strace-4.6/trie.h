@@ -0,0 +1,57 @@
+/*******************************************************************************
+module:   trie
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  super-simple trie for fast (ASCII) string matching, moved out of
+          cde.c (adapted by pgbovine from his earlier IncPy project)
+notes:    - strings may be inserted with a value, to find the value of the
+            longest inserted prefix of a string (e.g., the root a path is in)
+*******************************************************************************/
+
+#ifndef TRIE_H
+#define TRIE_H 1
+
+// allow this header to be included from c++ source file
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*******************************************************************************
+ * PUBLIC TYPES / CONSTANTS / VARIABLES
+ ******************************************************************************/
+
+typedef struct _trie {
+  struct _trie* children[128]; // we support ASCII characters from 0 to 127
+  int elt_is_present; // 1 if there is an element present here
+  int value; // value of the element present here (0 if inserted without one)
+} Trie;
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+// return new empty trie
+Trie* TrieNew (void);
+
+// insert ascii_string into t
+void TrieInsert (Trie* t, char* ascii_string);
+
+// insert ascii_string into t, with value
+void TrieInsertValue (Trie* t, char* ascii_string, int value);
+
+// return 1 if ascii_string was inserted into t, else 0
+int TrieContains (Trie* t, char* ascii_string);
+
+// return length of the longest string inserted into t that is a prefix of
+// ascii_string (and set *value to its value), or -1 if none is
+int TrieLongestPrefix (Trie* t, const char* ascii_string, int* value);
+
+// free t and all of its children
+void TrieDelete (Trie* t);
+
+// allow this header to be included from c++ source file
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TRIE_H
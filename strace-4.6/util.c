@@ -34,6 +34,8 @@
  */
 
 #include "defs.h"
+#include "perftimers.h"   // start_perf_timer(), stop_perf_timer(), count_perf_event()
+#include "sysprofile.h"   // Sysprofile_mode, sysprofile_count_child_read()
 
 #include <signal.h>
 #include <sys/syscall.h>
@@ -237,6 +239,17 @@ ptrace_restart(int op, struct tcb *tcp, int sig)
 	return -1;
 }
 
+/*
+ * digimokan: restart tcp to its next syscall stop, or (if an ignore_process
+ * runs it untraced) to its next signal, fork, or exit only.
+ */
+int
+ptrace_resume(struct tcb *tcp, int sig)
+{
+	return ptrace_restart(tcp->untraced ? PTRACE_CONT : PTRACE_SYSCALL,
+			      tcp, sig);
+}
+
 /*
  * Print entry in struct xlat table, if there.
  */
@@ -763,8 +776,8 @@ int len;
  * move `len' bytes of data from process `pid'
  * at address `addr' to our space at `laddr'
  */
-int
-umoven(struct tcb *tcp, long addr, int len, char *laddr)
+static int
+do_umoven(struct tcb *tcp, long addr, int len, char *laddr)
 {
 #ifdef LINUX
 	int pid = tcp->pid;
@@ -852,8 +865,8 @@ umoven(struct tcb *tcp, long addr, int len, char *laddr)
  * like `umove' but make the additional effort of looking
  * for a terminating zero byte.
  */
-int
-umovestr(struct tcb *tcp, long addr, int len, char *laddr)
+static int
+do_umovestr(struct tcb *tcp, long addr, int len, char *laddr)
 {
 #ifdef USE_PROCFS
 #ifdef HAVE_MP_PROCFS
@@ -939,6 +952,31 @@ umovestr(struct tcb *tcp, long addr, int len, char *laddr)
 	return 0;
 }
 
+/* digimokan: time (and profile) all reads of child memory */
+int
+umoven(struct tcb *tcp, long addr, int len, char *laddr)
+{
+	count_perf_event(CHILD_MEMORY_READ_CALLS, 1);
+	start_perf_timer(CHILD_MEMORY_READS);
+	int ret = do_umoven(tcp, addr, len, laddr);
+	stop_perf_timer(CHILD_MEMORY_READS);
+	if (Sysprofile_mode && ret == 0)
+		sysprofile_count_child_read(len);
+	return ret;
+}
+
+int
+umovestr(struct tcb *tcp, long addr, int len, char *laddr)
+{
+	count_perf_event(CHILD_MEMORY_READ_CALLS, 1);
+	start_perf_timer(CHILD_MEMORY_READS);
+	int ret = do_umovestr(tcp, addr, len, laddr);
+	stop_perf_timer(CHILD_MEMORY_READS);
+	if (Sysprofile_mode && ret == 0)
+		sysprofile_count_child_read(strnlen(laddr, len));
+	return ret;
+}
+
 #ifdef LINUX
 # if !defined (SPARC) && !defined(SPARC64)
 #  define PTRACE_WRITETEXT	101
@@ -0,0 +1,76 @@
+/*******************************************************************************
+module:   benchchild
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  fixtures for benchmarking work done against a traced child (defs.h
+          cannot be included from c++ source files, so tcbs are built in c)
+*******************************************************************************/
+
+/*******************************************************************************
+ * SYSTEM INCLUDES
+ ******************************************************************************/
+
+#include <signal.h>     // ISOC: raise(), kill(), SIGSTOP, SIGKILL
+#include <stdlib.h>     // ISOC: calloc(), free(), setenv()
+#include <string.h>     // ISOC: strncpy()
+#include <sys/param.h>  // LINUX: MAXPATHLEN
+#include <sys/ptrace.h> // LINUX: ptrace()
+#include <sys/wait.h>   // POSIX: waitpid()
+#include <unistd.h>     // POSIX: fork(), getpid(), _exit()
+
+/*******************************************************************************
+ * USER INCLUDES
+ ******************************************************************************/
+
+#include "benchchild.h"
+#include "defs.h"           // struct tcb, CDE_ROOT_NAME
+#include "provenance.h"     // init_prov(), Prov_prov_mode
+
+extern char Cde_app_dir[];  // from cde.c
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+pid_t bench_fork_traced_child (void) {
+  const pid_t pid = fork();
+  if (pid == 0) {
+    ptrace(PTRACE_TRACEME, 0, NULL, NULL);
+    raise(SIGSTOP);
+    _exit(0);
+  }
+  if (pid > 0) {
+    waitpid(pid, NULL, 0);
+  }
+  return pid;
+}
+
+void bench_kill_traced_child (pid_t pid) {
+  kill(pid, SIGKILL);
+  waitpid(pid, NULL, 0);
+}
+
+struct tcb* bench_new_child_tcb (pid_t pid, long path_addr, char* current_dir) {
+  struct tcb* parent = calloc(1, sizeof(struct tcb));
+  struct tcb* tcp = calloc(1, sizeof(struct tcb));
+  parent->pid = getpid();
+  tcp->pid = pid;
+  tcp->parent = parent;
+  tcp->current_dir = current_dir;
+  tcp->u_arg[0] = path_addr;
+  tcp->u_rval = 0;
+  return tcp;
+}
+
+void bench_free_child_tcb (struct tcb* tcp) {
+  free(tcp->parent);
+  free(tcp);
+}
+
+bool bench_init_prov (const char* dir) {
+  strncpy(Cde_app_dir, dir, MAXPATHLEN - 1);
+  CDE_ROOT_NAME = "bench";
+  setenv("IN_CDE_PROVENANCE_MODE", "1", 1);
+  init_prov();
+  return Prov_prov_mode;
+}
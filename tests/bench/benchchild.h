@@ -0,0 +1,60 @@
+/*******************************************************************************
+module:   benchchild
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  fixtures for benchmarking work done against a traced child (defs.h
+          cannot be included from c++ source files, so tcbs are built in c)
+*******************************************************************************/
+
+#ifndef BENCHCHILD_H
+#define BENCHCHILD_H 1
+
+// allow this header to be included from c++ source file
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*******************************************************************************
+ * SYSTEM INCLUDES
+ ******************************************************************************/
+
+#include <stdbool.h>    // ISOC: bool
+#include <sys/types.h>  // POSIX: pid_t
+
+/*******************************************************************************
+ * PUBLIC TYPES / CONSTANTS / VARIABLES
+ ******************************************************************************/
+
+struct tcb;
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+// fork a child that stops itself under ptrace, and return its pid
+pid_t bench_fork_traced_child (void);
+
+// kill and reap a child forked by bench_fork_traced_child()
+void bench_kill_traced_child (pid_t pid);
+
+// return new tcb of child pid (spawned by this process) in current_dir, as at
+// the exit of a successful syscall whose first arg is path_addr (caller frees)
+struct tcb* bench_new_child_tcb (pid_t pid, long path_addr, char* current_dir);
+
+// free tcb returned by bench_new_child_tcb()
+void bench_free_child_tcb (struct tcb* tcp);
+
+// start writing provenance records to a new log file in dir, return true if ok
+bool bench_init_prov (const char* dir);
+
+// from defs.h / provenance.h
+int umovestr (struct tcb* tcp, long addr, int len, char* laddr);
+void print_spawn_prov (struct tcb* tcp);
+void print_read_prov (struct tcb* tcp, const char* syscall_name, const int path_index);
+
+// allow this header to be included from c++ source file
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BENCHCHILD_H
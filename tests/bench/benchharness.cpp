@@ -0,0 +1,56 @@
+/*******************************************************************************
+module:   benchharness
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  main of the "ptubench" microbenchmark executable: runs all benchmark
+          test cases with doctest, writing results to stdout or to the file
+          given by --bench-out=<file> (all other args are passed to doctest)
+*******************************************************************************/
+
+/*******************************************************************************
+ * DOCTEST MAIN ON/OFF SWITCH
+ ******************************************************************************/
+
+// supply our own main (to handle --bench-out) instead of doctest's
+#define DOCTEST_CONFIG_IMPLEMENT
+
+/*******************************************************************************
+ * DOCTEST SINGLE-HEADER LIB (MUST GO LAST)
+ ******************************************************************************/
+
+#include "doctest.h"
+
+#include <cstdio>       // ISOC: fopen(), fclose(), fprintf()
+#include <cstring>      // ISOC: strncmp(), strlen()
+#include <vector>       // ISOC++: std::vector
+
+#include "benchutils.h"
+
+FILE* bench_out = stdout;
+
+int main (int argc, char** argv) {
+  const char* out_opt = "--bench-out=";
+  std::vector<char*> doctest_args;
+
+  for (int i = 0; i < argc; i++) {
+    if (strncmp(argv[i], out_opt, strlen(out_opt)) == 0) {
+      bench_out = fopen(argv[i] + strlen(out_opt), "w");
+      if (!bench_out) {
+        fprintf(stderr, "ptubench: cannot write '%s'\n", argv[i] + strlen(out_opt));
+        return 1;
+      }
+    }
+    else {
+      doctest_args.push_back(argv[i]);
+    }
+  }
+
+  doctest::Context context;
+  context.applyCommandLine((int)doctest_args.size(), doctest_args.data());
+  const int res = context.run();
+
+  if (bench_out != stdout) {
+    fclose(bench_out);
+  }
+  return res;
+}
@@ -0,0 +1,88 @@
+/*******************************************************************************
+module:   benchutils
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  time microbenchmarks of ptu components, and write their results as
+          json lines (one object per benchmark) to the --bench-out file
+*******************************************************************************/
+
+#ifndef BENCHUTILS_H
+#define BENCHUTILS_H 1
+
+/*******************************************************************************
+ * SYSTEM INCLUDES
+ ******************************************************************************/
+
+#include <algorithm>    // ISOC++: std::sort()
+#include <cstdio>       // ISOC: FILE, fprintf(), fflush()
+#include <ctime>        // P2001: clock_gettime()
+#include <vector>       // ISOC++: std::vector
+
+/*******************************************************************************
+ * PUBLIC TYPES / CONSTANTS / VARIABLES
+ ******************************************************************************/
+
+// where results are written (set by benchharness main)
+extern FILE* bench_out;
+
+// min run time of one timed batch of iterations (nanosec)
+#define BENCH_MIN_BATCH_NS 20000000LL
+
+// num timed batches per benchmark (min and median are reported)
+#define BENCH_NUM_BATCHES 5
+
+/*******************************************************************************
+ * PUBLIC MACROS / FUNCTIONS
+ ******************************************************************************/
+
+// return current time in nanosec
+static inline long long bench_now_ns () {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+  return ((long long)ts.tv_sec * 1000000000LL) + ts.tv_nsec;
+}
+
+// return time (nanosec) of running op iters times
+template <typename Op>
+static long long bench_time_batch (Op& op, long long iters) {
+  const long long start = bench_now_ns();
+  for (long long i = 0; i < iters; i++) {
+    op();
+  }
+  return bench_now_ns() - start;
+}
+
+// run op in batches sized to take BENCH_MIN_BATCH_NS, and write its name,
+// iterations per batch, min and median nanosec per op, and (if bytes_per_op is
+// given) throughput in MiB/s to bench_out; return min nanosec per op
+template <typename Op>
+static double run_benchmark (const char* name, Op op, long long bytes_per_op = 0) {
+  // warm up, then double num iterations until one batch takes long enough
+  long long iters = 1;
+  bench_time_batch(op, iters);
+  while (bench_time_batch(op, iters) < BENCH_MIN_BATCH_NS) {
+    iters *= 2;
+  }
+
+  std::vector<double> ns_per_op;
+  for (int i = 0; i < BENCH_NUM_BATCHES; i++) {
+    ns_per_op.push_back((double)bench_time_batch(op, iters) / iters);
+  }
+  std::sort(ns_per_op.begin(), ns_per_op.end());
+  const double min_ns = ns_per_op.front();
+  const double median_ns = ns_per_op[BENCH_NUM_BATCHES / 2];
+
+  fprintf(bench_out, "{\"benchmark\": \"%s\", \"iterations\": %lld, "
+                     "\"ns_per_op_min\": %.1f, \"ns_per_op_median\": %.1f",
+          name, iters, min_ns, median_ns);
+  if (bytes_per_op > 0) {
+    fprintf(bench_out, ", \"mib_per_sec\": %.1f",
+            (bytes_per_op / (1024.0 * 1024.0)) / (min_ns / 1e9));
+  }
+  fprintf(bench_out, "}\n");
+  fflush(bench_out);
+
+  return min_ns;
+}
+
+#endif // BENCHUTILS_H
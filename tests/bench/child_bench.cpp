@@ -0,0 +1,63 @@
+/*******************************************************************************
+module:   child_bench
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  microbenchmarks of work done against a traced child: reading strings
+          from child memory, and formatting/writing provenance records
+*******************************************************************************/
+
+#include "doctest.h"
+#include "benchutils.h"
+#include "benchchild.h"
+
+#include <climits>      // ISOC: PATH_MAX
+#include <cstdlib>      // ISOC: mkdtemp()
+#include <cstring>      // ISOC: strcmp()
+#include <unistd.h>     // POSIX: getcwd()
+
+// same address in the child after fork
+static char child_path[] = "/usr/lib/x86_64-linux-gnu/libstdc++.so.6.0.28";
+
+TEST_CASE("bench umovestr") {
+
+  const pid_t pid = bench_fork_traced_child();
+  REQUIRE(pid > 0);
+  struct tcb* tcp = bench_new_child_tcb(pid, (long)child_path, NULL);
+
+  char buf[PATH_MAX];
+  CHECK(umovestr(tcp, (long)child_path, sizeof(buf), buf) >= 0);
+  CHECK(strcmp(buf, child_path) == 0);
+
+  run_benchmark("umovestr/path", [&] {
+    umovestr(tcp, (long)child_path, sizeof(buf), buf);
+  }, sizeof(child_path));
+
+  bench_free_child_tcb(tcp);
+  bench_kill_traced_child(pid);
+
+}
+
+TEST_CASE("bench provenance records") {
+
+  char dir[] = "/tmp/ptubench.XXXXXX";
+  REQUIRE(mkdtemp(dir) != NULL);
+  REQUIRE(bench_init_prov(dir));
+
+  const pid_t pid = bench_fork_traced_child();
+  REQUIRE(pid > 0);
+  char cwd[PATH_MAX];
+  REQUIRE(getcwd(cwd, sizeof(cwd)) != NULL);
+  struct tcb* tcp = bench_new_child_tcb(pid, (long)child_path, cwd);
+
+  run_benchmark("provenance/spawn_record", [&] {
+    print_spawn_prov(tcp);
+  });
+
+  run_benchmark("provenance/read_record", [&] {
+    print_read_prov(tcp, "sys_read", 0);
+  });
+
+  bench_free_child_tcb(tcp);
+  bench_kill_traced_child(pid);
+
+}
@@ -0,0 +1,67 @@
+/*******************************************************************************
+module:   files_bench
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  microbenchmarks of package capture work done per file: copying
+          files into the package, and parsing elf headers for the interpreter
+*******************************************************************************/
+
+#include "doctest.h"
+#include "benchutils.h"
+
+#include <cstdio>       // ISOC: snprintf(), fopen(), fwrite(), fclose()
+#include <cstdlib>      // ISOC: mkdtemp(), free()
+#include <string>       // ISOC++: std::string
+#include <vector>       // ISOC++: std::vector
+#include <unistd.h>     // POSIX: readlink(), unlink(), rmdir()
+
+// okapi.h is a c header without c++ linkage guards
+extern "C" {
+#include "okapi.h"
+}
+
+// from readelf-mini (declared in cde.c)
+extern "C" char* find_ELF_program_interpreter (char* file_name);
+
+TEST_CASE("bench okapi_copy_file") {
+
+  char dir[] = "/tmp/ptubench.XXXXXX";
+  REQUIRE(mkdtemp(dir) != NULL);
+  const std::string src = std::string(dir) + "/src";
+  const std::string dst = std::string(dir) + "/dst";
+
+  const long sizes[] = {4L * 1024, 256L * 1024, 16L * 1024 * 1024};
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    FILE* f = fopen(src.c_str(), "w");
+    REQUIRE(f != NULL);
+    std::vector<char> data(sizes[i], 'x');
+    fwrite(data.data(), 1, data.size(), f);
+    fclose(f);
+
+    char name[64];
+    snprintf(name, sizeof(name), "okapi_copy_file/%ldK", sizes[i] / 1024);
+    run_benchmark(name, [&] {
+      okapi_copy_file((char*)src.c_str(), (char*)dst.c_str(), 0644);
+    }, sizes[i]);
+  }
+
+  unlink(src.c_str());
+  unlink(dst.c_str());
+  rmdir(dir);
+
+}
+
+TEST_CASE("bench find_ELF_program_interpreter") {
+
+  char exe[4096] = {0};
+  REQUIRE(readlink("/proc/self/exe", exe, sizeof(exe) - 1) > 0);
+
+  char* interp = find_ELF_program_interpreter(exe);
+  WARN_MESSAGE(interp != NULL, "ptubench is not dynamically linked");
+  free(interp);
+
+  run_benchmark("find_ELF_program_interpreter/self", [&] {
+    free(find_ELF_program_interpreter(exe));
+  });
+
+}
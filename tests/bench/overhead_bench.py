@@ -0,0 +1,276 @@
+#!/usr/bin/env python3
+
+'''
+module:   overhead_bench
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  end-to-end tracing overhead benchmark: run each workload (scenarios
+          from tests/legacy_pytests, plus synthetic stress workloads) natively,
+          under ptu audit, under ptu -b (provenance only), and under cde-exec
+          (replay of the audited package), and write wall time, tracer cpu,
+          trace stops per sec, bytes copied, and peak rss of each as json
+
+usage:    overhead_bench.py --ptu /path/to/ptu [--out results.json] [--reps N]
+                            [--workload NAME ...] [--mode MODE ...] [--work-dir DIR]
+'''
+
+import argparse
+import json
+import os
+import re
+import shutil
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+
+BENCH_DIR = os.path.dirname(os.path.abspath(__file__))
+REPO_DIR = os.path.dirname(os.path.dirname(BENCH_DIR))
+LEGACY_DIR = os.path.join(REPO_DIR, 'tests', 'legacy_pytests')
+
+MODES = ['native', 'audit', 'replay', 'prov']   # replay runs the audited package
+
+# lines of the ptu -M report (see print_perf_report() in perftimers.c)
+REPORT_LINES = {
+  'trace stops': 'trace_stops',
+  'bytes copied': 'bytes_copied',
+  'files copied': 'files_copied',
+  'provenance records': 'provenance_records',
+  'tracer user cpu': 'tracer_user_cpu_sec',
+  'tracer system cpu': 'tracer_system_cpu_sec',
+  'tracer peak rss (KiB)': 'tracer_peak_rss_kb',
+}
+REPORT_RE = re.compile(r'^  (%s)\s+([0-9.]+)$' % '|'.join(re.escape(k) for k in REPORT_LINES),
+                       re.MULTILINE)
+
+
+def which_python2():
+  for name in ('python2', 'python2.7'):
+    path = shutil.which(name)
+    if path and subprocess.call([path, '-c', 'pass'], stderr=subprocess.DEVNULL) == 0:
+      return path
+  return None
+
+
+def any_python():
+  return which_python2() or sys.executable
+
+
+# ------------------------------------------------------------------------------
+# workloads: name -> (subdir of the work dir to run in, argv, setup function)
+# legacy scenarios run in a copy of tests/legacy_pytests; synthetic ones in
+# dirs created by their setup functions
+# ------------------------------------------------------------------------------
+
+def setup_open_storm(work_dir):
+  d = os.path.join(work_dir, 'open_storm')
+  os.makedirs(d)
+  for i in range(200):
+    with open(os.path.join(d, 'f%d.txt' % i), 'w') as f:
+      f.write('x\n')
+
+
+def setup_deep_walk(work_dir):
+  d = os.path.join(work_dir, 'deep_walk')
+  for top in range(8):
+    level_dir = os.path.join(d, 'tree', 't%d' % top)
+    for depth in range(30):
+      level_dir = os.path.join(level_dir, 'd%02d' % depth)
+      os.makedirs(level_dir)
+      for i in range(4):
+        with open(os.path.join(level_dir, 'f%d' % i), 'w') as f:
+          f.write('%d %d %d\n' % (top, depth, i))
+
+
+def setup_cde_bootstrap(work_dir):
+  d = os.path.join(work_dir, 'cde_bootstrap')
+  os.makedirs(d)
+  for src in ('trie.c', 'pathrules.c', 'strmap.c', 'strutils.c'):
+    shutil.copy(os.path.join(REPO_DIR, 'strace-4.6', src), d)
+    header = os.path.splitext(src)[0] + '.h'
+    shutil.copy(os.path.join(REPO_DIR, 'strace-4.6', header), d)
+
+
+# opens and reads files with a shell builtin, so no process is forked per open
+OPEN_STORM_SH = 'i=0; while [ $i -lt 20000 ]; do read x < f$((i % 200)).txt; i=$((i+1)); done'
+
+FORK_BOMB_SH = 'i=0; while [ $i -lt 256 ]; do /bin/true & i=$((i+1)); done; wait'
+
+DEEP_WALK_SH = 'find tree -type f -exec cat {} + >/dev/null; ls -lR tree >/dev/null'
+
+
+def workloads():
+  py2 = which_python2()
+  cc = shutil.which('cc') or shutil.which('gcc')
+  return {
+    # legacy scenarios (CDE-bootstrap built CDE with itself: we build a few of
+    # ptu's own modules instead, since it needs no configure step)
+    'java_test': ('legacy/java_test', ['java', 'HelloWorld'], None,
+                  shutil.which('java')),
+    'basic_python': ('legacy/basic_python', [py2, 'file_io.py'], None, py2),
+    'script_exe_test_big_argv': ('legacy/script_exe_test_big_argv',
+                                 ['./script_exe_test_big_argv.sh', 'one', 'two', 'three', 'four',
+                                  'five', 'six', 'seven', 'eight', 'nine'], None, True),
+    'CDE-bootstrap': ('cde_bootstrap',
+                      [cc, '-O2', '-c', 'trie.c', 'pathrules.c', 'strmap.c', 'strutils.c'],
+                      setup_cde_bootstrap, cc),
+    'symlink_test': ('legacy/symlink_test', [any_python(), 'symlink.py'], None, True),
+    # synthetic stress workloads
+    'fork_bomb': ('.', ['/bin/sh', '-c', FORK_BOMB_SH], None, True),
+    'open_storm': ('open_storm', ['/bin/sh', '-c', OPEN_STORM_SH], setup_open_storm, True),
+    'deep_walk': ('deep_walk', ['/bin/sh', '-c', DEEP_WALK_SH], setup_deep_walk, True),
+  }
+
+
+# ------------------------------------------------------------------------------
+# running
+# ------------------------------------------------------------------------------
+
+# ptu does not pass on the exit status of the app, so the workload's own exit
+# status is printed, and its stdout compared to that of the native run
+EXIT_STATUS_SH = ['/bin/sh', '-c', '"$@"; echo "exit status $?"', 'sh']
+
+
+def run_once(argv, cwd):
+  '''run argv in cwd, return (exit status, wall sec, rusage, stdout, stderr)'''
+  with tempfile.TemporaryFile() as out, tempfile.TemporaryFile() as err:
+    start = time.monotonic()
+    proc = subprocess.Popen(argv, cwd=cwd, stdin=subprocess.DEVNULL, stdout=out, stderr=err)
+    _, status, rusage = os.wait4(proc.pid, 0)
+    wall = time.monotonic() - start
+    proc.returncode = os.waitstatus_to_exitcode(status)
+    out.seek(0)
+    err.seek(0)
+    return (proc.returncode, wall, rusage,
+            out.read().decode('utf-8', 'replace'), err.read().decode('utf-8', 'replace'))
+
+
+def mode_argv(mode, ptu, argv):
+  if mode == 'native':
+    return EXIT_STATUS_SH + argv
+  if mode == 'audit':
+    return [ptu, '-M'] + EXIT_STATUS_SH + argv
+  if mode == 'prov':
+    return [ptu, '-b', '-M'] + EXIT_STATUS_SH + argv
+  return [None, '-M'] + EXIT_STATUS_SH + argv  # replay: cde-exec of the package, filled in below
+
+
+def bench_mode(name, mode, ptu, run_dir, argv, reps, native_out):
+  '''run workload reps times in mode, return its result (and stdout of last run)'''
+  result = {'workload': name, 'mode': mode}
+  walls, runs = [], []
+
+  for _ in range(reps):
+    cwd = run_dir
+    cmd = mode_argv(mode, ptu, argv)
+    if mode in ('audit', 'prov'):
+      shutil.rmtree(os.path.join(run_dir, 'cde-package'), ignore_errors=True)
+    elif mode == 'replay':
+      pkg = os.path.join(run_dir, 'cde-package')
+      cmd[0] = os.path.join(pkg, 'cde-exec')
+      cwd = os.path.join(pkg, 'cde-root') + run_dir
+      if not os.path.isfile(cmd[0]) or not os.path.isdir(cwd):
+        result['status'] = 'skipped'
+        result['reason'] = 'no audited package to replay'
+        return result, None
+
+    status, wall, rusage, out, err = run_once(cmd, cwd)
+    if status != 0:
+      result['status'] = 'failed'
+      result['reason'] = 'exit status %d: %s' % (status, err.strip()[-200:])
+      return result, out
+    if native_out is not None and out != native_out:
+      result['status'] = 'failed'
+      result['reason'] = 'output differs from native run: %s' % out.strip()[-200:]
+      return result, out
+    walls.append(wall)
+    report = {REPORT_LINES[k]: float(v) for k, v in REPORT_RE.findall(err)}
+    report['peak_rss_kb'] = rusage.ru_maxrss
+    report['total_cpu_sec'] = rusage.ru_utime + rusage.ru_stime
+    runs.append(report)
+
+  # report the run with the median wall time (so its counts match its time)
+  median_run = runs[walls.index(sorted(walls)[len(walls) // 2])]
+  result['status'] = 'ok'
+  result['reps'] = reps
+  result['wall_sec_median'] = statistics.median(walls)
+  result['wall_sec_min'] = min(walls)
+  result['total_cpu_sec'] = median_run['total_cpu_sec']
+  result['peak_rss_kb'] = median_run['peak_rss_kb']
+  if mode != 'native':
+    result['tracer_cpu_sec'] = (median_run.get('tracer_user_cpu_sec', 0.0) +
+                                median_run.get('tracer_system_cpu_sec', 0.0))
+    for key in ('trace_stops', 'bytes_copied', 'files_copied', 'provenance_records',
+                'tracer_peak_rss_kb'):
+      result[key] = int(median_run.get(key, 0))
+    result['stops_per_sec'] = result['trace_stops'] / result['wall_sec_median']
+  return result, out
+
+
+def main():
+  all_workloads = workloads()
+  parser = argparse.ArgumentParser(description='ptu end-to-end tracing overhead benchmark')
+  parser.add_argument('--ptu', required=True, help='path to ptu executable')
+  parser.add_argument('--out', help='write json results here (default: stdout)')
+  parser.add_argument('--reps', type=int, default=3, help='runs per workload and mode')
+  parser.add_argument('--workload', action='append', choices=sorted(all_workloads),
+                      help='workload to run (default: all)')
+  parser.add_argument('--mode', action='append', choices=MODES,
+                      help='mode to run (default: all)')
+  parser.add_argument('--work-dir', default=os.getcwd(),
+                      help='where to create workload dirs (default: current dir; '
+                           'not /tmp, which cde.options ignores, so it could not be replayed)')
+  args = parser.parse_args()
+  ptu = os.path.abspath(args.ptu)
+  names = args.workload or list(all_workloads)
+  modes = args.mode or MODES
+  if 'replay' in modes and 'audit' not in modes:
+    modes = ['audit'] + modes   # replay needs a package to run
+
+  results = []
+  work_dir = os.path.realpath(tempfile.mkdtemp(prefix='ptu-overhead.', dir=args.work_dir))
+  try:
+    shutil.copytree(LEGACY_DIR, os.path.join(work_dir, 'legacy'), symlinks=True)
+    for name in names:
+      subdir, argv, setup, available = all_workloads[name]
+      if not available:
+        results.append({'workload': name, 'status': 'skipped',
+                        'reason': 'required program not found'})
+        continue
+      if setup:
+        setup(work_dir)
+      run_dir = os.path.normpath(os.path.join(work_dir, subdir))
+      native_wall, native_out = None, None
+      for mode in modes:
+        print('%s: %s' % (name, mode), file=sys.stderr)
+        r, out = bench_mode(name, mode, ptu, run_dir, argv, args.reps, native_out)
+        if mode == 'native' and (r['status'] != 'ok' or not out.endswith('exit status 0\n')):
+          # workload itself is broken on this host
+          r['status'] = 'skipped'
+          r.setdefault('reason', 'native run failed: %s' % out.strip()[-200:])
+          results.append(r)
+          break
+        if r['status'] == 'ok' and mode == 'native':
+          native_wall, native_out = r['wall_sec_median'], out
+        elif r['status'] == 'ok' and native_wall:
+          r['overhead_vs_native'] = r['wall_sec_median'] / native_wall
+        results.append(r)
+  finally:
+    shutil.rmtree(work_dir, ignore_errors=True)
+
+  rev = subprocess.run(['git', '-C', REPO_DIR, 'rev-parse', '--short', 'HEAD'],
+                       stdout=subprocess.PIPE, stderr=subprocess.DEVNULL).stdout.decode().strip()
+  doc = {'ptu': ptu, 'git_rev': rev, 'reps': args.reps, 'results': results}
+  text = json.dumps(doc, indent=2) + '\n'
+  if args.out:
+    with open(args.out, 'w') as f:
+      f.write(text)
+  else:
+    sys.stdout.write(text)
+
+  return 1 if any(r['status'] == 'failed' for r in results) else 0
+
+
+if __name__ == '__main__':
+  sys.exit(main())
@@ -0,0 +1,106 @@
+/*******************************************************************************
+module:   paths_bench
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  microbenchmarks of path handling on the tracer's hot path: path
+          canonicalization, ignore/redirect rule matching, and trie lookups
+*******************************************************************************/
+
+#include "doctest.h"
+#include "benchutils.h"
+
+#include <cstdio>       // ISOC: snprintf()
+#include <cstdlib>      // ISOC: free()
+#include <string>       // ISOC++: std::string
+#include <vector>       // ISOC++: std::vector
+
+// okapi.h is a c header without c++ linkage guards
+extern "C" {
+#include "okapi.h"
+}
+#include "pathrules.h"
+#include "trie.h"
+
+TEST_CASE("bench canonicalize_path") {
+
+  char abs_path[] = "/usr/lib/../lib/./x86_64-linux-gnu//libc.so.6";
+  char rel_path[] = "../../share/./doc/../man/man1/ls.1.gz";
+  char base[] = "/home/user/work/project";
+
+  run_benchmark("canonicalize_path/absolute", [&] {
+    free(canonicalize_path(abs_path, base));
+  });
+
+  run_benchmark("canonicalize_path/relative", [&] {
+    free(canonicalize_path(rel_path, base));
+  });
+
+}
+
+TEST_CASE("bench pathrules_match") {
+
+  static PathRules no_rules;
+  static PathRules full_rules;
+  std::vector<std::string> rule_strs;
+
+  // fill every rule list (the cde.options limit), none matching the path below
+  for (int i = 0; i < MAX_PATH_RULES - 1; i++) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "/opt/ignored/exact/%d", i);
+    rule_strs.push_back(buf);
+    snprintf(buf, sizeof(buf), "/opt/ignored/prefix/%d/", i);
+    rule_strs.push_back(buf);
+    snprintf(buf, sizeof(buf), "/ignored-substr-%d/", i);
+    rule_strs.push_back(buf);
+  }
+  for (int i = 0; i < MAX_PATH_RULES - 1; i++) {
+    full_rules.exact_paths[full_rules.exact_paths_ind++] = (char*)rule_strs[3 * i].c_str();
+    full_rules.prefix_paths[full_rules.prefix_paths_ind++] = (char*)rule_strs[3 * i + 1].c_str();
+    full_rules.substr_paths[full_rules.substr_paths_ind++] = (char*)rule_strs[3 * i + 2].c_str();
+  }
+
+  const char* path = "/usr/lib/x86_64-linux-gnu/libstdc++.so.6.0.28";
+  bool matched = false;
+
+  run_benchmark("pathrules_match/no_rules", [&] {
+    matched ^= pathrules_match(&no_rules, path);
+  });
+
+  run_benchmark("pathrules_match/297_rules_miss", [&] {
+    matched ^= pathrules_match(&full_rules, path);
+  });
+
+  CHECK_FALSE(matched);
+
+}
+
+TEST_CASE("bench Trie") {
+
+  const int num_paths = 10000;
+  std::vector<std::string> paths;
+  for (int i = 0; i < num_paths; i++) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "/usr/lib/pkg%d/lib%d.so", i % 97, i);
+    paths.push_back(buf);
+  }
+
+  Trie* t = TrieNew();
+  int i = 0;
+  run_benchmark("Trie/insert", [&] {
+    TrieInsert(t, (char*)paths[i++ % num_paths].c_str());
+  });
+
+  int found = 0;
+  run_benchmark("Trie/lookup_hit", [&] {
+    found += TrieContains(t, (char*)paths[i++ % num_paths].c_str());
+  });
+  CHECK(found > 0);
+
+  char miss[] = "/usr/lib/pkg12/missing.so";
+  run_benchmark("Trie/lookup_miss", [&] {
+    found += TrieContains(t, miss);
+  });
+
+  TrieDelete(t);
+
+}
@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+
+'''
+module:   startup_bench
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  startup latency benchmark: run a trivial command (true) natively,
+          under ptu audit (into a new package each run), and under cde-exec of
+          the audited package, both cold (no startup snapshot, as on its first
+          run) and warm (startup snapshot saved by an earlier run), and write
+          min, median, and p90 wall time of each as json
+
+usage:    startup_bench.py --ptu /path/to/ptu [--out results.json] [--reps N]
+                           [--mode MODE ...] [--work-dir DIR]
+'''
+
+import argparse
+import glob
+import json
+import os
+import shutil
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+
+BENCH_DIR = os.path.dirname(os.path.abspath(__file__))
+REPO_DIR = os.path.dirname(os.path.dirname(BENCH_DIR))
+
+MODES = ['native', 'audit', 'exec_cold', 'exec_warm']   # exec_* run the audited package
+
+
+def run_once(argv, cwd):
+  '''run argv in cwd, return (exit status, wall sec, stderr)'''
+  with tempfile.TemporaryFile() as err:
+    start = time.monotonic()
+    status = subprocess.call(argv, cwd=cwd, stdin=subprocess.DEVNULL,
+                             stdout=subprocess.DEVNULL, stderr=err)
+    wall = time.monotonic() - start
+    err.seek(0)
+    return status, wall, err.read().decode('utf-8', 'replace')
+
+
+def percentile(values, p):
+  '''nearest-rank percentile p (0-100) of values'''
+  s = sorted(values)
+  return s[max(0, min(len(s) - 1, int(round(p / 100.0 * len(s) + 0.5)) - 1))]
+
+
+def bench_mode(mode, ptu, run_dir, argv, reps):
+  '''run argv reps times in mode (after one untimed run), return its result'''
+  result = {'mode': mode}
+  pkg = os.path.join(run_dir, 'cde-package')
+  walls = []
+
+  for i in range(reps + 1):
+    cwd = run_dir
+    if mode == 'native':
+      cmd = argv
+    elif mode == 'audit':
+      shutil.rmtree(pkg, ignore_errors=True)
+      cmd = [ptu] + argv
+    else:
+      cmd = [os.path.join(pkg, 'cde-exec')] + argv
+      cwd = os.path.join(pkg, 'cde-root') + run_dir
+      if not os.path.isfile(cmd[0]) or not os.path.isdir(cwd):
+        result['status'] = 'skipped'
+        result['reason'] = 'no audited package to run'
+        return result
+      if mode == 'exec_cold':
+        for snap in glob.glob(os.path.join(pkg, 'cde.startup.*')):
+          os.unlink(snap)
+
+    status, wall, err = run_once(cmd, cwd)
+    if status != 0:
+      result['status'] = 'failed'
+      result['reason'] = 'exit status %d: %s' % (status, err.strip()[-200:])
+      return result
+    if i > 0:   # (the first run warms the page cache, and saves the snapshot)
+      walls.append(wall)
+
+  result['status'] = 'ok'
+  result['reps'] = reps
+  result['wall_ms_min'] = min(walls) * 1000.0
+  result['wall_ms_median'] = statistics.median(walls) * 1000.0
+  result['wall_ms_p90'] = percentile(walls, 90) * 1000.0
+  return result
+
+
+def main():
+  parser = argparse.ArgumentParser(description='ptu / cde-exec startup latency benchmark')
+  parser.add_argument('--ptu', required=True, help='path to ptu executable')
+  parser.add_argument('--out', help='write json results here (default: stdout)')
+  parser.add_argument('--reps', type=int, default=20, help='runs per mode')
+  parser.add_argument('--mode', action='append', choices=MODES,
+                      help='mode to run (default: all)')
+  parser.add_argument('--work-dir', default=os.getcwd(),
+                      help='where to create the package (default: current dir; '
+                           'not /tmp, which cde.options ignores)')
+  args = parser.parse_args()
+  ptu = os.path.abspath(args.ptu)
+  modes = args.mode or MODES
+  if any(m.startswith('exec') for m in modes) and 'audit' not in modes:
+    modes = ['audit'] + modes   # cde-exec needs a package to run
+
+  true_path = shutil.which('true')
+  if not true_path:
+    print('startup_bench: no true program found', file=sys.stderr)
+    return 1
+  argv = [true_path]
+
+  results = []
+  run_dir = os.path.realpath(tempfile.mkdtemp(prefix='ptu-startup.', dir=args.work_dir))
+  try:
+    for mode in modes:
+      print('startup: %s' % mode, file=sys.stderr)
+      r = bench_mode(mode, ptu, run_dir, argv, args.reps)
+      results.append(r)
+      if r['status'] == 'ok' and results[0]['mode'] == 'native' and mode != 'native':
+        r['overhead_ms_vs_native'] = r['wall_ms_median'] - results[0]['wall_ms_median']
+  finally:
+    shutil.rmtree(run_dir, ignore_errors=True)
+
+  rev = subprocess.run(['git', '-C', REPO_DIR, 'rev-parse', '--short', 'HEAD'],
+                       stdout=subprocess.PIPE, stderr=subprocess.DEVNULL).stdout.decode().strip()
+  doc = {'ptu': ptu, 'git_rev': rev, 'reps': args.reps, 'command': argv, 'results': results}
+  text = json.dumps(doc, indent=2) + '\n'
+  if args.out:
+    with open(args.out, 'w') as f:
+      f.write(text)
+  else:
+    sys.stdout.write(text)
+
+  return 1 if any(r['status'] == 'failed' for r in results) else 0
+
+
+if __name__ == '__main__':
+  sys.exit(main())
@@ -0,0 +1,129 @@
+/*******************************************************************************
+module:   ctlsock_test
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  test cases for functions in strace-4.6/ctlsock.c
+*******************************************************************************/
+
+#include "doctest.h"
+#include "ctlsock.h"
+#include "strutils.h"
+
+#include <cstdio>       // ISOC: fmemopen(), fdopen(), fgets()
+#include <cstdlib>      // ISOC: mkdtemp()
+#include <cstring>      // ISOC: strstr(), strcpy()
+#include <string>       // ISOC++: std::string
+#include <sys/socket.h> // P2001: socket(), connect()
+#include <sys/stat.h>   // P2001: stat()
+#include <sys/un.h>     // P2001: struct sockaddr_un
+#include <unistd.h>     // P2001: rmdir(), write(), close()
+
+static int verbose_pid = 0;
+static bool verbose_on = false;
+
+static void fake_dump_tcbs (FILE* f) {
+  fprintf(f, "[{\"pid\":42,\"cwd\":");
+  str_print_json(f, "/a \"quoted\" dir");
+  fprintf(f, "}]");
+}
+
+static int fake_set_verbose (int pid, bool on) {
+  if (pid != 42) {
+    return -1;
+  }
+  verbose_pid = pid;
+  verbose_on = on;
+  return 0;
+}
+
+// run command, return its reply
+static std::string run_command (const char* cmd) {
+  char buf[4096] = {0};
+  FILE* f = fmemopen(buf, sizeof(buf) - 1, "w");
+  ctlsock_run_command(cmd, f);
+  fclose(f);
+  return std::string(buf);
+}
+
+TEST_CASE("ctlsock commands") {
+
+  SUBCASE("stats reports live counters and slowest recent stops") {
+    ctlsock_add_pending_copies(2, 300);
+    ctlsock_record_stop(7, "openat", 5000, 3);
+    ctlsock_record_stop(8, "execve", 90000, 3);
+    const std::string reply = run_command("stats");
+    CHECK(reply.find("\"nprocs\":3") != std::string::npos);
+    CHECK(reply.find("\"pending_copy_files\":2") != std::string::npos);
+    CHECK(reply.find("\"pending_copy_bytes\":300") != std::string::npos);
+    CHECK(reply.find("\"capture_cache_hit_rate\":") != std::string::npos);
+    CHECK(reply.find("\"slowest_recent\":[{\"pid\":8,\"syscall\":\"execve\",\"handler_us\":90.000}") != std::string::npos);
+    CHECK(reply.back() == '\n');
+    ctlsock_clear_pending_copies();
+    CHECK(run_command("stats").find("\"pending_copy_files\":0") != std::string::npos);
+  }
+
+  SUBCASE("unknown command is an error") {
+    CHECK(run_command("frobnicate") == "{\"error\":\"unknown command 'frobnicate'\"}\n");
+  }
+
+  SUBCASE("empty line gets no reply") {
+    CHECK(run_command("") == "");
+  }
+}
+
+TEST_CASE("ctlsock_start") {
+
+  char dir[] = "/tmp/ctlsock_test.XXXXXX";
+  REQUIRE(mkdtemp(dir) != NULL);
+  const std::string path = std::string(dir) + "/" + CTLSOCK_NAME;
+
+  REQUIRE(ctlsock_start(path.c_str(), fake_dump_tcbs, fake_set_verbose) == 0);
+  CHECK(ctlsock_enabled());
+  CHECK(ctlsock_start(path.c_str(), fake_dump_tcbs, fake_set_verbose) == -1);
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, path.c_str());
+  REQUIRE(connect(fd, (struct sockaddr*)&addr, sizeof(addr)) == 0);
+  FILE* f = fdopen(fd, "r+");
+  char line[4096];
+
+  SUBCASE("tcbs uses the dumper") {
+    fputs("tcbs\n", f);
+    fflush(f);
+    REQUIRE(fgets(line, sizeof(line), f) != NULL);
+    CHECK(std::string(line) == "{\"tcbs\":[{\"pid\":42,\"cwd\":\"/a \\\"quoted\\\" dir\"}]}\n");
+  }
+
+  SUBCASE("verbose uses the setter") {
+    fputs("verbose 42 on\n", f);
+    fflush(f);
+    REQUIRE(fgets(line, sizeof(line), f) != NULL);
+    CHECK(std::string(line) == "{\"ok\":true}\n");
+    CHECK(verbose_pid == 42);
+    CHECK(verbose_on);
+  }
+
+  SUBCASE("verbose of unknown pid is an error") {
+    fputs("verbose 43 off\n", f);
+    fflush(f);
+    REQUIRE(fgets(line, sizeof(line), f) != NULL);
+    CHECK(strstr(line, "\"error\"") != NULL);
+  }
+
+  SUBCASE("watch streams stats") {
+    fputs("watch 1\n", f);
+    fflush(f);
+    REQUIRE(fgets(line, sizeof(line), f) != NULL);
+    CHECK(strstr(line, "\"trace_stops\":") != NULL);
+  }
+
+  fclose(f);
+  ctlsock_stop();
+  CHECK(!ctlsock_enabled());
+  struct stat st;
+  CHECK(stat(path.c_str(), &st) != 0);
+  rmdir(dir);
+}
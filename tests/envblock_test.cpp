@@ -0,0 +1,80 @@
+/*******************************************************************************
+module:   envblock_test
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  test cases for functions in strace-4.6/envblock.c
+*******************************************************************************/
+
+#include "doctest.h"
+#include "envblock.h"
+
+#include <cstring>    // ISOC: memcpy()
+#include <string>     // ISOC++: std::string
+
+// vars of env (freed), joined by '|'
+static std::string vars (EnvBlock* env) {
+  std::string s;
+  for (size_t i = 0; i < envblock_num_vars(env); i++) {
+    s += std::string(i == 0 ? "" : "|") + envblock_var(env, i);
+  }
+  envblock_free(env);
+  return s;
+}
+
+TEST_CASE("envblock_parse") {
+  const std::string mem("HOME=/home/u\0PATH=/bin:/usr/bin\0=junk\0\n\0HOME=/root\0OPT=a=b", 58);
+  char* names[] = { (char*)"DISPLAY", (char*)"PATH" };
+
+  SUBCASE("first var of a name wins, vars without a name are skipped") {
+    CHECK(vars(envblock_parse(mem.data(), mem.size(), NULL, NULL, 0)) ==
+          "HOME=/home/u|PATH=/bin:/usr/bin|OPT=a=b");
+  }
+
+  SUBCASE("ignored vars get their value here, or are left out") {
+    char* values[] = { NULL, (char*)"/opt/bin" };
+    CHECK(vars(envblock_parse(mem.data(), mem.size(), names, values, 2)) ==
+          "HOME=/home/u|PATH=/opt/bin|OPT=a=b");
+    char* no_values[] = { NULL, NULL };
+    CHECK(vars(envblock_parse(mem.data(), mem.size(), names, no_values, 2)) ==
+          "HOME=/home/u|OPT=a=b");
+  }
+
+  SUBCASE("empty file") {
+    CHECK(vars(envblock_parse("", 0, NULL, NULL, 0)) == "");
+  }
+}
+
+TEST_CASE("envblock_layout") {
+  const std::string mem("A=1\0BB=22\0", 10);
+  EnvBlock* env = envblock_parse(mem.data(), mem.size(), NULL, NULL, 0);
+  char buf[64];
+
+  SUBCASE("strings, then pointers to them at the child's address") {
+    const unsigned long child_addr = 0x1000;
+    const long offset = envblock_layout(env, buf, sizeof(buf), child_addr, 8);
+    CHECK(offset == 16);
+    CHECK(std::string(buf) == "A=1");
+    CHECK(std::string(buf + 4) == "BB=22");
+    unsigned long envp[3];
+    memcpy(envp, buf + offset, sizeof(envp));
+    CHECK(envp[0] == child_addr);
+    CHECK(envp[1] == child_addr + 4);
+    CHECK(envp[2] == 0);
+  }
+
+  SUBCASE("4-byte pointers for a 32-bit proc") {
+    const long offset = envblock_layout(env, buf, sizeof(buf), 0x2000, 4);
+    CHECK(offset == 12);
+    unsigned int envp[3];
+    memcpy(envp, buf + offset, sizeof(envp));
+    CHECK(envp[0] == 0x2000);
+    CHECK(envp[1] == 0x2004);
+    CHECK(envp[2] == 0);
+  }
+
+  SUBCASE("too large") {
+    CHECK(envblock_layout(env, buf, 20, 0x1000, 8) == -1);
+  }
+
+  envblock_free(env);
+}
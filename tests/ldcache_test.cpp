@@ -0,0 +1,154 @@
+/*******************************************************************************
+module:   ldcache_test
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  test cases for functions in strace-4.6/ldcache.c
+*******************************************************************************/
+
+#include "doctest.h"
+#include "ldcache.h"
+
+#include <cstdio>       // ISOC: fopen(), fread(), fgets(), remove()
+#include <cstdlib>      // ISOC: mkdtemp(), system()
+#include <cstring>      // ISOC: strcmp(), memcmp(), strchr(), strstr()
+#include <string>       // ISOC: std::string
+#include <unistd.h>     // P2001: symlink(), unlink(), rmdir()
+
+// return "key=value\n" of each entry of the ld.so.cache at path
+static std::string cache_entries (const std::string& path) {
+  std::string s;
+  FILE* f = fopen(path.c_str(), "rb");
+  if (!f) {
+    return s;
+  }
+  std::string buf(1 << 16, '\0');
+  const size_t n = fread(&buf[0], 1, buf.size(), f);
+  fclose(f);
+  const unsigned int nlibs = (n >= 48) ? *(const unsigned int*)(buf.data() + 20) : 0;
+  for (unsigned int i = 0; i < nlibs && 48 + (i + 1) * 24 <= n; i++) {
+    const unsigned int key = *(const unsigned int*)(buf.data() + 48 + i * 24 + 4);
+    const unsigned int value = *(const unsigned int*)(buf.data() + 48 + i * 24 + 8);
+    if (key < n && value < n) {
+      s += std::string(buf.c_str() + key) + "=" + std::string(buf.c_str() + value) + "\n";
+    }
+  }
+  return s;
+}
+
+// return path of the libc mapped into this process (whose soname is libc.so.6)
+static std::string mapped_libc () {
+  std::string path;
+  FILE* f = fopen("/proc/self/maps", "r");
+  if (!f) {
+    return path;
+  }
+  char line[4096];
+  while (path.empty() && fgets(line, sizeof(line), f)) {
+    const char* p = strchr(line, '/');
+    if (p && (strstr(p, "/libc.so.6") || strstr(p, "/libc-2."))) {
+      path = p;
+      path.erase(path.find_last_not_of("\n") + 1);
+    }
+  }
+  fclose(f);
+  return path;
+}
+
+TEST_CASE("ld_cache_libcmp") {
+
+  SUBCASE("equal names") {
+    CHECK(ld_cache_libcmp("libc.so.6", "libc.so.6") == 0);
+  }
+
+  SUBCASE("digit runs compare numerically") {
+    CHECK(ld_cache_libcmp("libfoo.so.10", "libfoo.so.9") > 0);
+    CHECK(ld_cache_libcmp("libfoo.so.9", "libfoo.so.10") < 0);
+  }
+
+  SUBCASE("digits sort after non-digits") {
+    CHECK(ld_cache_libcmp("libfoo1.so", "libfoo.so") > 0);
+    CHECK(ld_cache_libcmp("libfoo.so", "libfoo1.so") < 0);
+  }
+
+  SUBCASE("prefix sorts first") {
+    CHECK(ld_cache_libcmp("libfoo.so", "libfoo.so.1") < 0);
+  }
+
+}
+
+TEST_CASE("write_ld_so_cache") {
+
+  char root_template[] = "/tmp/ldcache_test.XXXXXX";
+  const char* root = mkdtemp(root_template);
+  REQUIRE(root != NULL);
+  const std::string root_s(root);
+
+  // the test binary is a position-independent ELF, so it passes for a lib
+  std::string cmd = "mkdir -p " + root_s + "/lib" +
+                    " && cp /proc/self/exe " + root_s + "/lib/libfoo.so.1" +
+                    " && echo notelf > " + root_s + "/lib/libbar.so.1";
+  REQUIRE(system(cmd.c_str()) == 0);
+  REQUIRE(symlink("libfoo.so.1", (root_s + "/lib/libfoo.so").c_str()) == 0);
+
+  const std::string cache = root_s + "/ld.so.cache";
+
+  SUBCASE("only ELF shared libs are listed, sorted in decreasing order") {
+    CHECK(write_ld_so_cache(root, cache.c_str()) == 2);
+
+    char buf[4096];
+    FILE* f = fopen(cache.c_str(), "rb");
+    REQUIRE(f != NULL);
+    size_t n = fread(buf, 1, sizeof(buf), f);
+    fclose(f);
+
+    REQUIRE(n > 48 + 2 * 24);
+    CHECK(memcmp(buf, "glibc-ld.so.cache1.1", 20) == 0);
+    CHECK(*(unsigned int*)(buf + 20) == 2);  // nlibs
+
+    // first entry: key and value are offsets from start of file
+    unsigned int key = *(unsigned int*)(buf + 48 + 4);
+    unsigned int value = *(unsigned int*)(buf + 48 + 8);
+    REQUIRE(key < n);
+    REQUIRE(value < n);
+    CHECK(strcmp(buf + key, "libfoo.so.1") == 0);
+    CHECK(strcmp(buf + value, "/lib/libfoo.so.1") == 0);
+
+    key = *(unsigned int*)(buf + 48 + 24 + 4);
+    REQUIRE(key < n);
+    CHECK(strcmp(buf + key, "libfoo.so") == 0);
+  }
+
+  SUBCASE("existing cache file is replaced, not written through") {
+    REQUIRE(system(("echo old > " + cache + " && ln " + cache + " " + root_s + "/hardlink").c_str()) == 0);
+    CHECK(write_ld_so_cache(root, cache.c_str()) == 2);
+    FILE* f = fopen((root_s + "/hardlink").c_str(), "r");
+    REQUIRE(f != NULL);
+    char buf[8] = {0};
+    fread(buf, 1, 3, f);
+    fclose(f);
+    CHECK(strcmp(buf, "old") == 0);
+  }
+
+  SUBCASE("app-private lib dirs are listed only if in ld.so.conf") {
+    REQUIRE(system(("mkdir -p " + root_s + "/opt/app/lib " + root_s + "/etc/ld.so.conf.d" +
+                    " && cp /proc/self/exe " + root_s + "/opt/app/lib/libapp.so.1").c_str()) == 0);
+    CHECK(write_ld_so_cache(root, cache.c_str()) == 2);
+    REQUIRE(system(("echo 'include ld.so.conf.d/*.conf' > " + root_s + "/etc/ld.so.conf" +
+                    " && echo '/opt/app/lib # app' > " + root_s +
+                    "/etc/ld.so.conf.d/app.conf").c_str()) == 0);
+    CHECK(write_ld_so_cache(root, cache.c_str()) == 3);
+    CHECK(cache_entries(cache).find("libapp.so.1=/opt/app/lib/libapp.so.1\n") != std::string::npos);
+  }
+
+  SUBCASE("libs are listed by their DT_SONAME") {
+    const std::string libc = mapped_libc();
+    REQUIRE(!libc.empty());
+    REQUIRE(system(("cp " + libc + " " + root_s + "/lib/libc-copy.so").c_str()) == 0);
+    CHECK(write_ld_so_cache(root, cache.c_str()) == 3);
+    CHECK(cache_entries(cache).find("libc.so.6=/lib/libc-copy.so\n") != std::string::npos);
+  }
+
+  REQUIRE(system(("rm -rf " + root_s).c_str()) == 0);
+
+}
+
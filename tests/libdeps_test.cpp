@@ -0,0 +1,117 @@
+/*******************************************************************************
+module:   libdeps_test
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  test cases for functions in strace-4.6/libdeps.c
+*******************************************************************************/
+
+#include "doctest.h"
+#include "libdeps.h"
+
+#include <cstdlib>      // ISOC: free(), realpath()
+#include <cstring>      // ISOC: strlen(), strrchr(), strcmp()
+#include <climits>      // ISOC: PATH_MAX
+#include <unistd.h>     // P2001: readlink()
+
+extern "C" int find_ELF_dynamic_deps (char* file_name, char*** needed,
+                                      char** rpath, char** runpath);
+
+// test binary is dynamically linked against libc, so use it as a fixture
+static int self_deps (char*** needed, char** rpath, char** runpath) {
+  static char self_exe[PATH_MAX];
+  ssize_t len = readlink("/proc/self/exe", self_exe, sizeof(self_exe) - 1);
+  self_exe[len > 0 ? len : 0] = '\0';
+  return find_ELF_dynamic_deps(self_exe, needed, rpath, runpath);
+}
+
+static void free_deps (char** needed, char* rpath, char* runpath) {
+  for (char** n = needed; n && *n; n++)
+    free(*n);
+  free(needed);
+  free(rpath);
+  free(runpath);
+}
+
+TEST_CASE("find_ELF_dynamic_deps") {
+
+  char** needed = NULL;
+  char* rpath = NULL;
+  char* runpath = NULL;
+
+  SUBCASE("non-ELF file") {
+    CHECK(find_ELF_dynamic_deps((char*)"/proc/self/status", &needed, &rpath, &runpath) == -1);
+    CHECK(needed == NULL);
+  }
+
+  SUBCASE("nonexistent file") {
+    CHECK(find_ELF_dynamic_deps((char*)"/nonexistent/foo", &needed, &rpath, &runpath) == -1);
+  }
+
+  SUBCASE("dynamically-linked test binary needs libc") {
+    int elf_class = self_deps(&needed, &rpath, &runpath);
+    CHECK(elf_class == (int)(sizeof(void*) * 8));
+    REQUIRE(needed != NULL);
+    bool found_libc = false;
+    for (char** n = needed; *n; n++) {
+      if (strncmp(*n, "libc.so", 7) == 0)
+        found_libc = true;
+    }
+    CHECK(found_libc);
+  }
+
+  free_deps(needed, rpath, runpath);
+
+}
+
+TEST_CASE("resolve_needed_lib") {
+
+  const int elf_class = (int)(sizeof(void*) * 8);
+
+  SUBCASE("lib in default dirs") {
+    char** needed = NULL;
+    char* rpath = NULL;
+    char* runpath = NULL;
+    self_deps(&needed, &rpath, &runpath);
+    REQUIRE(needed != NULL);
+    REQUIRE(needed[0] != NULL);
+    char* lib = resolve_needed_lib(needed[0], "/", NULL, NULL, NULL, elf_class);
+    REQUIRE(lib != NULL);
+    CHECK(lib[0] == '/');
+    CHECK(strcmp(strrchr(lib, '/') + 1, needed[0]) == 0);
+    free(lib);
+    free_deps(needed, rpath, runpath);
+  }
+
+  SUBCASE("nonexistent lib") {
+    CHECK(resolve_needed_lib("libnonexistent-ptu.so.9", "/", NULL, NULL, NULL, elf_class) == NULL);
+  }
+
+  SUBCASE("lib found via $ORIGIN in rpath before default dirs") {
+    char self_exe[PATH_MAX];
+    REQUIRE(realpath("/proc/self/exe", self_exe) != NULL);
+    char* base = strrchr(self_exe, '/');
+    *base = '\0';
+    char* lib = resolve_needed_lib(base + 1, self_exe, "/nonexistent:$ORIGIN", NULL, NULL, elf_class);
+    REQUIRE(lib != NULL);
+    *base = '/';
+    CHECK(strcmp(lib, self_exe) == 0);
+    free(lib);
+  }
+
+  SUBCASE("absolute lib path is used as-is") {
+    char self_exe[PATH_MAX];
+    REQUIRE(realpath("/proc/self/exe", self_exe) != NULL);
+    char* lib = resolve_needed_lib(self_exe, "/", NULL, NULL, NULL, elf_class);
+    REQUIRE(lib != NULL);
+    CHECK(strcmp(lib, self_exe) == 0);
+    free(lib);
+  }
+
+  SUBCASE("wrong ELF class is skipped") {
+    char self_exe[PATH_MAX];
+    REQUIRE(realpath("/proc/self/exe", self_exe) != NULL);
+    CHECK(resolve_needed_lib(self_exe, "/", NULL, NULL, NULL, 96 - elf_class) == NULL);
+  }
+
+}
+
@@ -0,0 +1,120 @@
+/*******************************************************************************
+module:   manifest_test
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  test cases for functions in strace-4.6/manifest.c
+*******************************************************************************/
+
+#include "doctest.h"
+#include "manifest.h"
+
+#include <cstdio>       // ISOC: fopen(), fputs(), fclose(), remove()
+#include <cstdlib>      // ISOC: mkdtemp(), system()
+#include <string>       // ISOC: std::string
+#include <sys/stat.h>   // P2001: stat()
+
+TEST_CASE("hash_file_contents") {
+
+  char dir_template[] = "/tmp/manifest_test.XXXXXX";
+  const char* dir = mkdtemp(dir_template);
+  REQUIRE(dir != NULL);
+  const std::string fn = std::string(dir) + "/f";
+
+  SUBCASE("known FNV-1a values") {
+    uint64_t hash = 0;
+    FILE* f = fopen(fn.c_str(), "w");
+    fclose(f);
+    CHECK(hash_file_contents(fn.c_str(), &hash) == 0);
+    CHECK(hash == 0xcbf29ce484222325ULL);
+
+    f = fopen(fn.c_str(), "w");
+    fputs("a", f);
+    fclose(f);
+    CHECK(hash_file_contents(fn.c_str(), &hash) == 0);
+    CHECK(hash == 0xaf63dc4c8601ec8cULL);
+  }
+
+  SUBCASE("nonexistent file") {
+    uint64_t hash = 0;
+    CHECK(hash_file_contents((fn + ".missing").c_str(), &hash) == -1);
+  }
+
+  REQUIRE(system(("rm -rf " + std::string(dir)).c_str()) == 0);
+
+}
+
+TEST_CASE("manifest_save and manifest_load") {
+
+  char dir_template[] = "/tmp/manifest_test.XXXXXX";
+  const char* dir = mkdtemp(dir_template);
+  REQUIRE(dir != NULL);
+  const std::string manifest_fn = std::string(dir) + "/cde.manifest";
+
+  struct stat root_stat;
+  REQUIRE(stat(dir, &root_stat) == 0);
+  struct stat file_stat;
+  REQUIRE(stat("/proc/self/exe", &file_stat) == 0);
+
+  StrMap* manifest = strmap_new();
+  ManifestEntry* e1 = (ManifestEntry*)malloc(sizeof(ManifestEntry));
+  manifest_entry_set_stat(e1, &file_stat);
+  e1->hash = 0x0123456789abcdefULL;
+  e1->has_hash = true;
+  e1->touched = true;
+  strmap_put(manifest, "/usr/bin/with space", e1);
+  ManifestEntry* e2 = (ManifestEntry*)malloc(sizeof(ManifestEntry));
+  manifest_entry_set_stat(e2, &file_stat);
+  e2->size = 1;
+  e2->touched = false;
+  strmap_put(manifest, "/a", e2);
+  REQUIRE(manifest_save(manifest, manifest_fn.c_str(), &root_stat) == 0);
+  manifest_free(manifest);
+
+  SUBCASE("entries survive a round trip") {
+    StrMap* loaded = manifest_load(manifest_fn.c_str(), &root_stat);
+    CHECK(strmap_size(loaded) == 2);
+    ManifestEntry* l1 = (ManifestEntry*)strmap_get(loaded, "/usr/bin/with space");
+    REQUIRE(l1 != NULL);
+    CHECK(manifest_entry_matches(l1, &file_stat));
+    CHECK(l1->has_hash);
+    CHECK(l1->hash == 0x0123456789abcdefULL);
+    CHECK_FALSE(l1->touched);
+    ManifestEntry* l2 = (ManifestEntry*)strmap_get(loaded, "/a");
+    REQUIRE(l2 != NULL);
+    CHECK_FALSE(l2->has_hash);
+    CHECK_FALSE(manifest_entry_matches(l2, &file_stat));  // size differs
+    manifest_free(loaded);
+  }
+
+  SUBCASE("manifest of another cde-root is not loaded") {
+    struct stat other_root_stat = root_stat;
+    other_root_stat.st_ino++;
+    StrMap* loaded = manifest_load(manifest_fn.c_str(), &other_root_stat);
+    CHECK(strmap_size(loaded) == 0);
+    manifest_free(loaded);
+  }
+
+  SUBCASE("untouched entries are listed") {
+    StrMap* loaded = manifest_load(manifest_fn.c_str(), &root_stat);
+    ((ManifestEntry*)strmap_get(loaded, "/a"))->touched = true;
+    const std::string untouched_fn = std::string(dir) + "/cde.untouched";
+    CHECK(manifest_save_untouched(loaded, untouched_fn.c_str()) == 0);
+    char buf[64] = {0};
+    FILE* f = fopen(untouched_fn.c_str(), "r");
+    REQUIRE(f != NULL);
+    fread(buf, 1, sizeof(buf) - 1, f);
+    fclose(f);
+    CHECK(std::string(buf) == "/usr/bin/with space\n");
+    manifest_free(loaded);
+  }
+
+  SUBCASE("missing manifest loads as empty") {
+    StrMap* loaded = manifest_load((manifest_fn + ".missing").c_str(), &root_stat);
+    CHECK(strmap_size(loaded) == 0);
+    manifest_free(loaded);
+  }
+
+  REQUIRE(system(("rm -rf " + std::string(dir)).c_str()) == 0);
+
+}
+
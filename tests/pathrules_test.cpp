@@ -0,0 +1,40 @@
+/*******************************************************************************
+module:   pathrules_test
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  test cases for functions in strace-4.6/pathrules.c
+*******************************************************************************/
+
+#include "doctest.h"
+#include "pathrules.h"
+
+TEST_CASE("pathrules_match") {
+
+  PathRules rules = PathRules();
+
+  SUBCASE("no rules match nothing") {
+    CHECK_FALSE(pathrules_match(&rules, "/etc/passwd"));
+  }
+
+  rules.exact_paths[rules.exact_paths_ind++] = (char*)"/etc/passwd";
+  rules.prefix_paths[rules.prefix_paths_ind++] = (char*)"/proc/";
+  rules.substr_paths[rules.substr_paths_ind++] = (char*)"/.cache/";
+
+  SUBCASE("exact rules") {
+    CHECK(pathrules_match_exact(&rules, "/etc/passwd"));
+    CHECK(pathrules_match(&rules, "/etc/passwd"));
+    CHECK_FALSE(pathrules_match(&rules, "/etc/passwd-"));
+    CHECK_FALSE(pathrules_match_exact(&rules, "/proc/self"));
+  }
+
+  SUBCASE("prefix rules") {
+    CHECK(pathrules_match(&rules, "/proc/self/maps"));
+    CHECK_FALSE(pathrules_match(&rules, "/proc"));
+  }
+
+  SUBCASE("substr rules") {
+    CHECK(pathrules_match(&rules, "/home/user/.cache/x"));
+    CHECK_FALSE(pathrules_match(&rules, "/home/user/.cache"));
+  }
+
+}
@@ -8,7 +8,9 @@ purpose:  test cases for functions in strace-4.6/perftimers.c
 #include "doctest.h"
 #include "perftimers.h"
 
+#include <cstring>    // ISOC: strstr()
 #include <ctime>      // P1993: struct timespec, nanosleep()
+#include <pthread.h>  // P2001: pthread_create(), pthread_join()
 
 TEST_CASE("set_perf_timer") {
 
@@ -150,3 +152,104 @@ TEST_CASE("get_total_perf_time") {
 
 }
 
+
+static void* run_elf_parsing_timer (void* arg) {
+  struct timespec time_to_run;
+  time_to_run.tv_sec = 0;
+  time_to_run.tv_nsec = 10000000;  // 10 millisec
+
+  *(TimerAction*)arg = start_perf_timer(ELF_PARSING);
+  nanosleep(&time_to_run, NULL);
+  stop_perf_timer(ELF_PARSING);
+  count_perf_event(ELF_FILES_PARSED, 1);
+  return NULL;
+}
+
+TEST_CASE("per-thread perf timers") {
+
+  set_all_perf_timers(ENABLED);
+
+  SUBCASE("timer started in another thread is not running in this thread") {
+    pthread_t thread;
+    TimerAction thread_ta = ERR_UNKNOWN_ERROR;
+    start_perf_timer(ELF_PARSING);
+    pthread_create(&thread, NULL, run_elf_parsing_timer, &thread_ta);
+    pthread_join(thread, NULL);
+    CHECK(thread_ta == SUCCESS_TIMER_STARTED);
+    CHECK(stop_perf_timer(ELF_PARSING) == SUCCESS_TIMER_STOPPED);
+  }
+
+  SUBCASE("totals and counts of all threads are summed") {
+    const long long count_before = get_perf_count(ELF_FILES_PARSED);
+    pthread_t threads[2];
+    TimerAction thread_tas[2];
+    for (int i = 0; i < 2; i++) {
+      pthread_create(&threads[i], NULL, run_elf_parsing_timer, &thread_tas[i]);
+    }
+    for (int i = 0; i < 2; i++) {
+      pthread_join(threads[i], NULL);
+    }
+    double tt;
+    CHECK(get_total_perf_time(ELF_PARSING, &tt) == SUCCESS_TIMER_TOTAL_RETURNED);
+    CHECK(tt >= 0.02);
+    CHECK(get_perf_count(ELF_FILES_PARSED) - count_before == 2);
+  }
+
+  set_all_perf_timers(DISABLED);
+
+}
+
+TEST_CASE("perf counters") {
+
+  SUBCASE("disabled counters do not count") {
+    set_perf_counters(DISABLED);
+    count_perf_event(BYTES_COPIED, 100);
+    set_perf_counters(ENABLED);
+    CHECK(get_perf_count(BYTES_COPIED) == 0);
+  }
+
+  SUBCASE("enabled counters count, and are zeroed when re-enabled") {
+    set_perf_counters(ENABLED);
+    count_perf_event(BYTES_COPIED, 100);
+    count_perf_event(BYTES_COPIED, 28);
+    CHECK(get_perf_count(BYTES_COPIED) == 128);
+    set_perf_counters(ENABLED);
+    CHECK(get_perf_count(BYTES_COPIED) == 0);
+  }
+
+  set_perf_counters(DISABLED);
+
+}
+
+TEST_CASE("print_perf_report with timers disabled") {
+
+  char buf[4096] = {0};
+  FILE* f = fmemopen(buf, sizeof(buf) - 1, "w");
+  REQUIRE(f != NULL);
+  print_perf_report(f);
+  fclose(f);
+  CHECK(buf[0] == '\0');
+
+}
+
+TEST_CASE("print_perf_report with timers enabled") {
+
+  set_all_perf_timers(ENABLED);
+  start_perf_timer(PATH_RULE_MATCHING);
+  stop_perf_timer(PATH_RULE_MATCHING);
+  count_perf_event(TRACE_STOPS, 3);
+
+  char buf[4096] = {0};
+  FILE* f = fmemopen(buf, sizeof(buf) - 1, "w");
+  REQUIRE(f != NULL);
+  print_perf_report(f);
+  fclose(f);
+  CHECK(strstr(buf, perf_timer_name(PATH_RULE_MATCHING)) != NULL);
+  CHECK(strstr(buf, perf_timer_name(AUDIT_FILE_COPYING)) != NULL);
+  CHECK(strstr(buf, perf_counter_name(TRACE_STOPS)) != NULL);
+  CHECK(strstr(buf, "tracer user cpu") != NULL);
+  CHECK(strstr(buf, "tracer peak rss (KiB)") != NULL);
+
+  set_all_perf_timers(DISABLED);
+
+}
@@ -0,0 +1,224 @@
+/*******************************************************************************
+module:   pkgdelta_test
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  test cases for functions in strace-4.6/pkgdelta.c
+*******************************************************************************/
+
+#include "doctest.h"
+#include "pkgdelta.h"
+
+#include <cstdint>      // ISOC: UINT32_MAX
+#include <cstdio>       // ISOC: FILE, fopen(), fwrite(), fclose(), remove()
+#include <cstdlib>      // ISOC: mkdtemp(), system()
+#include <string>       // ISOC++: std::string
+#include <sys/stat.h>   // P2001: stat(), chmod()
+#include <unistd.h>     // P2001: symlink(), truncate()
+
+// write s to path
+static void write_file (const std::string& path, const std::string& s) {
+  FILE* f = fopen(path.c_str(), "w");
+  REQUIRE(f);
+  fwrite(s.data(), 1, s.size(), f);
+  fclose(f);
+}
+
+// return len pseudo-random bytes (same for the same seed)
+static std::string random_bytes (size_t len, unsigned seed) {
+  std::string s(len, '\0');
+  for (size_t i = 0; i < len; i++) {
+    seed = seed * 1103515245u + 12345u;
+    s[i] = (char)(seed >> 16);
+  }
+  return s;
+}
+
+// write patch of new_dir against old_dir to patch_path, return 0 on success
+static int export_patch (const std::string& old_dir, const std::string& new_dir,
+                         const std::string& patch_path, PkgDeltaReport* report) {
+  FILE* patch = fopen(patch_path.c_str(), "w");
+  const int rc = pkgdelta_export(old_dir.c_str(), new_dir.c_str(), 2, patch, report);
+  fclose(patch);
+  return rc;
+}
+
+// apply patch at patch_path to old_dir into out_dir, return 0 on success
+static int apply_patch (const std::string& old_dir, const std::string& patch_path,
+                        const std::string& out_dir) {
+  FILE* patch = fopen(patch_path.c_str(), "r");
+  const int rc = pkgdelta_apply(old_dir.c_str(), patch, out_dir.c_str());
+  fclose(patch);
+  return rc;
+}
+
+TEST_CASE("pkgdelta_export and pkgdelta_apply") {
+
+  // the new package changes a few bytes of a big binary (and inserts some),
+  // changes a small file, moves a lib, adds and removes files, and retargets
+  // a symlink
+  char dir_template[] = "/tmp/pkgdelta_test.XXXXXX";
+  const char* dir_c = mkdtemp(dir_template);
+  REQUIRE(dir_c != NULL);
+  const std::string dir = dir_c;
+  const std::string old_dir = dir + "/old";
+  const std::string new_dir = dir + "/new";
+  const std::string patch_path = dir + "/patch";
+  for (const std::string& pkg : { old_dir, new_dir }) {
+    REQUIRE(system(("mkdir -p " + pkg + "/cde-root/bin " + pkg + "/cde-root/etc " +
+                    pkg + "/cde-root/lib").c_str()) == 0);
+  }
+
+  const std::string big = random_bytes(600000, 1);
+  write_file(old_dir + "/cde-root/bin/app", big);
+  write_file(old_dir + "/cde-root/etc/conf", "a = 1\n");
+  write_file(old_dir + "/cde-root/lib/libx.so", random_bytes(30000, 2));
+  write_file(old_dir + "/cde-root/etc/gone", "gone\n");
+  write_file(old_dir + "/cde.log", "cd /w\n./app\n");
+  REQUIRE(symlink("lib", (old_dir + "/cde-root/lib64").c_str()) == 0);
+
+  std::string big2 = big;
+  big2.replace(100000, 10, "0123456789");
+  big2.insert(400000, "inserted");
+  big2.resize(big2.size() - 1000);
+  write_file(new_dir + "/cde-root/bin/app", big2);
+  REQUIRE(chmod((new_dir + "/cde-root/bin/app").c_str(), 0751) == 0);
+  write_file(new_dir + "/cde-root/etc/conf", "a = 2\n");
+  write_file(new_dir + "/cde-root/lib/libx.so.1", random_bytes(30000, 2));
+  write_file(new_dir + "/cde-root/etc/new", random_bytes(5000, 3));
+  write_file(new_dir + "/cde-root/etc/empty", "");
+  write_file(new_dir + "/cde.log", "cd /w\n./app\n");
+  REQUIRE(symlink("lib/libx.so.1", (new_dir + "/cde-root/libx").c_str()) == 0);
+
+  PkgDeltaReport report;
+  REQUIRE(export_patch(old_dir, new_dir, patch_path, &report) == 0);
+
+  SUBCASE("patch copies what the old package has") {
+    CHECK(report.num_same == 1);      // cde.log
+    CHECK(report.num_moved == 1);     // libx.so -> libx.so.1
+    CHECK(report.num_patched == 1);   // app
+    CHECK(report.num_literal == 3);   // conf, new, empty
+    CHECK(report.bytes_new == big2.size() + 6 + 30000 + 5000 + 12);
+    struct stat st;
+    REQUIRE(stat(patch_path.c_str(), &st) == 0);
+    CHECK(report.bytes_patch == (uint64_t)st.st_size);
+    CHECK(report.bytes_patch < 20000);
+  }
+
+  SUBCASE("apply reconstructs the new package") {
+    const std::string out_dir = dir + "/out";
+    REQUIRE(apply_patch(old_dir, patch_path, out_dir) == 0);
+    CHECK(system(("diff -r --no-dereference " + new_dir + " " + out_dir).c_str()) == 0);
+    struct stat st;
+    REQUIRE(stat((out_dir + "/cde-root/bin/app").c_str(), &st) == 0);
+    CHECK((st.st_mode & 07777) == 0751);
+    struct stat new_st;
+    REQUIRE(stat((new_dir + "/cde-root/bin/app").c_str(), &new_st) == 0);
+    CHECK(st.st_mtim.tv_sec == new_st.st_mtim.tv_sec);
+    CHECK(st.st_mtim.tv_nsec == new_st.st_mtim.tv_nsec);
+    CHECK(apply_patch(old_dir, patch_path, out_dir) == -1);    // (out_dir exists)
+  }
+
+  SUBCASE("apply to another old package fails") {
+    write_file(old_dir + "/cde-root/bin/app", random_bytes(600000, 4));
+    CHECK(apply_patch(old_dir, patch_path, dir + "/out") == -1);
+  }
+
+  SUBCASE("truncated patch fails") {
+    REQUIRE(truncate(patch_path.c_str(), report.bytes_patch - 1) == 0);
+    CHECK(apply_patch(old_dir, patch_path, dir + "/out") == -1);
+  }
+
+  SUBCASE("more jobs than files") {
+    FILE* patch = fopen(patch_path.c_str(), "w");
+    CHECK(pkgdelta_export(old_dir.c_str(), new_dir.c_str(), UINT32_MAX, patch, &report) == 0);
+    fclose(patch);
+    CHECK(report.num_patched == 1);
+  }
+
+  SUBCASE("missing package") {
+    FILE* patch = fopen(patch_path.c_str(), "w");
+    CHECK(pkgdelta_export((dir + "/missing").c_str(), new_dir.c_str(), 1, patch, &report) == -1);
+    fclose(patch);
+  }
+
+  REQUIRE(system(("rm -rf " + dir).c_str()) == 0);
+
+}
+
+TEST_CASE("pkgdelta keeps stubs sparse") {
+
+  // the new package stubs a big binary (as "ptu-prov trim" does), adds a
+  // stub, keeps a stub, and adds a file with a run of zero bytes
+  char dir_template[] = "/tmp/pkgdelta_test.XXXXXX";
+  const char* dir_c = mkdtemp(dir_template);
+  REQUIRE(dir_c != NULL);
+  const std::string dir = dir_c;
+  const std::string old_dir = dir + "/old";
+  const std::string new_dir = dir + "/new";
+  const std::string patch_path = dir + "/patch";
+  const std::string out_dir = dir + "/out";
+  for (const std::string& pkg : { old_dir, new_dir }) {
+    REQUIRE(system(("mkdir -p " + pkg + "/cde-root/bin").c_str()) == 0);
+    write_file(pkg + "/cde-root/bin/kept", "");
+    REQUIRE(truncate((pkg + "/cde-root/bin/kept").c_str(), 300000) == 0);
+  }
+  write_file(old_dir + "/cde-root/bin/app", random_bytes(600000, 1));
+  write_file(new_dir + "/cde-root/bin/app", "");
+  REQUIRE(truncate((new_dir + "/cde-root/bin/app").c_str(), 600000) == 0);
+  write_file(new_dir + "/cde-root/bin/added", "");
+  REQUIRE(truncate((new_dir + "/cde-root/bin/added").c_str(), 1 << 20) == 0);
+  write_file(new_dir + "/cde-root/bin/zeros", "head" + std::string(100000, '\0') + "tail");
+
+  PkgDeltaReport report;
+  REQUIRE(export_patch(old_dir, new_dir, patch_path, &report) == 0);
+  CHECK(report.num_same == 1);      // kept
+  CHECK(report.num_patched == 1);   // app
+  CHECK(report.num_literal == 2);   // added, zeros
+  CHECK(report.bytes_patch < 1000);
+
+  REQUIRE(apply_patch(old_dir, patch_path, out_dir) == 0);
+  CHECK(system(("diff -r --no-dereference " + new_dir + " " + out_dir).c_str()) == 0);
+  for (const char* name : { "app", "added", "kept" }) {
+    struct stat st;
+    REQUIRE(stat((out_dir + "/cde-root/bin/" + name).c_str(), &st) == 0);
+    CHECK(st.st_blocks == 0);
+  }
+  struct stat st;
+  REQUIRE(stat((out_dir + "/cde-root/bin/zeros").c_str(), &st) == 0);
+  CHECK(st.st_size == 100008);
+  CHECK(st.st_blocks * 512 < 100000);
+
+  REQUIRE(system(("rm -rf " + dir).c_str()) == 0);
+
+}
+
+TEST_CASE("pkgdelta compares bytes, not only content hashes") {
+
+  // two files of the same size and FNV-1a 64 hash (but not the same bytes):
+  // the new package changes a file to the other one, and adds a copy of it
+  const std::string file_a("\xd6\x4f\xdb\x5d\x81\xa4\x3a\x00", 8);
+  const std::string file_b("\x7f\x79\xe3\xd5\x6b\x8d\x2d\x4f", 8);
+  char dir_template[] = "/tmp/pkgdelta_test.XXXXXX";
+  const char* dir_c = mkdtemp(dir_template);
+  REQUIRE(dir_c != NULL);
+  const std::string dir = dir_c;
+  const std::string old_dir = dir + "/old";
+  const std::string new_dir = dir + "/new";
+  const std::string patch_path = dir + "/patch";
+  const std::string out_dir = dir + "/out";
+  REQUIRE(system(("mkdir -p " + old_dir + " " + new_dir).c_str()) == 0);
+  write_file(old_dir + "/x", file_a);
+  write_file(new_dir + "/x", file_b);
+  write_file(new_dir + "/y", file_b);
+
+  PkgDeltaReport report;
+  REQUIRE(export_patch(old_dir, new_dir, patch_path, &report) == 0);
+  CHECK(report.num_same == 0);
+  CHECK(report.num_moved == 0);
+  CHECK(report.num_literal == 2);
+  REQUIRE(apply_patch(old_dir, patch_path, out_dir) == 0);
+  CHECK(system(("diff -r " + new_dir + " " + out_dir).c_str()) == 0);
+
+  REQUIRE(system(("rm -rf " + dir).c_str()) == 0);
+
+}
@@ -0,0 +1,201 @@
+/*******************************************************************************
+module:   pkgtrim_test
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  test cases for functions in strace-4.6/pkgtrim.c
+*******************************************************************************/
+
+#include "doctest.h"
+#include "pkgtrim.h"
+#include "manifest.h"
+
+#include <cstdint>      // ISOC: uint64_t
+#include <cstdio>       // ISOC: FILE, fopen(), fputs(), fgets(), fclose()
+#include <cstdlib>      // ISOC: malloc(), mkdtemp(), system()
+#include <string>       // ISOC++: std::string
+#include <sys/stat.h>   // P2001: stat(), mkdir()
+#include <unistd.h>     // P2001: symlink(), access()
+
+// write s to path
+static void write_file (const std::string& path, const std::string& s) {
+  FILE* f = fopen(path.c_str(), "w");
+  REQUIRE(f);
+  fputs(s.c_str(), f);
+  fclose(f);
+}
+
+// return contents of file (or "" if none)
+static std::string contents (const std::string& path) {
+  std::string s;
+  FILE* f = fopen(path.c_str(), "r");
+  if (f) {
+    char buf[256];
+    while (fgets(buf, sizeof(buf), f)) {
+      s += buf;
+    }
+    fclose(f);
+  }
+  return s;
+}
+
+// return bytes the file at path takes on disk (as trim lists them, which
+// depends on the file system, e.g. on inline extents or compression)
+static uint64_t disk_bytes (const std::string& path) {
+  struct stat st;
+  CHECK(stat(path.c_str(), &st) == 0);
+  return (uint64_t)st.st_blocks * 512;
+}
+
+// return listing line "<class> <action> <disk bytes of file> <path>\n"
+static std::string listed (const char* cls, const char* action, const std::string& root,
+                           const std::string& path) {
+  return std::string(cls) + " " + action + " " + std::to_string(disk_bytes(root + path)) + " " +
+         path + "\n";
+}
+
+// trim package at dir by idx as opts says, return its listing
+static std::string trim (const ProvIndex* idx, const std::string& dir, PkgTrimPolicy metadata,
+                         PkgTrimPolicy unused, bool dry_run, PkgTrimReport* report) {
+  const PkgTrimOptions opts = { metadata, unused, dry_run };
+  const std::string listing_fn = dir + "/listing";
+  FILE* listing = fopen(listing_fn.c_str(), "w");
+  CHECK(listing != NULL);
+  if (!listing) {
+    return "";
+  }
+  CHECK(pkgtrim_package(idx, dir.c_str(), &opts, listing, report) == 0);
+  fclose(listing);
+  return contents(listing_fn);
+}
+
+TEST_CASE("pkgtrim_parse_policy") {
+  PkgTrimPolicy policy = PKGTRIM_KEEP;
+  CHECK(pkgtrim_parse_policy("prune", &policy) == 0);
+  CHECK(policy == PKGTRIM_PRUNE);
+  CHECK(pkgtrim_parse_policy("stub", &policy) == 0);
+  CHECK(policy == PKGTRIM_STUB);
+  CHECK(pkgtrim_parse_policy("delete", &policy) == -1);
+  CHECK(std::string(pkgtrim_policy_name(PKGTRIM_KEEP)) == "keep");
+  CHECK(std::string(pkgtrim_class_name(PKGTRIM_METADATA)) == "metadata");
+}
+
+TEST_CASE("pkgtrim_package") {
+
+  // /bin/app (a #! script run by /bin/interp) is exec-ed in cwd /data, and
+  // reads /data/in and /lnk/in2 (/lnk -> data); /data/meta and /meta2/m were
+  // only stat-ed; /old/unused was not touched by the audit
+  char dir_template[] = "/tmp/pkgtrim_test.XXXXXX";
+  const char* dir_c = mkdtemp(dir_template);
+  REQUIRE(dir_c != NULL);
+  const std::string dir = dir_c;
+  const std::string root = dir + "/cde-root";
+  REQUIRE(system(("mkdir -p " + root + "/bin " + root + "/data " + root + "/meta2 " +
+                  root + "/old").c_str()) == 0);
+  REQUIRE(symlink("data", (root + "/lnk").c_str()) == 0);
+  write_file(root + "/bin/app", "#!/bin/interp -x\n");
+  write_file(root + "/bin/interp", "interp\n");
+  write_file(root + "/data/in", "in\n");
+  write_file(root + "/data/in2", "in2\n");
+  write_file(root + "/data/meta", std::string(20000, 'm'));
+  write_file(root + "/meta2/m", "m\n");
+  write_file(root + "/old/unused", "unused\n");
+
+  struct stat root_stat;
+  REQUIRE(stat(root.c_str(), &root_stat) == 0);
+  StrMap* manifest = strmap_new();
+  const char* captured[] = { "/bin/app", "/bin/interp", "/data/in", "/data/in2", "/data/meta",
+                             "/meta2/m", "/old/unused" };
+  for (const char* path : captured) {
+    struct stat st;
+    REQUIRE(stat((root + path).c_str(), &st) == 0);
+    ManifestEntry* e = (ManifestEntry*)malloc(sizeof(ManifestEntry));
+    manifest_entry_set_stat(e, &st);
+    strmap_put(manifest, path, e);
+  }
+  REQUIRE(manifest_save(manifest, (dir + "/cde.manifest").c_str(), &root_stat) == 0);
+  manifest_free(manifest);
+  write_file(dir + "/cde.untouched", "/old/unused\n");
+
+  const std::string log_path = dir + "/provenance.log";
+  write_file(log_path, "100 1 EXECVE 2 /bin/app /data [\"app\"]\n"
+                       "101 2 READ /data/in\n"
+                       "101 2 CLOSE /data/in\n"
+                       "102 2 READ /lnk/in2\n"
+                       "103 2 EXIT\n");
+  REQUIRE(provindex_build(log_path.c_str(), (log_path + ".idx").c_str()) == 0);
+  ProvIndex* idx = provindex_open((log_path + ".idx").c_str());
+  REQUIRE(idx);
+  PkgTrimReport report;
+
+  SUBCASE("dry run classifies, but changes nothing") {
+    const std::string listing = trim(idx, dir, PKGTRIM_STUB, PKGTRIM_PRUNE, true, &report);
+    CHECK(listing.find(listed("executed", "keep", root, "/bin/app")) != std::string::npos);
+    CHECK(listing.find(listed("executed", "keep", root, "/bin/interp")) != std::string::npos);
+    CHECK(listing.find(listed("read", "keep", root, "/data/in")) != std::string::npos);
+    CHECK(listing.find(listed("read", "keep", root, "/data/in2")) != std::string::npos);
+    CHECK(listing.find(listed("metadata", "stub", root, "/data/meta")) != std::string::npos);
+    CHECK(listing.find(listed("metadata", "stub", root, "/meta2/m")) != std::string::npos);
+    CHECK(listing.find(listed("unused", "prune", root, "/old/unused")) != std::string::npos);
+    CHECK(report.num_files[PKGTRIM_EXECUTED] == 2);
+    CHECK(report.num_files[PKGTRIM_READ] == 2);
+    CHECK(report.num_files[PKGTRIM_METADATA] == 2);
+    CHECK(report.num_files[PKGTRIM_UNUSED] == 1);
+    CHECK(report.num_stubbed == 2);
+    CHECK(report.num_pruned == 1);
+    CHECK(report.bytes_saved == disk_bytes(root + "/data/meta") + disk_bytes(root + "/meta2/m") +
+                                disk_bytes(root + "/old/unused"));
+    CHECK(contents(root + "/data/meta") == std::string(20000, 'm'));
+    CHECK(access((root + "/old/unused").c_str(), F_OK) == 0);
+    CHECK(contents(dir + "/cde.untouched") == "/old/unused\n");
+  }
+
+  SUBCASE("stub metadata-only, prune unused") {
+    struct stat meta_stat;
+    REQUIRE(stat((root + "/data/meta").c_str(), &meta_stat) == 0);
+    write_file(dir + "/cde.placeholders", "/big/blob\n");
+    trim(idx, dir, PKGTRIM_STUB, PKGTRIM_PRUNE, false, &report);
+    struct stat st;
+    REQUIRE(stat((root + "/data/meta").c_str(), &st) == 0);
+    CHECK(st.st_size == 20000);
+    CHECK(st.st_blocks == 0);
+    CHECK(st.st_mtime == meta_stat.st_mtime);
+    CHECK(st.st_mode == meta_stat.st_mode);
+    CHECK(contents(root + "/data/in") == "in\n");
+    CHECK(access((root + "/old/unused").c_str(), F_OK) != 0);
+    CHECK(access((root + "/old").c_str(), F_OK) == 0);
+    CHECK(report.num_dirs_pruned == 0);
+
+    manifest = manifest_load((dir + "/cde.manifest").c_str(), &root_stat);
+    CHECK(strmap_size(manifest) == 4);
+    CHECK(strmap_contains(manifest, "/data/in"));
+    CHECK(!strmap_contains(manifest, "/data/meta"));
+    CHECK(!strmap_contains(manifest, "/old/unused"));
+    manifest_free(manifest);
+    CHECK(contents(dir + "/cde.untouched") == "");
+
+    // stubs join the placeholders of earlier audits, so that a later audit
+    // replaces them with full copies
+    CHECK(contents(dir + "/cde.placeholders") == "/big/blob\n/data/meta\n/meta2/m\n");
+  }
+
+  SUBCASE("prune metadata-only, and the dirs left empty") {
+    const std::string listing = trim(idx, dir, PKGTRIM_PRUNE, PKGTRIM_PRUNE, false, &report);
+    CHECK(listing.find("dir prune 0 /meta2\n") != std::string::npos);
+    CHECK(listing.find("dir prune 0 /old\n") != std::string::npos);
+    CHECK(report.num_dirs_pruned == 2);
+    CHECK(access((root + "/meta2").c_str(), F_OK) != 0);
+    CHECK(access((root + "/old").c_str(), F_OK) != 0);
+    CHECK(access((root + "/data/meta").c_str(), F_OK) != 0);
+    CHECK(access((root + "/data/in").c_str(), F_OK) == 0);
+    CHECK(access((dir + "/cde.placeholders").c_str(), F_OK) != 0);
+  }
+
+  SUBCASE("no package") {
+    const PkgTrimOptions opts = { PKGTRIM_STUB, PKGTRIM_PRUNE, false };
+    CHECK(pkgtrim_package(idx, (dir + "/missing").c_str(), &opts, NULL, &report) == -1);
+  }
+
+  provindex_close(idx);
+  REQUIRE(system(("rm -rf " + dir).c_str()) == 0);
+
+}
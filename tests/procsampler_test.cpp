@@ -0,0 +1,112 @@
+/*******************************************************************************
+module:   procsampler_test
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  test cases for functions in strace-4.6/procsampler.c
+*******************************************************************************/
+
+#include "doctest.h"
+#include "procsampler.h"
+
+#include <cstring>    // ISOC: memset()
+#include <ctime>      // P1993: struct timespec, nanosleep()
+#include <unistd.h>   // P2001: getpid(), fork(), _exit(), sysconf()
+#include <sys/wait.h> // P2001: waitpid()
+
+static int num_samples = 0;
+static int num_lost = 0;
+static ProcSample last_sample;
+
+static void count_sample (const ProcSample* s, bool lost) {
+  if (lost) {
+    __atomic_add_fetch(&num_lost, 1, __ATOMIC_SEQ_CST);
+  } else {
+    last_sample = *s;
+    __atomic_add_fetch(&num_samples, 1, __ATOMIC_SEQ_CST);
+  }
+}
+
+// wait up to 2 sec for *count to reach n
+static bool wait_for (int* count, int n) {
+  const struct timespec ms10 = { 0, 10000000 };
+  for (int i = 0; i < 200 && __atomic_load_n(count, __ATOMIC_SEQ_CST) < n; i++) {
+    nanosleep(&ms10, NULL);
+  }
+  return __atomic_load_n(count, __ATOMIC_SEQ_CST) >= n;
+}
+
+TEST_CASE("procsampler_parse_stat") {
+
+  ProcSample s;
+  memset(&s, 0, sizeof(s));
+  const long ticks = sysconf(_SC_CLK_TCK);
+  const long page_kb = sysconf(_SC_PAGESIZE) / 1024;
+
+  SUBCASE("comm with spaces and parens") {
+    const char* buf = "42 (a (b) c) S 1 42 42 0 -1 4194560 100 0 0 0 "
+                      "250 50 0 0 20 0 1 0 12345 8192000 300 18446744073709551615";
+    REQUIRE(procsampler_parse_stat(buf, &s) == 0);
+    CHECK(s.utime_ms == 250ULL * 1000 / ticks);
+    CHECK(s.stime_ms == 50ULL * 1000 / ticks);
+    CHECK(s.vsize_bytes == 8192000ULL);
+    CHECK(s.rss_kb == 300 * page_kb);
+  }
+
+  SUBCASE("zombie has nothing to sample") {
+    CHECK(procsampler_parse_stat("42 (sh) Z 1 42 42 0 -1 4194560 100 0 0 0 "
+                                 "250 50 0 0 20 0 1 0 12345 0 0", &s) == -1);
+  }
+
+  SUBCASE("malformed") {
+    CHECK(procsampler_parse_stat("42 (sh", &s) == -1);
+    CHECK(procsampler_parse_stat("42 (sh) S 1 2", &s) == -1);
+  }
+}
+
+TEST_CASE("procsampler_parse_status and procsampler_parse_io") {
+
+  ProcSample s;
+  memset(&s, 0, sizeof(s));
+
+  SUBCASE("peak rss") {
+    CHECK(procsampler_parse_status("Name:\tsh\nVmPeak:\t  9000 kB\nVmHWM:\t  1234 kB\n", &s) == 0);
+    CHECK(s.peak_rss_kb == 1234);
+    CHECK(procsampler_parse_status("Name:\tsh\n", &s) == -1);
+  }
+
+  SUBCASE("read and write bytes, not cancelled write bytes") {
+    CHECK(procsampler_parse_io("rchar: 1\nwchar: 2\nsyscr: 3\nsyscw: 4\nread_bytes: 4096\n"
+                               "write_bytes: 8192\ncancelled_write_bytes: 512\n", &s) == 0);
+    CHECK(s.read_bytes == 4096ULL);
+    CHECK(s.write_bytes == 8192ULL);
+    CHECK(procsampler_parse_io("rchar: 1\n", &s) == -1);
+  }
+}
+
+TEST_CASE("procsampler_start") {
+
+  num_samples = 0;
+  num_lost = 0;
+  REQUIRE(procsampler_start(10, count_sample) == 0);
+
+  SUBCASE("samples a live process") {
+    procsampler_add_pid(getpid());
+    REQUIRE(wait_for(&num_samples, 2));
+    CHECK(last_sample.pid == getpid());
+    CHECK(last_sample.rss_kb > 0);
+    CHECK(last_sample.peak_rss_kb >= last_sample.rss_kb);
+    procsampler_remove_pid(getpid());
+  }
+
+  SUBCASE("reports a process that disappears as lost") {
+    const pid_t pid = fork();
+    if (pid == 0) {
+      _exit(0);
+    }
+    procsampler_add_pid(pid);
+    waitpid(pid, NULL, 0);
+    CHECK(wait_for(&num_lost, 1));
+  }
+
+  procsampler_stop();
+}
@@ -0,0 +1,113 @@
+/*******************************************************************************
+module:   provcoalesce_test
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  test cases for functions in strace-4.6/provcoalesce.c
+*******************************************************************************/
+
+#include "doctest.h"
+#include "provcoalesce.h"
+
+#include <cstdio>     // ISOC: snprintf()
+#include <string>     // ISOC++: std::string
+
+static std::string written;
+
+// record each flushed record as "first-last pid action count path;"
+static void write_record (const CoalescedRecord* rec) {
+  char buf[512];
+  snprintf(buf, sizeof(buf), "%d-%d %d %s %lu %s;", rec->first_time, rec->last_time,
+           (int)rec->pid, rec->action, rec->count, rec->path);
+  written += buf;
+}
+
+TEST_CASE("coalesce_record") {
+
+  written.clear();
+  coalesce_set_writer(write_record);
+
+  SUBCASE("repeated records are counted until the pid exits") {
+    for (int i = 0; i < 1000; i++) {
+      coalesce_record(100 + (i / 500), 7, "READ", "/etc/app.conf");
+      coalesce_record(100 + (i / 500), 7, "CLOSE", "/etc/app.conf");
+    }
+    CHECK(written == "");
+    coalesce_flush_pid(7);
+    CHECK(written == "100-101 7 READ 1000 /etc/app.conf;100-101 7 CLOSE 1000 /etc/app.conf;");
+  }
+
+  SUBCASE("flushing a pid leaves other pids pending") {
+    coalesce_record(100, 7, "READ", "/a");
+    coalesce_record(100, 8, "READ", "/b");
+    coalesce_flush_pid(8);
+    CHECK(written == "100-100 8 READ 1 /b;");
+    coalesce_flush_all();
+    CHECK(written == "100-100 8 READ 1 /b;100-100 7 READ 1 /a;");
+  }
+
+  SUBCASE("different access of a path flushes its pending records in order") {
+    coalesce_record(100, 7, "WRITE", "/log");
+    coalesce_record(100, 7, "WRITE", "/log");
+    coalesce_record(100, 7, "CLOSE", "/log");
+    coalesce_record(100, 9, "READ", "/other");
+    coalesce_record(101, 8, "READ", "/log");
+    CHECK(written == "100-100 7 WRITE 2 /log;100-100 7 CLOSE 1 /log;");
+    coalesce_flush_all();
+    CHECK(written == "100-100 7 WRITE 2 /log;100-100 7 CLOSE 1 /log;"
+                     "100-100 9 READ 1 /other;101-101 8 READ 1 /log;");
+  }
+
+  SUBCASE("flushing a path first flushes older records") {
+    coalesce_record(100, 7, "READ", "/in");
+    coalesce_record(100, 9, "READ", "/other");
+    coalesce_record(101, 7, "WRITE", "/log");
+    coalesce_record(102, 7, "READ", "/in");
+    coalesce_record(102, 9, "READ", "/new");
+    coalesce_record(103, 8, "READ", "/log");
+    CHECK(written == "100-102 7 READ 2 /in;100-100 9 READ 1 /other;101-101 7 WRITE 1 /log;");
+    coalesce_flush_all();
+    CHECK(written == "100-102 7 READ 2 /in;100-100 9 READ 1 /other;101-101 7 WRITE 1 /log;"
+                     "102-102 9 READ 1 /new;103-103 8 READ 1 /log;");
+  }
+
+  SUBCASE("records of earlier secs are flushed before other records") {
+    coalesce_record(100, 7, "READ", "/a");
+    coalesce_record(101, 8, "READ", "/b");
+    coalesce_record(101, 7, "READ", "/a");
+    coalesce_flush_before(101);
+    CHECK(written == "100-101 7 READ 2 /a;");
+    coalesce_record(101, 8, "READ", "/b");
+    coalesce_flush_before(101);
+    CHECK(written == "100-101 7 READ 2 /a;");
+    coalesce_flush_before(102);
+    CHECK(written == "100-101 7 READ 2 /a;101-101 8 READ 2 /b;");
+  }
+
+  SUBCASE("same access by another pid does not flush") {
+    coalesce_record(100, 7, "READ", "/lib.so");
+    coalesce_record(100, 8, "READ", "/lib.so");
+    coalesce_record(100, 7, "READ", "/lib.so");
+    CHECK(written == "");
+    coalesce_flush_all();
+    CHECK(written == "100-100 7 READ 2 /lib.so;100-100 8 READ 1 /lib.so;");
+  }
+
+  SUBCASE("records pending too long are flushed") {
+    coalesce_record(100, 7, "READ", "/a");
+    coalesce_record(100 + COALESCE_MAX_SECS, 7, "READ", "/a");
+    CHECK(written == "100-100 7 READ 1 /a;");
+    coalesce_flush_all();
+  }
+
+  SUBCASE("too many pending records are flushed") {
+    for (int i = 0; i <= COALESCE_MAX_PENDING; i++) {
+      coalesce_record(100, i, "READ", "/a");
+    }
+    CHECK(written.find("4095 READ 1 /a;") != std::string::npos);
+    CHECK(written.find(" 4096 READ") == std::string::npos);
+    coalesce_flush_all();
+  }
+
+  coalesce_flush_all();
+  coalesce_set_writer(NULL);
+}
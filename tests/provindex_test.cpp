@@ -0,0 +1,225 @@
+/*******************************************************************************
+module:   provindex_test
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  test cases for functions in strace-4.6/provindex.c
+*******************************************************************************/
+
+#include "doctest.h"
+#include "provindex.h"
+
+#include <cstdio>     // ISOC: FILE, fopen(), fputs(), fclose(), remove()
+#include <cstring>    // ISOC: strcpy()
+#include <string>     // ISOC++: std::string
+#include <unistd.h>   // P2001: getpid()
+
+// parse a copy of line
+static int parse (const char* line, ProvRecord* rec) {
+  static char buf[512];
+  strcpy(buf, line);
+  return provindex_parse_record(buf, rec);
+}
+
+// names of the marked procs (by pid) and paths, e.g. "3 /b "
+static std::string marked (const ProvIndex* idx, const bool* proc_marks, const bool* path_marks) {
+  std::string s;
+  for (uint32_t i = 0; i < provindex_num_procs(idx); i++) {
+    if (proc_marks[i]) {
+      s += std::to_string(provindex_proc(idx, i)->pid) + " ";
+    }
+  }
+  for (uint32_t i = 0; i < provindex_num_paths(idx); i++) {
+    if (path_marks[i]) {
+      s += std::string(provindex_path(idx, i)) + " ";
+    }
+  }
+  return s;
+}
+
+TEST_CASE("provindex_parse_record") {
+
+  ProvRecord rec;
+
+  SUBCASE("file access, with spaces in path") {
+    REQUIRE(parse("100 7 READ /a b/c\n", &rec) == 0);
+    CHECK(rec.time == 100);
+    CHECK(rec.pid == 7);
+    CHECK(rec.kind == PROVIDX_READ);
+    CHECK(rec.count == 1);
+    CHECK(std::string(rec.path) == "/a b/c");
+  }
+
+  SUBCASE("repeat counts the accesses after the first") {
+    REQUIRE(parse("105 7 REPEAT CLOSE 40 /a", &rec) == 0);
+    CHECK(rec.kind == PROVIDX_CLOSE);
+    CHECK(rec.count == 39);
+    CHECK(std::string(rec.path) == "/a");
+  }
+
+  SUBCASE("execve and spawn name the parent first") {
+    REQUIRE(parse("100 6 EXECVE 7 /bin/sh /home ['sh', '-c']", &rec) == 0);
+    CHECK(rec.kind == PROVIDX_EXECVE);
+    CHECK(rec.ppid == 6);
+    CHECK(rec.pid == 7);
+    CHECK(std::string(rec.path) == "/bin/sh");
+    REQUIRE(parse("100 7 SPAWN 8", &rec) == 0);
+    CHECK(rec.kind == PROVIDX_SPAWN);
+    CHECK(rec.ppid == 7);
+    CHECK(rec.pid == 8);
+  }
+
+  SUBCASE("byte counts and samples") {
+    REQUIRE(parse("100 7 IOBYTES 4096 12 /out", &rec) == 0);
+    CHECK(rec.vals[0] == 4096);
+    CHECK(rec.vals[1] == 12);
+    CHECK(std::string(rec.path) == "/out");
+    REQUIRE(parse("100 7 USAGE 10 20 30 40 50 60", &rec) == 0);
+    CHECK(rec.kind == PROVIDX_USAGE);
+    CHECK(rec.vals[5] == 60);
+    REQUIRE(parse("100 7 LEXIT", &rec) == 0);
+    CHECK(rec.kind == PROVIDX_LEXIT);
+  }
+
+  SUBCASE("comments and malformed records") {
+    CHECK(parse("# @agent: me", &rec) == -1);
+    CHECK(parse("", &rec) == -1);
+    CHECK(parse("100 7", &rec) == -1);
+    CHECK(parse("100 7 READ", &rec) == -1);
+    CHECK(parse("100 7 REPEAT EXIT 2 /a", &rec) == -1);
+    CHECK(parse("100 x READ /a", &rec) == -1);
+    REQUIRE(parse("100 7 PTRACE", &rec) == 0);
+    CHECK(rec.kind == PROVIDX_OTHER);
+  }
+}
+
+TEST_CASE("provindex_build and queries") {
+
+  // sh (2) spawns gen (3), which writes /mid, and use (4), which reads /mid
+  // and writes /out; other (5) only reads /in
+  const std::string log_path = "/tmp/provindex_test." + std::to_string(getpid()) + ".log";
+  const std::string index_path = log_path + ".idx";
+  FILE* log = fopen(log_path.c_str(), "w");
+  REQUIRE(log);
+  fputs("# @agent: me\n"
+        "100 1 EXECVE 2 /bin/sh /w [sh]\n"
+        "100 2 SPAWN 3\n"
+        "100 2 EXECVE 3 /bin/gen /w [gen]\n"
+        "101 3 READ /in\n"
+        "101 3 WRITE /mid\n"
+        "101 3 REPEAT WRITE 5 /mid\n"
+        "102 3 EXIT\n"
+        "102 2 SPAWN 4\n"
+        "102 2 EXECVE 4 /bin/use /w [use]\n"
+        "103 4 READ /mid\n"
+        "103 4 IOBYTES 0 10 /out\n"
+        "103 4 USAGE 1 2048 3 4 5 6\n"
+        "104 4 EXIT\n"
+        "104 9 SPAWN 5\n"
+        "104 5 READ /in\n", log);
+  fclose(log);
+  REQUIRE(provindex_build(log_path.c_str(), index_path.c_str()) == 0);
+  ProvIndex* idx = provindex_open(index_path.c_str());
+  REQUIRE(idx);
+
+  bool procs[8] = { false };
+  bool paths[8] = { false };
+
+  SUBCASE("tables") {
+    CHECK(provindex_num_procs(idx) == 4);
+    CHECK(provindex_num_paths(idx) == 6);
+    CHECK(provindex_num_events(idx) == 9);
+    const ProvProc* use = provindex_proc(idx, 2);
+    CHECK(use->pid == 4);
+    CHECK(use->parent == 0);
+    CHECK(std::string(provindex_path(idx, use->exe)) == "/bin/use");
+    CHECK(use->end_time == 104);
+    CHECK(use->peak_rss_kb == 2048);
+    CHECK(provindex_proc(idx, 3)->parent == PROVIDX_NONE);
+    const char* program;
+    const char* cwd;
+    const char* args;
+    REQUIRE(provindex_proc_cmd(idx, 2, &program, &cwd, &args));
+    CHECK(std::string(program) == "/bin/use");
+    CHECK(std::string(cwd) == "/w");
+    CHECK(std::string(args) == "[use]");
+    CHECK_FALSE(provindex_proc_cmd(idx, 3, &program, &cwd, &args));
+    CHECK(provindex_find_path(idx, "/nope") == PROVIDX_NONE);
+
+    // postings of /mid, newest first: READ by use, REPEAT and WRITE by gen
+    uint64_t counts = 0;
+    int num = 0;
+    for (uint64_t e = provindex_last_event_of_path(idx, provindex_find_path(idx, "/mid"));
+         e != PROVIDX_NO_EVENT; e = provindex_event(idx, e)->prev_of_path) {
+      counts += provindex_event(idx, e)->count;
+      num++;
+    }
+    CHECK(num == 3);
+    CHECK(counts == 6);
+  }
+
+  SUBCASE("ancestors of a file") {
+    paths[provindex_find_path(idx, "/out")] = true;
+    provindex_ancestors(idx, procs, paths);
+    CHECK(marked(idx, procs, paths) == "2 3 4 /bin/sh /bin/gen /in /mid /bin/use ");
+  }
+
+  SUBCASE("descendants of a file") {
+    paths[provindex_find_path(idx, "/in")] = true;
+    provindex_descendants(idx, procs, paths);
+    CHECK(marked(idx, procs, paths) == "3 4 5 /mid /out ");
+  }
+
+  SUBCASE("closure of a proc") {
+    procs[1] = true;
+    provindex_closure(idx, procs, paths);
+    CHECK(marked(idx, procs, paths) == "3 /bin/gen /in /mid ");
+  }
+
+  SUBCASE("stale or corrupt indexes do not open") {
+    std::string bytes;
+    FILE* f = fopen(index_path.c_str(), "rb");
+    REQUIRE(f);
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+      bytes.append(buf, n);
+    }
+    fclose(f);
+
+    // (find event 2 and proc 1 in the file by their bytes)
+    const ProvEvent ev = *provindex_event(idx, 2);
+    const ProvProc proc = *provindex_proc(idx, 1);
+    const size_t ev_off = bytes.find(std::string((const char*)&ev, sizeof(ev)));
+    const size_t proc_off = bytes.find(std::string((const char*)&proc, sizeof(proc)));
+    REQUIRE(ev_off != std::string::npos);
+    REQUIRE(proc_off != std::string::npos);
+
+    const std::string bad_path = index_path + ".bad";
+    for (int i = -1; i < 5; i++) {
+      std::string bad = bytes;
+      ProvEvent bad_ev = ev;
+      ProvProc bad_proc = proc;
+      switch (i) {
+        case 0: bad_ev.prev_of_path = 1000000; break;
+        case 1: bad_ev.prev_of_proc = 2; break;       // (a cycle)
+        case 2: bad_ev.path = 6; break;
+        case 3: bad_proc.parent = 1; break;
+        case 4: bad_proc.cmd = bytes.size(); break;
+      }
+      bad.replace(ev_off, sizeof(ev), std::string((const char*)&bad_ev, sizeof(ev)));
+      bad.replace(proc_off, sizeof(proc), std::string((const char*)&bad_proc, sizeof(proc)));
+      f = fopen(bad_path.c_str(), "wb");
+      REQUIRE(f);
+      fwrite(bad.data(), 1, bad.size(), f);
+      fclose(f);
+      ProvIndex* bad_idx = provindex_open(bad_path.c_str());
+      CHECK((bad_idx != NULL) == (i < 0));    // (-1: unchanged copy)
+      provindex_close(bad_idx);
+    }
+    remove(bad_path.c_str());
+  }
+
+  provindex_close(idx);
+  remove(index_path.c_str());
+  remove(log_path.c_str());
+}
@@ -0,0 +1,106 @@
+/*******************************************************************************
+module:   provmerge_test
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  test cases for functions in strace-4.6/provmerge.c
+*******************************************************************************/
+
+#include "doctest.h"
+#include "provmerge.h"
+
+#include <cstdio>     // ISOC: FILE, fopen(), fputs(), fclose(), remove(), tmpfile()
+#include <string>     // ISOC++: std::string
+#include <unistd.h>   // P2001: getpid()
+
+// write contents to a temp log, return its path
+static std::string write_log (const char* name, const char* contents) {
+  const std::string path = "/tmp/provmerge_test." + std::to_string(getpid()) + "." + name;
+  FILE* f = fopen(path.c_str(), "w");
+  fputs(contents, f);
+  fclose(f);
+  return path;
+}
+
+// merge logs, return merged log (without the namespace headers)
+static std::string merge (const std::string* paths, int num) {
+  const char* cpaths[8];
+  for (int i = 0; i < num; i++) {
+    cpaths[i] = paths[i].c_str();
+  }
+  FILE* out = tmpfile();
+  CHECK(provmerge_logs(cpaths, num, out) == 0);
+  rewind(out);
+  std::string merged;
+  char line[512];
+  while (fgets(line, sizeof(line), out)) {
+    if (std::string(line).compare(0, 5, "# @ns") != 0 && std::string(line).compare(0, 9, "# @merged") != 0) {
+      merged += line;
+    }
+  }
+  fclose(out);
+  return merged;
+}
+
+TEST_CASE("provmerge_logs") {
+
+  SUBCASE("orders by time, parent namespace first, each log in its own order") {
+    std::string paths[2];
+    paths[0] = write_log("b", "# @fullns: ns.2\n# @parentns: ns.1\n"
+                              "10 1 READ /b1\n"
+                              "12 1 READ /b2\n"
+                              "11 1 READ /b3\n");
+    paths[1] = write_log("a", "# @fullns: ns.1\n# @parentns: (null)\n"
+                              "10 2 READ /a1\n"
+                              "11 2 READ /a2\n");
+    CHECK(merge(paths, 2) == "10 2 READ /a1\n"
+                             "10 1 READ /b1\n"
+                             "11 2 READ /a2\n"
+                             "12 1 READ /b2\n"
+                             "11 1 READ /b3\n");
+    remove(paths[0].c_str());
+    remove(paths[1].c_str());
+  }
+
+  SUBCASE("pids used by another namespace are renamed, root linked to tracer") {
+    // in ns.1, sh (10) runs an inner ptu (11), which traces ns.2, whose root
+    // (12) spawns a proc that gets pid 10 again
+    std::string paths[2];
+    paths[0] = write_log("outer", "# @fullns: ns.1\n# @parentns: (null)\n"
+                                  "100 5 EXECVE 10 /bin/sh /w [sh]\n"
+                                  "100 10 SPAWN 11\n"
+                                  "100 10 EXECVE 11 /bin/ptu /w [ptu]\n"
+                                  "103 11 EXIT\n");
+    paths[1] = write_log("inner", "# @fullns: ns.2\n# @parentns: ns.1\n"
+                                  "101 11 EXECVE 12 /bin/sh /w [sh]\n"
+                                  "102 12 SPAWN 10\n"
+                                  "102 10 WRITE /out\n"
+                                  "102 10 EXIT\n");
+    CHECK(merge(paths, 2) == "100 5 EXECVE 10 /bin/sh /w [sh]\n"
+                             "100 10 SPAWN 11\n"
+                             "100 10 EXECVE 11 /bin/ptu /w [ptu]\n"
+                             "101 11 EXECVE 12 /bin/sh /w [sh]\n"
+                             "# @pid: 4194304 ns.2 10 102\n"
+                             "102 12 SPAWN 4194304\n"
+                             "102 4194304 WRITE /out\n"
+                             "102 4194304 EXIT\n"
+                             "103 11 EXIT\n");
+    remove(paths[0].c_str());
+    remove(paths[1].c_str());
+  }
+
+  SUBCASE("large logs are merged in chunks") {
+    std::string big;
+    for (int i = 0; i < 20000; i++) {
+      big += std::to_string(i) + " 1 READ /some/long/path/to/a/file/number/" + std::to_string(i) + "\n";
+    }
+    std::string paths[2];
+    paths[0] = write_log("big1", big.c_str());
+    paths[1] = write_log("big2", big.c_str());
+    const std::string merged = merge(paths, 2);
+    // second log's pid 1 is renamed to 4194304 (6 more chars per record)
+    CHECK(merged.size() == 2 * big.size() + 20000 * 6 + ("# @pid: 4194304 " + paths[1] + " 1 0\n").size());
+    CHECK(merged.find("19999 4194304 READ /some/long/path/to/a/file/number/19999\n") != std::string::npos);
+    remove(paths[0].c_str());
+    remove(paths[1].c_str());
+  }
+}
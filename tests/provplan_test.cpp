@@ -0,0 +1,278 @@
+/*******************************************************************************
+module:   provplan_test
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  test cases for functions in strace-4.6/provplan.c
+*******************************************************************************/
+
+#include "doctest.h"
+#include "provplan.h"
+
+#include <cstdio>     // ISOC: FILE, fopen(), fputs(), fgets(), fclose(), remove()
+#include <cstdlib>    // ISOC: free(), system()
+#include <string>     // ISOC++: std::string
+#include <sys/stat.h> // P2001: mkdir(), chmod()
+#include <unistd.h>   // P2001: getpid()
+
+// parse args, return them joined by '|', or "error"
+static std::string parse (const char* args) {
+  char** argv;
+  const int argc = provplan_parse_args(args, &argv);
+  if (argc < 0) {
+    return "error";
+  }
+  std::string s;
+  for (int i = 0; i < argc; i++) {
+    s += std::string(i == 0 ? "" : "|") + argv[i];
+    free(argv[i]);
+  }
+  free(argv);
+  return s;
+}
+
+// pids of the steps of plan p (freed), each with its deps, e.g. "3 4<1 "
+static std::string steps (const ProvIndex* idx, ProvPlan* p) {
+  if (!p) {
+    return "none";
+  }
+  std::string s;
+  for (uint32_t i = 0; i < p->num_steps; i++) {
+    s += std::to_string(provindex_proc(idx, p->steps[i].proc)->pid);
+    for (uint32_t d = 0; d < p->steps[i].num_deps; d++) {
+      s += "<" + std::to_string(p->steps[i].deps[d] + 1);
+    }
+    s += " ";
+  }
+  provplan_free(p);
+  return s;
+}
+
+// steps of the plan for changed path
+static std::string plan (const ProvIndex* idx, const char* changed) {
+  bool paths[16] = { false };
+  paths[provindex_find_path(idx, changed)] = true;
+  return steps(idx, provplan_new(idx, paths, 0));
+}
+
+// write log to path, index it, return opened index
+static ProvIndex* open_log (const std::string& log_path, const char* log) {
+  FILE* f = fopen(log_path.c_str(), "w");
+  fputs(log, f);
+  fclose(f);
+  CHECK(provindex_build(log_path.c_str(), (log_path + ".idx").c_str()) == 0);
+  return provindex_open((log_path + ".idx").c_str());
+}
+
+// return contents of file (or "" if none)
+static std::string contents (const std::string& path) {
+  std::string s;
+  FILE* f = fopen(path.c_str(), "r");
+  if (f) {
+    char buf[256];
+    while (fgets(buf, sizeof(buf), f)) {
+      s += buf;
+    }
+    fclose(f);
+  }
+  return s;
+}
+
+TEST_CASE("provplan_parse_args") {
+  CHECK(parse("[\"sh\", \"-c\", \"a \\\"b\\\" > c\"]") == "sh|-c|a \"b\" > c");
+  CHECK(parse("[\"printf\", \"\\t\\n\\x41\\101\\\\\"]") == "printf|\t\nAA\\");
+  CHECK(parse("[]") == "");
+  CHECK(parse("[\"sh\", ...]") == "error");
+  CHECK(parse("[\"a very long arg\"...]") == "error");
+  CHECK(parse("[\"sh\", 0x7ffd1234]") == "error");
+  CHECK(parse("[\"sh\"") == "error");
+}
+
+TEST_CASE("provplan_new") {
+
+  // sh (2) runs gen (3), which writes /mid, and use (4), which reads /mid and
+  // writes /out; cat (5) gets its stdout from sh ("cat /in3 > /red"); a (6)
+  // and b (7) run alongside each other (as in "a /in4 | b")
+  const std::string log_path = "/tmp/provplan_test." + std::to_string(getpid()) + ".log";
+  const std::string index_path = log_path + ".idx";
+  FILE* log = fopen(log_path.c_str(), "w");
+  REQUIRE(log);
+  fputs("100 1 EXECVE 2 /bin/sh /w [\"sh\", \"-c\", \"...\"]\n"
+        "100 2 SPAWN 3\n"
+        "100 2 EXECVE 3 /bin/gen /w [\"gen\", \"/in\", \"/mid\"]\n"
+        "101 3 READ /in\n"
+        "101 3 WRITE /mid\n"
+        "102 3 EXIT\n"
+        "102 2 SPAWN 4\n"
+        "102 2 EXECVE 4 /bin/use /w [\"use\"]\n"
+        "103 4 READ /mid\n"
+        "103 4 WRITE /out\n"
+        "104 4 EXIT\n"
+        "104 2 SPAWN 5\n"
+        "104 5 WRITE /red\n"
+        "104 2 EXECVE 5 /bin/cat /w [\"cat\", \"/in3\"]\n"
+        "104 5 READ /in3\n"
+        "104 5 EXIT\n"
+        "105 2 SPAWN 6\n"
+        "105 2 SPAWN 7\n"
+        "105 2 EXECVE 6 /bin/a /w [\"a\", \"/in4\"]\n"
+        "105 2 EXECVE 7 /bin/b /w [\"b\"]\n"
+        "105 6 READ /in4\n"
+        "106 6 EXIT\n"
+        "106 7 WRITE /out4\n"
+        "106 7 EXIT\n"
+        "107 2 EXIT\n", log);
+  fclose(log);
+  REQUIRE(provindex_build(log_path.c_str(), index_path.c_str()) == 0);
+  ProvIndex* idx = provindex_open(index_path.c_str());
+  REQUIRE(idx);
+
+  SUBCASE("re-run the readers of a changed file, and theirs, in order") {
+    CHECK(plan(idx, "/in") == "3 4<1 ");
+    CHECK(plan(idx, "/mid") == "4 ");
+  }
+
+  SUBCASE("nothing to re-run for a file no proc read") {
+    CHECK(plan(idx, "/out") == "");
+  }
+
+  SUBCASE("redirected or pipelined procs are re-run by their parent") {
+    CHECK(plan(idx, "/in3") == "2 ");
+    CHECK(plan(idx, "/in4") == "2 ");
+  }
+
+  SUBCASE("procs that ran at once are re-run by themselves if not piped") {
+    bool paths[16] = { false };
+    paths[provindex_find_path(idx, "/in4")] = true;
+    CHECK(steps(idx, provplan_new(idx, paths, PROVPLAN_NO_PIPES)) == "6 ");
+  }
+
+  provindex_close(idx);
+  remove(index_path.c_str());
+  remove(log_path.c_str());
+}
+
+TEST_CASE("provplan fingerprints") {
+
+  // cde-package with a cde-root holding /in, which a proc read
+  const std::string package = "/tmp/provplan_test." + std::to_string(getpid()) + ".pkg";
+  const std::string log_path = package + "/provenance.log";
+  const std::string index_path = log_path + ".idx";
+  REQUIRE(mkdir(package.c_str(), 0755) == 0);
+  REQUIRE(mkdir((package + "/cde-root").c_str(), 0755) == 0);
+  FILE* f = fopen((package + "/cde-root/in").c_str(), "w");
+  fputs("one", f);
+  fclose(f);
+  f = fopen(log_path.c_str(), "w");
+  fputs("100 1 EXECVE 2 /bin/cat /w [\"cat\", \"/in\"]\n"
+        "101 2 READ /in\n"
+        "101 2 READ /gone\n", f);
+  fclose(f);
+  REQUIRE(provindex_build(log_path.c_str(), index_path.c_str()) == 0);
+  ProvIndex* idx = provindex_open(index_path.c_str());
+  REQUIRE(idx);
+  bool paths[8] = { false };
+
+  CHECK(provplan_mark_changed(idx, package.c_str(), paths) == -1);
+  REQUIRE(provplan_save_fingerprints(idx, package.c_str()) == 0);
+  CHECK(provplan_mark_changed(idx, package.c_str(), paths) == 0);
+
+  SUBCASE("changed contents") {
+    f = fopen((package + "/cde-root/in").c_str(), "w");
+    fputs("two", f);
+    fclose(f);
+    CHECK(provplan_mark_changed(idx, package.c_str(), paths) == 1);
+    CHECK(paths[provindex_find_path(idx, "/in")]);
+  }
+
+  SUBCASE("created files") {
+    f = fopen((package + "/cde-root/gone").c_str(), "w");
+    fclose(f);
+    CHECK(provplan_mark_changed(idx, package.c_str(), paths) == 1);
+    CHECK(paths[provindex_find_path(idx, "/gone")]);
+  }
+
+  provindex_close(idx);
+  CHECK(system(("rm -rf " + package).c_str()) == 0);
+}
+
+// sh (2) runs a (3) and b (4) at once, which write /w/a and /w/b; then c (5),
+// which reads both and writes /w/c; then d (6), which rewrites /w/a; and
+// echo (7), which writes no files
+static const char* const replay_log =
+  "100 1 EXECVE 2 /bin/sh /w [\"sh\", \"-c\", \"...\"]\n"
+  "100 2 READ /etc/profile\n"
+  "100 2 SPAWN 3\n"
+  "100 2 SPAWN 4\n"
+  "100 2 EXECVE 3 /bin/sh /w [\"sh\", \"-c\", \"sleep 0.2; echo a > a\"]\n"
+  "100 2 EXECVE 4 /bin/sh /w [\"sh\", \"-c\", \"echo b > b\"]\n"
+  "100 4 WRITE /w/b\n"
+  "100 4 WRITE /dev/null\n"
+  "100 4 EXIT\n"
+  "101 3 WRITE /w/a\n"
+  "101 3 EXIT\n"
+  "101 2 SPAWN 5\n"
+  "101 2 EXECVE 5 /bin/sh /w [\"sh\", \"-c\", \"cat a b > c\"]\n"
+  "101 5 READ /w/a\n"
+  "101 5 READ /w/b\n"
+  "101 5 WRITE /w/c\n"
+  "101 5 WRITE /dev/null\n"
+  "101 5 EXIT\n"
+  "102 2 SPAWN 6\n"
+  "102 2 EXECVE 6 /bin/sh /w [\"sh\", \"-c\", \"echo d > a\"]\n"
+  "102 6 WRITE /w/a\n"
+  "102 6 EXIT\n"
+  "102 2 SPAWN 7\n"
+  "102 2 EXECVE 7 /bin/echo /w [\"echo\", \"done\"]\n"
+  "102 7 EXIT\n"
+  "103 2 EXIT\n";
+
+TEST_CASE("provplan_new_replay") {
+  const std::string log_path = "/tmp/provplan_test." + std::to_string(getpid()) + ".replay.log";
+  ProvIndex* idx = open_log(log_path, replay_log);
+  REQUIRE(idx);
+
+  SUBCASE("procs that ran at once may have been piped, so their parent is re-run") {
+    CHECK(steps(idx, provplan_new_replay(idx, 0)) == "2 ");
+  }
+
+  SUBCASE("independent subtrees, each after those whose files it shares") {
+    CHECK(steps(idx, provplan_new_replay(idx, PROVPLAN_NO_PIPES)) == "3 4 5<1<2 6<1<3 ");
+  }
+
+  provindex_close(idx);
+  remove((log_path + ".idx").c_str());
+  remove(log_path.c_str());
+}
+
+TEST_CASE("provplan_run_parallel") {
+
+  // cde-package whose cde-exec just runs its command
+  const std::string package = "/tmp/provplan_test." + std::to_string(getpid()) + ".run";
+  REQUIRE(mkdir(package.c_str(), 0755) == 0);
+  REQUIRE(mkdir((package + "/cde-root").c_str(), 0755) == 0);
+  REQUIRE(mkdir((package + "/cde-root/w").c_str(), 0755) == 0);
+  FILE* f = fopen((package + "/cde-exec").c_str(), "w");
+  fputs("#!/bin/sh\nexec \"$@\"\n", f);
+  fclose(f);
+  REQUIRE(chmod((package + "/cde-exec").c_str(), 0755) == 0);
+  ProvIndex* idx = open_log(package + "/provenance.log", replay_log);
+  REQUIRE(idx);
+  ProvPlan* p = provplan_new_replay(idx, PROVPLAN_NO_PIPES);
+  REQUIRE(p);
+
+  SUBCASE("steps run after the steps they depend on") {
+    CHECK(provplan_run_parallel(idx, p, package.c_str(), 4) == 0);
+    CHECK(contents(package + "/cde-root/w/c") == "a\nb\n");
+    CHECK(contents(package + "/cde-root/w/a") == "d\n");
+  }
+
+  SUBCASE("no steps run after one fails") {
+    remove((package + "/cde-exec").c_str());
+    CHECK(provplan_run_parallel(idx, p, package.c_str(), 4) == -1);
+    CHECK(contents(package + "/cde-root/w/c") == "");
+  }
+
+  provplan_free(p);
+  provindex_close(idx);
+  CHECK(system(("rm -rf " + package).c_str()) == 0);
+}
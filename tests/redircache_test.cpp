@@ -0,0 +1,73 @@
+/*******************************************************************************
+module:   redircache_test
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  test cases for functions in strace-4.6/redircache.c
+*******************************************************************************/
+
+#include "doctest.h"
+#include "redircache.h"
+
+#include <string>     // ISOC++: std::string
+
+// return cached redirection of path in cwd, "(none)" if not redirected, or
+// "(miss)" if not cached
+static std::string get (RedirCache* cache, const char* cwd, const char* path) {
+  const char* redirected;
+  if (!redircache_get(cache, cwd, path, &redirected)) {
+    return "(miss)";
+  }
+  return redirected ? redirected : "(none)";
+}
+
+TEST_CASE("redircache_get / redircache_put") {
+  RedirCache* cache = redircache_new(3);
+
+  SUBCASE("redirected and not-redirected paths are cached") {
+    CHECK(get(cache, "/w", "/a") == "(miss)");
+    redircache_put(cache, "/w", "/a", "/pkg/cde-root/a");
+    redircache_put(cache, "/w", "/tmp/b", NULL);
+    CHECK(get(cache, "/w", "/a") == "/pkg/cde-root/a");
+    CHECK(get(cache, "/w", "/tmp/b") == "(none)");
+    redircache_put(cache, "/w", "/a", "/pkg/cde-root/a2");
+    CHECK(get(cache, "/w", "/a") == "/pkg/cde-root/a2");
+    CHECK(redircache_size(cache) == 2);
+  }
+
+  SUBCASE("absolute paths hit in any cwd, relative ones only in theirs") {
+    redircache_put(cache, "/w", "/a", "/pkg/cde-root/a");
+    redircache_put(cache, "/w", "a", "/pkg/cde-root/w/a");
+    CHECK(get(cache, "/v", "/a") == "/pkg/cde-root/a");
+    CHECK(get(cache, "/w", "a") == "/pkg/cde-root/w/a");
+    CHECK(get(cache, "/v", "a") == "(miss)");
+    redircache_put(cache, "/v", "a", "/pkg/cde-root/v/a");
+    CHECK(get(cache, "/v", "a") == "/pkg/cde-root/v/a");
+    CHECK(get(cache, "/w", "a") == "/pkg/cde-root/w/a");
+  }
+
+  SUBCASE("least recently used paths are evicted") {
+    redircache_put(cache, "/w", "/a", "/r/a");
+    redircache_put(cache, "/w", "/b", "/r/b");
+    redircache_put(cache, "/w", "/c", "/r/c");
+    CHECK(get(cache, "/w", "/a") == "/r/a");
+    redircache_put(cache, "/w", "/d", "/r/d");
+    CHECK(redircache_size(cache) == 3);
+    CHECK(get(cache, "/w", "/b") == "(miss)");
+    CHECK(get(cache, "/w", "/a") == "/r/a");
+    CHECK(get(cache, "/w", "/c") == "/r/c");
+    CHECK(get(cache, "/w", "/d") == "/r/d");
+  }
+
+  SUBCASE("clear forgets all paths") {
+    redircache_put(cache, "/w", "/a", "/r/a");
+    redircache_put(cache, "/w", "b", "/r/w/b");
+    redircache_clear(cache);
+    CHECK(redircache_size(cache) == 0);
+    CHECK(get(cache, "/w", "/a") == "(miss)");
+    CHECK(get(cache, "/w", "b") == "(miss)");
+    redircache_put(cache, "/w", "b", "/r/w/b");
+    CHECK(get(cache, "/w", "b") == "/r/w/b");
+  }
+
+  redircache_free(cache);
+}
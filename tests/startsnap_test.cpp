@@ -0,0 +1,92 @@
+/*******************************************************************************
+module:   startsnap_test
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  test cases for functions in strace-4.6/startsnap.c
+*******************************************************************************/
+
+#include "doctest.h"
+#include "startsnap.h"
+
+#include <cstdio>       // ISOC: fopen(), fputs(), fclose()
+#include <cstdlib>      // ISOC: mkdtemp(), system()
+#include <string>       // ISOC: std::string
+#include <unistd.h>     // P2001: truncate()
+
+// section name of snap as a string, or "(none)"
+static std::string section (const StartSnap* snap, const char* name) {
+  size_t size = 0;
+  const void* data = startsnap_section(snap, name, &size);
+  return data ? std::string((const char*)data, size) : std::string("(none)");
+}
+
+TEST_CASE("startsnap_hash") {
+
+  SUBCASE("known FNV-1a values") {
+    CHECK(startsnap_hash(STARTSNAP_HASH_INIT, "", 0) == 0xcbf29ce484222325ULL);
+    CHECK(startsnap_hash(STARTSNAP_HASH_INIT, "a", 1) == 0xaf63dc4c8601ec8cULL);
+  }
+
+  SUBCASE("file stamps differ from a missing file's") {
+    const uint64_t missing = startsnap_hash_file(STARTSNAP_HASH_INIT, "/nonexistent/file");
+    CHECK(startsnap_hash_file(STARTSNAP_HASH_INIT, "/proc/self/exe") != missing);
+    CHECK(startsnap_hash_file(STARTSNAP_HASH_INIT, "/nonexistent/other") == missing);
+  }
+
+}
+
+TEST_CASE("startsnap_save and startsnap_open") {
+
+  char dir_template[] = "/tmp/startsnap_test.XXXXXX";
+  const char* dir = mkdtemp(dir_template);
+  REQUIRE(dir != NULL);
+  const std::string fn = std::string(dir) + "/cde.startup.cde-root";
+  const uint64_t key = 42;
+
+  StartSnapWriter* w = startsnap_writer_new();
+  startsnap_add(w, "options", "\002/tmp/\0", 7);
+  startsnap_append(w, "\003DISPLAY\0", 9);
+  startsnap_add(w, "empty", NULL, 0);
+  startsnap_add(w, "environment", "A=1\0B=2\0", 8);
+  REQUIRE(startsnap_save(w, fn.c_str(), key) == 0);
+  startsnap_writer_free(w);
+
+  SUBCASE("round trip") {
+    StartSnap* snap = startsnap_open(fn.c_str(), key);
+    REQUIRE(snap != NULL);
+    CHECK(section(snap, "options") == std::string("\002/tmp/\0\003DISPLAY\0", 16));
+    CHECK(section(snap, "empty") == "");
+    CHECK(section(snap, "environment") == std::string("A=1\0B=2\0", 8));
+    CHECK(section(snap, "missing") == "(none)");
+    startsnap_close(snap);
+  }
+
+  SUBCASE("other key") {
+    CHECK(startsnap_open(fn.c_str(), key + 1) == NULL);
+  }
+
+  SUBCASE("truncated") {
+    REQUIRE(truncate(fn.c_str(), 100) == 0);
+    CHECK(startsnap_open(fn.c_str(), key) == NULL);
+  }
+
+  SUBCASE("not a snapshot") {
+    FILE* f = fopen(fn.c_str(), "w");
+    fputs("cde.options v1 (do not alter this first line!)\n", f);
+    fclose(f);
+    CHECK(startsnap_open(fn.c_str(), key) == NULL);
+  }
+
+  SUBCASE("missing") {
+    CHECK(startsnap_open((fn + ".missing").c_str(), key) == NULL);
+  }
+
+  SUBCASE("unwritable dir") {
+    StartSnapWriter* w2 = startsnap_writer_new();
+    CHECK(startsnap_save(w2, "/nonexistent/dir/cde.startup.cde-root", key) == -1);
+    startsnap_writer_free(w2);
+  }
+
+  REQUIRE(system(("rm -rf " + std::string(dir)).c_str()) == 0);
+
+}
@@ -0,0 +1,87 @@
+/*******************************************************************************
+module:   strmap_test
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  test cases for functions in strace-4.6/strmap.c
+*******************************************************************************/
+
+#include "doctest.h"
+#include "strmap.h"
+
+#include <cstdio>       // ISOC: snprintf()
+
+static void count_keys (const char* key, void* val, void* arg) {
+  (void)key;
+  (void)val;
+  (*(int*)arg)++;
+}
+
+TEST_CASE("strmap") {
+
+  StrMap* map = strmap_new();
+  REQUIRE(map != NULL);
+
+  SUBCASE("empty map") {
+    CHECK(strmap_size(map) == 0);
+    CHECK(strmap_get(map, "/foo") == NULL);
+    CHECK_FALSE(strmap_contains(map, "/foo"));
+    CHECK(strmap_remove(map, "/foo") == NULL);
+  }
+
+  SUBCASE("put, get, replace, remove") {
+    int a = 1;
+    int b = 2;
+    CHECK(strmap_put(map, "/foo", &a) == NULL);
+    CHECK(strmap_get(map, "/foo") == &a);
+    CHECK(strmap_put(map, "/foo", &b) == &a);     // returns replaced val
+    CHECK(strmap_get(map, "/foo") == &b);
+    CHECK(strmap_size(map) == 1);
+    CHECK(strmap_remove(map, "/foo") == &b);
+    CHECK_FALSE(strmap_contains(map, "/foo"));
+    CHECK(strmap_size(map) == 0);
+  }
+
+  SUBCASE("NULL values are still contained") {
+    strmap_put(map, "/bar", NULL);
+    CHECK(strmap_contains(map, "/bar"));
+    CHECK(strmap_get(map, "/bar") == NULL);
+  }
+
+  SUBCASE("keys are copied") {
+    char key[] = "/baz";
+    int a = 1;
+    strmap_put(map, key, &a);
+    key[1] = 'X';
+    CHECK(strmap_get(map, "/baz") == &a);
+    CHECK_FALSE(strmap_contains(map, "/Xaz"));
+  }
+
+  strmap_free(map, NULL);
+
+}
+
+TEST_CASE("strmap grows") {
+
+  StrMap* map = strmap_new();
+  REQUIRE(map != NULL);
+
+  char key[32];
+  for (long i = 0; i < 10000; i++) {
+    snprintf(key, sizeof(key), "/path/%ld", i);
+    strmap_put(map, key, (void*)(i + 1));
+  }
+  CHECK(strmap_size(map) == 10000);
+  bool all_found = true;
+  for (long i = 0; i < 10000; i++) {
+    snprintf(key, sizeof(key), "/path/%ld", i);
+    if (strmap_get(map, key) != (void*)(i + 1))
+      all_found = false;
+  }
+  CHECK(all_found);
+  int count = 0;
+  strmap_foreach(map, count_keys, &count);
+  CHECK(count == 10000);
+
+  strmap_free(map, NULL);
+
+}
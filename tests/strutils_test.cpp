@@ -10,6 +10,9 @@ purpose:  test cases for functions in strace-4.6/strutils.c
 
 #include <cstring>      // ISOC: strlen()
 #include <cstdbool>     // ISOC: bool, true, false
+#include <cstdio>       // ISOC: FILE, fclose()
+#include <cstdlib>      // ISOC: free()
+#include <string>       // ISOC++: std::string
 
 TEST_CASE("str_find_stripped_end") {
 
@@ -252,3 +255,63 @@ TEST_CASE("str_endswith") {
 
 }
 
+
+TEST_CASE("str_to_bytes") {
+
+  SUBCASE("plain number of bytes") {
+    CHECK(str_to_bytes("0") == 0);
+    CHECK(str_to_bytes("512") == 512);
+  }
+
+  SUBCASE("1024-based suffixes, any case, optional B") {
+    CHECK(str_to_bytes("64K") == 64LL * 1024);
+    CHECK(str_to_bytes("10m") == 10LL * 1024 * 1024);
+    CHECK(str_to_bytes("10MB") == 10LL * 1024 * 1024);
+    CHECK(str_to_bytes("2G") == 2LL * 1024 * 1024 * 1024);
+    CHECK(str_to_bytes("1T") == 1024LL * 1024 * 1024 * 1024);
+  }
+
+  SUBCASE("trailing whitespace is allowed") {
+    CHECK(str_to_bytes("1K  ") == 1024);
+  }
+
+  SUBCASE("invalid sizes") {
+    CHECK(str_to_bytes("") == -1);
+    CHECK(str_to_bytes("-1") == -1);
+    CHECK(str_to_bytes("K") == -1);
+    CHECK(str_to_bytes("10X") == -1);
+    CHECK(str_to_bytes("10 M") == -1);
+    CHECK(str_to_bytes("99999999999999T") == -1);
+  }
+
+}
+
+// return str as str_print_json() prints it
+static std::string json_of (const char* str) {
+  char* buf = NULL;
+  size_t len = 0;
+  FILE* f = open_memstream(&buf, &len);
+  str_print_json(f, str);
+  fclose(f);
+  const std::string json(buf, len);
+  free(buf);
+  return json;
+}
+
+TEST_CASE("str_print_json") {
+
+  SUBCASE("plain string") {
+    CHECK(json_of("/usr/bin/ls") == "\"/usr/bin/ls\"");
+  }
+
+  SUBCASE("quotes, backslashes, and control chars are escaped") {
+    CHECK(json_of("a \"b\" c\\d") == "\"a \\\"b\\\" c\\\\d\"");
+    CHECK(json_of("tab\tnl\n") == "\"tab\\u0009nl\\u000a\"");
+  }
+
+  SUBCASE("empty and NULL strings") {
+    CHECK(json_of("") == "\"\"");
+    CHECK(json_of(NULL) == "\"\"");
+  }
+
+}
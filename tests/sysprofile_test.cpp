@@ -0,0 +1,99 @@
+/*******************************************************************************
+module:   sysprofile_test
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  test cases for functions in strace-4.6/sysprofile.c
+*******************************************************************************/
+
+#include "doctest.h"
+#include "sysprofile.h"
+
+#include <cstdio>       // ISOC: fmemopen(), fclose()
+#include <cstring>      // ISOC: strstr()
+
+TEST_CASE("sysprofile_parse_format") {
+
+  SysProfileFormat fmt;
+  CHECK(sysprofile_parse_format("table", &fmt) == 0);
+  CHECK(fmt == SYSPROFILE_TABLE);
+  CHECK(sysprofile_parse_format("json", &fmt) == 0);
+  CHECK(fmt == SYSPROFILE_JSON);
+  CHECK(sysprofile_parse_format("xml", &fmt) == -1);
+
+}
+
+TEST_CASE("sysprofile_record_stop") {
+
+  sysprofile_reset();
+
+  SUBCASE("entry and exit stops accumulate with pending counts") {
+    sysprofile_count_child_read(100);
+    sysprofile_add_prov_time(5);
+    sysprofile_record_stop(2, "open", true, 1000, 0);
+    sysprofile_count_child_write(8);
+    sysprofile_record_stop(2, "open", false, 300, 7000);
+
+    const SysProfileRow* r = sysprofile_row(2);
+    REQUIRE(r != NULL);
+    CHECK(r->entry_stops == 1);
+    CHECK(r->exit_stops == 1);
+    CHECK(r->entry_handler_ns == 1000);
+    CHECK(r->exit_handler_ns == 300);
+    CHECK(r->blocked_ns == 7000);
+    CHECK(r->prov_write_ns == 5);
+    CHECK(r->child_bytes_read == 100);
+    CHECK(r->child_bytes_written == 8);
+  }
+
+  SUBCASE("discarded counts are not recorded") {
+    sysprofile_count_child_read(100);
+    sysprofile_discard_stop();
+    sysprofile_record_stop(0, "read", true, 1, 0);
+    CHECK(sysprofile_row(0)->child_bytes_read == 0);
+  }
+
+  SUBCASE("large and unrecorded syscall numbers") {
+    sysprofile_record_stop(5000, "big", true, 1, 0);
+    CHECK(sysprofile_row(5000) != NULL);
+    CHECK(sysprofile_row(4999) == NULL);
+    CHECK(sysprofile_row(-1) == NULL);
+  }
+
+  sysprofile_reset();
+
+}
+
+TEST_CASE("print_sysprofile") {
+
+  sysprofile_reset();
+  sysprofile_record_stop(0, "read", true, 10, 0);
+  sysprofile_record_stop(2, "open", true, 1000, 0);
+
+  char buf[4096] = {0};
+
+  SUBCASE("table lists most expensive syscall first") {
+    FILE* f = fmemopen(buf, sizeof(buf) - 1, "w");
+    REQUIRE(f != NULL);
+    print_sysprofile(f, SYSPROFILE_TABLE);
+    fclose(f);
+    const char* open_pos = strstr(buf, "\nopen ");
+    const char* read_pos = strstr(buf, "\nread ");
+    REQUIRE(open_pos != NULL);
+    REQUIRE(read_pos != NULL);
+    CHECK(open_pos < read_pos);
+  }
+
+  SUBCASE("json has one object per syscall") {
+    FILE* f = fmemopen(buf, sizeof(buf) - 1, "w");
+    REQUIRE(f != NULL);
+    print_sysprofile(f, SYSPROFILE_JSON);
+    fclose(f);
+    CHECK(strstr(buf, "{\"syscalls\": [") == buf);
+    CHECK(strstr(buf, "\"name\": \"open\", \"scno\": 2,") != NULL);
+    CHECK(strstr(buf, "\"name\": \"read\", \"scno\": 0,") != NULL);
+    CHECK(strstr(buf, "\n]}\n") != NULL);
+  }
+
+  sysprofile_reset();
+
+}
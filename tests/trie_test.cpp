@@ -0,0 +1,52 @@
+/*******************************************************************************
+module:   trie_test
+author:   digimokan
+date:     18 OCT 2026 (created)
+purpose:  test cases for functions in strace-4.6/trie.c
+*******************************************************************************/
+
+#include "doctest.h"
+#include "trie.h"
+
+TEST_CASE("trie") {
+
+  Trie* t = TrieNew();
+  REQUIRE(t != NULL);
+
+  SUBCASE("empty trie contains nothing") {
+    CHECK(TrieContains(t, (char*)"/usr") == 0);
+  }
+
+  SUBCASE("inserted strings are contained, but not their prefixes") {
+    TrieInsert(t, (char*)"/usr/lib");
+    TrieInsert(t, (char*)"/usr/lib64");
+    CHECK(TrieContains(t, (char*)"/usr/lib") == 1);
+    CHECK(TrieContains(t, (char*)"/usr/lib64") == 1);
+    CHECK(TrieContains(t, (char*)"/usr/li") == 0);
+    CHECK(TrieContains(t, (char*)"/usr/lib6") == 0);
+    CHECK(TrieContains(t, (char*)"/usr/lib642") == 0);
+  }
+
+  SUBCASE("extended ascii strings are never contained") {
+    TrieInsert(t, (char*)"/caf");
+    CHECK(TrieContains(t, (char*)"/caf\xc3\xa9") == 0);
+  }
+
+  SUBCASE("longest inserted prefix, with its value") {
+    int value = -1;
+    CHECK(TrieLongestPrefix(t, "/app/repo/bin", &value) == -1);
+    TrieInsertValue(t, (char*)"/app/repo", 1);
+    TrieInsertValue(t, (char*)"/app/repo/sub", 2);
+    CHECK(TrieLongestPrefix(t, "/app/repo/bin", &value) == 9);
+    CHECK(value == 1);
+    CHECK(TrieLongestPrefix(t, "/app/repo/sub/bin", &value) == 13);
+    CHECK(value == 2);
+    CHECK(TrieLongestPrefix(t, "/app/repo", &value) == 9);
+    CHECK(value == 1);
+    CHECK(TrieLongestPrefix(t, "/app/rep", &value) == -1);
+    CHECK(TrieLongestPrefix(t, "/app/repo\xc3\xa9", &value) == 9);
+  }
+
+  TrieDelete(t);
+
+}